@@ -5,17 +5,22 @@
 #include <Windows.h>
 #include <iostream>
 
-#include "audio_handler.h"
-#include "hid_handler.h"
+#include "session_manager.h"
 
 #pragma comment(lib, "setupapi.lib")
 #pragma comment(lib, "hid.lib")
 
 using namespace std;
 
-jthread proxyThread;
-jthread outputThread;
-jthread audioThread;
+static session_manager manager;
+
+// 按键检测周期与防抖，同时是检查会话是否全部结束的周期
+static constexpr DWORD KEY_POLL_MS = 100;
+static constexpr DWORD KEY_DEBOUNCE_MS = 200;
+
+// 控制台事件交给主线程处理；主线程清理完才让处理函数返回，关闭窗口时 WAV 也能写完
+static HANDLE stopRequested = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+static HANDLE stopped = CreateEvent(nullptr, TRUE, FALSE, nullptr);
 
 //
 // Ctrl+C 信号处理
@@ -24,44 +29,55 @@ static BOOL WINAPI ConsoleCtrlHandler(DWORD ctrlType)
 {
 	if (ctrlType == CTRL_C_EVENT || ctrlType == CTRL_CLOSE_EVENT || ctrlType == CTRL_BREAK_EVENT)
 	{
-		audioThread.request_stop();
-		audioThread.join();
-		outputThread.request_stop();
-		outputThread.join();
-		proxyThread.request_stop();
-		proxyThread.join();
-		
-		ExitProcess(0);
+		SetEvent(stopRequested);
+		WaitForSingleObject(stopped, INFINITE);
 		return TRUE;
 	}
 	return FALSE;
 }
 
-int main()
+static int run()
 {
-	// 注册 Ctrl+C 处理，退出时保存WAV
-	SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
-	
-	const int initResult = hid_handler::hid_handler_init();
+	const int initResult = manager.start();
 	if (initResult != 0)
-	{
 		return initResult;
-	}
 
-	// 启动线程
-	proxyThread = jthread(hid_handler::proxy_thread);
-	outputThread = jthread(hid_handler::output_report_thread);
-	audioThread = jthread(audio_handler::audio_thread);
+	cout << "[App] Proxying " << manager.session_count()
+		 << " controller(s). Recording audio to DS5_audio_out_<n>_NNN.wav. Press 'k' to send report, Ctrl+C to stop." << endl;
+
+	// 会话都挂在后台线程池上，主线程等 Ctrl+C 或所有手柄断开，顺便检测按键 'k'，发给第一个手柄
+	while (WaitForSingleObject(stopRequested, KEY_POLL_MS) == WAIT_TIMEOUT)
+	{
+		if (manager.running_count() == 0)
+		{
+			cout << "[App] All controllers disconnected." << endl;
+			break;
+		}
+
+		if (GetAsyncKeyState('K') & 0x8000)
+		{
+			manager.send_test_report();
+
+			// 防止连续触发
+			Sleep(KEY_DEBOUNCE_MS);
+		}
+	}
 
-	cout << "[App] Recording audio to DS5_audio_out.wav. Press 'k' to send report, Ctrl+C to stop." << endl;
-	
-	proxyThread.join();
-	outputThread.join();
-	audioThread.join();
-	
 	return 0;
 }
 
+int main()
+{
+	// 注册 Ctrl+C 处理，退出时保存WAV
+	SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
+
+	const int result = run();
+
+	manager.stop();
+	SetEvent(stopped);
+	return result;
+}
+
 // 测试用例
 /*#include "utils.h"
 int main()
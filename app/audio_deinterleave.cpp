@@ -0,0 +1,187 @@
+﻿#include "audio_deinterleave.h"
+#include "cpu_features.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DEINTERLEAVE_HAVE_SSE2 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define DEINTERLEAVE_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DEINTERLEAVE_TARGET(x) __attribute__((target(x)))
+#else
+#define DEINTERLEAVE_TARGET(x)
+#endif
+
+namespace
+{
+    constexpr float INT16_SCALE = 1.0f / 32768.0f;
+
+    void deinterleave_scalar(const int16_t* in, size_t frames, const ds5_audio_planes& out)
+    {
+        for (size_t i = 0; i < frames; i++)
+        {
+            out.speakerL[i] = in[4 * i + 0] * INT16_SCALE;
+            out.speakerR[i] = in[4 * i + 1] * INT16_SCALE;
+            out.hapticL[i] = in[4 * i + 2] * INT16_SCALE;
+            out.hapticR[i] = in[4 * i + 3] * INT16_SCALE;
+        }
+    }
+
+#if defined(DEINTERLEAVE_HAVE_SSE2)
+    //
+    // 8 帧 (4 x 128bit) 转置成 4 个声道各 8 个样本：
+    //   a = L0 R0 H0 G0 L1 R1 H1 G1 ...
+    //   两轮 unpack_epi16 得到 L0-3 R0-3 / H0-3 G0-3，再按 64 位拼接
+    //
+    inline void transpose_8_frames(const int16_t* in, __m128i& l, __m128i& r, __m128i& h, __m128i& g)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 0));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 8));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 24));
+
+        const __m128i t0 = _mm_unpacklo_epi16(a, b);  // L0 L2 R0 R2 H0 H2 G0 G2
+        const __m128i t1 = _mm_unpackhi_epi16(a, b);  // L1 L3 R1 R3 H1 H3 G1 G3
+        const __m128i t2 = _mm_unpacklo_epi16(c, d);
+        const __m128i t3 = _mm_unpackhi_epi16(c, d);
+
+        const __m128i u0 = _mm_unpacklo_epi16(t0, t1);  // L0 L1 L2 L3 R0 R1 R2 R3
+        const __m128i u1 = _mm_unpackhi_epi16(t0, t1);  // H0 H1 H2 H3 G0 G1 G2 G3
+        const __m128i u2 = _mm_unpacklo_epi16(t2, t3);
+        const __m128i u3 = _mm_unpackhi_epi16(t2, t3);
+
+        l = _mm_unpacklo_epi64(u0, u2);
+        r = _mm_unpackhi_epi64(u0, u2);
+        h = _mm_unpacklo_epi64(u1, u3);
+        g = _mm_unpackhi_epi64(u1, u3);
+    }
+
+    // SSE2 没有符号扩展指令，把样本放到高 16 位再算术右移
+    inline void store_plane_sse2(__m128i v, float* dst, __m128 scale)
+    {
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + 0, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+
+    void deinterleave_sse2(const int16_t* in, size_t frames, const ds5_audio_planes& out)
+    {
+        const __m128 scale = _mm_set1_ps(INT16_SCALE);
+        size_t i = 0;
+
+        for (; i + 8 <= frames; i += 8)
+        {
+            __m128i l, r, h, g;
+            transpose_8_frames(in + 4 * i, l, r, h, g);
+
+            store_plane_sse2(l, out.speakerL + i, scale);
+            store_plane_sse2(r, out.speakerR + i, scale);
+            store_plane_sse2(h, out.hapticL + i, scale);
+            store_plane_sse2(g, out.hapticR + i, scale);
+        }
+
+        deinterleave_scalar(in + 4 * i, frames - i,
+            { out.speakerL + i, out.speakerR + i, out.hapticL + i, out.hapticR + i });
+    }
+
+    DEINTERLEAVE_TARGET("avx2")
+    inline void store_plane_avx2(__m128i v, float* dst, __m256 scale)
+    {
+        _mm256_storeu_ps(dst, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v)), scale));
+    }
+
+    DEINTERLEAVE_TARGET("avx2")
+    void deinterleave_avx2(const int16_t* in, size_t frames, const ds5_audio_planes& out)
+    {
+        const __m256 scale = _mm256_set1_ps(INT16_SCALE);
+        size_t i = 0;
+
+        for (; i + 8 <= frames; i += 8)
+        {
+            __m128i l, r, h, g;
+            transpose_8_frames(in + 4 * i, l, r, h, g);
+
+            store_plane_avx2(l, out.speakerL + i, scale);
+            store_plane_avx2(r, out.speakerR + i, scale);
+            store_plane_avx2(h, out.hapticL + i, scale);
+            store_plane_avx2(g, out.hapticR + i, scale);
+        }
+
+        deinterleave_scalar(in + 4 * i, frames - i,
+            { out.speakerL + i, out.speakerR + i, out.hapticL + i, out.hapticR + i });
+    }
+#endif
+
+#if defined(DEINTERLEAVE_HAVE_NEON)
+    inline void store_plane_neon(int16x8_t v, float* dst, float32x4_t scale)
+    {
+        vst1q_f32(dst + 0, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+        vst1q_f32(dst + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+    }
+
+    void deinterleave_neon(const int16_t* in, size_t frames, const ds5_audio_planes& out)
+    {
+        const float32x4_t scale = vdupq_n_f32(INT16_SCALE);
+        size_t i = 0;
+
+        for (; i + 8 <= frames; i += 8)
+        {
+            // vld4 直接按 4 声道解交错
+            const int16x8x4_t v = vld4q_s16(in + 4 * i);
+
+            store_plane_neon(v.val[0], out.speakerL + i, scale);
+            store_plane_neon(v.val[1], out.speakerR + i, scale);
+            store_plane_neon(v.val[2], out.hapticL + i, scale);
+            store_plane_neon(v.val[3], out.hapticR + i, scale);
+        }
+
+        deinterleave_scalar(in + 4 * i, frames - i,
+            { out.speakerL + i, out.speakerR + i, out.hapticL + i, out.hapticR + i });
+    }
+#endif
+
+    using deinterleave_fn = void(*)(const int16_t*, size_t, const ds5_audio_planes&);
+
+    struct deinterleave_kernel
+    {
+        deinterleave_fn fn;
+        const char* name;
+    };
+
+    deinterleave_kernel select_kernel()
+    {
+        const auto& cpu = get_cpu_features();
+
+#if defined(DEINTERLEAVE_HAVE_SSE2)
+        if (cpu.avx2)
+            return { deinterleave_avx2, "avx2" };
+        return { deinterleave_sse2, "sse2" };
+#elif defined(DEINTERLEAVE_HAVE_NEON)
+        if (cpu.neon)
+            return { deinterleave_neon, "neon" };
+#endif
+        (void)cpu;
+        return { deinterleave_scalar, "scalar" };
+    }
+
+    const deinterleave_kernel& kernel()
+    {
+        static const deinterleave_kernel selected = select_kernel();
+        return selected;
+    }
+}
+
+void ds5_deinterleave(const int16_t* interleaved, size_t frames, const ds5_audio_planes& out)
+{
+    kernel().fn(interleaved, frames, out);
+}
+
+const char* ds5_deinterleave_kernel_name()
+{
+    return kernel().name;
+}
@@ -0,0 +1,22 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+//
+// DS5 USB 音频 (4ch / 16bit / 48kHz) 拆分
+//
+// 声道 1-2 是扬声器，3-4 驱动左右振动马达。交错的 int16 帧被拆成四条
+// 连续的 float 平面并归一化到 [-1, 1)，后续处理不再需要跨步访问。
+//
+struct ds5_audio_planes
+{
+    float* speakerL;
+    float* speakerR;
+    float* hapticL;
+    float* hapticR;
+};
+
+void ds5_deinterleave(const int16_t* interleaved, size_t frames, const ds5_audio_planes& out);
+
+// 当前运行时选中的内核名称（avx2 / sse2 / neon / scalar）
+const char* ds5_deinterleave_kernel_name();
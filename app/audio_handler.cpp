@@ -1,19 +1,19 @@
 ﻿#define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 #include "audio_handler.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
-#include <mutex>
-#include <vector>
-#include <fstream>
 #include <iomanip>
 
-#include "hid_handler.h"
+#include "audio_deinterleave.h"
+#include "shared_audio_ring.h"
 #include "ViGEm/Common.h"
 
 using namespace std;
-// 音频录制状态
-static mutex audioMutex;
-static vector<UCHAR> audioData;
+
+// 每个消费者一条 ring，约 2.7 秒的 4ch/16bit/48kHz 数据
+static constexpr size_t SINK_RING_CAPACITY = 1 << 20;
 
 //
 // DS5 Audio OUT format: 4-channel, 16-bit PCM, 48000 Hz
@@ -24,104 +24,226 @@ static constexpr WORD  WAV_BITS        = 16;
 static constexpr WORD  WAV_BLOCK_ALIGN = WAV_CHANNELS * (WAV_BITS / 8); // 8 bytes
 static constexpr DWORD WAV_BYTE_RATE   = WAV_SAMPLE_RATE * WAV_BLOCK_ALIGN;
 
+// 录音按小时分段，单个文件约 1.3 GB
+static constexpr uint32_t RECORD_SEGMENT_SECONDS = 60 * 60;
+
+// 录音消费者单次从 ring 取出的上限，写盘由 wav_writer 按块合并
+static constexpr size_t RECORD_READ_SIZE = 64 * 1024;
+
+namespace
+{
+    wav_writer_options record_options()
+    {
+        wav_writer_options options;
+        options.segmentSeconds = RECORD_SEGMENT_SECONDS;
+        return options;
+    }
+}
+
 //
-// 写WAV文件（在程序退出时调用）
+// 峰值电平统计：把交错帧拆成平面后分别取扬声器与振动声道的峰值
 //
-void audio_handler::write_wav_file(const char* filename)
+struct audio_handler::level_meter
 {
-    scoped_lock lock(audioMutex);
+    static constexpr size_t BLOCK_FRAMES = 256;
+
+    float speakerL[BLOCK_FRAMES];
+    float speakerR[BLOCK_FRAMES];
+    float hapticL[BLOCK_FRAMES];
+    float hapticR[BLOCK_FRAMES];
 
-    if (audioData.empty())
+    float speakerPeak = 0.0f;
+    float hapticPeak = 0.0f;
+
+    void process(const uint8_t* data, size_t size)
     {
-        cout << "[WAV] No audio data captured, skipping WAV output." << endl;
-        return;
+        const auto* frames = reinterpret_cast<const int16_t*>(data);
+        size_t remaining = size / WAV_BLOCK_ALIGN;
+
+        while (remaining > 0)
+        {
+            const size_t n = min(remaining, BLOCK_FRAMES);
+            ds5_deinterleave(frames, n, { speakerL, speakerR, hapticL, hapticR });
+
+            for (size_t i = 0; i < n; i++)
+            {
+                speakerPeak = max(speakerPeak, max(fabsf(speakerL[i]), fabsf(speakerR[i])));
+                hapticPeak = max(hapticPeak, max(fabsf(hapticL[i]), fabsf(hapticR[i])));
+            }
+
+            frames += n * WAV_CHANNELS;
+            remaining -= n;
+        }
     }
 
-    ofstream file(filename, ios::binary);
-    if (!file.is_open())
+    static double to_dbfs(float peak)
     {
-        cerr << "[WAV] Failed to open " << filename << " for writing." << endl;
-        return;
+        return peak > 0.0f ? 20.0 * log10(peak) : -INFINITY;
+    }
+
+    void reset()
+    {
+        speakerPeak = 0.0f;
+        hapticPeak = 0.0f;
     }
+};
 
-    const DWORD dataSize = static_cast<DWORD>(audioData.size());
-    const DWORD fileSize = 36 + dataSize;
-
-    // RIFF header
-    file.write("RIFF", 4);
-    file.write(reinterpret_cast<const char*>(&fileSize), 4);
-    file.write("WAVE", 4);
-
-    // fmt  sub-chunk
-    file.write("fmt ", 4);
-    const DWORD fmtSize = 16;
-    file.write(reinterpret_cast<const char*>(&fmtSize), 4);
-    const WORD  audioFormat = 1; // PCM
-    file.write(reinterpret_cast<const char*>(&audioFormat), 2);
-    const WORD  channels = WAV_CHANNELS;
-    file.write(reinterpret_cast<const char*>(&channels), 2);
-    const DWORD sampleRate = WAV_SAMPLE_RATE;
-    file.write(reinterpret_cast<const char*>(&sampleRate), 4);
-    const DWORD byteRate = WAV_BYTE_RATE;
-    file.write(reinterpret_cast<const char*>(&byteRate), 4);
-    const WORD  blockAlign = WAV_BLOCK_ALIGN;
-    file.write(reinterpret_cast<const char*>(&blockAlign), 2);
-    const WORD  bitsPerSample = WAV_BITS;
-    file.write(reinterpret_cast<const char*>(&bitsPerSample), 2);
-
-    // data sub-chunk
-    file.write("data", 4);
-    file.write(reinterpret_cast<const char*>(&dataSize), 4);
-    file.write(reinterpret_cast<const char*>(audioData.data()), dataSize);
-
-    file.close();
-
-    const double durationSec = static_cast<double>(dataSize) / WAV_BYTE_RATE;
-    cout << "[WAV] Saved " << filename 
-              << " (" << dataSize << " bytes, "
-              << fixed << setprecision(2) << durationSec << "s)"
-              << endl;
+audio_handler::audio_handler(ULONG serial, unsigned index, bus_device& bus, bus_device* ringBus)
+    : serial_(serial), index_(index), bus_(bus), ringBus_(ringBus), meter_(make_unique<level_meter>())
+{
+    request_.owner = this;
+}
+
+audio_handler::~audio_handler()
+{
+    stop();
 }
 
-void audio_handler::audio_thread(stop_token stoken)
+audio_ring& audio_handler::open_sink()
 {
-    DS5_AUDIO_BUFFER audioBuf;
-    ULONG audioPacketCount = 0;
+    sinks_[sinkCount_] = make_unique<audio_ring>(SINK_RING_CAPACITY);
+    return *sinks_[sinkCount_++];
+}
 
-    while (!stoken.stop_requested())
+bool audio_handler::start()
+{
+    if (ringBus_)
     {
-        auto err = vigem_target_DS5_await_audio_data_timeout(hid_handler::vigem_client, hid_handler::vigem_ds, 500, &audioBuf);
+        ring_ = make_unique<shared_audio_ring>(*ringBus_);
+        if (!ring_->attach(serial_))
+            ring_.reset();
+    }
 
-        if (VIGEM_SUCCESS(err))
-        {
-            audioPacketCount++;
+    return io_loop::start();
+}
 
-            // 将音频数据追加到全局缓冲区
-            {
-                scoped_lock lock(audioMutex);
-                audioData.insert(audioData.end(),
-                                   audioBuf.AudioData,
-                                   audioBuf.AudioData + audioBuf.AudioDataLength);
-            }
+void audio_handler::stop()
+{
+    io_loop::stop();
 
-            if (audioPacketCount % 100 == 0)
-            {
-                double sec;
-                {
-                    scoped_lock lock(audioMutex);
-                    sec = static_cast<double>(audioData.size()) / WAV_BYTE_RATE;
-                }
-                cout << "[Audio] " << audioPacketCount << " packets received, "
-                          << fixed << setprecision(2) << sec << "s recorded"
-                          << endl;
-            }
+    if (ring_)
+        ring_->detach();
+
+    // 让消费者醒来检查退出
+    for (size_t i = 0; i < sinkCount_; i++)
+    {
+        sinks_[i]->wake();
+    }
+}
+
+bool audio_handler::issue()
+{
+    // 环里已有数据时 doorbell 立即完成
+    if (ring_)
+        return ring_->post_wait(bus_, request_);
+
+    await_.Size = sizeof(DS5_AUDIO_DATA);
+    await_.SerialNo = serial_;
+    return bus_.ioctl_async(IOCTL_DS5_AWAIT_AUDIO_DATA, &await_, sizeof(await_), &await_, sizeof(await_), request_);
+}
+
+void audio_handler::cancel()
+{
+    bus_.cancel(request_);
+}
+
+bool audio_handler::completed(bool ok, size_t transferred)
+{
+    if (ring_)
+    {
+        if (!ok)
+        {
+            cerr << "[Audio#" << index_ << "] Shared audio ring detached" << endl;
+            return false;
         }
-        else if (err != VIGEM_ERROR_TIMED_OUT)
+
+        // 原地读取驱动写入的数据，读空了再挂 doorbell
+        ViGEm::Audio::AudioRingSpans spans;
+        unsigned long available;
+        while ((available = ring_->peek(spans)) != 0)
         {
-            cerr << "[Audio] Error receiving audio data" << endl;
-            break;
+            deliver(spans.First, spans.FirstLength);
+            if (spans.SecondLength > 0)
+                deliver(spans.Second, spans.SecondLength);
+
+            ring_->release(available);
+            report(ring_->dropped());
         }
+        return true;
+    }
+
+    const size_t header = FIELD_OFFSET(DS5_AUDIO_DATA, AudioData);
+    if (!ok || transferred < header)
+    {
+        cerr << "[Audio#" << index_ << "] Error receiving audio data" << endl;
+        return false;
     }
-    cout << "[App] Stopping... writing WAV file." << endl;
-    write_wav_file("DS5_audio_out.wav");
-}
\ No newline at end of file
+
+    // 驱动只回传报文头和实际采到的字节
+    deliver(await_.AudioData, min<size_t>(await_.AudioDataLength, transferred - header));
+    report(0);
+    return true;
+}
+
+void audio_handler::deliver(const uint8_t* data, size_t size)
+{
+    bytes_ += size;
+
+    for (size_t i = 0; i < sinkCount_; i++)
+    {
+        sinks_[i]->write(data, size);
+    }
+
+    meter_->process(data, size);
+}
+
+void audio_handler::report(unsigned long ringDropped)
+{
+    if (++packetCount_ % 100 != 0)
+        return;
+
+    const double sec = static_cast<double>(bytes_) / WAV_BYTE_RATE;
+    cout << "[Audio#" << index_ << "] " << packetCount_ << " packets received, "
+              << fixed << setprecision(2) << sec << "s received"
+              << " | peak speaker " << setprecision(1) << level_meter::to_dbfs(meter_->speakerPeak)
+              << " dBFS haptic " << level_meter::to_dbfs(meter_->hapticPeak) << " dBFS";
+    meter_->reset();
+    if (ring_)
+    {
+        cout << " | shared ring dropped " << ringDropped;
+    }
+    for (size_t i = 0; i < sinkCount_; i++)
+    {
+        cout << " | sink" << i << " overflow " << sinks_[i]->overflows()
+             << " underrun " << sinks_[i]->underruns();
+    }
+    cout << endl;
+}
+
+audio_recorder::audio_recorder(audio_ring& ring, const string& path)
+    : ring_(ring),
+      writer_(path, { WAV_CHANNELS, WAV_SAMPLE_RATE, WAV_BITS }, record_options()),
+      buffer_(RECORD_READ_SIZE)
+{
+}
+
+bool audio_recorder::pump()
+{
+    bool drained = false;
+
+    size_t read;
+    while ((read = ring_.read(buffer_.data(), buffer_.size())) != 0)
+    {
+        writer_.write(buffer_.data(), read);
+        drained = true;
+    }
+
+    return drained;
+}
+
+void audio_recorder::close()
+{
+    // 把停止前已经进入 ring 的数据也落盘
+    pump();
+    writer_.close();
+}
@@ -1,13 +1,84 @@
 ﻿#pragma once
 #include <atomic>
-#include <stop_token>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "ViGEm/Client.h"
+#include "audio_ring.h"
+#include "bus_device.h"
+#include "io_pool.h"
+#include "shared_audio_ring.h"
+#include "sink_worker.h"
+#include "wav_writer.h"
 
-class audio_handler
+#include <ViGEm/km/BusShared.h>
+
+//
+// 一个虚拟 DS5 的 USB 音频接收：从驱动取 Audio OUT 数据，分发给各消费者的 ring
+//
+// 请求挂在 io_pool 上，一次一个：共享音频环挂上时是 doorbell，否则是按 SerialNo
+// 路由的 IOCTL_DS5_AWAIT_AUDIO_DATA。ringBus 非空时优先挂共享音频环，挂不上再退回等待。
+//
+class audio_handler : private io_loop
 {
 public:
-    static void audio_thread(std::stop_token stop_token);
-    static void write_wav_file(const char* filename);
+    // bus 须已 bind 到 io_pool
+    audio_handler(ULONG serial, unsigned index, bus_device& bus, bus_device* ringBus = nullptr);
+    ~audio_handler();
+
+    // 为一个消费者创建独立的环形缓冲，必须在 start 之前调用
+    audio_ring& open_sink();
+
+    bool start();
+    // 取消挂起的请求，唤醒消费者检查退出
+    void stop();
+
+private:
+    static constexpr size_t MAX_SINKS = 4;
+
+    struct level_meter;
+
+    bool issue() override;
+    void cancel() override;
+    bool completed(bool ok, size_t transferred) override;
+
+    // 分发给各个消费者，ring 满时由 ring 自己计数丢弃
+    void deliver(const uint8_t* data, size_t size);
+    void report(unsigned long ringDropped);
+
+    const ULONG serial_;
+    const unsigned index_;
+    bus_device& bus_;
+    bus_device* ringBus_;
+    std::unique_ptr<audio_ring> sinks_[MAX_SINKS];
+    size_t sinkCount_ = 0;
+
+    std::unique_ptr<shared_audio_ring> ring_;
+    io_pool::request request_;
+    DS5_AUDIO_DATA await_ = {};
+
+    // 以下只在完成回调里访问
+    ULONG packetCount_ = 0;
+    uint64_t bytes_ = 0;
+    std::unique_ptr<level_meter> meter_;
+};
+
+//
+// 录音消费者：从 ring 取数据边收边写 WAV，由共享的 sink_worker 驱动
+//
+class audio_recorder : public sink_consumer
+{
+public:
+    audio_recorder(audio_ring& ring, const std::string& path);
+
+    bool pump() override;
+    // 从 sink_worker 移除之后调用
+    void close();
+
 private:
+    audio_ring& ring_;
+    wav_writer writer_;
+    std::vector<uint8_t> buffer_;
 };
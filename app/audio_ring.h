@@ -0,0 +1,146 @@
+﻿#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+//
+// 单生产者 / 单消费者字节环形缓冲
+//
+// 容量为 2 的幂，存储在构造时一次性分配，之后读写都不再分配内存。
+// head / tail 各占一条缓存行；写满时整包丢弃并计入 overflow，
+// 按固定块消费时数据不足一块计入 underrun。消费者可以在 signal 上阻塞等待新数据。
+//
+class audio_ring
+{
+public:
+    // capacity 必须是 2 的幂
+    explicit audio_ring(size_t capacity)
+        : capacity_(capacity), mask_(capacity - 1), storage_(new uint8_t[capacity])
+    {
+    }
+
+    audio_ring(const audio_ring&) = delete;
+    audio_ring& operator=(const audio_ring&) = delete;
+
+    // 生产者：整包写入，空间不足时丢弃整包
+    bool write(const uint8_t* data, size_t size)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (capacity_ - (tail - cachedHead_) < size)
+        {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (capacity_ - (tail - cachedHead_) < size)
+            {
+                overflows_.fetch_add(1, std::memory_order_relaxed);
+                overflowBytes_.fetch_add(size, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        const size_t offset = tail & mask_;
+        const size_t first = std::min(size, capacity_ - offset);
+        memcpy(storage_.get() + offset, data, first);
+        memcpy(storage_.get(), data + first, size - first);
+
+        tail_.store(tail + size, std::memory_order_release);
+        wake();
+        return true;
+    }
+
+    // 消费者：最多读 size 字节，返回实际读到的字节数
+    size_t read(uint8_t* data, size_t size)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        size_t available = cachedTail_ - head;
+        if (available < size)
+        {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            available = cachedTail_ - head;
+        }
+
+        if (available == 0)
+            return 0;
+
+        size = std::min(size, available);
+        const size_t offset = head & mask_;
+        const size_t first = std::min(size, capacity_ - offset);
+        memcpy(data, storage_.get() + offset, first);
+        memcpy(data + first, storage_.get(), size - first);
+
+        head_.store(head + size, std::memory_order_release);
+        return size;
+    }
+
+    // 消费者：按固定块读取，不足 size 字节时不读并计入 underrun
+    bool read_exact(uint8_t* data, size_t size)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (cachedTail_ - head < size)
+        {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (cachedTail_ - head < size)
+            {
+                underruns_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        return read(data, size) == size;
+    }
+
+    size_t size() const
+    {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    //
+    // 等待新数据：先取 signal()，确认读空后再 wait(seen)，
+    // 期间有写入时 wait 会立即返回
+    //
+    uint32_t signal() const { return signal_.load(std::memory_order_acquire); }
+    void wait(uint32_t seen) const { signal_.wait(seen, std::memory_order_acquire); }
+
+    // 唤醒等待中的消费者（写入和退出时调用）
+    void wake()
+    {
+        signal_.fetch_add(1, std::memory_order_release);
+        signal_.notify_one();
+
+        if (doorbell_ != nullptr)
+        {
+            doorbell_->fetch_add(1, std::memory_order_release);
+            doorbell_->notify_one();
+        }
+    }
+
+    // 由共享的消费线程服务时，写入同时敲响该线程的门铃；须在写入开始前设置
+    void attach(std::atomic<uint32_t>* doorbell) { doorbell_ = doorbell; }
+
+    uint64_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+    uint64_t overflow_bytes() const { return overflowBytes_.load(std::memory_order_relaxed); }
+    uint64_t underruns() const { return underruns_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    const size_t capacity_;
+    const size_t mask_;
+    const std::unique_ptr<uint8_t[]> storage_;
+
+    alignas(CACHE_LINE) std::atomic<size_t> head_ = 0;
+    size_t cachedTail_ = 0;  // 消费者本地缓存
+    std::atomic<uint64_t> underruns_ = 0;
+
+    alignas(CACHE_LINE) std::atomic<size_t> tail_ = 0;
+    size_t cachedHead_ = 0;  // 生产者本地缓存
+    std::atomic<uint64_t> overflows_ = 0;
+    std::atomic<uint64_t> overflowBytes_ = 0;
+
+    alignas(CACHE_LINE) std::atomic<uint32_t> signal_ = 0;
+    std::atomic<uint32_t>* doorbell_ = nullptr;
+};
@@ -0,0 +1,100 @@
+﻿#include "bus_device.h"
+
+#include <initguid.h>
+#include <SetupAPI.h>
+#include <vector>
+#include <ViGEm/km/BusShared.h>
+
+using namespace std;
+
+namespace
+{
+    // 每个线程一个等待事件，同步 IOCTL 之间互不干扰
+    struct thread_event
+    {
+        HANDLE handle = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+        ~thread_event() { if (handle) CloseHandle(handle); }
+    };
+}
+
+bool bus_device::open()
+{
+    const HDEVINFO info = SetupDiGetClassDevs(&GUID_DEVINTERFACE_BUSENUM_VIGEM, nullptr, nullptr,
+                                              DIGCF_PRESENT | DIGCF_DEVICEINTERFACE);
+    if (info == INVALID_HANDLE_VALUE)
+        return false;
+
+    SP_DEVICE_INTERFACE_DATA interfaceData = {};
+    interfaceData.cbSize = sizeof(interfaceData);
+
+    for (DWORD index = 0; handle_ == INVALID_HANDLE_VALUE &&
+         SetupDiEnumDeviceInterfaces(info, nullptr, &GUID_DEVINTERFACE_BUSENUM_VIGEM, index, &interfaceData); index++)
+    {
+        DWORD required = 0;
+        SetupDiGetDeviceInterfaceDetail(info, &interfaceData, nullptr, 0, &required, nullptr);
+        if (required == 0)
+            continue;
+
+        vector<uint8_t> storage(required);
+        auto detail = reinterpret_cast<PSP_DEVICE_INTERFACE_DETAIL_DATA>(storage.data());
+        detail->cbSize = sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA);
+
+        if (!SetupDiGetDeviceInterfaceDetail(info, &interfaceData, detail, required, &required, nullptr))
+            continue;
+
+        handle_ = CreateFile(detail->DevicePath, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                             nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING |
+                             FILE_FLAG_WRITE_THROUGH | FILE_FLAG_OVERLAPPED, nullptr);
+    }
+
+    SetupDiDestroyDeviceInfoList(info);
+
+    return handle_ != INVALID_HANDLE_VALUE;
+}
+
+void bus_device::close()
+{
+    if (handle_ != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(handle_);
+        handle_ = INVALID_HANDLE_VALUE;
+    }
+}
+
+bool bus_device::ioctl(DWORD code, const void* in, size_t inSize, void* out, size_t outSize, DWORD* returned)
+{
+    static thread_local thread_event event;
+
+    // 事件句柄最低位置 1：句柄关联了完成端口时，同步请求的完成包不进端口
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = reinterpret_cast<HANDLE>(reinterpret_cast<ULONG_PTR>(event.handle) | 1);
+
+    DWORD transferred = 0;
+    BOOL ok = DeviceIoControl(handle_, code, const_cast<void*>(in), static_cast<DWORD>(inSize),
+                              out, static_cast<DWORD>(outSize), &transferred, &overlapped);
+
+    if (!ok && GetLastError() == ERROR_IO_PENDING)
+        ok = GetOverlappedResult(handle_, &overlapped, &transferred, TRUE);
+
+    if (returned)
+        *returned = transferred;
+
+    return ok != FALSE;
+}
+
+bool bus_device::ioctl_async(DWORD code, const void* in, size_t inSize, void* out, size_t outSize, io_pool::request& request)
+{
+    request.overlapped = {};
+
+    // 同步完成时完成包同样会进端口
+    if (DeviceIoControl(handle_, code, const_cast<void*>(in), static_cast<DWORD>(inSize),
+                        out, static_cast<DWORD>(outSize), nullptr, &request.overlapped))
+        return true;
+
+    return GetLastError() == ERROR_IO_PENDING;
+}
+
+void bus_device::cancel(io_pool::request& request)
+{
+    CancelIoEx(handle_, &request.overlapped);
+}
@@ -0,0 +1,40 @@
+﻿#pragma once
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <winioctl.h>
+#include <cstddef>
+
+#include "io_pool.h"
+
+//
+// 直接打开 ViGEmBus 的设备接口，用于 ViGEmClient 没有封装的扩展 IOCTL
+//
+// 句柄以 overlapped 方式打开：ioctl() 同步等待完成；bind 到 io_pool 之后
+// 可以用 ioctl_async() 挂起请求，同一句柄上的同步 ioctl() 不受影响。
+// 驱动按进程判断 target 归属，与 ViGEmClient 的句柄在同一进程内即可互通。
+//
+class bus_device
+{
+public:
+    bus_device() = default;
+    ~bus_device() { close(); }
+
+    bus_device(const bus_device&) = delete;
+    bus_device& operator=(const bus_device&) = delete;
+
+    bool open();
+    void close();
+
+    // 同步 IOCTL，可多线程并发调用；失败时返回 false，错误码见 GetLastError
+    bool ioctl(DWORD code, const void* in, size_t inSize, void* out, size_t outSize, DWORD* returned = nullptr);
+
+    // 异步 IOCTL：句柄须已 bind 到 io_pool，完成（包括取消）时回调 request.owner；
+    // 返回 false 表示请求没有发出去。缓冲在完成前必须有效
+    bool ioctl_async(DWORD code, const void* in, size_t inSize, void* out, size_t outSize, io_pool::request& request);
+    void cancel(io_pool::request& request);
+
+    HANDLE handle() const { return handle_; }
+
+private:
+    HANDLE handle_ = INVALID_HANDLE_VALUE;
+};
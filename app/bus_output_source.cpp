@@ -0,0 +1,54 @@
+﻿#include "bus_output_source.h"
+
+bus_output_source::~bus_output_source()
+{
+    if (port_)
+        CloseHandle(port_);
+}
+
+bool bus_output_source::open()
+{
+    port_ = CreateIoCompletionPort(bus_.handle(), nullptr, 0, 1);
+    return port_ != nullptr;
+}
+
+bool bus_output_source::post(unsigned slot)
+{
+    request& r = requests_[slot];
+    r.overlapped = {};
+    r.buffer = {};
+    r.buffer.Size = sizeof(DS5_AWAIT_OUTPUT);
+
+    // 同步完成时完成包同样会进端口，由 wait() 统一取回
+    if (DeviceIoControl(bus_.handle(), IOCTL_DS5_AWAIT_OUTPUT_AVAILABLE,
+                        &r.buffer, sizeof(r.buffer), &r.buffer, sizeof(r.buffer), nullptr, &r.overlapped))
+        return true;
+
+    return GetLastError() == ERROR_IO_PENDING;
+}
+
+bool bus_output_source::wait(completion& done)
+{
+    DWORD transferred = 0;
+    ULONG_PTR key = 0;
+    LPOVERLAPPED overlapped = nullptr;
+
+    const BOOL ok = GetQueuedCompletionStatus(port_, &transferred, &key, &overlapped, INFINITE);
+    if (!overlapped)
+        return false;
+
+    const auto r = CONTAINING_RECORD(overlapped, request, overlapped);
+    done.slot = static_cast<unsigned>(r - requests_);
+    done.ok = ok && transferred == sizeof(DS5_AWAIT_OUTPUT);
+    if (done.ok)
+    {
+        done.serial = r->buffer.SerialNo;
+        done.report = r->buffer.Report;
+    }
+    return true;
+}
+
+void bus_output_source::cancel()
+{
+    CancelIoEx(bus_.handle(), nullptr);
+}
@@ -0,0 +1,42 @@
+﻿#pragma once
+#include "bus_device.h"
+#include "output_receiver.h"
+
+#include <ViGEm/km/BusShared.h>
+
+//
+// 在 ViGEmBus 句柄上挂起 DEPTH 个 IOCTL_DS5_AWAIT_OUTPUT_AVAILABLE，
+// 完成通过 I/O 完成端口取回
+//
+// 句柄要单独打开：关联完成端口后，该句柄上所有 overlapped 请求的完成都会进端口。
+//
+class bus_output_source : public output_source
+{
+public:
+    static constexpr unsigned DEPTH = 8;
+
+    explicit bus_output_source(bus_device& bus) : bus_(bus) {}
+    ~bus_output_source() override;
+
+    bus_output_source(const bus_output_source&) = delete;
+    bus_output_source& operator=(const bus_output_source&) = delete;
+
+    // 创建完成端口并关联句柄
+    bool open();
+
+    unsigned capacity() const override { return DEPTH; }
+    bool post(unsigned slot) override;
+    bool wait(completion& done) override;
+    void cancel() override;
+
+private:
+    struct request
+    {
+        OVERLAPPED overlapped;
+        DS5_AWAIT_OUTPUT buffer;
+    };
+
+    bus_device& bus_;
+    HANDLE port_ = nullptr;
+    request requests_[DEPTH] = {};
+};
@@ -0,0 +1,90 @@
+﻿#include "cpu_features.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_FEATURES_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define CPU_FEATURES_ARM64 1
+#if defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+namespace
+{
+#if defined(CPU_FEATURES_X86)
+    void cpuid(int leaf, int subleaf, int regs[4])
+    {
+#if defined(_MSC_VER)
+        __cpuidex(regs, leaf, subleaf);
+#else
+        unsigned int a, b, c, d;
+        __cpuid_count(leaf, subleaf, a, b, c, d);
+        regs[0] = static_cast<int>(a);
+        regs[1] = static_cast<int>(b);
+        regs[2] = static_cast<int>(c);
+        regs[3] = static_cast<int>(d);
+#endif
+    }
+
+    unsigned long long xgetbv0()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        unsigned int eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+    }
+#endif
+
+    cpu_features detect()
+    {
+        cpu_features f = {};
+
+#if defined(CPU_FEATURES_X86)
+        int regs[4];
+        cpuid(0, 0, regs);
+        const int maxLeaf = regs[0];
+
+        cpuid(1, 0, regs);
+        f.sse41 = (regs[2] & (1 << 19)) != 0;
+        f.pclmul = (regs[2] & (1 << 1)) != 0;
+
+        // AVX2 还需要操作系统保存 YMM 状态 (OSXSAVE + XCR0[2:1])
+        const bool osxsave = (regs[2] & (1 << 27)) != 0;
+        if (maxLeaf >= 7 && osxsave && (xgetbv0() & 0x6) == 0x6)
+        {
+            cpuid(7, 0, regs);
+            f.avx2 = (regs[1] & (1 << 5)) != 0;
+        }
+#elif defined(CPU_FEATURES_ARM64)
+        // ARMv8-A 必定带 AdvSIMD
+        f.neon = true;
+#if defined(_WIN32)
+        f.pmull = IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE) != FALSE;
+#elif defined(__linux__)
+        f.pmull = (getauxval(AT_HWCAP) & HWCAP_PMULL) != 0;
+#endif
+#endif
+
+        return f;
+    }
+}
+
+const cpu_features& get_cpu_features()
+{
+    static const cpu_features features = detect();
+    return features;
+}
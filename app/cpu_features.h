@@ -0,0 +1,15 @@
+﻿#pragma once
+
+//
+// 运行时 CPU 指令集探测，供 CRC / 音频等热路径选择内核
+//
+struct cpu_features
+{
+    bool sse41;
+    bool pclmul;
+    bool avx2;
+    bool neon;
+    bool pmull;
+};
+
+const cpu_features& get_cpu_features();
@@ -0,0 +1,471 @@
+﻿#include "crc32.h"
+#include "cpu_features.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CRC32_HAVE_CLMUL 1
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#elif (defined(_M_ARM64) || defined(__aarch64__))
+#define CRC32_HAVE_PMULL 1
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CRC32_TARGET(x) __attribute__((target(x)))
+#else
+#define CRC32_TARGET(x)
+#endif
+
+namespace
+{
+    constexpr uint32_t CRC32_POLY = 0xEDB88320;
+
+    //
+    // slicing-by-8 查表：t[0] 为经典逐字节表，t[k] 为后移 k 字节的表
+    //
+    struct crc32_tables
+    {
+        uint32_t t[8][256];
+    };
+
+    constexpr crc32_tables make_tables()
+    {
+        crc32_tables tables = {};
+
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc >> 1) ^ (CRC32_POLY & (0u - (crc & 1)));
+            tables.t[0][i] = crc;
+        }
+
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            for (int k = 1; k < 8; k++)
+            {
+                const uint32_t prev = tables.t[k - 1][i];
+                tables.t[k][i] = (prev >> 8) ^ tables.t[0][prev & 0xFF];
+            }
+        }
+
+        return tables;
+    }
+
+    constexpr crc32_tables TABLES = make_tables();
+
+    inline uint32_t load_le32(const uint8_t* p)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    uint32_t crc32_slice8(uint32_t crc, const uint8_t* data, size_t size)
+    {
+        const auto& t = TABLES.t;
+
+        while (size >= 8)
+        {
+            const uint32_t one = load_le32(data) ^ crc;
+            const uint32_t two = load_le32(data + 4);
+
+            crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^
+                  t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24] ^
+                  t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^
+                  t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+
+            data += 8;
+            size -= 8;
+        }
+
+        while (size--)
+            crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+
+        return crc;
+    }
+
+    //
+    // 折叠内核至少需要 64 字节，且只处理 16 字节整数倍，尾部交给查表。
+    // 常数来自 Intel 白皮书 "Fast CRC Computation for Generic Polynomials
+    // Using PCLMULQDQ Instruction" 的反射域版本 (与 zlib/chromium 相同)。
+    //
+    constexpr size_t CLMUL_MIN_LENGTH = 64;
+
+    alignas(16) constexpr uint64_t K1K2[2] = { 0x0154442bd4, 0x01c6e41596 };
+    alignas(16) constexpr uint64_t K3K4[2] = { 0x01751997d0, 0x00ccaa009e };
+    alignas(16) constexpr uint64_t K5K0[2] = { 0x0163cd6124, 0x0000000000 };
+    alignas(16) constexpr uint64_t POLY[2] = { 0x01db710641, 0x01f7011641 };
+
+#if defined(CRC32_HAVE_CLMUL)
+    CRC32_TARGET("pclmul,sse4.1")
+    uint32_t crc32_clmul(uint32_t crc, const uint8_t* buf, size_t len)
+    {
+        __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+        x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x00));
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x10));
+        x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x20));
+        x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x30));
+
+        x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(K1K2));
+
+        buf += 64;
+        len -= 64;
+
+        // 4 路并行折叠，每轮 64 字节
+        while (len >= 64)
+        {
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+            x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+            x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+            x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+            x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+            y5 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x00));
+            y6 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x10));
+            y7 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x20));
+            y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x30));
+
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+            x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+            x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+            x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+            buf += 64;
+            len -= 64;
+        }
+
+        // 4 路合并为 128 位
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(K3K4));
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+        // 剩余的 16 字节块
+        while (len >= 16)
+        {
+            x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+            buf += 16;
+            len -= 16;
+        }
+
+        // 128 -> 64 位
+        x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+        x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+        x1 = _mm_srli_si128(x1, 8);
+        x1 = _mm_xor_si128(x1, x2);
+
+        x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(K5K0));
+
+        x2 = _mm_srli_si128(x1, 4);
+        x1 = _mm_and_si128(x1, x3);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        // Barrett 约减到 32 位
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(POLY));
+
+        x2 = _mm_and_si128(x1, x3);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+        x2 = _mm_and_si128(x2, x3);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+    }
+#endif
+
+#if defined(CRC32_HAVE_PMULL)
+    //
+    // 与 PCLMULQDQ 版本逐条对应：imm 0x00 = lo*lo, 0x11 = hi*hi, 0x10 = a.lo*b.hi
+    //
+    CRC32_TARGET("+crypto")
+    inline uint64x2_t clmul_00(uint64x2_t a, uint64x2_t b)
+    {
+        return vreinterpretq_u64_p128(vmull_p64(
+            static_cast<poly64_t>(vgetq_lane_u64(a, 0)),
+            static_cast<poly64_t>(vgetq_lane_u64(b, 0))));
+    }
+
+    CRC32_TARGET("+crypto")
+    inline uint64x2_t clmul_11(uint64x2_t a, uint64x2_t b)
+    {
+        return vreinterpretq_u64_p128(vmull_p64(
+            static_cast<poly64_t>(vgetq_lane_u64(a, 1)),
+            static_cast<poly64_t>(vgetq_lane_u64(b, 1))));
+    }
+
+    CRC32_TARGET("+crypto")
+    inline uint64x2_t clmul_10(uint64x2_t a, uint64x2_t b)
+    {
+        return vreinterpretq_u64_p128(vmull_p64(
+            static_cast<poly64_t>(vgetq_lane_u64(a, 0)),
+            static_cast<poly64_t>(vgetq_lane_u64(b, 1))));
+    }
+
+    inline uint64x2_t shift_right_bytes(uint64x2_t v, int bytes)
+    {
+        const uint8x16_t zero = vdupq_n_u8(0);
+        const uint8x16_t in = vreinterpretq_u8_u64(v);
+        return vreinterpretq_u64_u8(bytes == 8 ? vextq_u8(in, zero, 8) : vextq_u8(in, zero, 4));
+    }
+
+    CRC32_TARGET("+crypto")
+    uint32_t crc32_pmull(uint32_t crc, const uint8_t* buf, size_t len)
+    {
+        uint64x2_t x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+        x1 = vld1q_u64(reinterpret_cast<const uint64_t*>(buf + 0x00));
+        x2 = vld1q_u64(reinterpret_cast<const uint64_t*>(buf + 0x10));
+        x3 = vld1q_u64(reinterpret_cast<const uint64_t*>(buf + 0x20));
+        x4 = vld1q_u64(reinterpret_cast<const uint64_t*>(buf + 0x30));
+
+        x1 = veorq_u64(x1, vsetq_lane_u64(crc, vdupq_n_u64(0), 0));
+
+        x0 = vld1q_u64(K1K2);
+
+        buf += 64;
+        len -= 64;
+
+        while (len >= 64)
+        {
+            x5 = clmul_00(x1, x0);
+            x6 = clmul_00(x2, x0);
+            x7 = clmul_00(x3, x0);
+            x8 = clmul_00(x4, x0);
+
+            x1 = clmul_11(x1, x0);
+            x2 = clmul_11(x2, x0);
+            x3 = clmul_11(x3, x0);
+            x4 = clmul_11(x4, x0);
+
+            y5 = vld1q_u64(reinterpret_cast<const uint64_t*>(buf + 0x00));
+            y6 = vld1q_u64(reinterpret_cast<const uint64_t*>(buf + 0x10));
+            y7 = vld1q_u64(reinterpret_cast<const uint64_t*>(buf + 0x20));
+            y8 = vld1q_u64(reinterpret_cast<const uint64_t*>(buf + 0x30));
+
+            x1 = veorq_u64(veorq_u64(x1, x5), y5);
+            x2 = veorq_u64(veorq_u64(x2, x6), y6);
+            x3 = veorq_u64(veorq_u64(x3, x7), y7);
+            x4 = veorq_u64(veorq_u64(x4, x8), y8);
+
+            buf += 64;
+            len -= 64;
+        }
+
+        x0 = vld1q_u64(K3K4);
+
+        x5 = clmul_00(x1, x0);
+        x1 = clmul_11(x1, x0);
+        x1 = veorq_u64(veorq_u64(x1, x2), x5);
+
+        x5 = clmul_00(x1, x0);
+        x1 = clmul_11(x1, x0);
+        x1 = veorq_u64(veorq_u64(x1, x3), x5);
+
+        x5 = clmul_00(x1, x0);
+        x1 = clmul_11(x1, x0);
+        x1 = veorq_u64(veorq_u64(x1, x4), x5);
+
+        while (len >= 16)
+        {
+            x2 = vld1q_u64(reinterpret_cast<const uint64_t*>(buf));
+
+            x5 = clmul_00(x1, x0);
+            x1 = clmul_11(x1, x0);
+            x1 = veorq_u64(veorq_u64(x1, x2), x5);
+
+            buf += 16;
+            len -= 16;
+        }
+
+        x2 = clmul_10(x1, x0);
+        x3 = vdupq_n_u64(0x00000000FFFFFFFFull);
+        x1 = shift_right_bytes(x1, 8);
+        x1 = veorq_u64(x1, x2);
+
+        x0 = vld1q_u64(K5K0);
+
+        x2 = shift_right_bytes(x1, 4);
+        x1 = vandq_u64(x1, x3);
+        x1 = clmul_00(x1, x0);
+        x1 = veorq_u64(x1, x2);
+
+        x0 = vld1q_u64(POLY);
+
+        x2 = vandq_u64(x1, x3);
+        x2 = clmul_10(x2, x0);
+        x2 = vandq_u64(x2, x3);
+        x2 = clmul_00(x2, x0);
+        x1 = veorq_u64(x1, x2);
+
+        return vgetq_lane_u32(vreinterpretq_u32_u64(x1), 1);
+    }
+#endif
+
+    //
+    // GF(2) 多项式乘法（反射域，bit31 为 x^0），取自 zlib 的 multmodp
+    //
+    constexpr uint32_t multmodp(uint32_t a, uint32_t b)
+    {
+        uint32_t m = 1u << 31;
+        uint32_t p = 0;
+
+        for (;;)
+        {
+            if (a & m)
+            {
+                p ^= b;
+                if ((a & (m - 1)) == 0)
+                    break;
+            }
+            m >>= 1;
+            b = (b & 1) ? (b >> 1) ^ CRC32_POLY : b >> 1;
+        }
+
+        return p;
+    }
+
+    // x2n[k] = x^(2^k) mod P
+    struct crc32_x2n_table
+    {
+        uint32_t t[32];
+    };
+
+    constexpr crc32_x2n_table make_x2n_table()
+    {
+        crc32_x2n_table table = {};
+        uint32_t p = 1u << 30; // x^1
+
+        table.t[0] = p;
+        for (int n = 1; n < 32; n++)
+            table.t[n] = p = multmodp(p, p);
+
+        return table;
+    }
+
+    constexpr crc32_x2n_table X2N = make_x2n_table();
+
+    // x^(8 * length) mod P
+    uint32_t x8nmodp(size_t length)
+    {
+        uint32_t p = 1u << 31; // x^0
+        unsigned k = 3;
+
+        while (length)
+        {
+            if (length & 1)
+                p = multmodp(X2N.t[k & 31], p);
+            length >>= 1;
+            k++;
+        }
+
+        return p;
+    }
+
+    using crc32_fold_fn = uint32_t(*)(uint32_t, const uint8_t*, size_t);
+
+    struct crc32_kernel
+    {
+        crc32_fold_fn fold;
+        const char* name;
+    };
+
+    crc32_kernel select_kernel()
+    {
+        const auto& cpu = get_cpu_features();
+
+#if defined(CRC32_HAVE_CLMUL)
+        if (cpu.pclmul && cpu.sse41)
+            return { crc32_clmul, "pclmul" };
+#elif defined(CRC32_HAVE_PMULL)
+        if (cpu.pmull)
+            return { crc32_pmull, "pmull" };
+#endif
+        (void)cpu;
+        return { nullptr, "slice8" };
+    }
+
+    const crc32_kernel& kernel()
+    {
+        static const crc32_kernel selected = select_kernel();
+        return selected;
+    }
+}
+
+uint32_t crc32_update(uint32_t state, const uint8_t* data, size_t size)
+{
+    const auto& k = kernel();
+
+    if (k.fold != nullptr && size >= CLMUL_MIN_LENGTH)
+    {
+        const size_t folded = size & ~static_cast<size_t>(15);
+        state = k.fold(state, data, folded);
+        data += folded;
+        size -= folded;
+    }
+
+    return crc32_slice8(state, data, size);
+}
+
+const char* crc32_kernel_name()
+{
+    return kernel().name;
+}
+
+uint32_t crc32_shift(uint32_t state, size_t length)
+{
+    return length ? multmodp(x8nmodp(length), state) : state;
+}
+
+uint32_t crc32_combine(uint32_t state, uint32_t crcB, size_t lengthB)
+{
+    return crc32_shift(state, lengthB) ^ crcB;
+}
+
+uint32_t crc32_patch(uint32_t state, const uint8_t* oldData, const uint8_t* newData, size_t size, size_t trailing)
+{
+    const auto& t = TABLES.t;
+    uint32_t delta = 0;
+
+    for (size_t i = 0; i < size; i++)
+        delta = (delta >> 8) ^ t[0][(delta ^ oldData[i] ^ newData[i]) & 0xFF];
+
+    return state ^ crc32_shift(delta, trailing);
+}
+
+crc32_shifter::crc32_shifter(size_t length) : table_{}
+{
+    const uint32_t op = x8nmodp(length);
+
+    // 线性算子：按字节拆开后各自预乘
+    for (int lane = 0; lane < 4; lane++)
+    {
+        for (uint32_t v = 0; v < 256; v++)
+            table_[lane][v] = multmodp(op, v << (8 * lane));
+    }
+}
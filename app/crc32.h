@@ -0,0 +1,50 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+//
+// CRC-32 (IEEE 802.3, 反射多项式 0xEDB88320)
+//
+// 这里的 state 是未取反的原始寄存器值：标准 CRC-32 的初值是 0xFFFFFFFF，
+// 结果再取反。DualSense 蓝牙报文的 0xA2 种子就是先喂一个 0xA2 字节后的状态。
+//
+uint32_t crc32_update(uint32_t state, const uint8_t* data, size_t size);
+
+// 当前运行时选中的内核名称（pclmul / pmull / slice8）
+const char* crc32_kernel_name();
+
+//
+// 增量 / 组合运算（GF(2) 上乘 x^(8n) mod P）
+//
+// crc32_update 对 state 是线性的：
+//   update(s, A || B) == combine(update(s, A), update(0, B), |B|)
+// 因此缓存固定前缀后的状态，或只改动报文中某个字段时，都不必重算整帧。
+//
+
+// 等价于再喂 length 个 0x00 字节，O(log length)
+uint32_t crc32_shift(uint32_t state, size_t length);
+
+// state 为 A 之后的寄存器，crcB 为以 0 为初值对 B 计算的寄存器
+uint32_t crc32_combine(uint32_t state, uint32_t crcB, size_t lengthB);
+
+// 报文中 size 字节的字段由 oldData 改为 newData，字段之后还有 trailing 字节参与校验
+uint32_t crc32_patch(uint32_t state, const uint8_t* oldData, const uint8_t* newData, size_t size, size_t trailing);
+
+//
+// 固定长度的移位算子：构造时把 x^(8n) mod P 展开成 4x256 表，
+// 之后每次移位只需 4 次查表，适合报文里位置固定的字段
+//
+class crc32_shifter
+{
+public:
+    explicit crc32_shifter(size_t length);
+
+    uint32_t operator()(uint32_t state) const
+    {
+        return table_[0][state & 0xFF] ^ table_[1][(state >> 8) & 0xFF] ^
+               table_[2][(state >> 16) & 0xFF] ^ table_[3][state >> 24];
+    }
+
+private:
+    uint32_t table_[4][256];
+};
@@ -0,0 +1,527 @@
+﻿#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include "ds5_session.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <ViGEm/Client.h>
+#include <Ds5ReportFilter.h>
+#include "latency_histogram.h"
+#include "utils.h"
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+    // 统计输出周期
+    constexpr auto INPUT_STATS_PERIOD = seconds(5);
+
+    //
+    // 变化抑制：只有易变字段（序号、时间戳、IMU、CMAC）变化的报文不发 IOCTL，
+    // 但至少每 INPUT_KEEPALIVE 发一次，驱动轮询定时器（默认 6 ms，注册表
+    // PollingIntervalMs 可设 1-16 ms）送出的 IMU 不会过旧。
+    // 驱动侧按注册表 InputSignificantFields 做同样的判断。
+    //
+    constexpr unsigned long INPUT_SIGNIFICANT_FIELDS = 0;
+    constexpr auto INPUT_KEEPALIVE = milliseconds(6);
+
+    //
+    // 输入转发统计（steady_clock 在 Windows 上就是 QPC，与驱动的
+    // KeQueryPerformanceCounter 同一时间轴）
+    //
+    // interval: 相邻两帧到达的间隔，反映手柄实际回报率
+    // decode:   hid_read 返回 -> 调用 vigem_target_DS5_update
+    // submit:   vigem_target_DS5_update 调用 -> 返回（IOCTL 往返，含驱动 SubmitReportImpl）；
+    //           批量模式下只是放入槽位，IOCTL 往返见 [Batch] 统计；共享槽位模式下是一次内存写
+    //
+    // 驱动侧 SubmitReportImpl -> URB 完成的分位数通过 WPP 输出
+    //
+    struct input_stats
+    {
+        const unsigned index;
+        latency_histogram interval;
+        latency_histogram decode;
+        latency_histogram submit;
+        uint64_t overlapped = 0;  // 到达时写线程正在 hid_write
+        uint64_t avoided = 0;     // 未变化而省掉的 IOCTL
+        steady_clock::time_point windowStart = steady_clock::now();
+        steady_clock::time_point lastArrival = {};
+
+        explicit input_stats(unsigned index) : index(index) {}
+
+        void arrived(steady_clock::time_point now)
+        {
+            if (lastArrival.time_since_epoch().count() != 0)
+                interval.record(duration_cast<nanoseconds>(now - lastArrival).count());
+            lastArrival = now;
+        }
+
+        void forwarded(steady_clock::time_point arrival, steady_clock::time_point call)
+        {
+            decode.record(duration_cast<nanoseconds>(call - arrival).count());
+            submit.record(duration_cast<nanoseconds>(steady_clock::now() - call).count());
+        }
+
+        void report(steady_clock::time_point now)
+        {
+            if (now - windowStart < INPUT_STATS_PERIOD)
+                return;
+
+            const double seconds = duration<double>(now - windowStart).count();
+            char line[384];
+            snprintf(line, sizeof(line),
+                "[Input#%u] %.1f Hz | interval p50 %.2f ms p99 %.2f ms max %.2f ms"
+                " | decode p50/p99/p999 %.1f/%.1f/%.1f us | submit p50/p99/p999 %.1f/%.1f/%.1f us | overlapped %llu avoided %llu",
+                index, interval.count() / seconds,
+                interval.percentile(0.50) / 1e6, interval.percentile(0.99) / 1e6, interval.max() / 1e6,
+                decode.percentile(0.50) / 1e3, decode.percentile(0.99) / 1e3, decode.percentile(0.999) / 1e3,
+                submit.percentile(0.50) / 1e3, submit.percentile(0.99) / 1e3, submit.percentile(0.999) / 1e3,
+                static_cast<unsigned long long>(overlapped), static_cast<unsigned long long>(avoided));
+            cout << line << endl;
+
+            interval.reset();
+            decode.reset();
+            submit.reset();
+            overlapped = 0;
+            avoided = 0;
+            windowStart = now;
+        }
+    };
+}
+
+//
+// 输入转发的状态，只在读请求的完成回调里访问
+//
+struct ds5_session::input_state
+{
+    input_stats stats;
+    const ViGEm::Reports::Ds5ReportFilter filter{ INPUT_SIGNIFICANT_FIELDS };
+    DS5_REPORT lastSent = {};
+    steady_clock::time_point lastSentAt = {};
+
+    explicit input_state(unsigned index) : stats(index) {}
+};
+
+ds5_session::ds5_session(unsigned index, PVIGEM_CLIENT client, unique_ptr<hid_device_io> device,
+                         io_pool& pool, bus_device& pooledBus,
+                         hid_writer& writer, sink_worker& hapticsWorker, sink_worker& recordWorker,
+                         const session_channels& channels)
+    : index_(index),
+      client_(client),
+      device_(move(device)),
+      pool_(pool),
+      pooledBus_(pooledBus),
+      writer_(writer),
+      channels_(channels),
+      inputState_(make_unique<input_state>(index)),
+      hapticsWorker_(hapticsWorker),
+      recordWorker_(recordWorker)
+{
+    outputRequest_.owner = &output_;
+}
+
+ds5_session::~ds5_session()
+{
+    stop();
+
+    if (target_)
+    {
+        if (added_)
+            vigem_target_remove(client_, target_);
+        vigem_target_free(target_);
+    }
+}
+
+bool ds5_session::start()
+{
+    // HID 读请求的完成走共享池
+    if (!device_->bind(pool_))
+    {
+        cerr << "[Session#" << index_ << "] Failed to bind the HID device to the I/O pool." << endl;
+        return false;
+    }
+
+    // 初始化 ViGEmBus 虚拟设备
+    target_ = vigem_target_DS5_alloc();
+
+    // busenum.cpp -> Bus_PlugInDevice
+    const auto error = vigem_target_add(client_, target_);
+    if (!VIGEM_SUCCESS(error))
+    {
+        DWORD win32 = ::GetLastError();
+        wcerr << L"vigem_target_add failed. GetLastError="
+            << win32 << L" (" << Win32ErrorToString(win32) << L")\n";
+        return false;
+    }
+    added_ = true;
+
+    // 共享槽位挂不上时退回批量提交，批量槽位用完时退回直接提交
+    serial_ = vigem_target_get_index(target_);
+    if (channels_.slotBus)
+    {
+        sharedSlot_ = make_unique<shared_input_slot>(*channels_.slotBus);
+        if (!sharedSlot_->attach(serial_))
+            sharedSlot_.reset();
+    }
+    if (!sharedSlot_ && channels_.batcher)
+        inputSlot_ = channels_.batcher->open_slot(serial_);
+
+    // 每个手柄的输出报文和振动报文各占写线程的一个通道
+    outputChannel_ = writer_.open_channel(*device_);
+    hapticsChannel_ = writer_.open_channel(*device_);
+    if (!outputChannel_ || !hapticsChannel_)
+    {
+        cerr << "[Session#" << index_ << "] No free HID writer channel." << endl;
+        return false;
+    }
+
+    // 音频消费者要在音频请求挂上之前登记
+    audio_ = make_unique<audio_handler>(serial_, index_, pooledBus_, channels_.audioRingBus);
+    audio_ring& hapticsRing = audio_->open_sink();
+    audio_ring& recorderRing = audio_->open_sink();
+    hapticsRing.attach(hapticsWorker_.doorbell());
+    recorderRing.attach(recordWorker_.doorbell());
+
+    if (channels_.outputReceiver)
+    {
+        channels_.outputReceiver->subscribe(serial_, [this](const DS5_OUTPUT_BUFFER& out) { forward_output(out); });
+        outputSubscribed_ = true;
+    }
+
+    haptics_ = make_unique<haptics_handler>(hapticsRing, hapticsChannel_, index_);
+    recorder_ = make_unique<audio_recorder>(recorderRing, "DS5_audio_out_" + to_string(index_) + ".wav");
+    hapticsWorker_.add(haptics_.get());
+    recordWorker_.add(recorder_.get());
+
+    // 输出和音频等不到只影响该方向，输入读不了会话就没有意义
+    if (!outputSubscribed_ && !output_.start())
+        cerr << "[Session#" << index_ << "] Failed to await output reports, GetLastError=" << GetLastError() << endl;
+    if (!audio_->start())
+        cerr << "[Session#" << index_ << "] Failed to await audio data, GetLastError=" << GetLastError() << endl;
+
+    if (!input_.start())
+    {
+        wcerr << "[Session#" << index_ << "] HID READ ERROR: " << device_->read_error() << endl;
+        return false;
+    }
+    return true;
+}
+
+void ds5_session::stop()
+{
+    // 取消挂起的请求并等回调返回
+    if (audio_)
+        audio_->stop();
+    output_.stop();
+    input_.stop();
+
+    // 之后不会再有回调往写线程提交
+    if (outputSubscribed_)
+    {
+        channels_.outputReceiver->unsubscribe(serial_);
+        outputSubscribed_ = false;
+    }
+
+    // 读请求已停，驱动不会再读到新报文
+    if (sharedSlot_)
+        sharedSlot_->detach();
+
+    if (inputSlot_)
+    {
+        channels_.batcher->close_slot(inputSlot_);
+        inputSlot_ = nullptr;
+    }
+
+    if (haptics_)
+    {
+        hapticsWorker_.remove(haptics_.get());
+        haptics_.reset();
+    }
+
+    if (recorder_)
+    {
+        recordWorker_.remove(recorder_.get());
+        cout << "[Session#" << index_ << "] Closing WAV file." << endl;
+        recorder_->close();
+        recorder_.reset();
+    }
+
+    // 振动和输出都不再提交，归还通道后写线程不会再碰 device_
+    writer_.close_channel(hapticsChannel_);
+    writer_.close_channel(outputChannel_);
+    hapticsChannel_ = nullptr;
+    outputChannel_ = nullptr;
+}
+
+bool ds5_session::input_loop::issue()
+{
+    return session_.device_->read_async(session_.inputBuffer_, sizeof(session_.inputBuffer_), *this);
+}
+
+void ds5_session::input_loop::cancel()
+{
+    session_.device_->cancel_read();
+}
+
+bool ds5_session::input_loop::completed(bool ok, size_t transferred)
+{
+    // 读失败多半是手柄断开，会话到此结束
+    if (!ok)
+    {
+        wcerr << "[Session#" << session_.index_ << "] HID READ ERROR: " << session_.device_->read_error() << endl;
+        return false;
+    }
+
+    session_.forward_input(session_.inputBuffer_, transferred);
+    return true;
+}
+
+bool ds5_session::output_loop::issue()
+{
+    session_.outputAwait_ = {};
+    session_.outputAwait_.Size = sizeof(DS5_AWAIT_OUTPUT);
+    session_.outputAwait_.SerialNo = session_.serial_;
+
+    return session_.pooledBus_.ioctl_async(IOCTL_DS5_AWAIT_OUTPUT_AVAILABLE,
+                                           &session_.outputAwait_, sizeof(DS5_AWAIT_OUTPUT),
+                                           &session_.outputAwait_, sizeof(DS5_AWAIT_OUTPUT), session_.outputRequest_);
+}
+
+void ds5_session::output_loop::cancel()
+{
+    session_.pooledBus_.cancel(session_.outputRequest_);
+}
+
+bool ds5_session::output_loop::completed(bool ok, size_t transferred)
+{
+    if (!ok || transferred != sizeof(DS5_AWAIT_OUTPUT))
+    {
+        cerr << "[Session#" << session_.index_ << "] Await output report failed." << endl;
+        return false;
+    }
+
+    session_.forward_output(session_.outputAwait_.Report);
+    return true;
+}
+
+void ds5_session::forward_input(uint8_t* buf, size_t read)
+{
+    input_state& state = *inputState_;
+    const auto arrival = steady_clock::now();
+
+    if (read > 1)
+    {
+        switch (buf[0])
+        {
+        case 0x31:
+            {
+                state.stats.arrived(arrival);
+                if (outputChannel_->busy())
+                    state.stats.overlapped++;
+
+                // cout << "Receive Input Report: " << hexStr(buf,78) << endl;
+                DS5_REPORT report;
+                RtlZeroMemory(&report, sizeof(DS5_REPORT));
+                RtlCopyMemory(&report, buf + 2, min(sizeof(DS5_REPORT), read - 2));
+
+                // 共享槽位只是一次内存写，不需要省
+                if (sharedSlot_)
+                {
+                    const auto call = steady_clock::now();
+                    sharedSlot_->publish(report);
+                    state.stats.forwarded(arrival, call);
+                    break;
+                }
+
+                if (arrival - state.lastSentAt < INPUT_KEEPALIVE &&
+                    !state.filter.Changed(reinterpret_cast<const uint8_t*>(&state.lastSent), reinterpret_cast<const uint8_t*>(&report)))
+                {
+                    state.stats.avoided++;
+                    break;
+                }
+
+                const auto call = steady_clock::now();
+                if (inputSlot_)
+                {
+                    channels_.batcher->post(inputSlot_, report);
+                }
+                else
+                {
+                    auto error = vigem_target_DS5_update(client_, target_, report);
+                    if (!VIGEM_SUCCESS(error))
+                    {
+                        cerr << "[App] Failed to send DS5 report." << endl;
+                    }
+                }
+                state.stats.forwarded(arrival, call);
+                state.lastSent = report;
+                state.lastSentAt = arrival;
+                break;
+            }
+        case 0x01:
+            {
+                cout << "Receive 0x01 Input Report: " << hexStr(buf, 63) << endl;
+                break;
+            }
+        default:
+            break;
+        }
+    }
+
+    state.stats.report(arrival);
+}
+
+void ds5_session::send_test_report()
+{
+    DS5_REPORT report;
+    RtlZeroMemory(&report, sizeof(DS5_REPORT));
+
+    // --- Sticks (0x00-0xFF, 0x80 = center) ---
+    report.bThumbLX = 0x7e;
+    report.bThumbLY = 0x81;
+    report.bThumbRX = 0x80;
+    report.bThumbRY = 0x7f;
+
+    // --- Triggers ---
+    report.bTriggerL = 0x00;
+    report.bTriggerR = 0x00;
+
+    // --- Sequence number ---
+    report.bSeqNo = 0x59;
+
+    // --- Byte 7: DPad + face buttons ---
+    report.DPad = 0x8;            // DS5_BUTTON_DPAD_NONE
+    report.ButtonSquare = 0;
+    report.ButtonCross = 0;
+    report.ButtonCircle = 0;
+    report.ButtonTriangle = 0;
+
+    // --- Byte 8: shoulder/trigger/menu/thumbstick ---
+    report.ButtonL1 = 0;
+    report.ButtonR1 = 0;
+    report.ButtonL2 = 0;
+    report.ButtonR2 = 0;
+    report.ButtonCreate = 0;
+    report.ButtonOptions = 0;
+    report.ButtonL3 = 0;
+    report.ButtonR3 = 0;
+
+    // --- Byte 9: special buttons ---
+    report.ButtonHome = 0;
+    report.ButtonPad = 0;
+    report.ButtonMute = 0;
+    report.UNK1 = 0;
+    report.ButtonLeftFunction = 0;
+    report.ButtonRightFunction = 0;
+    report.ButtonLeftPaddle = 0;
+    report.ButtonRightPaddle = 0;
+
+    // --- Byte 10 ---
+    report.bUNK2 = 0x00;
+
+    // --- Counter ---
+    report.ulUNKCounter = 0x787A7C40;
+
+    // --- IMU: Gyroscope ---
+    report.wAngularVelocityX = 0x006B;   // 107
+    report.wAngularVelocityZ = 0x0007;   // 7
+    report.wAngularVelocityY = 0x0004;   // 4
+
+    // --- IMU: Accelerometer ---
+    report.wAccelerometerX = 0x0139;      // 313
+    report.wAccelerometerY = 0x25BC;      // 9660
+    report.wAccelerometerZ = (SHORT)0xEB57;// -5289
+
+    // --- Timestamps & Temperature ---
+    report.ulSensorTimestamp = 0x016BFF84;
+    report.bTemperature = 0x07;
+
+    // --- Touch data (both fingers not touching) ---
+    report.sCurrentTouch.Finger[0].Index = 0;
+    report.sCurrentTouch.Finger[0].NotTouching = 1;
+    report.sCurrentTouch.Finger[0].FingerX = 0;
+    report.sCurrentTouch.Finger[0].FingerY = 0;
+    report.sCurrentTouch.Finger[1].Index = 0;
+    report.sCurrentTouch.Finger[1].NotTouching = 1;
+    report.sCurrentTouch.Finger[1].FingerX = 0;
+    report.sCurrentTouch.Finger[1].FingerY = 0;
+    report.sCurrentTouch.bTimestamp = 0x00;
+
+    // --- Trigger feedback ---
+    report.TriggerRightStopLocation = 9;
+    report.TriggerRightStatus = 0;
+    report.TriggerLeftStopLocation = 9;
+    report.TriggerLeftStatus = 0;
+
+    // --- Host timestamp ---
+    report.ulHostTimestamp = 0x00000000;
+
+    // --- Active trigger effects ---
+    report.TriggerRightEffect = 0;
+    report.TriggerLeftEffect = 0;
+
+    // --- Device timestamp ---
+    report.ulDeviceTimeStamp = 0x016C1A97;
+
+    // --- Power ---
+    report.PowerPercent = 9;       // ~90%
+    report.PowerState = 2;
+
+    // --- Byte 53: plugged devices ---
+    report.PluggedHeadphones = 0;
+    report.PluggedMic = 0;
+    report.MicMuted = 0;
+    report.PluggedUsbData = 1;
+    report.PluggedUsbPower = 0;
+    report.UsbPowerOnBT = 0;
+    report.DockDetect = 0;
+    report.PluggedUnk = 0;
+
+    // --- Byte 54 ---
+    report.PluggedExternalMic = 0;
+    report.HapticLowPassFilter = 0;
+    report.PluggedUnk3 = 0;
+
+    // --- AES-CMAC (8 bytes) ---
+    report.bAesCmac[0] = 0x8A;
+    report.bAesCmac[1] = 0x01;
+    report.bAesCmac[2] = 0x58;
+    report.bAesCmac[3] = 0x45;
+    report.bAesCmac[4] = 0x74;
+    report.bAesCmac[5] = 0x2E;
+    report.bAesCmac[6] = 0x75;
+    report.bAesCmac[7] = 0x3D;
+    const auto error = vigem_target_DS5_update(client_, target_, report);
+    if (VIGEM_SUCCESS(error))
+        cout << "[App] DS5 report sent successfully." << endl;
+    else
+        cerr << "[App] Failed to send DS5 report." << endl;
+}
+
+void ds5_session::forward_output(const DS5_OUTPUT_BUFFER& out)
+{
+	cout << "Receive Output Report" << endl;
+	// cout << hexStr(out.Buffer, sizeof(DS5_OUTPUT_BUFFER)) << endl;
+
+	RtlZeroMemory(outputData_, sizeof(outputData_));
+	outputData_[0] = 0x31;
+	outputData_[1] = outputSeq_ << 4;
+	if (++outputSeq_ == 256)
+	{
+		outputSeq_ = 0;
+	}
+	outputData_[2] = 0x10;
+	RtlCopyMemory(outputData_ + 3, out.Buffer + 1, sizeof(DS5_OUTPUT_BUFFER) - 1);
+	outputChecksum_.fill(outputData_);
+
+	// cout << "Send Output Report: ";
+	// cout << hexStr(outputData_, sizeof(outputData_)) << endl;
+
+	if (!outputChannel_->submit(outputData_, sizeof(outputData_)))
+	{
+		cerr << "[App] Output report queue full, report dropped." << endl;
+	}
+}
@@ -0,0 +1,141 @@
+﻿#pragma once
+#include <memory>
+#include <string>
+
+#include "ViGEm/Client.h"
+#include "audio_handler.h"
+#include "bus_device.h"
+#include "haptics_handler.h"
+#include "hid_device_io.h"
+#include "hid_writer.h"
+#include "input_batcher.h"
+#include "io_pool.h"
+#include "output_receiver.h"
+#include "shared_input_slot.h"
+#include "sink_worker.h"
+#include "utils.h"
+
+#include <ViGEm/km/BusShared.h>
+
+//
+// 会话共用的驱动通道，均可为空（退回 ViGEmClient 的逐帧调用）
+//
+struct session_channels
+{
+    input_batcher* batcher = nullptr;
+    // 非空时输入走共享内存槽位
+    bus_device* slotBus = nullptr;
+    output_receiver* outputReceiver = nullptr;
+    // 非空时音频走共享内存环
+    bus_device* audioRingBus = nullptr;
+};
+
+//
+// 一个物理手柄与一个虚拟 DS5 的会话
+//
+// 会话不占线程：HID 读、驱动输出报文（没有 output_receiver 时）、驱动音频都以异步
+// 请求挂在共享的 io_pool 上，各保持一个请求挂起，完成回调里处理后补投。
+// HID 写、振动、录音挂在 session_manager 的共享线程上。
+//
+class ds5_session
+{
+public:
+    // pooledBus 须已 bind 到 pool
+    ds5_session(unsigned index, PVIGEM_CLIENT client, std::unique_ptr<hid_device_io> device,
+                io_pool& pool, bus_device& pooledBus,
+                hid_writer& writer, sink_worker& hapticsWorker, sink_worker& recordWorker,
+                const session_channels& channels = {});
+    ~ds5_session();
+
+    ds5_session(const ds5_session&) = delete;
+    ds5_session& operator=(const ds5_session&) = delete;
+
+    // 插入虚拟 DS5 并挂上异步请求
+    bool start();
+    // 取消挂起的请求、从共享线程上摘下消费者并归还写通道和批量槽位；设备在析构时关闭
+    void stop();
+
+    // HID 读出错（手柄断开）后为 false
+    bool running() { return input_.running(); }
+
+    // 向虚拟 DS5 发一个固定的测试输入报文
+    void send_test_report();
+
+    unsigned index() const { return index_; }
+
+private:
+    // HID 输入报文
+    class input_loop : public io_loop
+    {
+    public:
+        explicit input_loop(ds5_session& session) : session_(session) {}
+
+    private:
+        bool issue() override;
+        void cancel() override;
+        bool completed(bool ok, size_t transferred) override;
+
+        ds5_session& session_;
+    };
+
+    // 没有 output_receiver 时按 SerialNo 等驱动输出报文
+    class output_loop : public io_loop
+    {
+    public:
+        explicit output_loop(ds5_session& session) : session_(session) {}
+
+    private:
+        bool issue() override;
+        void cancel() override;
+        bool completed(bool ok, size_t transferred) override;
+
+        ds5_session& session_;
+    };
+
+    struct input_state;
+
+    // 处理一个 HID 输入报文
+    void forward_input(uint8_t* data, size_t size);
+    // 驱动输出报文转成蓝牙 0x31 报文交给写线程；同一时刻只在一个线程上调用
+    void forward_output(const DS5_OUTPUT_BUFFER& out);
+
+    const unsigned index_;
+    PVIGEM_CLIENT client_;
+    PVIGEM_TARGET target_ = nullptr;
+    ULONG serial_ = 0;
+    bool added_ = false;
+
+    // HID 设备（读写句柄分离）
+    std::unique_ptr<hid_device_io> device_;
+    io_pool& pool_;
+    bus_device& pooledBus_;
+    hid_writer& writer_;
+    hid_writer::channel* outputChannel_ = nullptr;
+    hid_writer::channel* hapticsChannel_ = nullptr;
+
+    // 输入报文提交方式，优先级：共享内存槽位 > 批量提交线程 > 每帧 vigem_target_DS5_update
+    // 输出报文：有 outputReceiver 时由它回调，否则按 SerialNo 逐个等待
+    session_channels channels_;
+    input_batcher::slot* inputSlot_ = nullptr;
+    std::unique_ptr<shared_input_slot> sharedSlot_;
+    bool outputSubscribed_ = false;
+
+    // 蓝牙 DS5 的输入报文为 78 字节（含报告 ID），留出余量
+    uint8_t inputBuffer_[128] = {};
+    std::unique_ptr<input_state> inputState_;
+    input_loop input_{ *this };
+
+    io_pool::request outputRequest_;
+    DS5_AWAIT_OUTPUT outputAwait_ = {};
+    output_loop output_{ *this };
+
+    int outputSeq_ = 0;
+    uint8_t outputData_[78] = {};
+    output_report_checksum outputChecksum_{sizeof(outputData_)};
+
+    sink_worker& hapticsWorker_;
+    sink_worker& recordWorker_;
+    std::unique_ptr<audio_handler> audio_;
+    std::unique_ptr<haptics_handler> haptics_;
+    std::unique_ptr<audio_recorder> recorder_;
+};
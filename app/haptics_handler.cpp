@@ -0,0 +1,164 @@
+﻿#include "haptics_handler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "audio_deinterleave.h"
+#include "output_checksum.h"
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+    //
+    // USB 音频：4ch / 16bit / 48kHz；蓝牙振动：2ch / int8 / 3kHz
+    //
+    constexpr unsigned INPUT_RATE = 48000;
+    constexpr unsigned HAPTICS_RATE = 3000;
+    constexpr unsigned DECIMATION = INPUT_RATE / HAPTICS_RATE;     // 16
+    constexpr unsigned TAPS_PER_PHASE = 16;                         // 共 256 阶
+    constexpr double CUTOFF = 1250.0 / INPUT_RATE;                  // 留出过渡带，2 kHz 处约 -75 dB
+
+    constexpr size_t INPUT_FRAME_SIZE = 4 * sizeof(int16_t);
+    constexpr size_t HAPTICS_FRAMES = 32;                           // 每个报文 32 帧，约 10.7 ms
+    constexpr size_t INPUT_FRAMES = HAPTICS_FRAMES * DECIMATION;    // 512
+    constexpr size_t INPUT_BLOCK_SIZE = INPUT_FRAMES * INPUT_FRAME_SIZE;
+
+    //
+    // 0x32 报文布局：
+    //   [0]     report id 0x32
+    //   [1]     seq << 4
+    //   [2..10] 子包 0x11 (带长度标志 0x80)，7 字节控制数据
+    //   [11..76] 子包 0x12，64 字节 = 32 帧交错的左右 int8 样本
+    //   [137..140] CRC32 (0xA2 种子)
+    //
+    constexpr size_t HAPTICS_REPORT_SIZE = 141;
+    constexpr uint8_t HAPTICS_REPORT_ID = 0x32;
+    constexpr uint8_t PACKET_SIZED = 0x80;
+    constexpr uint8_t PACKET_CONTROL = 0x11;
+    constexpr uint8_t PACKET_CONTROL_SIZE = 7;
+    constexpr uint8_t PACKET_SAMPLES = 0x12;
+    constexpr uint8_t PACKET_SAMPLES_SIZE = HAPTICS_FRAMES * 2;
+
+    // 每个报文的处理预算：远小于 10.7 ms 的报文周期
+    constexpr auto PACKET_BUDGET = microseconds(500);
+    constexpr auto HAPTICS_STATS_PERIOD = seconds(5);
+
+    int8_t quantize(float v)
+    {
+        const float scaled = nearbyintf(v * 127.0f);
+        return static_cast<int8_t>(clamp(scaled, -128.0f, 127.0f));
+    }
+
+    void pack_report(uint8_t* report, uint8_t seq, const float* left, const float* right)
+    {
+        memset(report, 0, HAPTICS_REPORT_SIZE);
+
+        uint8_t* p = report;
+        *p++ = HAPTICS_REPORT_ID;
+        *p++ = static_cast<uint8_t>(seq << 4);
+
+        *p++ = PACKET_CONTROL | PACKET_SIZED;
+        *p++ = PACKET_CONTROL_SIZE;
+        const uint8_t control[PACKET_CONTROL_SIZE] = { 0xFE, 0x00, 0x00, 0x00, 0x00, seq, 0x00 };
+        memcpy(p, control, sizeof(control));
+        p += sizeof(control);
+
+        *p++ = PACKET_SAMPLES | PACKET_SIZED;
+        *p++ = PACKET_SAMPLES_SIZE;
+        for (size_t i = 0; i < HAPTICS_FRAMES; i++)
+        {
+            *p++ = static_cast<uint8_t>(quantize(left[i]));
+            *p++ = static_cast<uint8_t>(quantize(right[i]));
+        }
+
+        fill_output_report_checksum(report, HAPTICS_REPORT_SIZE);
+    }
+}
+
+//
+// 拆分 / 抽取用的工作缓冲，扬声器声道不用，只是给拆分内核一个落脚处
+//
+struct haptics_handler::buffers
+{
+    int16_t input[INPUT_FRAMES * 4];
+    float speakerL[INPUT_FRAMES], speakerR[INPUT_FRAMES];
+    float hapticL[INPUT_FRAMES], hapticR[INPUT_FRAMES];
+    float left[HAPTICS_FRAMES], right[HAPTICS_FRAMES];
+    uint8_t report[HAPTICS_REPORT_SIZE];
+};
+
+haptics_handler::haptics_handler(audio_ring& ring, hid_writer::channel* channel, unsigned index)
+    : ring_(ring),
+      channel_(channel),
+      index_(index),
+      leftFilter_(DECIMATION, TAPS_PER_PHASE, CUTOFF, INPUT_FRAMES),
+      rightFilter_(DECIMATION, TAPS_PER_PHASE, CUTOFF, INPUT_FRAMES),
+      buffers_(make_unique<buffers>()),
+      idleSignal_(ring.signal() - 1),
+      windowStart_(steady_clock::now())
+{
+}
+
+haptics_handler::~haptics_handler() = default;
+
+bool haptics_handler::pump()
+{
+    // 共享线程被别的手柄唤醒时不算本 ring 的 short read
+    const uint32_t signal = ring_.signal();
+    if (signal == idleSignal_)
+        return false;
+
+    buffers& b = *buffers_;
+    if (!ring_.read_exact(reinterpret_cast<uint8_t*>(b.input), INPUT_BLOCK_SIZE))
+    {
+        idleSignal_ = signal;
+        return false;
+    }
+
+    const auto begin = steady_clock::now();
+
+    ds5_deinterleave(b.input, INPUT_FRAMES, { b.speakerL, b.speakerR, b.hapticL, b.hapticR });
+    leftFilter_.process(b.hapticL, INPUT_FRAMES, b.left);
+    rightFilter_.process(b.hapticR, INPUT_FRAMES, b.right);
+
+    pack_report(b.report, seq_, b.left, b.right);
+    seq_ = (seq_ + 1) & 0x0F;
+
+    if (!channel_->submit(b.report, HAPTICS_REPORT_SIZE))
+        dropped_++;
+
+    const auto end = steady_clock::now();
+    const auto elapsed = end - begin;
+    cost_.record(duration_cast<nanoseconds>(elapsed).count());
+    packets_++;
+    if (elapsed > PACKET_BUDGET)
+        overBudget_++;
+
+    report_stats(end);
+    return true;
+}
+
+void haptics_handler::report_stats(steady_clock::time_point now)
+{
+    if (now - windowStart_ < HAPTICS_STATS_PERIOD)
+        return;
+
+    char line[256];
+    snprintf(line, sizeof(line),
+        "[Haptics#%u] packets %llu dropped %llu | cost p50 %.1f us p99 %.1f us max %.1f us | over budget %llu | short reads %llu",
+        index_,
+        static_cast<unsigned long long>(packets_), static_cast<unsigned long long>(dropped_),
+        cost_.percentile(0.50) / 1e3, cost_.percentile(0.99) / 1e3, cost_.max() / 1e3,
+        static_cast<unsigned long long>(overBudget_),
+        static_cast<unsigned long long>(ring_.underruns()));
+    cout << line << endl;
+
+    cost_.reset();
+    windowStart_ = now;
+}
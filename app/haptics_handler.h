@@ -0,0 +1,47 @@
+﻿#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "audio_ring.h"
+#include "hid_writer.h"
+#include "latency_histogram.h"
+#include "polyphase_decimator.h"
+#include "sink_worker.h"
+
+//
+// 蓝牙振动管线
+//
+// 蓝牙连接的 DualSense 收不到 USB 音频端点，声道 3-4 的振动信号
+// 在这里低通抽取到 3 kHz、量化成 int8，打包成 0x32 输出报文经写线程发出。
+// 每个手柄一个实例，由共享的 sink_worker 驱动。
+//
+class haptics_handler : public sink_consumer
+{
+public:
+    haptics_handler(audio_ring& ring, hid_writer::channel* channel, unsigned index);
+    ~haptics_handler() override;
+
+    // ring 中凑满一个报文的输入时处理一个报文
+    bool pump() override;
+
+private:
+    struct buffers;
+
+    void report_stats(std::chrono::steady_clock::time_point now);
+
+    audio_ring& ring_;
+    hid_writer::channel* channel_;
+    const unsigned index_;
+    polyphase_decimator leftFilter_;
+    polyphase_decimator rightFilter_;
+    std::unique_ptr<buffers> buffers_;
+    uint32_t idleSignal_;   // 上次读不满一个报文时的 ring 信号值
+
+    uint8_t seq_ = 0;
+    latency_histogram cost_;
+    uint64_t packets_ = 0;
+    uint64_t overBudget_ = 0;
+    uint64_t dropped_ = 0;
+    std::chrono::steady_clock::time_point windowStart_;
+};
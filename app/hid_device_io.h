@@ -0,0 +1,34 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "io_pool.h"
+
+//
+// 全双工 HID 设备
+//
+// 读是异步的，完成在共享的 io_pool 上回调；write 是同步的，由 hid_writer 的
+// 写线程调用。读写可以同时进行，彼此不共享锁。
+//
+// 接口不依赖 Windows：hidapi_device_io 是实际的实现，测试用模拟设备驱动读写路径。
+//
+class hid_device_io
+{
+public:
+    virtual ~hid_device_io() = default;
+
+    // 读请求的完成走这个池，第一次 read_async 之前调用
+    virtual bool bind(io_pool& pool) = 0;
+    // 读一个输入报文，完成时回调 done.complete(ok, 读到的字节数)；
+    // 同一时刻只挂一个读请求，data 在完成前必须有效
+    virtual bool read_async(uint8_t* data, size_t size, io_pool::task& done) = 0;
+    // 取消挂起的读请求，它仍会以 ok == false 完成
+    virtual void cancel_read() = 0;
+
+    // 返回写入的字节数，出错返回 -1
+    virtual int write(const uint8_t* data, size_t size) = 0;
+
+    virtual std::wstring read_error() = 0;
+    virtual std::wstring write_error() = 0;
+};
@@ -0,0 +1,192 @@
+﻿#include "hid_writer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+    constexpr auto WRITER_STATS_PERIOD = seconds(5);
+
+    int64_t now_ticks()
+    {
+        return steady_clock::now().time_since_epoch().count();
+    }
+
+    uint64_t ticks_to_ns(int64_t ticks)
+    {
+        return duration_cast<nanoseconds>(steady_clock::duration(ticks)).count();
+    }
+}
+
+bool hid_writer::channel::submit(const uint8_t* data, size_t size)
+{
+    if (size > MAX_REPORT_SIZE)
+        return false;
+
+    report r;
+    r.enqueued = now_ticks();
+    r.size = static_cast<uint16_t>(size);
+    memcpy(r.data, data, size);
+
+    if (!queue_.push(r))
+    {
+        dropped_.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    owner_->ring();
+    return true;
+}
+
+hid_writer::channel* hid_writer::open_channel(hid_device_io& device)
+{
+    scoped_lock lock(channelMutex_);
+
+    // 先复用关闭过的通道
+    const size_t count = channelCount_.load(memory_order_relaxed);
+    size_t index = 0;
+    while (index < count && channels_[index].open_)
+        index++;
+
+    if (index >= MAX_CHANNELS)
+        return nullptr;
+
+    channel& ch = channels_[index];
+    ch.owner_ = this;
+    ch.open_ = true;
+    ch.dropped_.store(0, memory_order_relaxed);
+    {
+        scoped_lock io(ch.ioMutex_);
+        ch.device_ = &device;
+    }
+
+    if (index == count)
+        channelCount_.store(index + 1, memory_order_release);
+    openCount_.fetch_add(1, memory_order_relaxed);
+    return &ch;
+}
+
+void hid_writer::close_channel(channel* ch)
+{
+    if (!ch)
+        return;
+
+    {
+        // 写线程正在写该设备时在这里等它写完
+        scoped_lock io(ch->ioMutex_);
+        ch->device_ = nullptr;
+
+        report r;
+        while (ch->queue_.pop(r))
+        {
+        }
+    }
+
+    scoped_lock lock(channelMutex_);
+    ch->open_ = false;
+    openCount_.fetch_sub(1, memory_order_relaxed);
+}
+
+void hid_writer::start()
+{
+    windowStart_ = now_ticks();
+    thread_ = jthread([this](stop_token stoken) { run(stoken); });
+}
+
+void hid_writer::stop()
+{
+    if (!thread_.joinable())
+        return;
+
+    thread_.request_stop();
+    ring();
+    thread_.join();
+}
+
+void hid_writer::ring()
+{
+    doorbell_.fetch_add(1, memory_order_release);
+    doorbell_.notify_one();
+}
+
+void hid_writer::run(stop_token stoken)
+{
+    report r;
+
+    while (!stoken.stop_requested())
+    {
+        // 先取门铃值再检查队列，入队发生在检查之后时 wait 会立即返回
+        const uint32_t seen = doorbell_.load(memory_order_acquire);
+        bool drained = false;
+
+        const size_t count = channelCount_.load(memory_order_acquire);
+        for (size_t i = 0; i < count; i++)
+        {
+            channel& ch = channels_[i];
+            scoped_lock io(ch.ioMutex_);
+
+            // 每个通道每轮只取一个，多个手柄之间轮流写
+            if (ch.device_ && ch.queue_.pop(r))
+            {
+                drained = true;
+                if (ch.queue_.size() != 0)
+                    backlogged_++;
+
+                const int64_t begin = now_ticks();
+                dwell_.record(ticks_to_ns(begin - r.enqueued));
+
+                ch.busy_.store(true, memory_order_relaxed);
+                const int result = ch.device_->write(r.data, r.size);
+                ch.busy_.store(false, memory_order_relaxed);
+
+                const int64_t end = now_ticks();
+                write_.record(ticks_to_ns(end - begin));
+
+                if (result < 0)
+                {
+                    failed_++;
+                    wcerr << "hid_write failed: " << ch.device_->write_error() << endl;
+                }
+                else
+                {
+                    written_++;
+                }
+
+                report_stats(end);
+            }
+        }
+
+        if (!drained)
+            doorbell_.wait(seen, memory_order_acquire);
+    }
+}
+
+void hid_writer::report_stats(int64_t now)
+{
+    if (ticks_to_ns(now - windowStart_) < static_cast<uint64_t>(duration_cast<nanoseconds>(WRITER_STATS_PERIOD).count()))
+        return;
+
+    uint64_t dropped = 0;
+    const size_t count = channelCount_.load(memory_order_acquire);
+    for (size_t i = 0; i < count; i++)
+        dropped += channels_[i].dropped();
+
+    char line[256];
+    snprintf(line, sizeof(line),
+        "[Output#%u] channels %zu | written %llu failed %llu dropped %llu backlogged %llu | dwell p50 %.1f us p99 %.1f us | write p50 %.2f ms p99 %.2f ms",
+        index_, count,
+        static_cast<unsigned long long>(written_), static_cast<unsigned long long>(failed_),
+        static_cast<unsigned long long>(dropped), static_cast<unsigned long long>(backlogged_),
+        dwell_.percentile(0.50) / 1e3, dwell_.percentile(0.99) / 1e3,
+        write_.percentile(0.50) / 1e6, write_.percentile(0.99) / 1e6);
+    cout << line << endl;
+
+    dwell_.reset();
+    write_.reset();
+    windowStart_ = now;
+}
@@ -0,0 +1,95 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+#include "hid_device_io.h"
+#include "latency_histogram.h"
+#include "spsc_queue.h"
+
+//
+// 共享的 HID 写线程
+//
+// 每个生产者线程通过 open_channel 为某个设备拿到自己的 SPSC 队列，入队不加锁；
+// 写线程轮流取出各队列的报文并写到对应设备，慢速的蓝牙写不会再阻塞输入转发。
+// 一个写线程可以服务多个手柄。
+//
+class hid_writer
+{
+public:
+    // 目前最大的蓝牙输出报文 (0x32) 为 141 字节
+    static constexpr size_t MAX_REPORT_SIZE = 160;
+    static constexpr size_t QUEUE_DEPTH = 32;
+    static constexpr size_t MAX_CHANNELS = 32;
+
+    struct report
+    {
+        int64_t enqueued;  // steady_clock ticks
+        uint16_t size;
+        uint8_t data[MAX_REPORT_SIZE];
+    };
+
+    class channel
+    {
+    public:
+        // 生产者调用；队列满时丢弃并计数
+        bool submit(const uint8_t* data, size_t size);
+
+        uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+        // 写线程当前是否正阻塞在本通道设备的 hid_write 中
+        bool busy() const { return busy_.load(std::memory_order_relaxed); }
+
+    private:
+        friend class hid_writer;
+
+        hid_writer* owner_ = nullptr;
+        bool open_ = false;             // channelMutex_
+        std::mutex ioMutex_;            // 写线程出队、写设备时持有
+        hid_device_io* device_ = nullptr;
+        spsc_queue<report, QUEUE_DEPTH> queue_;
+        std::atomic<uint64_t> dropped_ = 0;
+        std::atomic<bool> busy_ = false;
+    };
+
+    explicit hid_writer(unsigned index) : index_(index) {}
+    ~hid_writer() { stop(); }
+
+    hid_writer(const hid_writer&) = delete;
+    hid_writer& operator=(const hid_writer&) = delete;
+
+    // 每个生产者调用一次，可并发调用；超过 MAX_CHANNELS 返回 nullptr
+    channel* open_channel(hid_device_io& device);
+    // 生产者停止提交后调用：丢弃积压报文、等写线程离开该设备，之后可以关闭设备，
+    // 通道留给下一个 open_channel
+    void close_channel(channel* ch);
+
+    size_t channel_count() const { return openCount_.load(std::memory_order_relaxed); }
+
+    void start();
+    void stop();
+
+private:
+    void run(std::stop_token stoken);
+    void ring();
+    void report_stats(int64_t now);
+
+    const unsigned index_;
+    channel channels_[MAX_CHANNELS];
+    std::atomic<size_t> channelCount_ = 0;  // 用过的通道数，只增不减
+    std::atomic<size_t> openCount_ = 0;
+    std::mutex channelMutex_;
+    std::atomic<uint32_t> doorbell_ = 0;
+    std::jthread thread_;
+
+    // 以下只由写线程访问
+    latency_histogram dwell_;    // 入队到开始写
+    latency_histogram write_;    // hid_write 耗时
+    uint64_t written_ = 0;
+    uint64_t failed_ = 0;
+    uint64_t backlogged_ = 0;    // 取出时队列里还有积压的次数
+    int64_t windowStart_ = 0;
+};
@@ -0,0 +1,102 @@
+﻿#include "hidapi_device_io.h"
+
+#include <hidsdi.h>
+#include <string>
+
+#include "utils.h"
+
+using namespace std;
+
+namespace
+{
+    size_t input_report_length(HANDLE device)
+    {
+        PHIDP_PREPARSED_DATA preparsed = nullptr;
+        if (!HidD_GetPreparsedData(device, &preparsed))
+            return 0;
+
+        HIDP_CAPS caps = {};
+        const NTSTATUS status = HidP_GetCaps(preparsed, &caps);
+        HidD_FreePreparsedData(preparsed);
+
+        return status == HIDP_STATUS_SUCCESS ? caps.InputReportByteLength : 0;
+    }
+}
+
+hidapi_device_io::~hidapi_device_io()
+{
+    hid_close(writer_);
+    CloseHandle(reader_);
+}
+
+unique_ptr<hidapi_device_io> hidapi_device_io::open_path(const char* path)
+{
+    const HANDLE reader = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                      nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+    if (reader == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    const size_t length = input_report_length(reader);
+    hid_device* writer = length != 0 ? hid_open_path(path) : nullptr;
+    if (!writer)
+    {
+        CloseHandle(reader);
+        return nullptr;
+    }
+
+    return unique_ptr<hidapi_device_io>(new hidapi_device_io(reader, length, writer));
+}
+
+bool hidapi_device_io::bind(io_pool& pool)
+{
+    return pool.bind(reader_);
+}
+
+bool hidapi_device_io::read_async(uint8_t* data, size_t size, io_pool::task& done)
+{
+    if (size < inputReportLength_)
+    {
+        readError_ = ERROR_INSUFFICIENT_BUFFER;
+        return false;
+    }
+
+    readRequest_.overlapped = {};
+    readRequest_.owner = &done;
+
+    // 同步完成时完成包同样会进端口
+    if (ReadFile(reader_, data, static_cast<DWORD>(inputReportLength_), nullptr, &readRequest_.overlapped))
+    {
+        readError_ = ERROR_IO_PENDING;
+        return true;
+    }
+
+    readError_ = GetLastError();
+    return readError_ == ERROR_IO_PENDING;
+}
+
+void hidapi_device_io::cancel_read()
+{
+    CancelIoEx(reader_, &readRequest_.overlapped);
+}
+
+int hidapi_device_io::write(const uint8_t* data, size_t size)
+{
+    return hid_write(writer_, data, size);
+}
+
+wstring hidapi_device_io::read_error()
+{
+    // 请求发出去了就看它的完成状态，否则是发起时的错误
+    DWORD error = readError_;
+    DWORD transferred = 0;
+    if (error == ERROR_IO_PENDING)
+        error = GetOverlappedResult(reader_, &readRequest_.overlapped, &transferred, FALSE) ? ERROR_SUCCESS : GetLastError();
+
+    return Win32ErrorToString(error);
+}
+
+wstring hidapi_device_io::write_error()
+{
+    const wchar_t* err = hid_error(writer_);
+    return err ? err : L"";
+}
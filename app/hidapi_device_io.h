@@ -0,0 +1,40 @@
+﻿#pragma once
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <memory>
+
+#include <hidapi/hidapi.h>
+
+#include "hid_device_io.h"
+
+//
+// Windows 上的实现：读走同一设备路径的 overlapped 句柄，完成进 io_pool；
+// 写仍用 HIDAPI 单独打开的句柄，两边互不干扰
+//
+class hidapi_device_io : public hid_device_io
+{
+public:
+    ~hidapi_device_io() override;
+
+    // 按 hid_enumerate 给出的路径打开，失败返回 nullptr
+    static std::unique_ptr<hidapi_device_io> open_path(const char* path);
+
+    bool bind(io_pool& pool) override;
+    bool read_async(uint8_t* data, size_t size, io_pool::task& done) override;
+    void cancel_read() override;
+    int write(const uint8_t* data, size_t size) override;
+
+    std::wstring read_error() override;
+    std::wstring write_error() override;
+
+private:
+    hidapi_device_io(HANDLE reader, size_t inputReportLength, hid_device* writer)
+        : reader_(reader), inputReportLength_(inputReportLength), writer_(writer) {}
+
+    HANDLE reader_;
+    // 含报告 ID；ReadFile 的长度必须不小于它
+    const size_t inputReportLength_;
+    io_pool::request readRequest_;
+    DWORD readError_ = ERROR_SUCCESS;
+    hid_device* writer_;
+};
@@ -0,0 +1,198 @@
+﻿#include "input_batcher.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+using namespace std;
+using namespace std::chrono;
+using namespace ViGEm::Batch;
+
+namespace
+{
+    constexpr auto BATCH_STATS_PERIOD = seconds(5);
+
+    int64_t now_ticks()
+    {
+        return steady_clock::now().time_since_epoch().count();
+    }
+
+    uint64_t ticks_to_ns(int64_t ticks)
+    {
+        return duration_cast<nanoseconds>(steady_clock::duration(ticks)).count();
+    }
+}
+
+input_batcher::input_batcher(bus_device& bus)
+    : bus_(bus), buffer_(SubmitBatchLength(SubmitBatchMaxEntries))
+{
+}
+
+bool input_batcher::supported()
+{
+    SubmitBatchBuilder builder(buffer_.data(), buffer_.size());
+    return bus_.ioctl(IOCTL_VIGEM_SUBMIT_BATCH, buffer_.data(), builder.Length(), buffer_.data(), builder.Length());
+}
+
+input_batcher::slot* input_batcher::open_slot(ULONG serial)
+{
+    scoped_lock lock(slotMutex_);
+
+    // 先复用关闭过的槽位
+    const size_t count = slotCount_.load(memory_order_relaxed);
+    for (size_t i = 0; i < count; i++)
+    {
+        slot& s = slots_[i];
+        scoped_lock slotLock(s.mutex_);
+        if (s.open_)
+            continue;
+
+        s.open_ = true;
+        s.serial_ = serial;
+        return &s;
+    }
+
+    if (count >= MAX_SLOTS)
+        return nullptr;
+
+    slot& s = slots_[count];
+    {
+        scoped_lock slotLock(s.mutex_);
+        s.open_ = true;
+        s.serial_ = serial;
+    }
+    slotCount_.store(count + 1, memory_order_release);
+    return &s;
+}
+
+void input_batcher::close_slot(slot* target)
+{
+    if (!target)
+        return;
+
+    // 已经打进当前批次的条目照常发出，虚拟设备拔掉后驱动会在条目状态里报错
+    scoped_lock lock(target->mutex_);
+    target->open_ = false;
+    target->pending_ = false;
+}
+
+void input_batcher::post(slot* target, const DS5_REPORT& report)
+{
+    {
+        scoped_lock lock(target->mutex_);
+        if (target->pending_)
+            target->overwritten_++;
+        target->report_ = report;
+        target->pending_ = true;
+    }
+
+    ring();
+}
+
+void input_batcher::start()
+{
+    windowStart_ = now_ticks();
+    thread_ = jthread([this](stop_token stoken) { run(stoken); });
+}
+
+void input_batcher::stop()
+{
+    if (!thread_.joinable())
+        return;
+
+    thread_.request_stop();
+    ring();
+    thread_.join();
+}
+
+void input_batcher::ring()
+{
+    doorbell_.fetch_add(1, memory_order_release);
+    doorbell_.notify_one();
+}
+
+void input_batcher::run(stop_token stoken)
+{
+    SubmitBatchBuilder builder(buffer_.data(), buffer_.size());
+
+    while (!stoken.stop_requested())
+    {
+        // 先取门铃值再收集，收集之后的 post 会让 wait 立即返回
+        const uint32_t seen = doorbell_.load(memory_order_acquire);
+
+        builder.Reset();
+        const size_t count = slotCount_.load(memory_order_acquire);
+        for (size_t i = 0; i < count; i++)
+        {
+            slot& s = slots_[i];
+            scoped_lock lock(s.mutex_);
+            if (!s.pending_)
+                continue;
+
+            builder.Add(SubmitBatchTargetDs5, s.serial_, &s.report_, sizeof(DS5_REPORT));
+            s.pending_ = false;
+        }
+
+        if (builder.Count() == 0)
+        {
+            doorbell_.wait(seen, memory_order_acquire);
+            continue;
+        }
+
+        const int64_t begin = now_ticks();
+        const bool ok = bus_.ioctl(IOCTL_VIGEM_SUBMIT_BATCH, buffer_.data(), builder.Length(),
+                                   buffer_.data(), builder.Length());
+        const int64_t end = now_ticks();
+        ioctl_.record(ticks_to_ns(end - begin));
+
+        batches_++;
+        entries_ += builder.Count();
+
+        if (!ok)
+        {
+            failed_ += builder.Count();
+            cerr << "[Batch] IOCTL_VIGEM_SUBMIT_BATCH failed, GetLastError=" << GetLastError() << endl;
+        }
+        else
+        {
+            // 每个条目的 NTSTATUS 写回在原位
+            for (unsigned int i = 0; i < builder.Count(); i++)
+            {
+                if (builder.Entry(i).Status < 0)
+                    failed_++;
+            }
+        }
+
+        report_stats(end);
+    }
+}
+
+void input_batcher::report_stats(int64_t now)
+{
+    if (ticks_to_ns(now - windowStart_) < static_cast<uint64_t>(duration_cast<nanoseconds>(BATCH_STATS_PERIOD).count()))
+        return;
+
+    uint64_t overwritten = 0;
+    const size_t count = slotCount_.load(memory_order_acquire);
+    for (size_t i = 0; i < count; i++)
+    {
+        scoped_lock lock(slots_[i].mutex_);
+        overwritten += slots_[i].overwritten_;
+        slots_[i].overwritten_ = 0;
+    }
+
+    const double seconds = ticks_to_ns(now - windowStart_) / 1e9;
+    char line[256];
+    snprintf(line, sizeof(line),
+        "[Batch] %.1f IOCTL/s | %.2f reports per batch | ioctl p50 %.1f us p99 %.1f us | failed %llu overwritten %llu",
+        batches_ / seconds, batches_ ? static_cast<double>(entries_) / batches_ : 0.0,
+        ioctl_.percentile(0.50) / 1e3, ioctl_.percentile(0.99) / 1e3,
+        static_cast<unsigned long long>(failed_), static_cast<unsigned long long>(overwritten));
+    cout << line << endl;
+
+    ioctl_.reset();
+    batches_ = 0;
+    entries_ = 0;
+    failed_ = 0;
+    windowStart_ = now;
+}
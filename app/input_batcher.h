@@ -0,0 +1,79 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "ViGEm/Client.h"
+#include "bus_device.h"
+#include "latency_histogram.h"
+
+#include <SubmitBatch.h>
+
+//
+// 批量提交输入报文
+//
+// 各会话的读回调把最新报文放进自己的槽位（后到覆盖先到），提交线程醒来后
+// 把所有待发槽位打包成一次 IOCTL_VIGEM_SUBMIT_BATCH。单个手柄时每帧仍立即发出，
+// 多个手柄同时到达或上一次 IOCTL 未返回期间到达的报文合并成一批。
+//
+class input_batcher
+{
+public:
+    static constexpr size_t MAX_SLOTS = ViGEm::Batch::SubmitBatchMaxEntries;
+
+    class slot
+    {
+    private:
+        friend class input_batcher;
+
+        std::mutex mutex_;
+        bool open_ = false;
+        ULONG serial_ = 0;
+        DS5_REPORT report_ = {};
+        bool pending_ = false;
+        uint64_t overwritten_ = 0;  // 未发出就被新报文覆盖
+    };
+
+    explicit input_batcher(bus_device& bus);
+    ~input_batcher() { stop(); }
+
+    input_batcher(const input_batcher&) = delete;
+    input_batcher& operator=(const input_batcher&) = delete;
+
+    // 发一个空批次探测驱动是否支持
+    bool supported();
+
+    // 每个虚拟 DS5 调用一次，可并发调用；超过 MAX_SLOTS 返回 nullptr
+    slot* open_slot(ULONG serial);
+    // 会话的读请求停止后调用，丢弃未发出的报文，槽位留给下一个 open_slot
+    void close_slot(slot* target);
+
+    // 读回调调用，同一槽位不会并发
+    void post(slot* target, const DS5_REPORT& report);
+
+    void start();
+    void stop();
+
+private:
+    void run(std::stop_token stoken);
+    void ring();
+    void report_stats(int64_t now);
+
+    bus_device& bus_;
+    slot slots_[MAX_SLOTS];
+    std::atomic<size_t> slotCount_ = 0;  // 用过的槽位数，只增不减
+    std::mutex slotMutex_;
+    std::atomic<uint32_t> doorbell_ = 0;
+    std::jthread thread_;
+
+    // 以下只由提交线程访问
+    std::vector<uint8_t> buffer_;
+    latency_histogram ioctl_;
+    uint64_t batches_ = 0;
+    uint64_t entries_ = 0;
+    uint64_t failed_ = 0;
+    int64_t windowStart_ = 0;
+};
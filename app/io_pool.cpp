@@ -0,0 +1,166 @@
+﻿#include "io_pool.h"
+
+using namespace std;
+
+bool io_pool::start()
+{
+#if defined(_WIN32)
+    port_ = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, threads_);
+    if (!port_)
+        return false;
+#else
+    stopping_ = false;
+#endif
+
+    for (unsigned i = 0; i < threads_; i++)
+        workers_.emplace_back([this] { run(); });
+    return true;
+}
+
+void io_pool::stop()
+{
+    if (workers_.empty())
+        return;
+
+#if defined(_WIN32)
+    // 每个线程取走一个空完成包后退出
+    for (size_t i = 0; i < workers_.size(); i++)
+        PostQueuedCompletionStatus(port_, 0, 0, nullptr);
+#else
+    {
+        scoped_lock lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+#endif
+
+    for (auto& worker : workers_)
+        worker.join();
+    workers_.clear();
+
+#if defined(_WIN32)
+    CloseHandle(port_);
+    port_ = nullptr;
+#else
+    queue_.clear();
+#endif
+}
+
+#if defined(_WIN32)
+
+bool io_pool::bind(HANDLE handle)
+{
+    return CreateIoCompletionPort(handle, port_, 0, 0) == port_;
+}
+
+bool io_pool::post(task& target, bool ok, size_t transferred)
+{
+    return PostQueuedCompletionStatus(port_, static_cast<DWORD>(transferred), reinterpret_cast<ULONG_PTR>(&target),
+                                      ok ? nullptr : &failed_) != FALSE;
+}
+
+void io_pool::run()
+{
+    for (;;)
+    {
+        DWORD transferred = 0;
+        ULONG_PTR key = 0;
+        LPOVERLAPPED overlapped = nullptr;
+
+        const BOOL ok = GetQueuedCompletionStatus(port_, &transferred, &key, &overlapped, INFINITE);
+
+        // bind 的句柄 key 都是 0，非 0 的是 post 进来的
+        if (key != 0)
+        {
+            reinterpret_cast<task*>(key)->complete(overlapped != &failed_, transferred);
+            continue;
+        }
+
+        // 退出包，或端口已关闭
+        if (!overlapped)
+            return;
+
+        const auto r = CONTAINING_RECORD(overlapped, request, overlapped);
+        r->owner->complete(ok != FALSE, transferred);
+    }
+}
+
+#else
+
+bool io_pool::post(task& target, bool ok, size_t transferred)
+{
+    {
+        scoped_lock lock(mutex_);
+        if (stopping_)
+            return false;
+        queue_.push_back({ &target, ok, transferred });
+    }
+    wake_.notify_one();
+    return true;
+}
+
+void io_pool::run()
+{
+    unique_lock lock(mutex_);
+
+    for (;;)
+    {
+        wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (stopping_)
+            return;
+
+        const posted next = queue_.front();
+        queue_.pop_front();
+
+        lock.unlock();
+        next.target->complete(next.ok, next.transferred);
+        lock.lock();
+    }
+}
+
+#endif
+
+bool io_loop::start()
+{
+    scoped_lock lock(mutex_);
+
+    stopping_ = false;
+    active_ = issue();
+    return active_;
+}
+
+void io_loop::stop()
+{
+    unique_lock lock(mutex_);
+
+    stopping_ = true;
+    if (active_)
+        cancel();
+
+    idle_.wait(lock, [this] { return !active_; });
+}
+
+bool io_loop::running()
+{
+    scoped_lock lock(mutex_);
+    return active_;
+}
+
+void io_loop::complete(bool ok, size_t transferred)
+{
+    bool stopping;
+    {
+        scoped_lock lock(mutex_);
+        stopping = stopping_;
+    }
+
+    // 停止时被取消的完成不交给 completed，免得当成错误报告
+    const bool again = !stopping && completed(ok, transferred);
+
+    scoped_lock lock(mutex_);
+    if (again && !stopping_ && issue())
+        return;
+
+    active_ = false;
+    idle_.notify_all();
+}
@@ -0,0 +1,120 @@
+﻿#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#endif
+
+//
+// 共享的异步 I/O 线程池
+//
+// 所有手柄的 HID 读、驱动输出报文和音频等待都以异步请求挂起，完成后在少数几个
+// 池线程上回调，不再每个手柄各开三个阻塞线程。Windows 上是 I/O 完成端口，
+// 句柄 bind() 之后其上的 overlapped 请求直接进端口；其他平台只有 post()，
+// 用来驱动模拟设备。
+//
+class io_pool
+{
+public:
+    // 异步请求的完成回调，在池线程上执行
+    class task
+    {
+    public:
+        virtual void complete(bool ok, size_t transferred) = 0;
+
+    protected:
+        ~task() = default;
+    };
+
+#if defined(_WIN32)
+    // 在已 bind 的句柄上发起 overlapped 请求时使用，完成后回调 owner
+    struct request
+    {
+        OVERLAPPED overlapped = {};
+        task* owner = nullptr;
+    };
+
+    // 句柄必须以 FILE_FLAG_OVERLAPPED 打开，一个句柄只能关联一个端口
+    bool bind(HANDLE handle);
+#endif
+
+    explicit io_pool(unsigned threads) : threads_(threads) {}
+    ~io_pool() { stop(); }
+
+    io_pool(const io_pool&) = delete;
+    io_pool& operator=(const io_pool&) = delete;
+
+    bool start();
+    // 挂起的请求须先取消并等回调返回
+    void stop();
+
+    // 在池线程上调用 target.complete(ok, transferred)
+    bool post(task& target, bool ok = true, size_t transferred = 0);
+
+private:
+    void run();
+
+    const unsigned threads_;
+    std::vector<std::thread> workers_;
+
+#if defined(_WIN32)
+    HANDLE port_ = nullptr;
+    // post(ok == false) 的完成包带这个地址，与 overlapped 请求区分
+    OVERLAPPED failed_ = {};
+#else
+    struct posted
+    {
+        task* target;
+        bool ok;
+        size_t transferred;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<posted> queue_;
+    bool stopping_ = false;
+#endif
+};
+
+//
+// 一次只挂一个请求的异步循环
+//
+// issue() 发起请求，完成后 completed() 处理结果，返回 true 时立即补投下一个。
+// stop() 之后不再补投：取消挂起的请求并等回调返回，之后可以释放请求用到的缓冲。
+//
+class io_loop : public io_pool::task
+{
+public:
+    // 发起第一个请求，失败返回 false
+    bool start();
+    // 可重复调用
+    void stop();
+
+    // 还有请求挂起或回调正在执行；出错结束后为 false
+    bool running();
+
+protected:
+    ~io_loop() = default;
+
+    // 发起请求，完成（包括被取消）时必须回调 complete；失败返回 false
+    virtual bool issue() = 0;
+    // 取消挂起的请求
+    virtual void cancel() = 0;
+    // 处理一次完成，返回 false 结束循环
+    virtual bool completed(bool ok, size_t transferred) = 0;
+
+private:
+    void complete(bool ok, size_t transferred) final;
+
+    // issue / cancel 都在锁内调用，stop() 要么看到挂起的请求，要么让补投看到 stopping_
+    std::mutex mutex_;
+    std::condition_variable idle_;
+    bool stopping_ = false;
+    bool active_ = false;
+};
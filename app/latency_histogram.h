@@ -0,0 +1,27 @@
+﻿#pragma once
+#include <cstdint>
+
+#include <LatencyHistogram.h>
+
+//
+// 延迟直方图（单位 ns），与驱动共用 include/LatencyHistogram.h 的分桶方式，
+// 两边打印出来的分位数可以直接对照
+//
+class latency_histogram
+{
+public:
+    void record(uint64_t ns) { histogram_.Record(ns); }
+    void reset() { histogram_.Reset(); }
+
+    // p 取 0~1，返回所在桶的下界
+    uint64_t percentile(double p) const
+    {
+        return histogram_.Percentile(static_cast<unsigned int>(p * 1000000.0 + 0.5));
+    }
+
+    uint64_t count() const { return histogram_.Count(); }
+    uint64_t max() const { return histogram_.Max(); }
+
+private:
+    ViGEm::Stats::LatencyHistogram histogram_;
+};
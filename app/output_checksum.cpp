@@ -0,0 +1,124 @@
+﻿#include "output_checksum.h"
+
+#include <cstring>
+
+using namespace std;
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+    return ~crc32_update(~0xEADA2D49, data, size);  // 0xA2 seed
+}
+
+void fill_output_report_checksum(uint8_t* outputData,size_t len)
+{
+    uint32_t crc = crc32(outputData, len - 4);
+    outputData[len - 4] = (crc >> 0) & 0xFF;
+    outputData[len - 3] = (crc >> 8) & 0xFF;
+    outputData[len - 2] = (crc >> 16) & 0xFF;
+    outputData[len - 1] = (crc >> 24) & 0xFF;
+}
+
+namespace
+{
+    constexpr uint32_t CRC32_SEED_A2 = ~0xEADA2D49u;  // 喂过 0xA2 之后的寄存器
+    constexpr uint8_t BT_OUTPUT_REPORT_ID = 0x31;
+    constexpr uint8_t BT_OUTPUT_TAG = 0x10;
+    constexpr size_t BT_OUTPUT_HEADER = 3;           // id, seq, tag
+
+    // 相对报文起始的偏移（USB 输出报文的 common 部分从第 3 字节开始）
+    constexpr size_t FIELD_FLAGS_MOTORS = BT_OUTPUT_HEADER + 0;   // valid_flag0/1, motor_right/left
+    constexpr size_t FIELD_FLAGS_MOTORS_SIZE = 4;
+    constexpr size_t FIELD_LIGHTBAR = BT_OUTPUT_HEADER + 41;      // lightbar_setup .. lightbar_blue
+    constexpr size_t FIELD_LIGHTBAR_SIZE = 6;
+}
+
+output_report_checksum::output_report_checksum(size_t len) : len_(len)
+{
+    const size_t body = len_ - 4;
+
+    for (uint8_t seq = 0; seq < 16; seq++)
+    {
+        const uint8_t header[BT_OUTPUT_HEADER] = { BT_OUTPUT_REPORT_ID, static_cast<uint8_t>(seq << 4), BT_OUTPUT_TAG };
+        headerState_[seq] = crc32_update(CRC32_SEED_A2, header, sizeof(header));
+
+        // 序号字节后面还有 body - 2 字节
+        const uint8_t delta = static_cast<uint8_t>(seq << 4);
+        seqDelta_[seq] = crc32_shift(crc32_update(0, &delta, 1), body - 2);
+    }
+
+    fields_.reserve(2);
+    fields_.push_back({ FIELD_FLAGS_MOTORS, FIELD_FLAGS_MOTORS_SIZE,
+                        crc32_shifter(body - FIELD_FLAGS_MOTORS - FIELD_FLAGS_MOTORS_SIZE) });
+    fields_.push_back({ FIELD_LIGHTBAR, FIELD_LIGHTBAR_SIZE,
+                        crc32_shifter(body - FIELD_LIGHTBAR - FIELD_LIGHTBAR_SIZE) });
+
+    last_.resize(len_);
+}
+
+bool output_report_checksum::only_fields_changed(const uint8_t* outputData) const
+{
+    const uint8_t* last = last_.data();
+
+    // 除序号与登记字段以外的区间必须完全一致
+    if (outputData[0] != last[0] || outputData[2] != last[2])
+        return false;
+
+    // 序号只占高 4 位
+    if (((outputData[1] ^ last[1]) & 0x0F) != 0)
+        return false;
+
+    size_t pos = BT_OUTPUT_HEADER;
+    for (const auto& f : fields_)
+    {
+        if (memcmp(outputData + pos, last + pos, f.offset - pos) != 0)
+            return false;
+        pos = f.offset + f.size;
+    }
+
+    return memcmp(outputData + pos, last + pos, len_ - 4 - pos) == 0;
+}
+
+void output_report_checksum::fill(uint8_t* outputData)
+{
+    uint32_t state;
+
+    if (valid_ && only_fields_changed(outputData))
+    {
+        state = lastState_ ^ seqDelta_[(outputData[1] ^ last_[1]) >> 4];
+
+        for (const auto& f : fields_)
+        {
+            uint8_t delta[8];
+            bool changed = false;
+
+            for (size_t i = 0; i < f.size; i++)
+            {
+                delta[i] = outputData[f.offset + i] ^ last_[f.offset + i];
+                changed |= delta[i] != 0;
+            }
+
+            if (changed)
+                state ^= f.shift(crc32_update(0, delta, f.size));
+        }
+
+        patched_++;
+    }
+    else
+    {
+        if (outputData[0] == BT_OUTPUT_REPORT_ID && outputData[2] == BT_OUTPUT_TAG && (outputData[1] & 0x0F) == 0)
+            state = crc32_update(headerState_[outputData[1] >> 4], outputData + BT_OUTPUT_HEADER, len_ - 4 - BT_OUTPUT_HEADER);
+        else
+            state = crc32_update(CRC32_SEED_A2, outputData, len_ - 4);
+
+        recomputed_++;
+    }
+
+    const uint32_t crc = ~state;
+    outputData[len_ - 4] = (crc >> 0) & 0xFF;
+    outputData[len_ - 3] = (crc >> 8) & 0xFF;
+    outputData[len_ - 2] = (crc >> 16) & 0xFF;
+    outputData[len_ - 1] = (crc >> 24) & 0xFF;
+
+    memcpy(last_.data(), outputData, len_);
+    lastState_ = state;
+    valid_ = true;
+}
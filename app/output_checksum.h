@@ -0,0 +1,49 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "crc32.h"
+
+// 以 0xA2 为种子的 CRC-32（DualSense 蓝牙报文）
+uint32_t crc32(const uint8_t* data, size_t size);
+// 整帧重算报文末尾 4 字节的校验和
+void fill_output_report_checksum(uint8_t* outputData,size_t len);
+
+//
+// 蓝牙输出报文 (0x31) 的校验和
+//
+// 报文头 [0xA2, 0x31, seq << 4, 0x10] 只有 16 种，前缀状态全部预先算好；
+// 与上一帧相比只有序号、标志/马达、灯条等固定字段变化时，直接在上一帧的
+// CRC 上做增量修补，不必重新扫描整帧。
+//
+class output_report_checksum
+{
+public:
+    explicit output_report_checksum(size_t len);
+
+    void fill(uint8_t* outputData);
+
+    uint64_t patched() const { return patched_; }
+    uint64_t recomputed() const { return recomputed_; }
+
+private:
+    struct field
+    {
+        size_t offset;
+        size_t size;
+        crc32_shifter shift;
+    };
+
+    bool only_fields_changed(const uint8_t* outputData) const;
+
+    size_t len_;
+    uint32_t headerState_[16];
+    uint32_t seqDelta_[16];
+    std::vector<field> fields_;
+    std::vector<uint8_t> last_;
+    uint32_t lastState_ = 0;
+    bool valid_ = false;
+    uint64_t patched_ = 0;
+    uint64_t recomputed_ = 0;
+};
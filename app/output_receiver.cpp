@@ -0,0 +1,169 @@
+﻿#include "output_receiver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+    constexpr auto OUTPUT_STATS_PERIOD = seconds(5);
+
+    int64_t now_ticks()
+    {
+        return steady_clock::now().time_since_epoch().count();
+    }
+
+    uint64_t ticks_to_ns(int64_t ticks)
+    {
+        return duration_cast<nanoseconds>(steady_clock::duration(ticks)).count();
+    }
+}
+
+output_receiver::output_receiver(output_source& source)
+    : source_(source)
+{
+}
+
+void output_receiver::subscribe(uint32_t serial, handler callback)
+{
+    scoped_lock lock(routeMutex_);
+    routes_.emplace_back(serial, move(callback));
+}
+
+void output_receiver::unsubscribe(uint32_t serial)
+{
+    scoped_lock lock(routeMutex_);
+    erase_if(routes_, [serial](const auto& route) { return route.first == serial; });
+}
+
+void output_receiver::start()
+{
+    thread_ = jthread([this](stop_token stoken) { run(stoken); });
+}
+
+void output_receiver::stop()
+{
+    if (!thread_.joinable())
+        return;
+
+    thread_.request_stop();
+    source_.cancel();
+    thread_.join();
+}
+
+void output_receiver::run(stop_token stoken)
+{
+    const unsigned depth = source_.capacity();
+    postedAt_.assign(depth, 0);
+    windowStart_ = now_ticks();
+    minDepth_ = depth;
+
+    for (unsigned slot = 0; slot < depth; slot++)
+        post(slot, windowStart_);
+
+    // 停止时不再补投，等所有已投递的请求取消完成，缓冲才能释放
+    while (outstanding_ > 0)
+    {
+        output_source::completion done;
+        if (!source_.wait(done))
+        {
+            cerr << "[Output] Receiver source failed, " << outstanding_ << " request(s) abandoned." << endl;
+            break;
+        }
+
+        const int64_t now = now_ticks();
+        outstanding_--;
+
+        if (stoken.stop_requested())
+            continue;
+
+        if (!done.ok)
+        {
+            // 驱动拒绝的请求不再补投，避免空转
+            failed_++;
+            cerr << "[Output] Await request failed, " << outstanding_ << " still pending." << endl;
+            continue;
+        }
+
+        pending_.record(ticks_to_ns(now - postedAt_[done.slot]));
+        minDepth_ = min(minDepth_, outstanding_);
+        if (outstanding_ == 0)
+            starved_++;
+
+        post(done.slot, now);
+        // 补投与 stop() 的取消交错时，确保新请求也被取消
+        if (stoken.stop_requested())
+            source_.cancel();
+
+        dispatch(done);
+        report_stats(now);
+    }
+}
+
+void output_receiver::post(unsigned slot, int64_t now)
+{
+    if (!source_.post(slot))
+    {
+        failed_++;
+        return;
+    }
+
+    postedAt_[slot] = now;
+    outstanding_++;
+}
+
+void output_receiver::dispatch(const output_source::completion& done)
+{
+    const int64_t begin = now_ticks();
+    bool routed = false;
+
+    {
+        scoped_lock lock(routeMutex_);
+        for (auto& [serial, callback] : routes_)
+        {
+            if (serial == done.serial)
+            {
+                callback(done.report);
+                routed = true;
+                break;
+            }
+        }
+    }
+
+    received_++;
+    if (!routed)
+        unrouted_++;
+
+    dispatch_.record(ticks_to_ns(now_ticks() - begin));
+}
+
+void output_receiver::report_stats(int64_t now)
+{
+    if (ticks_to_ns(now - windowStart_) < static_cast<uint64_t>(duration_cast<nanoseconds>(OUTPUT_STATS_PERIOD).count()))
+        return;
+
+    const double seconds = ticks_to_ns(now - windowStart_) / 1e9;
+    char line[320];
+    snprintf(line, sizeof(line),
+        "[Output] %.1f reports/s | depth %u/%u min %u starved %llu | pending p50 %.2f ms p99 %.2f ms"
+        " | dispatch p50 %.1f us p99 %.1f us | unrouted %llu failed %llu",
+        received_ / seconds, outstanding_, source_.capacity(), minDepth_,
+        static_cast<unsigned long long>(starved_),
+        pending_.percentile(0.50) / 1e6, pending_.percentile(0.99) / 1e6,
+        dispatch_.percentile(0.50) / 1e3, dispatch_.percentile(0.99) / 1e3,
+        static_cast<unsigned long long>(unrouted_), static_cast<unsigned long long>(failed_));
+    cout << line << endl;
+
+    pending_.reset();
+    dispatch_.reset();
+    received_ = 0;
+    starved_ = 0;
+    unrouted_ = 0;
+    failed_ = 0;
+    minDepth_ = outstanding_;
+    windowStart_ = now;
+}
@@ -0,0 +1,100 @@
+﻿#pragma once
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "latency_histogram.h"
+
+#if __has_include("ViGEm/Client.h")
+#include "ViGEm/Client.h"
+
+using output_report = DS5_OUTPUT_BUFFER;
+#else
+// 主机构建没有 ViGEmClient 头文件；接收器只整体拷贝报文，用字节块代替
+struct output_report
+{
+    uint8_t data[64];
+};
+#endif
+
+//
+// 输出报文的来源：一组可以同时挂起的等待请求
+//
+// Windows 上是 bus_output_source（overlapped IOCTL + 完成端口），
+// 接口本身不依赖 Windows，可以用模拟的通知源驱动 output_receiver。
+//
+class output_source
+{
+public:
+    struct completion
+    {
+        unsigned slot = 0;
+        bool ok = false;
+        uint32_t serial = 0;
+        output_report report = {};
+    };
+
+    virtual ~output_source() = default;
+
+    // 可同时挂起的请求数，slot 取 0 ~ capacity()-1
+    virtual unsigned capacity() const = 0;
+    // 投递第 slot 个等待请求
+    virtual bool post(unsigned slot) = 0;
+    // 阻塞到任意一个请求完成；返回 false 表示源已失效，不会再有完成
+    virtual bool wait(completion& done) = 0;
+    // 取消所有挂起的请求，它们仍会以 ok == false 完成
+    virtual void cancel() = 0;
+};
+
+//
+// 输出报文接收
+//
+// 始终保持 capacity() 个等待请求挂起：一个完成后先补投再分发，驱动一次连发
+// 多个报文时不必逐个往返，也不会在驱动的通知队列里排队。所有虚拟 DS5 的输出
+// 报文走同一个源，按 SerialNo 分发给订阅者。
+//
+class output_receiver
+{
+public:
+    using handler = std::function<void(const output_report&)>;
+
+    explicit output_receiver(output_source& source);
+    ~output_receiver() { stop(); }
+
+    output_receiver(const output_receiver&) = delete;
+    output_receiver& operator=(const output_receiver&) = delete;
+
+    // 可在运行中调用；unsubscribe 返回后回调不会再被调用
+    void subscribe(uint32_t serial, handler callback);
+    void unsubscribe(uint32_t serial);
+
+    void start();
+    void stop();
+
+private:
+    void run(std::stop_token stoken);
+    void post(unsigned slot, int64_t now);
+    void dispatch(const output_source::completion& done);
+    void report_stats(int64_t now);
+
+    output_source& source_;
+    std::mutex routeMutex_;
+    std::vector<std::pair<uint32_t, handler>> routes_;
+    std::jthread thread_;
+
+    // 以下只由接收线程访问
+    std::vector<int64_t> postedAt_;
+    unsigned outstanding_ = 0;
+    latency_histogram pending_;   // 投递到完成；接近 0 说明报文已在驱动里排队
+    latency_histogram dispatch_;  // 回调耗时
+    uint64_t received_ = 0;
+    uint64_t starved_ = 0;        // 完成时已没有其他请求挂起
+    uint64_t unrouted_ = 0;
+    uint64_t failed_ = 0;
+    unsigned minDepth_ = 0;
+    int64_t windowStart_ = 0;
+};
@@ -0,0 +1,65 @@
+﻿#include "polyphase_decimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+    constexpr double PI = 3.14159265358979323846;
+}
+
+polyphase_decimator::polyphase_decimator(unsigned factor, unsigned tapsPerPhase, double cutoff, size_t maxBlock)
+    : factor_(factor), coeffs_(static_cast<size_t>(factor) * tapsPerPhase),
+      work_(coeffs_.size() - 1 + maxBlock, 0.0f)
+{
+    const size_t taps = coeffs_.size();
+    const double center = (taps - 1) / 2.0;
+    double sum = 0.0;
+    vector<double> h(taps);
+
+    for (size_t n = 0; n < taps; n++)
+    {
+        const double x = n - center;
+        const double sinc = x == 0.0 ? 2.0 * cutoff : sin(2.0 * PI * cutoff * x) / (PI * x);
+        const double window = 0.42 - 0.5 * cos(2.0 * PI * n / (taps - 1)) + 0.08 * cos(4.0 * PI * n / (taps - 1));
+        h[n] = sinc * window;
+        sum += h[n];
+    }
+
+    // 直流增益归一，系数反转存放
+    for (size_t n = 0; n < taps; n++)
+        coeffs_[n] = static_cast<float>(h[taps - 1 - n] / sum);
+}
+
+void polyphase_decimator::reset()
+{
+    fill(work_.begin(), work_.end(), 0.0f);
+}
+
+size_t polyphase_decimator::process(const float* in, size_t count, float* out)
+{
+    const size_t taps = coeffs_.size();
+    const size_t history = taps - 1;
+    const float* h = coeffs_.data();
+
+    copy(in, in + count, work_.begin() + history);
+
+    // 第 k 个输出对应输入下标 (k + 1) * factor - 1，窗口从 work_[该下标] 开始
+    const size_t outputs = count / factor_;
+    for (size_t k = 0; k < outputs; k++)
+    {
+        const float* x = work_.data() + (k + 1) * factor_ - 1;
+        float acc = 0.0f;
+
+        for (size_t j = 0; j < taps; j++)
+            acc += h[j] * x[j];
+
+        out[k] = acc;
+    }
+
+    // 保留尾部作为下一块的历史
+    copy(work_.begin() + count, work_.begin() + count + history, work_.begin());
+    return outputs;
+}
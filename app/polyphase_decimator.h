@@ -0,0 +1,30 @@
+﻿#pragma once
+#include <cstddef>
+#include <vector>
+
+//
+// 整数倍 FIR 抽取器
+//
+// 低通滤波与抽取合并：只在保留下来的输出时刻做点积（多相结构的换向器形式），
+// 被丢弃的 factor - 1 个样本不做任何计算。系数为 Blackman 窗 sinc，
+// 缓冲在构造时分配，process 本身不分配内存。
+//
+class polyphase_decimator
+{
+public:
+    // cutoff 为相对输入采样率的截止频率 (0 ~ 0.5 / factor)，maxBlock 为单次输入的最大样本数
+    polyphase_decimator(unsigned factor, unsigned tapsPerPhase, double cutoff, size_t maxBlock);
+
+    // count 必须是 factor 的整数倍，输出 count / factor 个样本
+    size_t process(const float* in, size_t count, float* out);
+
+    void reset();
+
+    unsigned factor() const { return factor_; }
+    size_t taps() const { return coeffs_.size(); }
+
+private:
+    const unsigned factor_;
+    std::vector<float> coeffs_;  // 已反转，直接与时间顺序的输入做点积
+    std::vector<float> work_;    // 前 taps - 1 个为上一块的尾部
+};
@@ -0,0 +1,223 @@
+﻿#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include "session_manager.h"
+#include <cwchar>
+#include <iostream>
+#include <hidapi/hidapi.h>
+
+#include "audio_deinterleave.h"
+#include "hidapi_device_io.h"
+#include "utils.h"
+
+using namespace std;
+
+namespace
+{
+    constexpr unsigned short DS5_VID = 0x054C;
+    constexpr unsigned short DS5_PID = 0x0CE6;
+
+    // 虚拟设备故意使用旧的制造商名字，便于 HidHide 识别，枚举时跳过
+    constexpr const wchar_t* VIRTUAL_MANUFACTURER = L"Sony Computer Entertainment";
+
+    // 共享内存输入槽位（可选）：每帧只写内存不发 IOCTL，由驱动在完成 URB 前轮询，
+    // 适合回报率很高的手柄；延迟上限是驱动的轮询周期
+    constexpr bool USE_SHARED_INPUT_SLOT = false;
+
+    // 共享内存音频环（可选）：驱动把 ISO OUT 音频直接写进映射给本进程的环，
+    // 省掉每个 URB 一次的 await IOCTL 和中间拷贝；挂上后该手柄的音频只进环
+    constexpr bool USE_SHARED_AUDIO_RING = false;
+
+    const wchar_t* or_unknown(const wchar_t* s)
+    {
+        return s ? s : L"(unknown)";
+    }
+}
+
+int session_manager::start()
+{
+    // 打开蓝牙DualSense设备
+    if (hid_init() < 0)
+    {
+        wcout << "HIDAPI Init Fail" << L"\n";
+        return 1;
+    }
+    hidInitialized_ = true;
+
+    cout << "[Audio] Deinterleave kernel: " << ds5_deinterleave_kernel_name() << endl;
+
+    // 初始化 ViGEmBus 连接，所有虚拟 DS5 共用
+    client_ = vigem_alloc();
+    const auto error = vigem_connect(client_);
+    if (!VIGEM_SUCCESS(error))
+    {
+        DWORD win32 = ::GetLastError();
+        wcerr << L"vigem_connect failed. GetLastError="
+            << win32 << L" (" << Win32ErrorToString(win32) << L")\n";
+        return 1;
+    }
+
+    // 所有会话的异步请求共用一个线程池
+    pool_ = make_unique<io_pool>(IO_POOL_THREADS);
+    if (!pool_->start() || !pooledBus_.open() || !pool_->bind(pooledBus_.handle()))
+    {
+        cerr << "[App] Failed to start the I/O pool, GetLastError=" << GetLastError() << endl;
+        return 1;
+    }
+
+    hapticsWorker_ = make_unique<sink_worker>();
+    recordWorker_ = make_unique<sink_worker>();
+    hapticsWorker_->start();
+    recordWorker_->start();
+
+    // 旧驱动不认识批量 IOCTL，退回每帧一次 vigem_target_DS5_update
+    const bool busOpened = bus_.open();
+    if (busOpened)
+    {
+        batcher_ = make_unique<input_batcher>(bus_);
+        if (batcher_->supported())
+            batcher_->start();
+        else
+            batcher_.reset();
+    }
+    session_channels channels;
+    channels.batcher = batcher_.get();
+    channels.slotBus = USE_SHARED_INPUT_SLOT && busOpened ? &bus_ : nullptr;
+    cout << "[Input] Submit mode: " << (channels.slotBus ? "shared slot" : batcher_ ? "batched" : "direct") << endl;
+    channels.audioRingBus = USE_SHARED_AUDIO_RING && busOpened ? &bus_ : nullptr;
+    cout << "[Audio] Receive mode: " << (channels.audioRingBus ? "shared ring" : "await") << endl;
+
+    // 打不开第二个句柄时退回每个会话逐个等待
+    if (outputBus_.open())
+    {
+        outputSource_ = make_unique<bus_output_source>(outputBus_);
+        if (outputSource_->open())
+        {
+            outputReceiver_ = make_unique<output_receiver>(*outputSource_);
+            outputReceiver_->start();
+        }
+        else
+            outputSource_.reset();
+    }
+    channels.outputReceiver = outputReceiver_.get();
+    cout << "[Output] Receive mode: " << (outputReceiver_ ? "async" : "per-session await") << endl;
+
+    hid_device_info* devices = hid_enumerate(DS5_VID, DS5_PID);
+    for (hid_device_info* info = devices; info; info = info->next)
+    {
+        // USB 连接的手柄走原生驱动，不需要代理
+        if (info->bus_type != HID_API_BUS_BLUETOOTH)
+            continue;
+
+        if (info->manufacturer_string && wcscmp(info->manufacturer_string, VIRTUAL_MANUFACTURER) == 0)
+            continue;
+
+        wcout << L"ManufactureName: " << or_unknown(info->manufacturer_string)
+              << L" | ProductName: " << or_unknown(info->product_string)
+              << L" | SerialNumber: " << or_unknown(info->serial_number) << L"\n";
+
+        auto device = hidapi_device_io::open_path(info->path);
+        if (!device)
+        {
+            wcerr << "打开设备失败" << L"\n";
+            continue;
+        }
+
+        const auto index = static_cast<unsigned>(sessions_.size());
+        auto session = make_unique<ds5_session>(index, client_, move(device), *pool_, pooledBus_,
+                                                writer_for(index), *hapticsWorker_, *recordWorker_,
+                                                channels);
+        if (!session->start())
+            continue;
+
+        wcout << "连接设备成功" << L"\n";
+        sessions_.push_back(move(session));
+    }
+    hid_free_enumeration(devices);
+
+    if (sessions_.empty())
+    {
+        wcerr << "没有找到蓝牙 DualSense" << L"\n";
+        return 1;
+    }
+
+    return 0;
+}
+
+void session_manager::stop()
+{
+    // 先停会话（取消挂起的请求，归还写通道和批量槽位），再停共享线程，最后关设备
+    for (auto& session : sessions_)
+        session->stop();
+
+    for (auto& writer : writers_)
+        writer->stop();
+    if (hapticsWorker_)
+        hapticsWorker_->stop();
+    if (recordWorker_)
+        recordWorker_->stop();
+    if (batcher_)
+        batcher_->stop();
+    if (outputReceiver_)
+        outputReceiver_->stop();
+    if (pool_)
+        pool_->stop();
+
+    if (!sessions_.empty())
+        cout << "Closing HIDAPI..." << endl;
+    sessions_.clear();
+    writers_.clear();
+    batcher_.reset();
+    bus_.close();
+    outputReceiver_.reset();
+    outputSource_.reset();
+    outputBus_.close();
+    pool_.reset();
+    pooledBus_.close();
+
+    if (client_)
+    {
+        vigem_disconnect(client_);
+        vigem_free(client_);
+        client_ = nullptr;
+    }
+
+    if (hidInitialized_)
+    {
+        hidInitialized_ = false;
+        if (hid_exit() == -1)
+        {
+            // 奇怪，不加这个就会导致退出时间很长
+            cerr << "Failed to exit HIDAPI." << endl;
+        }
+    }
+}
+
+hid_writer& session_manager::writer_for(size_t sessionIndex)
+{
+    // 手柄不多时每个写线程服务 PADS_PER_WRITER 个，超出 MAX_WRITERS 后轮流分摊
+    const size_t wanted = sessionIndex / PADS_PER_WRITER;
+    if (wanted < MAX_WRITERS && wanted >= writers_.size())
+    {
+        writers_.push_back(make_unique<hid_writer>(static_cast<unsigned>(writers_.size())));
+        writers_.back()->start();
+    }
+
+    return *writers_[wanted < MAX_WRITERS ? wanted : sessionIndex % MAX_WRITERS];
+}
+
+size_t session_manager::running_count()
+{
+    size_t running = 0;
+    for (auto& session : sessions_)
+    {
+        if (session->running())
+            running++;
+    }
+    return running;
+}
+
+void session_manager::send_test_report()
+{
+    if (!sessions_.empty())
+        sessions_.front()->send_test_report();
+}
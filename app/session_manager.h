@@ -0,0 +1,66 @@
+﻿#pragma once
+#include <memory>
+#include <vector>
+
+#include "ViGEm/Client.h"
+#include "bus_device.h"
+#include "bus_output_source.h"
+#include "ds5_session.h"
+#include "hid_writer.h"
+#include "input_batcher.h"
+#include "io_pool.h"
+#include "sink_worker.h"
+
+//
+// 枚举所有蓝牙 DualSense，为每个手柄建立一个 ds5_session
+//
+// 共享线程：所有手柄的 HID 读和驱动等待挂在 IO_POOL_THREADS 个池线程上，
+// 每 PADS_PER_WRITER 个手柄一个 HID 写线程，
+// 所有手柄的振动打包共用一个线程，录音落盘共用一个线程；
+// 驱动支持 IOCTL_VIGEM_SUBMIT_BATCH 时，所有手柄的输入报文由一个线程批量提交；
+// 所有手柄的输出报文由一个线程接收，按 SerialNo 分发。
+//
+class session_manager
+{
+public:
+    static constexpr size_t PADS_PER_WRITER = 4;
+    static constexpr size_t MAX_WRITERS = 4;
+    // 回调都很短，两个线程足够；一个被慢回调拖住时另一个继续
+    static constexpr unsigned IO_POOL_THREADS = 2;
+
+    session_manager() = default;
+    ~session_manager() { stop(); }
+
+    session_manager(const session_manager&) = delete;
+    session_manager& operator=(const session_manager&) = delete;
+
+    // 返回 0 表示至少有一个手柄开始转发
+    int start();
+    void stop();
+
+    size_t session_count() const { return sessions_.size(); }
+    // 手柄还连着的会话数
+    size_t running_count();
+
+    // 向第一个手柄的虚拟 DS5 发测试报文
+    void send_test_report();
+
+private:
+    hid_writer& writer_for(size_t sessionIndex);
+
+    bool hidInitialized_ = false;
+    PVIGEM_CLIENT client_ = nullptr;
+    std::unique_ptr<io_pool> pool_;
+    // 关联到池的完成端口，独占一个句柄
+    bus_device pooledBus_;
+    std::vector<std::unique_ptr<hid_writer>> writers_;
+    std::unique_ptr<sink_worker> hapticsWorker_;
+    std::unique_ptr<sink_worker> recordWorker_;
+    bus_device bus_;
+    std::unique_ptr<input_batcher> batcher_;
+    // 完成端口独占一个句柄
+    bus_device outputBus_;
+    std::unique_ptr<bus_output_source> outputSource_;
+    std::unique_ptr<output_receiver> outputReceiver_;
+    std::vector<std::unique_ptr<ds5_session>> sessions_;
+};
@@ -0,0 +1,68 @@
+﻿#include "shared_audio_ring.h"
+
+#include <iostream>
+
+using namespace std;
+using namespace ViGEm::Audio;
+
+shared_audio_ring::shared_audio_ring(bus_device& bus, unsigned long capacity)
+    : bus_(bus), size_(sizeof(AUDIO_RING_HEADER) + capacity)
+{
+    ring_ = static_cast<AUDIO_RING_HEADER*>(VirtualAlloc(nullptr, size_, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+    attach_.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+}
+
+shared_audio_ring::~shared_audio_ring()
+{
+    detach();
+
+    if (attach_.hEvent)
+        CloseHandle(attach_.hEvent);
+    if (ring_)
+        VirtualFree(ring_, 0, MEM_RELEASE);
+}
+
+bool shared_audio_ring::attach(ULONG serial)
+{
+    if (!ring_ || !attach_.hEvent || attached_)
+        return false;
+
+    AUDIO_RING_ATTACH request = {};
+    request.Size = sizeof(AUDIO_RING_ATTACH);
+    request.SerialNo = serial;
+
+    // 正常情况下请求挂起直到 detach()，立即完成说明驱动拒绝了
+    if (DeviceIoControl(bus_.handle(), IOCTL_VIGEM_ATTACH_AUDIO_RING, &request, sizeof(request),
+                        ring_, static_cast<DWORD>(size_), nullptr, &attach_) ||
+        GetLastError() != ERROR_IO_PENDING)
+    {
+        cerr << "[AudioRing] Attach failed for serial " << serial << ", GetLastError=" << GetLastError() << endl;
+        return false;
+    }
+
+    serial_ = serial;
+    attached_ = true;
+    return true;
+}
+
+void shared_audio_ring::detach()
+{
+    if (!attached_)
+        return;
+
+    DWORD transferred = 0;
+    CancelIoEx(bus_.handle(), &attach_);
+    GetOverlappedResult(bus_.handle(), &attach_, &transferred, TRUE);
+    attached_ = false;
+}
+
+bool shared_audio_ring::post_wait(bus_device& pooledBus, io_pool::request& request)
+{
+    if (!attached_)
+        return false;
+
+    doorbell_.Size = sizeof(AUDIO_RING_ATTACH);
+    doorbell_.SerialNo = serial_;
+
+    return pooledBus.ioctl_async(IOCTL_VIGEM_AUDIO_RING_DOORBELL, &doorbell_, sizeof(doorbell_), nullptr, 0, request);
+}
@@ -0,0 +1,65 @@
+﻿#pragma once
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include "bus_device.h"
+
+#include <AudioRing.h>
+
+//
+// 共享内存音频环（可选）
+//
+// 与 shared_input_slot 相同，把内存作为 IOCTL_VIGEM_ATTACH_AUDIO_RING 的输出缓冲
+// 交给驱动并一直挂起。驱动在 ISO OUT 处理中把音频直接写进环里，用户态原地读取，
+// 省去 DS5_AUDIO_DATA 的两次拷贝和每个 URB 一次的 IOCTL。环里没有数据时才挂一个
+// doorbell IOCTL 等驱动敲门，完成走 io_pool。挂上环之后该手柄的音频只进环，
+// 不再走 await 请求。
+//
+// 挂起的 IRP 属于发起线程，attach() 要在长期存在的线程上调用。
+//
+class shared_audio_ring
+{
+public:
+    // 约 170 ms 的 4ch/16bit/48kHz 数据
+    static constexpr unsigned long DEFAULT_CAPACITY = 64 * 1024;
+
+    explicit shared_audio_ring(bus_device& bus, unsigned long capacity = DEFAULT_CAPACITY);
+    ~shared_audio_ring();
+
+    shared_audio_ring(const shared_audio_ring&) = delete;
+    shared_audio_ring& operator=(const shared_audio_ring&) = delete;
+
+    bool attach(ULONG serial);
+    // 取消挂起的请求并等待驱动放开内存
+    void detach();
+
+    // 在已 bind 到 io_pool 的句柄上挂一个 doorbell 请求，驱动有数据可读时完成；
+    // 环里已有未读数据时立即完成。环已分离或请求发不出去时返回 false
+    bool post_wait(bus_device& pooledBus, io_pool::request& request);
+
+    // 取出当前可读的（至多两段）数据，用完后 release
+    unsigned long peek(ViGEm::Audio::AudioRingSpans& spans) const
+    {
+        return ViGEm::Audio::PeekAudioRing(ring_, &spans);
+    }
+
+    void release(unsigned long length)
+    {
+        ViGEm::Audio::ReleaseAudioRing(ring_, length);
+    }
+
+    // 环满时驱动丢弃的字节数
+    unsigned long dropped() const
+    {
+        return static_cast<unsigned long>(ring_->DroppedBytes);
+    }
+
+private:
+    bus_device& bus_;
+    ViGEm::Audio::AUDIO_RING_HEADER* ring_ = nullptr;
+    size_t size_ = 0;
+    ULONG serial_ = 0;
+    OVERLAPPED attach_ = {};
+    ViGEm::Audio::AUDIO_RING_ATTACH doorbell_ = {};
+    bool attached_ = false;
+};
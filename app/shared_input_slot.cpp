@@ -0,0 +1,57 @@
+﻿#include "shared_input_slot.h"
+
+#include <iostream>
+
+using namespace std;
+using namespace ViGEm::Reports;
+
+shared_input_slot::shared_input_slot(bus_device& bus)
+    : bus_(bus)
+{
+    // 独占一页，驱动锁定并映射的只有这块内存
+    slot_ = static_cast<INPUT_SLOT*>(VirtualAlloc(nullptr, sizeof(INPUT_SLOT), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+    overlapped_.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+}
+
+shared_input_slot::~shared_input_slot()
+{
+    detach();
+
+    if (overlapped_.hEvent)
+        CloseHandle(overlapped_.hEvent);
+    if (slot_)
+        VirtualFree(slot_, 0, MEM_RELEASE);
+}
+
+bool shared_input_slot::attach(ULONG serial)
+{
+    if (!slot_ || !overlapped_.hEvent || attached_)
+        return false;
+
+    INPUT_SLOT_ATTACH request = {};
+    request.Size = sizeof(INPUT_SLOT_ATTACH);
+    request.SerialNo = serial;
+
+    // 正常情况下请求挂起直到 detach()，立即完成说明驱动拒绝了
+    if (DeviceIoControl(bus_.handle(), IOCTL_VIGEM_ATTACH_INPUT_SLOT, &request, sizeof(request),
+                        slot_, sizeof(INPUT_SLOT), nullptr, &overlapped_) ||
+        GetLastError() != ERROR_IO_PENDING)
+    {
+        cerr << "[InputSlot] Attach failed for serial " << serial << ", GetLastError=" << GetLastError() << endl;
+        return false;
+    }
+
+    attached_ = true;
+    return true;
+}
+
+void shared_input_slot::detach()
+{
+    if (!attached_)
+        return;
+
+    DWORD transferred = 0;
+    CancelIoEx(bus_.handle(), &overlapped_);
+    GetOverlappedResult(bus_.handle(), &overlapped_, &transferred, TRUE);
+    attached_ = false;
+}
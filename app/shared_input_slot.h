@@ -0,0 +1,43 @@
+﻿#pragma once
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include "ViGEm/Client.h"
+#include "bus_device.h"
+
+#include <InputSlot.h>
+
+//
+// 共享内存输入槽位（可选）
+//
+// 把一页内存作为 IOCTL_VIGEM_ATTACH_INPUT_SLOT 的输出缓冲交给驱动，请求一直挂起，
+// 之后每帧只写共享内存，不再发 IOCTL；驱动在完成中断 IN URB 前读取最新报文。
+// 代价是报文要等到下一个 URB 或驱动定时器才送出。
+//
+// 挂起的 IRP 属于发起线程，线程退出时会被取消，attach() 要在长期存在的线程上调用。
+//
+class shared_input_slot
+{
+public:
+    explicit shared_input_slot(bus_device& bus);
+    ~shared_input_slot();
+
+    shared_input_slot(const shared_input_slot&) = delete;
+    shared_input_slot& operator=(const shared_input_slot&) = delete;
+
+    bool attach(ULONG serial);
+    // 取消挂起的请求并等待驱动放开槽位
+    void detach();
+
+    // 单写者：只能由一个线程调用
+    void publish(const DS5_REPORT& report)
+    {
+        ViGEm::Reports::PublishInputSlot(slot_, &report, sizeof(report));
+    }
+
+private:
+    bus_device& bus_;
+    ViGEm::Reports::INPUT_SLOT* slot_ = nullptr;
+    OVERLAPPED overlapped_ = {};
+    bool attached_ = false;
+};
@@ -0,0 +1,60 @@
+﻿#include "sink_worker.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void sink_worker::add(sink_consumer* consumer)
+{
+    {
+        scoped_lock lock(mutex_);
+        consumers_.push_back(consumer);
+    }
+    ring();
+}
+
+void sink_worker::remove(sink_consumer* consumer)
+{
+    // 工作线程在一轮 pump 期间持有锁，拿到锁即说明它不在处理该消费者
+    scoped_lock lock(mutex_);
+    consumers_.erase(std::remove(consumers_.begin(), consumers_.end(), consumer), consumers_.end());
+}
+
+void sink_worker::start()
+{
+    thread_ = jthread([this](stop_token stoken) { run(stoken); });
+}
+
+void sink_worker::stop()
+{
+    if (!thread_.joinable())
+        return;
+
+    thread_.request_stop();
+    ring();
+    thread_.join();
+}
+
+void sink_worker::ring()
+{
+    doorbell_.fetch_add(1, memory_order_release);
+    doorbell_.notify_one();
+}
+
+void sink_worker::run(stop_token stoken)
+{
+    while (!stoken.stop_requested())
+    {
+        const uint32_t seen = doorbell_.load(memory_order_acquire);
+        bool progress = false;
+
+        {
+            scoped_lock lock(mutex_);
+            for (sink_consumer* consumer : consumers_)
+                progress |= consumer->pump();
+        }
+
+        if (!progress)
+            doorbell_.wait(seen, memory_order_acquire);
+    }
+}
@@ -0,0 +1,52 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+//
+// 环形缓冲的消费者：pump 处理当前能处理的数据，有进展时返回 true
+//
+class sink_consumer
+{
+public:
+    virtual ~sink_consumer() = default;
+    virtual bool pump() = 0;
+};
+
+//
+// 共享消费线程
+//
+// 多个手柄的同类消费者（振动、录音）挂在同一个线程上，轮流 pump，
+// 全部无进展时在门铃上等待，不再每个手柄各开一个线程。
+//
+class sink_worker
+{
+public:
+    sink_worker() = default;
+    ~sink_worker() { stop(); }
+
+    sink_worker(const sink_worker&) = delete;
+    sink_worker& operator=(const sink_worker&) = delete;
+
+    // 添加 / 移除消费者；remove 返回后该消费者不会再被 pump
+    void add(sink_consumer* consumer);
+    void remove(sink_consumer* consumer);
+
+    // 交给 audio_ring::attach
+    std::atomic<uint32_t>* doorbell() { return &doorbell_; }
+
+    void start();
+    void stop();
+
+private:
+    void run(std::stop_token stoken);
+    void ring();
+
+    std::mutex mutex_;
+    std::vector<sink_consumer*> consumers_;
+    std::atomic<uint32_t> doorbell_ = 0;
+    std::jthread thread_;
+};
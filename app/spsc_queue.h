@@ -0,0 +1,64 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+//
+// 单生产者 / 单消费者无锁队列
+//
+// 容量固定为 2 的幂，槽位预先分配；head / tail 各占一条缓存行，
+// 避免生产者和消费者互相伪共享。
+//
+template <typename T, size_t Capacity>
+class spsc_queue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // 生产者调用，队列满时返回 false
+    bool push(const T& item)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ == Capacity)
+        {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ == Capacity)
+                return false;
+        }
+
+        slots_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者调用，队列空时返回 false
+    bool pop(T& item)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cachedTail_)
+        {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_)
+                return false;
+        }
+
+        item = slots_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const
+    {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    alignas(CACHE_LINE) std::atomic<size_t> head_ = 0;
+    size_t cachedTail_ = 0;  // 消费者本地缓存
+    alignas(CACHE_LINE) std::atomic<size_t> tail_ = 0;
+    size_t cachedHead_ = 0;  // 生产者本地缓存
+    alignas(CACHE_LINE) T slots_[Capacity];
+};
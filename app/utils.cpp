@@ -7,27 +7,6 @@
 
 using namespace std;
 
-uint32_t crc32(const uint8_t* data, size_t size) {
-    uint32_t crc = ~0xEADA2D49;  // 0xA2 seed
-
-    while (size--) {
-        crc ^= *data++;
-        for (unsigned i = 0; i < 8; i++)
-            crc = ((crc >> 1) ^ (0xEDB88320 & -(static_cast<int>(crc & 1))));
-    }
-
-    return ~crc;
-}
-
-void fill_output_report_checksum(uint8_t* outputData,size_t len)
-{
-    uint32_t crc = crc32(outputData, len - 4);
-    outputData[len - 4] = (crc >> 0) & 0xFF;
-    outputData[len - 3] = (crc >> 8) & 0xFF;
-    outputData[len - 2] = (crc >> 16) & 0xFF;
-    outputData[len - 1] = (crc >> 24) & 0xFF;
-}
-
 string hexStr(uint8_t* data, int len)
 {
     stringstream ss;
@@ -6,9 +6,9 @@
 #include <cstdint>
 #include <string>
 
-uint32_t crc32(const uint8_t* data, size_t size);
+#include "output_checksum.h"
+
 std::string hexStr(uint8_t* data, int len);
 std::wstring Win32ErrorToString(DWORD error);
-void fill_output_report_checksum(uint8_t* outputData,size_t len);
 
 #endif
\ No newline at end of file
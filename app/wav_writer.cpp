@@ -0,0 +1,221 @@
+﻿#include "wav_writer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+namespace
+{
+    //
+    // 固定 80 字节的文件头：
+    //   RIFF/RF64 (12) + JUNK/ds64 (8 + 28) + fmt (8 + 16) + data (8)
+    //
+    constexpr size_t DS64_SIZE = 28;
+    constexpr size_t HEADER_SIZE = 12 + 8 + DS64_SIZE + 8 + 16 + 8;
+
+    void put16(uint8_t*& p, uint16_t v)
+    {
+        memcpy(p, &v, 2);
+        p += 2;
+    }
+
+    void put32(uint8_t*& p, uint32_t v)
+    {
+        memcpy(p, &v, 4);
+        p += 4;
+    }
+
+    void put64(uint8_t*& p, uint64_t v)
+    {
+        memcpy(p, &v, 8);
+        p += 8;
+    }
+
+    void put_tag(uint8_t*& p, const char* tag)
+    {
+        memcpy(p, tag, 4);
+        p += 4;
+    }
+
+    void build_header(uint8_t (&header)[HEADER_SIZE], const wav_format& format, uint32_t blockAlign, uint64_t dataSize,
+                      uint64_t riffLimit)
+    {
+        const uint64_t riffSize = HEADER_SIZE - 8 + dataSize;
+        const bool rf64 = riffSize > riffLimit;
+        uint8_t* p = header;
+
+        put_tag(p, rf64 ? "RF64" : "RIFF");
+        put32(p, rf64 ? 0xFFFFFFFF : static_cast<uint32_t>(riffSize));
+        put_tag(p, "WAVE");
+
+        put_tag(p, rf64 ? "ds64" : "JUNK");
+        put32(p, DS64_SIZE);
+        put64(p, rf64 ? riffSize : 0);
+        put64(p, rf64 ? dataSize : 0);
+        put64(p, rf64 ? dataSize / blockAlign : 0);
+        put32(p, 0);  // table length
+
+        put_tag(p, "fmt ");
+        put32(p, 16);
+        put16(p, 1);  // PCM
+        put16(p, format.channels);
+        put32(p, format.sampleRate);
+        put32(p, format.sampleRate * blockAlign);
+        put16(p, static_cast<uint16_t>(blockAlign));
+        put16(p, format.bitsPerSample);
+
+        put_tag(p, "data");
+        put32(p, rf64 ? 0xFFFFFFFF : static_cast<uint32_t>(dataSize));
+    }
+}
+
+wav_writer::wav_writer(string path, const wav_format& format, const wav_writer_options& options)
+    : path_(move(path)), format_(format), options_(options),
+      blockAlign_(format.channels * (format.bitsPerSample / 8)),
+      chunkSize_(max<size_t>(1, options.chunkSize)),
+      chunk_(chunkSize_)
+{
+}
+
+wav_writer::~wav_writer()
+{
+    close();
+}
+
+string wav_writer::segment_path() const
+{
+    if (options_.segmentBytes == 0 && options_.segmentSeconds == 0)
+        return path_;
+
+    // name.wav -> name_000.wav
+    const size_t dot = path_.find_last_of('.');
+    const string stem = dot == string::npos ? path_ : path_.substr(0, dot);
+    const string ext = dot == string::npos ? ".wav" : path_.substr(dot);
+
+    char index[16];
+    snprintf(index, sizeof(index), "_%03u", segmentIndex_);
+    return stem + index + ext;
+}
+
+uint64_t wav_writer::segment_limit() const
+{
+    uint64_t limit = UINT64_MAX;
+
+    if (options_.segmentBytes != 0)
+        limit = min(limit, options_.segmentBytes);
+    if (options_.segmentSeconds != 0)
+        limit = min(limit, static_cast<uint64_t>(options_.segmentSeconds) * format_.sampleRate * blockAlign_);
+
+    // 分段边界必须落在整帧上
+    return max<uint64_t>(blockAlign_, limit - limit % blockAlign_);
+}
+
+bool wav_writer::open_segment()
+{
+    const string name = segment_path();
+
+    file_.rdbuf()->pubsetbuf(nullptr, 0);
+    file_.open(name, ios::binary | ios::trunc);
+    if (!file_.is_open())
+    {
+        cerr << "[WAV] Failed to open " << name << " for writing." << endl;
+        failed_ = true;
+        return false;
+    }
+
+    segmentBytes_ = 0;
+    flushedBytes_ = 0;
+    patch_header();
+    return !failed_;
+}
+
+void wav_writer::close_segment()
+{
+    if (!file_.is_open())
+        return;
+
+    flush_chunk();
+    file_.close();
+
+    const double durationSec = static_cast<double>(segmentBytes_) / (static_cast<double>(format_.sampleRate) * blockAlign_);
+    cout << "[WAV] Saved " << segment_path()
+         << " (" << segmentBytes_ << " bytes, "
+         << fixed << setprecision(2) << durationSec << "s)"
+         << endl;
+
+    segmentIndex_++;
+}
+
+bool wav_writer::flush_chunk()
+{
+    if (chunkUsed_ == 0)
+        return true;
+
+    file_.seekp(static_cast<streamoff>(HEADER_SIZE + flushedBytes_));
+    file_.write(reinterpret_cast<const char*>(chunk_.data()), static_cast<streamsize>(chunkUsed_));
+    if (!file_)
+    {
+        cerr << "[WAV] Write failed, recording stopped." << endl;
+        failed_ = true;
+        return false;
+    }
+
+    flushedBytes_ += chunkUsed_;
+    chunkUsed_ = 0;
+
+    // 每落盘一块就回写长度，崩溃时文件仍然完整
+    patch_header();
+    return !failed_;
+}
+
+void wav_writer::patch_header()
+{
+    uint8_t header[HEADER_SIZE];
+    build_header(header, format_, blockAlign_, flushedBytes_, options_.riffLimit);
+
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file_.flush();
+    if (!file_)
+        failed_ = true;
+}
+
+bool wav_writer::write(const uint8_t* data, size_t size)
+{
+    if (failed_)
+        return false;
+
+    const uint64_t limit = segment_limit();
+
+    while (size > 0)
+    {
+        if (!file_.is_open() && !open_segment())
+            return false;
+
+        const size_t room = min<uint64_t>(chunkSize_ - chunkUsed_, limit - segmentBytes_);
+        const size_t len = min(size, room);
+
+        memcpy(chunk_.data() + chunkUsed_, data, len);
+        chunkUsed_ += len;
+        segmentBytes_ += len;
+        totalBytes_ += len;
+        data += len;
+        size -= len;
+
+        if (segmentBytes_ == limit)
+            close_segment();
+        else if (chunkUsed_ == chunkSize_ && !flush_chunk())
+            return false;
+    }
+
+    return true;
+}
+
+void wav_writer::close()
+{
+    close_segment();
+}
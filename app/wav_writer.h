@@ -0,0 +1,73 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct wav_format
+{
+    uint16_t channels;
+    uint32_t sampleRate;
+    uint16_t bitsPerSample;
+};
+
+struct wav_writer_options
+{
+    // 单个分段的上限，0 表示不限制；两者都设置时先到先切
+    uint64_t segmentBytes = 0;
+    uint32_t segmentSeconds = 0;
+    // 写盘块大小：攒满一块才写一次盘并回写文件头
+    size_t chunkSize = 256 * 1024;
+    // RIFF 长度超过该值时改写为 RF64，默认是 32 位长度的上限，测试可以调低
+    uint64_t riffLimit = 0xFFFFFFFFull;
+};
+
+//
+// 流式 WAV 写入
+//
+// PCM 先攒进块缓冲，满一块写一次盘（文件流本身不缓冲），随后回写 RIFF / data
+// 长度，进程崩溃时文件依然可以播放。内存占用只有一个块。
+//
+// 文件头预留 JUNK 块，数据超过 4 GB 时原地改写成 RF64 + ds64，
+// 不必搬移数据。设置了分段上限时按 name_000.wav、name_001.wav ... 切分。
+//
+class wav_writer
+{
+public:
+    wav_writer(std::string path, const wav_format& format, const wav_writer_options& options = {});
+    ~wav_writer();
+
+    wav_writer(const wav_writer&) = delete;
+    wav_writer& operator=(const wav_writer&) = delete;
+
+    bool write(const uint8_t* data, size_t size);
+    void close();
+
+    uint64_t total_bytes() const { return totalBytes_; }
+    uint32_t segments() const { return segmentIndex_; }
+
+private:
+    bool open_segment();
+    void close_segment();
+    bool flush_chunk();
+    void patch_header();
+    std::string segment_path() const;
+    uint64_t segment_limit() const;
+
+    const std::string path_;
+    const wav_format format_;
+    const wav_writer_options options_;
+    const uint32_t blockAlign_;
+    const size_t chunkSize_;
+
+    std::ofstream file_;
+    std::vector<uint8_t> chunk_;
+    size_t chunkUsed_ = 0;
+
+    uint64_t segmentBytes_ = 0;   // 当前分段的 PCM 字节数（含未落盘部分）
+    uint64_t flushedBytes_ = 0;   // 当前分段已落盘的 PCM 字节数
+    uint32_t segmentIndex_ = 0;
+    uint64_t totalBytes_ = 0;
+    bool failed_ = false;
+};
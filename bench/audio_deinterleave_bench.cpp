@@ -0,0 +1,60 @@
+#include "audio_deinterleave.h"
+#include "bench.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//
+// 4 声道拆分：逐帧标量循环 vs 运行时选中的内核
+//
+// 48 帧是 1 ms 的 USB 包，512 帧是触觉处理的一块，4800 帧是 100 ms
+//
+namespace
+{
+    void deinterleave_reference(const int16_t* in, size_t frames, const ds5_audio_planes& out)
+    {
+        for (size_t i = 0; i < frames; i++)
+        {
+            out.speakerL[i] = in[4 * i + 0] * (1.0f / 32768.0f);
+            out.speakerR[i] = in[4 * i + 1] * (1.0f / 32768.0f);
+            out.hapticL[i] = in[4 * i + 2] * (1.0f / 32768.0f);
+            out.hapticR[i] = in[4 * i + 3] * (1.0f / 32768.0f);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const bench_options options(argc, argv);
+
+    constexpr size_t MAX_FRAMES = 4800;
+    std::vector<int16_t> in(4 * MAX_FRAMES);
+    std::mt19937 rng(1);
+    for (auto& s : in)
+        s = static_cast<int16_t>(rng());
+
+    std::vector<float> planes(4 * MAX_FRAMES);
+    const ds5_audio_planes out = { &planes[0], &planes[MAX_FRAMES], &planes[2 * MAX_FRAMES], &planes[3 * MAX_FRAMES] };
+
+    std::printf("kernel: %s\n", ds5_deinterleave_kernel_name());
+    std::printf("%8s %14s %14s %10s %16s\n", "frames", "scalar ns", "kernel ns", "speedup", "kernel Mframe/s");
+
+    for (const size_t frames : { 48, 512, 4800 })
+    {
+        const double scalar = bench_ns_per_call(options, [&] {
+            deinterleave_reference(in.data(), frames, out);
+            bench_keep(planes[frames - 1]);
+        });
+
+        const double kernel = bench_ns_per_call(options, [&] {
+            ds5_deinterleave(in.data(), frames, out);
+            bench_keep(planes[frames - 1]);
+        });
+
+        std::printf("%8zu %14.1f %14.1f %9.1fx %16.1f\n", frames, scalar, kernel, scalar / kernel, frames * 1000.0 / kernel);
+    }
+
+    return 0;
+}
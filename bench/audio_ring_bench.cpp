@@ -0,0 +1,139 @@
+#include "audio_ring.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// 音频环形缓冲压力测试
+//
+// 1. 合成生产者按 48 kHz × 4 声道 16 位的实时节奏每 1 ms 写一包 (384 字节)，
+//    消费者像触觉处理一样每 512 帧 (约 10.7 ms) 取一块，统计 overflow / underrun
+//    和生产者单次写入（含唤醒）的耗时
+// 2. 不限速吞吐：audio_ring 对比原来的全局 vector + mutex 追加
+//
+namespace
+{
+    using namespace std::chrono;
+
+    constexpr unsigned SAMPLE_RATE = 48000;
+    constexpr size_t FRAME_SIZE = 4 * sizeof(int16_t);
+    constexpr size_t PACKET_FRAMES = SAMPLE_RATE / 1000;
+    constexpr size_t PACKET_SIZE = PACKET_FRAMES * FRAME_SIZE;      // 384
+    constexpr size_t BLOCK_SIZE = 512 * FRAME_SIZE;                 // 4096
+    constexpr size_t RING_CAPACITY = 1 << 20;
+
+    void realtime(const bench_options& options)
+    {
+        audio_ring ring(RING_CAPACITY);
+        const unsigned packets = options.quick ? 100 : 5000;
+
+        std::atomic<bool> done = false;
+        std::vector<uint64_t> lag;
+        lag.reserve(packets);
+        uint64_t blocks = 0;
+
+        const auto begin = steady_clock::now();
+        std::jthread consumer([&] {
+            uint8_t block[BLOCK_SIZE];
+            constexpr auto period = nanoseconds(1'000'000'000ull * 512 / SAMPLE_RATE);
+            // 首块留半个周期余量，和实际处理线程一样先攒够一块再开始
+            auto next = begin + period + period / 2;
+            while (!done.load())
+            {
+                std::this_thread::sleep_until(next);
+                next += period;
+                blocks += ring.read_exact(block, sizeof(block)) ? 1 : 0;
+            }
+        });
+
+        uint8_t packet[PACKET_SIZE] = {};
+        auto next = begin;
+        for (unsigned i = 0; i < packets; i++)
+        {
+            next += microseconds(1000);
+            std::this_thread::sleep_until(next);
+            const auto start = steady_clock::now();
+            ring.write(packet, sizeof(packet));
+            lag.push_back(duration_cast<nanoseconds>(steady_clock::now() - start).count());
+        }
+
+        done = true;
+        consumer.join();
+
+        std::sort(lag.begin(), lag.end());
+        std::printf("realtime 48 kHz x 4 ch, %u packets of %zu bytes\n", packets, PACKET_SIZE);
+        std::printf("  blocks read %llu, overflows %llu, underruns %llu\n",
+                    static_cast<unsigned long long>(blocks),
+                    static_cast<unsigned long long>(ring.overflows()),
+                    static_cast<unsigned long long>(ring.underruns()));
+        std::printf("  producer write ns: p50 %llu  p99 %llu  max %llu\n",
+                    static_cast<unsigned long long>(lag[lag.size() / 2]),
+                    static_cast<unsigned long long>(lag[lag.size() * 99 / 100]),
+                    static_cast<unsigned long long>(lag.back()));
+    }
+
+    // 原实现：每包在锁内追加到不断增长的 vector
+    double vector_append(const bench_options& options)
+    {
+        std::mutex mutex;
+        std::vector<uint8_t> recording;
+        const uint8_t packet[PACKET_SIZE] = {};
+
+        const double ns = bench_ns_per_call(options, [&] {
+            std::lock_guard lock(mutex);
+            recording.insert(recording.end(), packet, packet + sizeof(packet));
+        });
+        bench_keep(recording.size());
+        return ns;
+    }
+
+    // 生产者与消费者在两个线程上，生产者写满时自旋等待
+    double ring_throughput(const bench_options& options)
+    {
+        audio_ring ring(RING_CAPACITY);
+        std::atomic<bool> done = false;
+
+        std::jthread consumer([&] {
+            uint8_t block[BLOCK_SIZE];
+            while (!done.load(std::memory_order_relaxed) || ring.size() != 0)
+            {
+                if (!ring.read_exact(block, sizeof(block)))
+                    std::this_thread::yield();
+            }
+        });
+
+        const uint8_t packet[PACKET_SIZE] = {};
+        const double ns = bench_ns_per_call(options, [&] {
+            while (!ring.write(packet, sizeof(packet)))
+                std::this_thread::yield();
+        });
+
+        done = true;
+        // 剩余不足一块的尾巴直接读掉
+        uint8_t tail[BLOCK_SIZE];
+        while (ring.size() != 0)
+            ring.read(tail, sizeof(tail));
+        return ns;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const bench_options options(argc, argv);
+
+    realtime(options);
+
+    const double vector = vector_append(options);
+    const double ring = ring_throughput(options);
+    std::printf("%-24s %10s %10s\n", "per 384-byte packet", "ns", "GB/s");
+    std::printf("%-24s %10.1f %10.2f\n", "vector + mutex", vector, PACKET_SIZE / vector);
+    std::printf("%-24s %10.1f %10.2f\n", "audio_ring", ring, PACKET_SIZE / ring);
+
+    return 0;
+}
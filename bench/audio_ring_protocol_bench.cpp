@@ -0,0 +1,182 @@
+#include "bench.h"
+
+#include <AudioRing.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+//
+// AudioRing.h at 48 kHz x 4 ch 16-bit: the bus writes one 10 ms ISO OUT
+// URB (3840 bytes) at a time and rings a doorbell when WakeThreshold bytes
+// are readable; the consumer reads in place and parks on the doorbell when
+// the ring is empty.
+//
+//   realtime: paced producer, reports drops, doorbells per URB and bytes
+//             copied per URB next to the three-copy await path
+//   unpaced:  cost per URB through the ring with a consumer draining flat
+//             out, the producer yielding while the ring is full
+//
+namespace
+{
+	using namespace std::chrono;
+	using namespace ViGEm::Audio;
+
+	constexpr unsigned long URB_SIZE = 48 * 8 * 10;
+	constexpr unsigned long CAPACITY = 64 * 1024;
+
+	struct shared_ring
+	{
+		shared_ring() : storage((sizeof(AUDIO_RING_HEADER) + CAPACITY) / 64) {}
+
+		AUDIO_RING_HEADER* header() { return reinterpret_cast<AUDIO_RING_HEADER*>(storage.data()); }
+
+		struct alignas(64) line { unsigned char bytes[64]; };
+		std::vector<line> storage;
+	};
+
+	// Stands in for the doorbell IOCTL
+	struct doorbell
+	{
+		std::atomic<uint32_t> rings = 0;
+
+		void ring()
+		{
+			rings.fetch_add(1, std::memory_order_release);
+			rings.notify_one();
+		}
+	};
+
+	struct consumer_stats
+	{
+		uint64_t bytes = 0;
+		uint64_t parks = 0;
+	};
+
+	// Drains the ring in place; parks with WakeThreshold = 1 when empty
+	void consume(shared_ring& shared, doorbell& bell, std::atomic<bool>& done, consumer_stats& stats)
+	{
+		AUDIO_RING_HEADER* header = shared.header();
+		uint32_t checksum = 0;
+
+		while (true)
+		{
+			const uint32_t seen = bell.rings.load(std::memory_order_acquire);
+			AudioRingSpans spans;
+			const unsigned long used = PeekAudioRing(header, &spans);
+			if (used == 0)
+			{
+				if (done.load())
+					break;
+				header->WakeThreshold = 1;
+				stats.parks++;
+				bell.rings.wait(seen);
+				continue;
+			}
+
+			checksum += spans.First[0] + (spans.SecondLength ? spans.Second[0] : 0);
+			ReleaseAudioRing(header, used);
+			stats.bytes += used;
+		}
+
+		bench_keep(checksum);
+	}
+
+	void produce(AudioRingProducer& producer, doorbell& bell, const unsigned char* urb)
+	{
+		if (producer.Reserve(URB_SIZE))
+		{
+			producer.Stage(0, urb, URB_SIZE);
+			producer.Commit(URB_SIZE);
+		}
+		if (producer.ShouldWake())
+		{
+			producer.Ring->WakeThreshold = 1 << 30;
+			bell.ring();
+		}
+	}
+
+	void realtime(const bench_options& options)
+	{
+		shared_ring shared;
+		AudioRingProducer producer;
+		producer.Attach(shared.header(), CAPACITY);
+
+		doorbell bell;
+		std::atomic<bool> done = false;
+		consumer_stats stats;
+		std::thread consumer([&] { consume(shared, bell, done, stats); });
+
+		const unsigned int urbs = options.quick ? 20 : 500;
+		std::vector<unsigned char> urb(URB_SIZE, 0x11);
+		auto next = steady_clock::now();
+		for (unsigned int i = 0; i < urbs; i++)
+		{
+			next += milliseconds(10);
+			std::this_thread::sleep_until(next);
+			produce(producer, bell, urb.data());
+		}
+
+		done = true;
+		bell.ring();
+		consumer.join();
+
+		// Await path: ISO packets to the stack buffer, DMF to the request,
+		// client to its own buffer
+		std::printf("realtime 48 kHz x 4 ch, %u URBs of %lu bytes\n", urbs, URB_SIZE);
+		std::printf("  consumed %llu bytes, dropped %ld, doorbells %.2f per URB\n",
+			static_cast<unsigned long long>(stats.bytes), shared.header()->DroppedBytes,
+			static_cast<double>(bell.rings.load()) / urbs);
+		std::printf("  bytes copied per URB: ring %lu, three-copy await path %lu\n", URB_SIZE, 3 * URB_SIZE);
+	}
+
+	void unpaced(const bench_options& options)
+	{
+		shared_ring shared;
+		AudioRingProducer producer;
+		producer.Attach(shared.header(), CAPACITY);
+
+		doorbell bell;
+		std::atomic<bool> done = false;
+		consumer_stats stats;
+		std::thread consumer([&] { consume(shared, bell, done, stats); });
+
+		std::vector<unsigned char> urb(URB_SIZE, 0x22);
+		const double ns = bench_ns_per_call(options, [&] {
+			while (producer.Capacity - producer.Used() < URB_SIZE)
+				std::this_thread::yield();
+			produce(producer, bell, urb.data());
+		});
+
+		done = true;
+		bell.ring();
+		consumer.join();
+
+		std::vector<unsigned char> copy(URB_SIZE);
+		const double copyNs = bench_ns_per_call(options, [&] {
+			std::memcpy(copy.data(), urb.data(), URB_SIZE);
+			bench_keep(copy[0]);
+		});
+
+		std::printf("unpaced: %.1f ns per URB written (%.2f GB/s), memcpy of one URB %.1f ns\n",
+			ns, URB_SIZE / ns, copyNs);
+		std::printf("  consumed %llu bytes, dropped %ld, consumer parked %llu times\n",
+			static_cast<unsigned long long>(stats.bytes), shared.header()->DroppedBytes,
+			static_cast<unsigned long long>(stats.parks));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bench_options options(argc, argv);
+
+	realtime(options);
+	unpaced(options);
+
+	return 0;
+}
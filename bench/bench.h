@@ -0,0 +1,64 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+//
+// 基准测试的公共部分：--quick 时只跑很短的时间，供 ctest 验证能编译运行
+//
+struct bench_options
+{
+    bool quick = false;
+
+    bench_options(int argc, char** argv)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            if (std::strcmp(argv[i], "--quick") == 0)
+                quick = true;
+        }
+    }
+
+    // 单项测量的最短时长
+    std::chrono::nanoseconds budget() const
+    {
+        return quick ? std::chrono::milliseconds(10) : std::chrono::milliseconds(500);
+    }
+};
+
+//
+// 反复调用 fn 直到用完时间预算，返回每次调用的平均纳秒数
+//
+template <typename Fn>
+double bench_ns_per_call(const bench_options& options, Fn&& fn)
+{
+    using clock = std::chrono::steady_clock;
+
+    uint64_t calls = 0;
+    uint64_t batch = 1;
+    const auto start = clock::now();
+    auto elapsed = clock::duration::zero();
+
+    while (elapsed < options.budget())
+    {
+        for (uint64_t i = 0; i < batch; i++)
+            fn();
+        calls += batch;
+        batch *= 2;
+        elapsed = clock::now() - start;
+    }
+
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / calls;
+}
+
+// 防止被测结果被优化掉
+template <typename T>
+inline void bench_keep(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile T sink;
+    sink = value;
+#endif
+}
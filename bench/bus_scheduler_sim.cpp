@@ -0,0 +1,162 @@
+#include "bench.h"
+
+#include <DeadlineHeap.h>
+#include <FrameClock.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+//
+// DPCs per second at 1 / 16 / 64 DS5 targets, in virtual time, with the
+// pads idle (interrupt IN polling every 6 ms only) and with audio playing
+// (plus ISO OUT pacing due every 10 ms URB), each at a random phase.
+//
+//   per-PDO timers: every target runs a 6 ms polling timer, and a 10 ms
+//                   ISO timer while audio plays, each expiry a DPC of its
+//                   own
+//   bus scheduler:  one one-shot timer armed for the earliest deadline
+//                   (floored at 1 ms), servicing all due work in one batch
+//                   through the same DeadlineHeap helpers BusScheduler::Tick
+//                   and ServicePolling use
+//
+// Besides DPC counts the simulation reports batch sizes, how late work is
+// serviced and the measured heap cost per tick.
+//
+namespace
+{
+	using namespace std::chrono;
+	using ViGEm::Timing::DeadlineHeap;
+	using ViGEm::Timing::DueWork;
+	using ViGEm::Timing::MicroframesPerFrame;
+	using ViGEm::Timing::MicroframesPerSecond;
+	using ViGEm::Timing::NextPeriodicDeadline;
+	using ViGEm::Timing::TimerDelay;
+
+	constexpr unsigned long MAX_TARGETS = 64;
+	constexpr unsigned long WORK_COUNT = 2;  // InterruptIn, IsoOut
+	constexpr unsigned long long POLL_PERIOD = 6 * MicroframesPerFrame;
+	constexpr unsigned long long ISO_PERIOD = 10 * MicroframesPerFrame;
+	constexpr unsigned long long MIN_DELAY = MicroframesPerFrame;
+
+	// Per-PDO timers run in 1/8 microframe steps so their phases don't all
+	// line up on microframe boundaries
+	constexpr unsigned long long SUBSTEPS = 8;
+
+	struct result
+	{
+		double dpcsPerSecond;
+		double averageBatch;
+		unsigned long peakBatch;
+		unsigned long long maxLateMicroframes;
+		double heapNsPerTick;
+	};
+
+	unsigned long long period_of(unsigned long id)
+	{
+		return id % WORK_COUNT == 0 ? POLL_PERIOD : ISO_PERIOD;
+	}
+
+	result per_pdo_timers(unsigned long targets, bool audio, unsigned long long seconds)
+	{
+		std::mt19937 rng(targets);
+		const unsigned long long end = seconds * MicroframesPerSecond * SUBSTEPS;
+
+		unsigned long long dpcs = 0;
+		for (unsigned long t = 0; t < targets; t++)
+		{
+			for (unsigned long work = 0; work < (audio ? WORK_COUNT : 1); work++)
+			{
+				const unsigned long long period = period_of(work) * SUBSTEPS;
+
+				for (unsigned long long at = rng() % period; at < end; at += period)
+					dpcs++;
+			}
+		}
+
+		return { static_cast<double>(dpcs) / seconds, 1.0, 1, 0, 0.0 };
+	}
+
+	result bus_scheduler(unsigned long targets, bool audio, unsigned long long seconds)
+	{
+		static DeadlineHeap<MAX_TARGETS * WORK_COUNT> heap;
+		static DueWork batch[MAX_TARGETS * WORK_COUNT];
+		heap.Init();
+
+		std::mt19937 rng(targets);
+		for (unsigned long t = 0; t < targets; t++)
+		{
+			heap.Schedule(t * WORK_COUNT + 0, 1 + rng() % POLL_PERIOD);
+			if (audio)
+				heap.Schedule(t * WORK_COUNT + 1, 1 + rng() % ISO_PERIOD);
+		}
+
+		const unsigned long long end = seconds * MicroframesPerSecond;
+		unsigned long long ticks = 0, serviced = 0, maxLate = 0;
+		unsigned long peakBatch = 0;
+		nanoseconds heapTime{ 0 };
+
+		// First Schedule arms the timer
+		unsigned long long now = TimerDelay(heap.NextDeadline(), 0, MIN_DELAY);
+
+		while (now <= end && !heap.IsEmpty())
+		{
+			ticks++;
+			const auto start = steady_clock::now();
+
+			const unsigned long count = heap.PopAllDue(now, batch);
+
+			for (unsigned long i = 0; i < count; i++)
+			{
+				maxLate = std::max(maxLate, now - batch[i].Deadline);
+
+				// Polling and ISO pacing both stay on their grid
+				batch[i].Next = NextPeriodicDeadline(batch[i].Deadline, period_of(batch[i].Id), now);
+			}
+
+			heap.Requeue(batch, count, [](unsigned long) { return true; });
+
+			heapTime += steady_clock::now() - start;
+			serviced += count;
+			peakBatch = std::max(peakBatch, count);
+
+			// Tick re-arms the one-shot timer for the earliest deadline
+			now += TimerDelay(heap.NextDeadline(), now, MIN_DELAY);
+		}
+
+		return { static_cast<double>(ticks) / seconds,
+				 static_cast<double>(serviced) / ticks, peakBatch, maxLate,
+				 static_cast<double>(heapTime.count()) / ticks };
+	}
+
+	void print(const char* model, const char* load, unsigned long targets, const result& r)
+	{
+		std::printf("%-14s %-6s %8lu %10.0f %10.2f %8lu %12llu %12.1f\n",
+			model, load, targets, r.dpcsPerSecond, r.averageBatch, r.peakBatch,
+			r.maxLateMicroframes, r.heapNsPerTick);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bench_options options(argc, argv);
+	const unsigned long long seconds = options.quick ? 1 : 10;
+
+	std::printf("%-14s %-6s %8s %10s %10s %8s %12s %12s\n",
+		"model", "load", "targets", "DPC/s", "avg batch", "peak", "max late uf", "heap ns/tick");
+
+	for (const bool audio : { false, true })
+	{
+		const char* load = audio ? "audio" : "idle";
+
+		for (const unsigned long targets : { 1ul, 16ul, 64ul })
+		{
+			print("per-PDO timers", load, targets, per_pdo_timers(targets, audio, seconds));
+			print("bus scheduler", load, targets, bus_scheduler(targets, audio, seconds));
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,145 @@
+#include "bench.h"
+
+#include <InputSlot.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+//
+// InputSlot costs for a 64-byte DS5 report:
+//   publish / read on an idle slot
+//   a feeder publishing flat out while the bus polls, versus handing every
+//   report to the consumer thread under a lock (the shape of one request
+//   per report)
+//
+namespace
+{
+	using namespace ViGEm::Reports;
+
+	struct contended
+	{
+		double publishNs;
+		unsigned long long published;
+		unsigned long long updated;
+		unsigned long long torn;
+	};
+
+	contended slot_contended(const bench_options& options)
+	{
+		INPUT_SLOT slot = {};
+		std::atomic<bool> done = false;
+		unsigned long long updated = 0, torn = 0;
+
+		std::thread bus([&] {
+			unsigned char read[InputSlotReportSize];
+			long last = 0;
+			while (!done.load(std::memory_order_relaxed))
+			{
+				switch (ReadInputSlot(&slot, read, sizeof(read), &last))
+				{
+				case InputSlotRead::Updated: updated++; break;
+				case InputSlotRead::Torn: torn++; break;
+				case InputSlotRead::Unchanged: std::this_thread::yield(); break;
+				}
+			}
+		});
+
+		unsigned char report[InputSlotReportSize] = {};
+		unsigned long long published = 0;
+		const double ns = bench_ns_per_call(options, [&] {
+			report[0]++;
+			PublishInputSlot(&slot, report, sizeof(report));
+			published++;
+		});
+
+		done = true;
+		bus.join();
+		return { ns, published, updated, torn };
+	}
+
+	double handoff(const bench_options& options)
+	{
+		std::mutex mutex;
+		std::condition_variable wake;
+		unsigned char pending[InputSlotReportSize] = {};
+		bool full = false;
+		bool done = false;
+
+		std::thread bus([&] {
+			unsigned char read[InputSlotReportSize];
+			std::unique_lock lock(mutex);
+			while (true)
+			{
+				wake.wait(lock, [&] { return full || done; });
+				if (full)
+				{
+					std::memcpy(read, pending, sizeof(read));
+					full = false;
+					wake.notify_all();
+				}
+				else
+				{
+					return;
+				}
+			}
+		});
+
+		unsigned char report[InputSlotReportSize] = {};
+		const double ns = bench_ns_per_call(options, [&] {
+			report[0]++;
+			std::unique_lock lock(mutex);
+			wake.wait(lock, [&] { return !full; });
+			std::memcpy(pending, report, sizeof(report));
+			full = true;
+			wake.notify_all();
+		});
+
+		{
+			std::scoped_lock lock(mutex);
+			done = true;
+		}
+		wake.notify_all();
+		bus.join();
+		return ns;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bench_options options(argc, argv);
+
+	INPUT_SLOT slot = {};
+	unsigned char report[InputSlotReportSize] = {};
+	unsigned char read[InputSlotReportSize];
+	long last = 0;
+
+	const double publish = bench_ns_per_call(options, [&] {
+		report[0]++;
+		PublishInputSlot(&slot, report, sizeof(report));
+	});
+
+	const double readUpdated = bench_ns_per_call(options, [&] {
+		slot.Sequence = slot.Sequence + 2;
+		bench_keep(ReadInputSlot(&slot, read, sizeof(read), &last));
+	});
+
+	const double readUnchanged = bench_ns_per_call(options, [&] {
+		bench_keep(ReadInputSlot(&slot, read, sizeof(read), &last));
+	});
+
+	std::printf("%-32s %10.1f ns\n", "publish (idle slot)", publish);
+	std::printf("%-32s %10.1f ns\n", "read, updated", readUpdated);
+	std::printf("%-32s %10.1f ns\n", "read, unchanged", readUnchanged);
+
+	const contended c = slot_contended(options);
+	std::printf("%-32s %10.1f ns  (%llu published, bus saw %llu, %llu torn polls)\n",
+		"publish while bus polls", c.publishNs, c.published, c.updated, c.torn);
+	std::printf("%-32s %10.1f ns\n", "per-report handoff", handoff(options));
+
+	return 0;
+}
@@ -0,0 +1,223 @@
+#include "bench.h"
+
+#include <NotificationBacklog.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+//
+// Wake-ups per delivered DS5 output report, 1 / 4 / 16 targets with one
+// waiting client thread each.
+//
+//   broadcast: every report completes every parked await, clients filter
+//              by serial and await again (the bus-wide DMF module)
+//   keyed:     a report completes the oldest await of its own target only
+//              (NotificationChannel), others stay asleep
+//
+// The producer delivers reports round-robin and waits until every client
+// has parked again, so each delivery sees the same set of waiters.
+//
+namespace
+{
+	using namespace std::chrono;
+	using namespace ViGEm::Notifications;
+
+	constexpr unsigned long REPORT_SIZE = 64;
+	constexpr unsigned long BACKLOG = 8;
+
+	struct client
+	{
+		unsigned int serial = 0;
+		std::binary_semaphore wake{ 0 };
+		unsigned char buffer[REPORT_SIZE] = {};
+		bool stop = false;
+		uint64_t wakeups = 0;
+		uint64_t delivered = 0;
+		std::thread thread;
+	};
+
+	class hub
+	{
+	public:
+		hub(size_t targets, bool keyed) : keyed_(keyed), channels_(targets) {}
+
+		// Client side: park, or take a backlog entry at once
+		void await(client& c)
+		{
+			std::unique_lock lock(mutex_);
+			if (keyed_)
+			{
+				unsigned long length;
+				if (channels_[c.serial].backlog.Take(c.buffer, &length))
+				{
+					c.wake.release();
+					return;
+				}
+				channels_[c.serial].parked.push_back(&c);
+			}
+			else
+			{
+				broadcast_.push_back(&c);
+			}
+			parked_.fetch_add(1);
+			parked_.notify_all();
+		}
+
+		void deliver(unsigned int serial, const unsigned char* report)
+		{
+			std::unique_lock lock(mutex_);
+			if (keyed_)
+			{
+				auto& channel = channels_[serial];
+				if (channel.parked.empty())
+				{
+					channel.backlog.Store(report, REPORT_SIZE);
+					return;
+				}
+				complete(*channel.parked.front(), report);
+				channel.parked.pop_front();
+				channel.backlog.CountRouted(REPORT_SIZE);
+				return;
+			}
+
+			for (client* c : broadcast_)
+				complete(*c, report);
+			broadcast_.clear();
+		}
+
+		void wait_parked(size_t count)
+		{
+			for (size_t seen = parked_.load(); seen < count; seen = parked_.load())
+				parked_.wait(seen);
+		}
+
+		void unpark_all()
+		{
+			std::unique_lock lock(mutex_);
+			for (auto& channel : channels_)
+			{
+				for (client* c : channel.parked)
+				{
+					c->stop = true;
+					c->wake.release();
+				}
+				channel.parked.clear();
+			}
+			for (client* c : broadcast_)
+			{
+				c->stop = true;
+				c->wake.release();
+			}
+			broadcast_.clear();
+		}
+
+	private:
+		void complete(client& c, const unsigned char* report)
+		{
+			std::memcpy(c.buffer, report, REPORT_SIZE);
+			parked_.fetch_sub(1);
+			c.wake.release();
+		}
+
+		struct channel
+		{
+			NotificationBacklog<REPORT_SIZE, BACKLOG> backlog;
+			std::deque<client*> parked;
+		};
+
+		const bool keyed_;
+		std::mutex mutex_;
+		std::vector<channel> channels_;
+		std::vector<client*> broadcast_;
+		std::atomic<size_t> parked_ = 0;
+	};
+
+	struct result
+	{
+		double wakeupsPerReport;
+		double nsPerReport;
+		uint64_t delivered;
+		uint64_t reports;
+	};
+
+	result run(size_t targets, bool keyed, unsigned int reports)
+	{
+		hub h(targets, keyed);
+		std::vector<std::unique_ptr<client>> clients;
+
+		for (size_t i = 0; i < targets; i++)
+		{
+			clients.push_back(std::make_unique<client>());
+			client& c = *clients.back();
+			c.serial = static_cast<unsigned int>(i);
+			c.thread = std::thread([&h, &c] {
+				while (true)
+				{
+					h.await(c);
+					c.wake.acquire();
+					if (c.stop)
+						return;
+					c.wakeups++;
+					if (c.buffer[0] == c.serial)
+						c.delivered++;
+				}
+			});
+		}
+
+		unsigned char report[REPORT_SIZE] = {};
+		h.wait_parked(targets);
+
+		const auto start = steady_clock::now();
+		for (unsigned int i = 0; i < reports; i++)
+		{
+			const unsigned int serial = static_cast<unsigned int>(i % targets);
+			report[0] = static_cast<unsigned char>(serial);
+			h.deliver(serial, report);
+			h.wait_parked(targets);
+		}
+		const auto elapsed = steady_clock::now() - start;
+
+		h.unpark_all();
+		uint64_t wakeups = 0, delivered = 0;
+		for (auto& c : clients)
+		{
+			c->thread.join();
+			wakeups += c->wakeups;
+			delivered += c->delivered;
+		}
+
+		return { static_cast<double>(wakeups) / reports,
+				 static_cast<double>(duration_cast<nanoseconds>(elapsed).count()) / reports,
+				 delivered, reports };
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bench_options options(argc, argv);
+	const unsigned int reports = options.quick ? 2000 : 50000;
+
+	std::printf("%-10s %8s %12s %12s %20s\n", "routing", "targets", "wakeups/rpt", "ns/rpt", "delivered/reports");
+
+	for (const size_t targets : { 1, 4, 16 })
+	{
+		for (const bool keyed : { false, true })
+		{
+			const result r = run(targets, keyed, reports);
+			std::printf("%-10s %8zu %12.2f %12.0f %10llu/%-10llu\n",
+				keyed ? "keyed" : "broadcast", targets, r.wakeupsPerReport, r.nsPerReport,
+				static_cast<unsigned long long>(r.delivered), static_cast<unsigned long long>(r.reports));
+		}
+	}
+
+	return 0;
+}
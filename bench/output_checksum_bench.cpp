@@ -0,0 +1,88 @@
+#include "bench.h"
+#include "output_checksum.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+//
+// 蓝牙输出报文 (0x31, 78 字节) 的校验：每帧整帧重算 vs output_report_checksum
+//
+// 典型的输出流每帧只变序号，偶尔变马达或灯条；"other" 行每帧改动一个
+// 不在登记字段里的字节，增量路径退回整帧重算
+//
+namespace
+{
+    constexpr size_t REPORT_SIZE = 78;
+
+    enum class change { sequence, motors, lightbar, other };
+
+    void next_frame(uint8_t* report, uint8_t& seq, change kind, uint8_t value)
+    {
+        report[1] = static_cast<uint8_t>(seq++ << 4);
+
+        switch (kind)
+        {
+        case change::sequence:
+            break;
+        case change::motors:
+            report[5] = value;
+            break;
+        case change::lightbar:
+            report[47] = value;
+            break;
+        case change::other:
+            report[20] = value;
+            break;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const bench_options options(argc, argv);
+
+    uint8_t report[REPORT_SIZE] = {};
+    std::mt19937 rng(1);
+    for (auto& b : report)
+        b = static_cast<uint8_t>(rng());
+    report[0] = 0x31;
+    report[2] = 0x10;
+
+    std::printf("crc32 kernel: %s\n", crc32_kernel_name());
+    std::printf("%10s %12s %14s %10s\n", "change", "fill ns", "checksum ns", "speedup");
+
+    const struct
+    {
+        const char* name;
+        change kind;
+    } rows[] = {
+        { "sequence", change::sequence },
+        { "motors", change::motors },
+        { "lightbar", change::lightbar },
+        { "other", change::other },
+    };
+
+    for (const auto& row : rows)
+    {
+        uint8_t seq = 0;
+        uint8_t value = 0;
+
+        const double full = bench_ns_per_call(options, [&] {
+            next_frame(report, seq, row.kind, value++);
+            fill_output_report_checksum(report, REPORT_SIZE);
+        });
+        bench_keep(report[REPORT_SIZE - 1]);
+
+        output_report_checksum checksum(REPORT_SIZE);
+        const double incremental = bench_ns_per_call(options, [&] {
+            next_frame(report, seq, row.kind, value++);
+            checksum.fill(report);
+        });
+        bench_keep(report[REPORT_SIZE - 1]);
+
+        std::printf("%10s %12.1f %14.1f %9.1fx\n", row.name, full, incremental, full / incremental);
+    }
+
+    return 0;
+}
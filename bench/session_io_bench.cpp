@@ -0,0 +1,288 @@
+#include "bench.h"
+#include "fake_hid_device.h"
+#include "io_pool.h"
+#include "latency_histogram.h"
+
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// 1 / 4 / 16 个手柄会话的 I/O 线程模型对比
+//
+// 每个会话有两路输入：手柄 HID 输入报文 (1 kHz) 和驱动转来的输出报文 (250 Hz)，
+// 都由回环设备模拟，注入线程按实时节奏写入。
+//   thread-per-pad：每路一个线程阻塞读（完成时直接唤醒该线程）
+//   io_pool：所有会话的请求挂在 2 个池线程上，与 ds5_session 的结构相同
+// 统计注入到处理的延迟、线程数、每个报文的 CPU 时间和上下文切换次数。
+//
+namespace
+{
+    using namespace std::chrono;
+
+    constexpr size_t REPORT_SIZE = 78;
+    constexpr unsigned POOL_THREADS = 2;
+    constexpr unsigned OUTPUT_DIVIDER = 4;  // 输出报文每 4 个 tick 一个
+
+    void stamp(uint8_t* report)
+    {
+        std::memset(report, 0, REPORT_SIZE);
+        report[0] = 0x31;
+        const int64_t now = steady_clock::now().time_since_epoch().count();
+        std::memcpy(report + 1, &now, sizeof(now));
+    }
+
+    // 所有读路径共用的处理：记录延迟
+    struct sink
+    {
+        std::mutex mutex;
+        latency_histogram latency;
+        std::atomic<uint64_t> handled = 0;
+
+        void handle(const uint8_t* report)
+        {
+            int64_t injected;
+            std::memcpy(&injected, report + 1, sizeof(injected));
+            const int64_t now = steady_clock::now().time_since_epoch().count();
+            {
+                std::scoped_lock lock(mutex);
+                latency.record(now - injected);
+            }
+            handled.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    class pooled_reader : public io_loop
+    {
+    public:
+        pooled_reader(hid_device_io& device, sink& out) : device_(device), sink_(out) {}
+        ~pooled_reader() { stop(); }
+
+    private:
+        bool issue() override { return device_.read_async(buffer_, sizeof(buffer_), *this); }
+        void cancel() override { device_.cancel_read(); }
+
+        bool completed(bool ok, size_t) override
+        {
+            if (ok)
+                sink_.handle(buffer_);
+            return ok;
+        }
+
+        hid_device_io& device_;
+        sink& sink_;
+        uint8_t buffer_[128] = {};
+    };
+
+    // 阻塞读：发起请求后在条件变量上等完成
+    class blocking_reader : private io_pool::task
+    {
+    public:
+        blocking_reader(hid_device_io& device, sink& out)
+            : device_(device), sink_(out), thread_([this] { run(); })
+        {
+        }
+
+        ~blocking_reader() { thread_.join(); }
+
+    private:
+        void run()
+        {
+            while (true)
+            {
+                {
+                    std::scoped_lock lock(mutex_);
+                    done_ = false;
+                }
+                if (!device_.read_async(buffer_, sizeof(buffer_), *this))
+                    return;
+
+                std::unique_lock lock(mutex_);
+                wake_.wait(lock, [this] { return done_; });
+                if (!ok_)
+                    return;
+                lock.unlock();
+                sink_.handle(buffer_);
+            }
+        }
+
+        void complete(bool ok, size_t) override
+        {
+            std::scoped_lock lock(mutex_);
+            ok_ = ok;
+            done_ = true;
+            wake_.notify_one();
+        }
+
+        hid_device_io& device_;
+        sink& sink_;
+        uint8_t buffer_[128] = {};
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        bool done_ = false;
+        bool ok_ = false;
+        std::thread thread_;
+    };
+
+    struct session_devices
+    {
+        fake_hid_device input;
+        fake_hid_device output;
+    };
+
+    struct result
+    {
+        unsigned threads;
+        uint64_t handled;
+        uint64_t p50;
+        uint64_t p99;
+        uint64_t max;
+        double cpuNsPerReport;
+        double switchesPerReport;
+    };
+
+    struct usage
+    {
+        double cpuNs;
+        uint64_t switches;
+
+        static usage now()
+        {
+            rusage u = {};
+            getrusage(RUSAGE_SELF, &u);
+            const auto ns = [](const timeval& t) { return t.tv_sec * 1e9 + t.tv_usec * 1e3; };
+            return { ns(u.ru_utime) + ns(u.ru_stime), static_cast<uint64_t>(u.ru_nvcsw + u.ru_nivcsw) };
+        }
+    };
+
+    // 注入线程：每 1 ms 给每个会话一个输入报文，每 4 ms 一个输出报文
+    void inject(std::vector<std::unique_ptr<session_devices>>& sessions, unsigned ticks)
+    {
+        uint8_t report[REPORT_SIZE];
+        auto next = steady_clock::now();
+        for (unsigned t = 0; t < ticks; t++)
+        {
+            next += microseconds(1000);
+            std::this_thread::sleep_until(next);
+            for (auto& s : sessions)
+            {
+                stamp(report);
+                s->input.inject(report, sizeof(report));
+                if (t % OUTPUT_DIVIDER == 0)
+                    s->output.inject(report, sizeof(report));
+            }
+        }
+    }
+
+    uint64_t expected_reports(size_t sessions, unsigned ticks)
+    {
+        return sessions * (ticks + (ticks + OUTPUT_DIVIDER - 1) / OUTPUT_DIVIDER);
+    }
+
+    void wait_handled(sink& out, uint64_t expected)
+    {
+        const auto deadline = steady_clock::now() + seconds(5);
+        while (out.handled.load() < expected && steady_clock::now() < deadline)
+            std::this_thread::sleep_for(milliseconds(1));
+    }
+
+    result finish(sink& out, unsigned threads, const usage& before, const usage& after)
+    {
+        const uint64_t handled = out.handled.load();
+        return { threads, handled,
+                 out.latency.percentile(0.50), out.latency.percentile(0.99), out.latency.max(),
+                 (after.cpuNs - before.cpuNs) / handled,
+                 static_cast<double>(after.switches - before.switches) / handled };
+    }
+
+    result run_pooled(size_t count, unsigned ticks)
+    {
+        io_pool pool(POOL_THREADS);
+        pool.start();
+
+        std::vector<std::unique_ptr<session_devices>> sessions;
+        std::vector<std::unique_ptr<pooled_reader>> readers;
+        sink out;
+        for (size_t i = 0; i < count; i++)
+        {
+            sessions.push_back(std::make_unique<session_devices>());
+            sessions.back()->input.bind(pool);
+            sessions.back()->output.bind(pool);
+            readers.push_back(std::make_unique<pooled_reader>(sessions.back()->input, out));
+            readers.push_back(std::make_unique<pooled_reader>(sessions.back()->output, out));
+        }
+        for (auto& r : readers)
+            r->start();
+
+        const usage before = usage::now();
+        inject(sessions, ticks);
+        wait_handled(out, expected_reports(count, ticks));
+        const usage after = usage::now();
+
+        for (auto& r : readers)
+            r->stop();
+        pool.stop();
+        return finish(out, POOL_THREADS, before, after);
+    }
+
+    result run_thread_per_pad(size_t count, unsigned ticks)
+    {
+        std::vector<std::unique_ptr<session_devices>> sessions;
+        std::vector<std::unique_ptr<blocking_reader>> readers;
+        sink out;
+        for (size_t i = 0; i < count; i++)
+        {
+            sessions.push_back(std::make_unique<session_devices>());
+            readers.push_back(std::make_unique<blocking_reader>(sessions.back()->input, out));
+            readers.push_back(std::make_unique<blocking_reader>(sessions.back()->output, out));
+        }
+
+        const usage before = usage::now();
+        inject(sessions, ticks);
+        wait_handled(out, expected_reports(count, ticks));
+        const usage after = usage::now();
+
+        for (auto& s : sessions)
+        {
+            s->input.disconnect();
+            s->output.disconnect();
+        }
+        readers.clear();
+        return finish(out, static_cast<unsigned>(count * 2), before, after);
+    }
+
+    void print(const char* model, size_t sessions, const result& r, unsigned ticks)
+    {
+        std::printf("%-16s %8zu %8u %10llu/%-10llu %8.1f %8.1f %8.1f %10.0f %9.2f\n",
+            model, sessions, r.threads,
+            static_cast<unsigned long long>(r.handled),
+            static_cast<unsigned long long>(expected_reports(sessions, ticks)),
+            r.p50 / 1e3, r.p99 / 1e3, r.max / 1e3, r.cpuNsPerReport, r.switchesPerReport);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const bench_options options(argc, argv);
+    const unsigned ticks = options.quick ? 100 : 2000;
+
+    std::printf("%-16s %8s %8s %21s %8s %8s %8s %10s %9s\n",
+        "model", "sessions", "threads", "handled/expected", "p50 us", "p99 us", "max us", "cpu ns/rpt", "csw/rpt");
+
+    for (const size_t sessions : { 1, 4, 16 })
+    {
+        print("thread-per-pad", sessions, run_thread_per_pad(sessions, ticks), ticks);
+        print("io_pool", sessions, run_pooled(sessions, ticks), ticks);
+    }
+
+    return 0;
+}
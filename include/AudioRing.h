@@ -0,0 +1,249 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2022, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "ReportCache.h"
+
+//
+// Shared-memory audio ring: an opt-in alternative to one await IOCTL per
+// isochronous OUT URB for audio consumers.
+//
+// The consumer allocates an AUDIO_RING_HEADER followed by the data area and
+// hands it to the bus with IOCTL_VIGEM_ATTACH_AUDIO_RING (METHOD_OUT_DIRECT,
+// the ring is the output buffer). Like the input slot, the request stays
+// pending while the ring is attached and cancelling it detaches the ring.
+// The bus uses the largest power of two that fits as Capacity.
+//
+// Protocol: single producer (the bus, from the ISO OUT handler), single
+// consumer. Indices are free-running byte counts, each side only ever
+// writes its own. The producer writes a URB's audio in one go or drops it
+// whole if it doesn't fit, so the stream only ever contains complete
+// frames.
+//
+// A consumer that found the ring empty sends IOCTL_VIGEM_AUDIO_RING_DOORBELL
+// and blocks on it; the bus completes it once WakeThreshold bytes (or any,
+// if 0) are readable. Consumers that poll never need it.
+//
+// The producer must not trust the consumer: it keeps its own write index and
+// capacity and treats an impossible ReadIndex as a full ring.
+//
+// Portable (no CRT, no Windows headers required) so the protocol builds in
+// user mode and on other platforms.
+//
+
+#if defined(CTL_CODE)
+#define IOCTL_VIGEM_ATTACH_AUDIO_RING CTL_CODE(FILE_DEVICE_BUS_EXTENDER, 0xE02, METHOD_OUT_DIRECT, FILE_READ_DATA | FILE_WRITE_DATA)
+#define IOCTL_VIGEM_AUDIO_RING_DOORBELL CTL_CODE(FILE_DEVICE_BUS_EXTENDER, 0xE03, METHOD_BUFFERED, FILE_READ_DATA | FILE_WRITE_DATA)
+#endif
+
+namespace ViGEm::Audio
+{
+	namespace Detail = Reports::Detail;
+
+	constexpr unsigned long AudioRingMinCapacity = 4096;
+	constexpr unsigned long AudioRingMaxCapacity = 1024 * 1024;
+
+	//
+	// Input of both IOCTLs
+	//
+	typedef struct _AUDIO_RING_ATTACH
+	{
+		//
+		// sizeof(AUDIO_RING_ATTACH)
+		//
+		unsigned int Size;
+
+		unsigned int SerialNo;
+	} AUDIO_RING_ATTACH, *PAUDIO_RING_ATTACH;
+
+	//
+	// Producer and consumer fields live on separate cache lines
+	//
+	typedef struct _AUDIO_RING_HEADER
+	{
+		//
+		// Written by the bus
+		//
+		volatile long WriteIndex;
+		volatile long Capacity;
+		volatile long DroppedBytes;
+		unsigned char ProducerReserved[64 - 3 * sizeof(long)];
+
+		//
+		// Written by the consumer
+		//
+		volatile long ReadIndex;
+		volatile long WakeThreshold;
+		unsigned char ConsumerReserved[64 - 2 * sizeof(long)];
+	} AUDIO_RING_HEADER, *PAUDIO_RING_HEADER;
+
+	static_assert(sizeof(AUDIO_RING_HEADER) == 128, "AUDIO_RING_HEADER layout changed");
+
+	inline unsigned char* AudioRingData(AUDIO_RING_HEADER* Ring)
+	{
+		return reinterpret_cast<unsigned char*>(Ring + 1);
+	}
+
+	//
+	// Largest usable capacity for a ring of BufferSize bytes, 0 if too small
+	//
+	inline unsigned long AudioRingCapacityFor(unsigned long BufferSize)
+	{
+		if (BufferSize < sizeof(AUDIO_RING_HEADER) + AudioRingMinCapacity)
+			return 0;
+
+		const unsigned long available = BufferSize - sizeof(AUDIO_RING_HEADER);
+		unsigned long capacity = AudioRingMinCapacity;
+
+		while (capacity * 2 <= available && capacity * 2 <= AudioRingMaxCapacity)
+			capacity *= 2;
+
+		return capacity;
+	}
+
+	//
+	// Bus side. Everything but the header pointer is kept out of the
+	// consumer's reach.
+	//
+	struct AudioRingProducer
+	{
+		AUDIO_RING_HEADER* Ring;
+		unsigned char* Data;
+		unsigned long Capacity;
+		unsigned long WriteIndex;
+
+		void Attach(AUDIO_RING_HEADER* Header, unsigned long RingCapacity)
+		{
+			Ring = Header;
+			Data = AudioRingData(Header);
+			Capacity = RingCapacity;
+			WriteIndex = static_cast<unsigned long>(Detail::LoadRelaxed(&Header->ReadIndex));
+
+			Detail::StoreRelaxed(&Header->Capacity, static_cast<long>(RingCapacity));
+			Detail::StoreRelaxed(&Header->DroppedBytes, 0);
+			Detail::StoreRelease(&Header->WriteIndex, static_cast<long>(WriteIndex));
+		}
+
+		//
+		// Bytes readable by the consumer, Capacity if ReadIndex is bogus
+		//
+		unsigned long Used() const
+		{
+			const unsigned long used = WriteIndex - static_cast<unsigned long>(Detail::LoadAcquire(&Ring->ReadIndex));
+
+			return (used > Capacity) ? Capacity : used;
+		}
+
+		bool Reserve(unsigned long Length)
+		{
+			if (Length <= Capacity - Used())
+				return true;
+
+			Detail::StoreRelaxed(&Ring->DroppedBytes,
+				static_cast<long>(static_cast<unsigned long>(Detail::LoadRelaxed(&Ring->DroppedBytes)) + Length));
+
+			return false;
+		}
+
+		//
+		// Copies to Offset bytes past the write index, within a reservation
+		//
+		void Stage(unsigned long Offset, const void* Source, unsigned long Length)
+		{
+			auto src = static_cast<const unsigned char*>(Source);
+			const unsigned long start = (WriteIndex + Offset) & (Capacity - 1);
+			const unsigned long first = (Length < Capacity - start) ? Length : Capacity - start;
+
+			for (unsigned long i = 0; i < first; i++)
+				Data[start + i] = src[i];
+
+			for (unsigned long i = first; i < Length; i++)
+				Data[i - first] = src[i];
+		}
+
+		void Commit(unsigned long Length)
+		{
+			WriteIndex += Length;
+
+			Detail::StoreRelease(&Ring->WriteIndex, static_cast<long>(WriteIndex));
+		}
+
+		//
+		// Whether a doorbell should be rung now
+		//
+		bool ShouldWake() const
+		{
+			const unsigned long threshold = static_cast<unsigned long>(Detail::LoadRelaxed(&Ring->WakeThreshold));
+			const unsigned long used = Used();
+
+			return used > 0 && used >= ((threshold > Capacity) ? Capacity : threshold);
+		}
+	};
+
+	//
+	// Consumer side: up to two contiguous spans (the second one after the
+	// wrap) that stay valid until Release.
+	//
+	struct AudioRingSpans
+	{
+		const unsigned char* First;
+		unsigned long FirstLength;
+		const unsigned char* Second;
+		unsigned long SecondLength;
+	};
+
+	inline unsigned long PeekAudioRing(AUDIO_RING_HEADER* Ring, AudioRingSpans* Spans)
+	{
+		const unsigned long capacity = static_cast<unsigned long>(Detail::LoadRelaxed(&Ring->Capacity));
+		const unsigned long read = static_cast<unsigned long>(Detail::LoadRelaxed(&Ring->ReadIndex));
+		const unsigned long used = static_cast<unsigned long>(Detail::LoadAcquire(&Ring->WriteIndex)) - read;
+		const unsigned long start = read & (capacity - 1);
+		const unsigned long first = (used < capacity - start) ? used : capacity - start;
+
+		Spans->First = AudioRingData(Ring) + start;
+		Spans->FirstLength = first;
+		Spans->Second = AudioRingData(Ring);
+		Spans->SecondLength = used - first;
+
+		return used;
+	}
+
+	inline void ReleaseAudioRing(AUDIO_RING_HEADER* Ring, unsigned long Length)
+	{
+		const unsigned long read = static_cast<unsigned long>(Detail::LoadRelaxed(&Ring->ReadIndex));
+
+		Detail::StoreRelease(&Ring->ReadIndex, static_cast<long>(read + Length));
+	}
+}
@@ -0,0 +1,287 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2022, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+//
+// Fixed capacity min-heap of deadlines keyed by small integer ids, so a
+// single timer can serve many independent periodic jobs: the earliest
+// deadline is always at the top, and an id's deadline can be moved or
+// cancelled in O(log n) without searching.
+//
+// An id is either queued once or not at all, Schedule keeps the earlier
+// of the queued and the requested deadline. Deadlines are in whatever
+// monotonic unit the owner uses (the bus uses microframes, see
+// FrameClock.h). Not thread safe, the owner serialises access.
+//
+// The batch helpers below are the scheduler's whole tick: take every due
+// entry, let the owner service them (outside its lock), requeue the ones
+// that returned a next deadline, then arm a one-shot timer for the new
+// earliest deadline.
+//
+// Portable (no CRT, no Windows headers required) so it can be tested in
+// user mode.
+//
+
+namespace ViGEm::Timing
+{
+	//
+	// One serviced entry of a batch. Next is filled in by the owner, 0 if
+	// the work has nothing left to do.
+	//
+	struct DueWork
+	{
+		unsigned long Id;
+		unsigned long long Deadline;
+		unsigned long long Next;
+	};
+
+	//
+	// Next deadline of periodic work due at Deadline and serviced at Now.
+	// Stays on the original grid, a late tick doesn't push later ones back.
+	//
+	inline unsigned long long NextPeriodicDeadline(unsigned long long Deadline, unsigned long long Period, unsigned long long Now)
+	{
+		return (Deadline + Period > Now) ? Deadline + Period : Now + Period;
+	}
+
+	//
+	// Delay of a one-shot timer for Deadline, never shorter than MinDelay
+	// (the timer resolution)
+	//
+	inline unsigned long long TimerDelay(unsigned long long Deadline, unsigned long long Now, unsigned long long MinDelay)
+	{
+		return (Deadline > Now + MinDelay) ? Deadline - Now : MinDelay;
+	}
+
+	template <unsigned long Capacity>
+	class DeadlineHeap
+	{
+	public:
+		static constexpr unsigned long NotQueued = ~0UL;
+
+		void Init()
+		{
+			_Count = 0;
+
+			for (unsigned long id = 0; id < Capacity; id++)
+				_Position[id] = NotQueued;
+		}
+
+		bool IsEmpty() const
+		{
+			return _Count == 0;
+		}
+
+		unsigned long Count() const
+		{
+			return _Count;
+		}
+
+		bool IsQueued(unsigned long Id) const
+		{
+			return Id < Capacity && _Position[Id] != NotQueued;
+		}
+
+		//
+		// Only valid if not empty
+		//
+		unsigned long long NextDeadline() const
+		{
+			return _Heap[0].Deadline;
+		}
+
+		//
+		// Queues Id at Deadline, or moves it earlier if already queued
+		//
+		void Schedule(unsigned long Id, unsigned long long Deadline)
+		{
+			if (Id >= Capacity)
+				return;
+
+			unsigned long position = _Position[Id];
+
+			if (position == NotQueued)
+			{
+				position = _Count++;
+				_Heap[position].Id = Id;
+				_Heap[position].Deadline = Deadline;
+				_Position[Id] = position;
+			}
+			else if (Deadline < _Heap[position].Deadline)
+			{
+				_Heap[position].Deadline = Deadline;
+			}
+			else
+			{
+				return;
+			}
+
+			SiftUp(position);
+		}
+
+		void Cancel(unsigned long Id)
+		{
+			if (!IsQueued(Id))
+				return;
+
+			RemoveAt(_Position[Id]);
+		}
+
+		//
+		// Takes the earliest entry if it's due at Now
+		//
+		bool PopDue(unsigned long long Now, unsigned long* Id, unsigned long long* Deadline)
+		{
+			if (_Count == 0 || _Heap[0].Deadline > Now)
+				return false;
+
+			*Id = _Heap[0].Id;
+			*Deadline = _Heap[0].Deadline;
+
+			RemoveAt(0);
+
+			return true;
+		}
+
+		//
+		// Takes every entry due at Now into Batch (room for Capacity),
+		// earliest first, and returns how many
+		//
+		unsigned long PopAllDue(unsigned long long Now, DueWork* Batch)
+		{
+			unsigned long count = 0;
+
+			while (PopDue(Now, &Batch[count].Id, &Batch[count].Deadline))
+			{
+				Batch[count].Next = 0;
+				count++;
+			}
+
+			return count;
+		}
+
+		//
+		// Queues the serviced entries that have a next deadline and for
+		// which Keep(Index) still holds (the owner may have dropped them
+		// while the batch ran)
+		//
+		template <typename KeepFn>
+		void Requeue(const DueWork* Batch, unsigned long Count, KeepFn&& Keep)
+		{
+			for (unsigned long index = 0; index < Count; index++)
+			{
+				if (Batch[index].Next != 0 && Keep(index))
+					Schedule(Batch[index].Id, Batch[index].Next);
+			}
+		}
+
+	private:
+		struct Entry
+		{
+			unsigned long long Deadline;
+			unsigned long Id;
+		};
+
+		void Place(unsigned long Position, const Entry& Item)
+		{
+			_Heap[Position] = Item;
+			_Position[Item.Id] = Position;
+		}
+
+		void SiftUp(unsigned long Position)
+		{
+			const Entry item = _Heap[Position];
+
+			while (Position > 0)
+			{
+				const unsigned long parent = (Position - 1) / 2;
+
+				if (_Heap[parent].Deadline <= item.Deadline)
+					break;
+
+				Place(Position, _Heap[parent]);
+				Position = parent;
+			}
+
+			Place(Position, item);
+		}
+
+		void SiftDown(unsigned long Position)
+		{
+			const Entry item = _Heap[Position];
+
+			for (;;)
+			{
+				unsigned long child = Position * 2 + 1;
+
+				if (child >= _Count)
+					break;
+
+				if (child + 1 < _Count && _Heap[child + 1].Deadline < _Heap[child].Deadline)
+					child++;
+
+				if (item.Deadline <= _Heap[child].Deadline)
+					break;
+
+				Place(Position, _Heap[child]);
+				Position = child;
+			}
+
+			Place(Position, item);
+		}
+
+		void RemoveAt(unsigned long Position)
+		{
+			_Position[_Heap[Position].Id] = NotQueued;
+
+			if (--_Count == Position)
+				return;
+
+			//
+			// Fill the hole with the last entry and restore order from there
+			//
+			Place(Position, _Heap[_Count]);
+
+			if (Position > 0 && _Heap[Position].Deadline < _Heap[(Position - 1) / 2].Deadline)
+				SiftUp(Position);
+			else
+				SiftDown(Position);
+		}
+
+		Entry _Heap[Capacity];
+		unsigned long _Position[Capacity];
+		unsigned long _Count;
+	};
+}
@@ -0,0 +1,131 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2022, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+//
+// Change detection for DualSense input reports, shared by the bus driver and
+// the app so both sides agree on what "unchanged" means.
+//
+// Operates on the 63-byte DS5_REPORT payload (report ID stripped). Fields the
+// controller rewrites on every report (sequence number, timestamps, motion
+// sensors, AES-CMAC) are ignored unless enabled in the significant fields
+// mask. Kernel-safe: no CRT, no STL, no exceptions.
+//
+namespace ViGEm::Reports
+{
+	//
+	// Volatile field groups that may be declared significant.
+	//
+	enum Ds5ReportFields : unsigned long
+	{
+		Ds5FieldSequence = 0x01,        // bSeqNo, touch timestamp
+		Ds5FieldTimestamps = 0x02,      // counter, sensor, host and device timestamps
+		Ds5FieldMotion = 0x04,          // gyroscope, accelerometer, temperature
+		Ds5FieldAuthentication = 0x08,  // AES-CMAC
+
+		Ds5FieldAll = 0x0F
+	};
+
+	class Ds5ReportFilter
+	{
+	public:
+		static constexpr unsigned Size = 63;
+
+		explicit Ds5ReportFilter(unsigned long SignificantFields = 0)
+		{
+			SetSignificantFields(SignificantFields);
+		}
+
+		void SetSignificantFields(unsigned long SignificantFields)
+		{
+			for (unsigned i = 0; i < Size; i++)
+				_Mask[i] = 0xFF;
+
+			for (const auto& range : VolatileRanges)
+			{
+				if (SignificantFields & range.Field)
+					continue;
+
+				for (unsigned i = 0; i < range.Length; i++)
+					_Mask[range.Offset + i] = 0x00;
+			}
+
+			_Fields = SignificantFields;
+		}
+
+		unsigned long SignificantFields() const { return _Fields; }
+
+		//
+		// TRUE if any significant byte differs between the two payloads.
+		//
+		bool Changed(const unsigned char* Previous, const unsigned char* Current) const
+		{
+			unsigned char diff = 0;
+
+			for (unsigned i = 0; i < Size; i++)
+				diff |= static_cast<unsigned char>((Previous[i] ^ Current[i]) & _Mask[i]);
+
+			return diff != 0;
+		}
+
+	private:
+		struct Range
+		{
+			unsigned char Offset;
+			unsigned char Length;
+			unsigned long Field;
+		};
+
+		//
+		// Byte offsets within DS5_REPORT
+		//
+		static constexpr Range VolatileRanges[] =
+		{
+			{ 6, 1, Ds5FieldSequence },         // bSeqNo
+			{ 11, 4, Ds5FieldTimestamps },      // ulUNKCounter
+			{ 15, 12, Ds5FieldMotion },         // wAngularVelocity*, wAccelerometer*
+			{ 27, 4, Ds5FieldTimestamps },      // ulSensorTimestamp
+			{ 31, 1, Ds5FieldMotion },          // bTemperature
+			{ 40, 1, Ds5FieldSequence },        // sCurrentTouch.bTimestamp
+			{ 43, 4, Ds5FieldTimestamps },      // ulHostTimestamp
+			{ 48, 4, Ds5FieldTimestamps },      // ulDeviceTimeStamp
+			{ 55, 8, Ds5FieldAuthentication },  // bAesCmac
+		};
+
+		unsigned char _Mask[Size];
+		unsigned long _Fields = 0;
+	};
+}
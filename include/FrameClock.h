@@ -0,0 +1,175 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2022, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//
+// Virtual USB frame clock: converts performance counter ticks to 1 ms
+// frames and 125 us microframes.
+//
+// The divide by the counter frequency is done once by Init; readers
+// multiply by a 64-bit reciprocal and keep the high half, so a read is a
+// single widening multiply and never overflows however long the machine
+// has been up. The result is exact or one microframe low right at a
+// boundary, and monotonic.
+//
+// Portable (no CRT, no Windows headers required) so it can be tested with
+// an injected time source.
+//
+
+namespace ViGEm::Timing
+{
+	constexpr unsigned long MicroframesPerFrame = 8;
+	constexpr unsigned long long MicroframesPerSecond = 8000;
+
+	namespace Detail
+	{
+		inline unsigned long long MultiplyHigh(unsigned long long A, unsigned long long B)
+		{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+			return __umulh(A, B);
+#elif defined(__SIZEOF_INT128__)
+			return static_cast<unsigned long long>((static_cast<unsigned __int128>(A) * B) >> 64);
+#else
+			const unsigned long long aLo = A & 0xFFFFFFFF, aHi = A >> 32;
+			const unsigned long long bLo = B & 0xFFFFFFFF, bHi = B >> 32;
+			const unsigned long long lo = aLo * bLo;
+			const unsigned long long mid1 = aHi * bLo + (lo >> 32);
+			const unsigned long long mid2 = aLo * bHi + (mid1 & 0xFFFFFFFF);
+
+			return aHi * bHi + (mid1 >> 32) + (mid2 >> 32);
+#endif
+		}
+	}
+
+	class FrameClock
+	{
+	public:
+		//
+		// Frequency in ticks per second, Origin is the tick of frame 0
+		//
+		void Init(long long Frequency, long long Origin = 0)
+		{
+			_Frequency = static_cast<unsigned long long>(Frequency);
+			_Origin = Origin;
+
+			//
+			// floor(2^64 * 8000 / Frequency), split so nothing overflows
+			// for any counter faster than 8 kHz
+			//
+			const unsigned long long quotient = MicroframesPerSecond / _Frequency;
+			const unsigned long long remainder = MicroframesPerSecond % _Frequency;
+
+			_Reciprocal = (quotient << 32) << 32;
+			_Reciprocal += DivideShifted(remainder, _Frequency);
+		}
+
+		bool IsInitialized() const
+		{
+			return _Frequency != 0;
+		}
+
+		unsigned long long Microframes(long long Ticks) const
+		{
+			if (Ticks <= _Origin)
+				return 0;
+
+			return Detail::MultiplyHigh(static_cast<unsigned long long>(Ticks - _Origin), _Reciprocal);
+		}
+
+		//
+		// USB frame number, wraps like a real bus' 32-bit frame counter (also
+		// where unsigned long is 64 bits)
+		//
+		unsigned long Frame(long long Ticks) const
+		{
+			return static_cast<unsigned long>((Microframes(Ticks) / MicroframesPerFrame) & 0xFFFFFFFF);
+		}
+
+		//
+		// The same read from a time source, Now() returns the current tick
+		// count. The driver passes the performance counter, tests a fake one.
+		//
+		template <typename TickSource>
+		unsigned long long CurrentMicroframe(TickSource&& Now) const
+		{
+			return Microframes(Now());
+		}
+
+		template <typename TickSource>
+		unsigned long CurrentFrame(TickSource&& Now) const
+		{
+			return Frame(Now());
+		}
+
+		long long Frequency() const
+		{
+			return static_cast<long long>(_Frequency);
+		}
+
+	private:
+		//
+		// floor(Numerator * 2^64 / Denominator) for Numerator < Denominator,
+		// bit by bit, only used at init
+		//
+		static unsigned long long DivideShifted(unsigned long long Numerator, unsigned long long Denominator)
+		{
+			unsigned long long result = 0;
+
+			for (int bit = 0; bit < 64; bit++)
+			{
+				const bool carry = (Numerator >> 63) != 0;
+
+				Numerator <<= 1;
+				result <<= 1;
+
+				if (carry || Numerator >= Denominator)
+				{
+					Numerator -= Denominator;
+					result |= 1;
+				}
+			}
+
+			return result;
+		}
+
+		unsigned long long _Frequency;
+		long long _Origin;
+		unsigned long long _Reciprocal;
+	};
+}
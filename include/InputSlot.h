@@ -0,0 +1,153 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2022, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "ReportCache.h"
+
+//
+// Shared-memory input slot: an opt-in alternative to one submit IOCTL per
+// report for high-rate feeders.
+//
+// The feeder allocates an INPUT_SLOT and hands it to the bus with
+// IOCTL_VIGEM_ATTACH_INPUT_SLOT (METHOD_OUT_DIRECT, the slot is the output
+// buffer). The driver keeps that request pending for as long as the slot is
+// attached, so the pages stay locked and mapped; cancelling the request
+// detaches the slot.
+//
+// Protocol: single writer (the feeder), single reader (the bus). Sequence is
+// odd while the feeder is writing and advances by two per published report.
+// The bus polls the slot whenever it is about to complete an interrupt IN
+// URB and picks up the report if Sequence moved since its last read.
+//
+// The reader must not trust the feeder: it never waits for a writer, gives
+// up after InputSlotMaxAttempts torn reads and tries again on its next poll.
+//
+// Portable (no CRT, no Windows headers required) so the protocol builds in
+// user mode and on other platforms.
+//
+
+#if defined(CTL_CODE)
+#define IOCTL_VIGEM_ATTACH_INPUT_SLOT CTL_CODE(FILE_DEVICE_BUS_EXTENDER, 0xE01, METHOD_OUT_DIRECT, FILE_READ_DATA | FILE_WRITE_DATA)
+#endif
+
+namespace ViGEm::Reports
+{
+	constexpr unsigned int InputSlotReportSize = 64;
+	constexpr unsigned int InputSlotMaxAttempts = 4;
+
+	typedef struct _INPUT_SLOT_ATTACH
+	{
+		//
+		// sizeof(INPUT_SLOT_ATTACH)
+		//
+		unsigned int Size;
+
+		unsigned int SerialNo;
+	} INPUT_SLOT_ATTACH, *PINPUT_SLOT_ATTACH;
+
+	typedef struct _INPUT_SLOT
+	{
+		volatile long Sequence;
+
+		unsigned int Reserved;
+
+		//
+		// Target report without report ID (DS5_REPORT for DualSense)
+		//
+		unsigned char Report[InputSlotReportSize];
+	} INPUT_SLOT, *PINPUT_SLOT;
+
+	enum class InputSlotRead
+	{
+		Unchanged,
+		Updated,
+		Torn
+	};
+
+	//
+	// Feeder side: publish Length bytes of Report.
+	//
+	inline void PublishInputSlot(INPUT_SLOT* Slot, const void* Report, unsigned int Length)
+	{
+		const long sequence = Detail::LoadRelaxed(&Slot->Sequence);
+
+		Detail::StoreRelaxed(&Slot->Sequence, sequence + 1);
+		Detail::ReleaseFence();
+
+		auto dst = reinterpret_cast<volatile unsigned char*>(Slot->Report);
+		auto src = static_cast<const unsigned char*>(Report);
+
+		for (unsigned int i = 0; i < Length && i < InputSlotReportSize; i++)
+			dst[i] = src[i];
+
+		Detail::StoreRelease(&Slot->Sequence, sequence + 2);
+	}
+
+	//
+	// Bus side: copy Length bytes to Buffer if a report was published since
+	// the sequence stored in LastSequence, which is updated on success.
+	// Buffer content is undefined unless Updated is returned.
+	//
+	inline InputSlotRead ReadInputSlot(const INPUT_SLOT* Slot, void* Buffer, unsigned int Length, long* LastSequence)
+	{
+		auto dst = static_cast<unsigned char*>(Buffer);
+		auto src = reinterpret_cast<const volatile unsigned char*>(Slot->Report);
+
+		for (unsigned int attempt = 0; attempt < InputSlotMaxAttempts; attempt++)
+		{
+			const long begin = Detail::LoadAcquire(&Slot->Sequence);
+
+			if (begin == *LastSequence)
+				return InputSlotRead::Unchanged;
+
+			if ((begin & 1) == 0)
+			{
+				for (unsigned int i = 0; i < Length && i < InputSlotReportSize; i++)
+					dst[i] = src[i];
+
+				Detail::AcquireFence();
+
+				if (Detail::LoadRelaxed(&Slot->Sequence) == begin)
+				{
+					*LastSequence = begin;
+					return InputSlotRead::Updated;
+				}
+			}
+
+			Detail::Pause();
+		}
+
+		return InputSlotRead::Torn;
+	}
+}
@@ -0,0 +1,158 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2022, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+//
+// ISO OUT pacing: completes isochronous OUT URBs at the rate a real device
+// would consume them, one packet per 1 ms frame.
+//
+// Each URB gets an absolute due time when it is queued, the end of its last
+// frame counted from the start of the stream. The completion timer may fire
+// late or early, it only completes what is due, so its jitter never adds up
+// over the stream. A stream whose host stopped submitting for more than
+// IsoOutResyncFrames is re-anchored at the next URB.
+//
+// Times are in microframes of the bus frame clock (see FrameClock.h), so
+// scheduling is integer adds and shifts with no division. Not thread safe,
+// the owner serialises access.
+//
+// Portable (no CRT, no Windows headers required) so the scheduling math
+// can be tested against a simulated clock.
+//
+
+#include "FrameClock.h"
+
+namespace ViGEm::Audio
+{
+	constexpr unsigned long IsoOutResyncFrames = 2;
+
+	struct IsoOutPacer
+	{
+		long long Anchor;
+		unsigned long long Scheduled;
+		unsigned long long Completed;
+		long long LastDue;
+
+		//
+		// Statistics, see ResetStatistics
+		//
+		unsigned long Resyncs;
+		unsigned long LateCompletions;
+		long long MaxLateness;
+		unsigned long Passes;
+		unsigned long UsefulPasses;
+
+		void Init()
+		{
+			*this = {};
+		}
+
+		static long long MicroframesFor(unsigned long long Frames)
+		{
+			return static_cast<long long>(Frames * Timing::MicroframesPerFrame);
+		}
+
+		//
+		// Due time of a URB of Packets frames queued at Now
+		//
+		long long Schedule(long long Now, unsigned long Packets)
+		{
+			if (Scheduled == 0 || LastDue + MicroframesFor(IsoOutResyncFrames) < Now)
+			{
+				if (Scheduled != 0)
+					Resyncs++;
+
+				Anchor = Now;
+				Scheduled = 0;
+				Completed = 0;
+			}
+
+			Scheduled += Packets;
+			LastDue = Anchor + MicroframesFor(Scheduled);
+
+			return LastDue;
+		}
+
+		//
+		// Records the completion at Now of a URB that was due at Due
+		//
+		void Complete(long long Now, long long Due, unsigned long Packets)
+		{
+			const long long lateness = Now - Due;
+
+			Completed += Packets;
+
+			if (lateness > MaxLateness)
+				MaxLateness = lateness;
+
+			if (lateness >= MicroframesFor(1))
+				LateCompletions++;
+		}
+
+		//
+		// Records a completion pass, Useful if it completed a URB
+		//
+		void RecordPass(bool Useful)
+		{
+			Passes++;
+
+			if (Useful)
+				UsefulPasses++;
+		}
+
+		//
+		// Frames completed minus frames elapsed since the stream started,
+		// negative while completions lag behind real time
+		//
+		long long DriftFrames(long long Now) const
+		{
+			if (Scheduled == 0 || Now < Anchor)
+				return 0;
+
+			const long long elapsed = (Now - Anchor) / static_cast<long long>(Timing::MicroframesPerFrame);
+
+			return static_cast<long long>(Completed) - elapsed;
+		}
+
+		void ResetStatistics()
+		{
+			Resyncs = 0;
+			LateCompletions = 0;
+			MaxLateness = 0;
+			Passes = 0;
+			UsefulPasses = 0;
+		}
+	};
+}
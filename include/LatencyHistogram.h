@@ -0,0 +1,154 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2022, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+//
+// Log-bucketed latency histogram shared by the bus driver and the app.
+//
+// Kernel-safe: no CRT, no STL, no exceptions and no floating point, so it can
+// be used at DISPATCH_LEVEL. Not synchronized; callers serialize access.
+// Each power-of-two range is split into 4 linear sub-buckets (<= 25% error).
+// Values are in whatever unit the caller chooses (typically nanoseconds).
+//
+namespace ViGEm::Stats
+{
+	//
+	// Copy of the reported figures, taken under the owner's lock and
+	// printed after releasing it
+	//
+	struct LatencySummary
+	{
+		unsigned long long Count;
+		unsigned long long P50;
+		unsigned long long P99;
+		unsigned long long P999;
+		unsigned long long Max;
+	};
+
+	class LatencyHistogram
+	{
+	public:
+		static constexpr int SubBits = 2;
+		static constexpr int Linear = 1 << (SubBits + 2);
+		static constexpr int Buckets = Linear + (64 - SubBits - 2) * (1 << SubBits);
+
+		void Record(unsigned long long Value)
+		{
+			_Buckets[BucketOf(Value)]++;
+			_Count++;
+			if (Value > _Max)
+				_Max = Value;
+		}
+
+		void Reset()
+		{
+			for (auto& bucket : _Buckets)
+				bucket = 0;
+			_Count = 0;
+			_Max = 0;
+		}
+
+		//
+		// Returns the lower bound of the bucket holding the given percentile,
+		// expressed in parts per million (500000 = p50, 999000 = p99.9).
+		//
+		unsigned long long Percentile(unsigned int PartsPerMillion) const
+		{
+			if (_Count == 0)
+				return 0;
+
+			unsigned long long rank = (_Count * PartsPerMillion + 999999ULL) / 1000000ULL;
+			if (rank < 1)
+				rank = 1;
+			if (rank > _Count)
+				rank = _Count;
+
+			unsigned long long seen = 0;
+			for (int i = 0; i < Buckets; i++)
+			{
+				seen += _Buckets[i];
+				if (seen >= rank)
+					return BucketFloor(i);
+			}
+
+			return _Max;
+		}
+
+		LatencySummary Summarize() const
+		{
+			return { _Count, Percentile(500000), Percentile(990000), Percentile(999000), _Max };
+		}
+
+		unsigned long long Count() const { return _Count; }
+
+		unsigned long long Max() const { return _Max; }
+
+		static int BucketOf(unsigned long long Value)
+		{
+			if (Value < Linear)
+				return static_cast<int>(Value);
+
+			const int msb = MostSignificantBit(Value);
+			const int sub = static_cast<int>(Value >> (msb - SubBits)) & ((1 << SubBits) - 1);
+
+			return Linear + (msb - SubBits - 2) * (1 << SubBits) + sub;
+		}
+
+		static unsigned long long BucketFloor(int Bucket)
+		{
+			if (Bucket < Linear)
+				return static_cast<unsigned long long>(Bucket);
+
+			const int msb = (Bucket - Linear) / (1 << SubBits) + SubBits + 2;
+			const unsigned long long sub = static_cast<unsigned long long>((Bucket - Linear) % (1 << SubBits));
+
+			return (1ULL << msb) | (sub << (msb - SubBits));
+		}
+
+	private:
+		static int MostSignificantBit(unsigned long long Value)
+		{
+			int msb = 0;
+			while (Value >>= 1)
+				msb++;
+			return msb;
+		}
+
+		unsigned long long _Buckets[Buckets]{};
+		unsigned long long _Count = 0;
+		unsigned long long _Max = 0;
+	};
+}
@@ -0,0 +1,154 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2022, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+//
+// Backlog and counters of a per-target notification channel: notifications
+// that arrive while no await request is parked are kept here, once a client
+// has shown interest, and handed to the next await. Entries keep their own
+// length so a completion only copies the bytes the notification carries.
+// When full the oldest entry is dropped.
+//
+// Not thread safe, the owner serialises access (the bus holds the channel's
+// spin lock). Portable (no CRT, no Windows headers required) so it can be
+// tested in user mode.
+//
+
+namespace ViGEm::Notifications
+{
+	struct NotificationStatistics
+	{
+		unsigned long long Routed;
+		unsigned long long Buffered;
+		unsigned long long Dropped;
+		unsigned long long BytesCopied;
+	};
+
+	template <unsigned long EntrySize, unsigned long Capacity>
+	class NotificationBacklog
+	{
+	public:
+		static constexpr unsigned long MaxLength = EntrySize;
+
+		unsigned long Count() const
+		{
+			return _Count;
+		}
+
+		//
+		// An await arrived: marks the channel as interested and copies the
+		// oldest entry to Buffer (at least EntrySize bytes) if there is one
+		//
+		bool Take(void* Buffer, unsigned long* Length)
+		{
+			_Interested = true;
+
+			if (_Count == 0)
+				return false;
+
+			*Length = _Lengths[_Head];
+			Copy(Buffer, _Entries[_Head], *Length);
+
+			_Head = (_Head + 1) % Capacity;
+			_Count--;
+			_Statistics.BytesCopied += *Length;
+
+			return true;
+		}
+
+		//
+		// A notification was copied straight into a parked await
+		//
+		void CountRouted(unsigned long Length)
+		{
+			_Statistics.Routed++;
+			_Statistics.BytesCopied += Length;
+		}
+
+		//
+		// A notification arrived with no await parked. Ignored until the
+		// first await, Length is clamped to EntrySize.
+		//
+		void Store(const void* Data, unsigned long Length)
+		{
+			if (!_Interested)
+				return;
+
+			if (Length > EntrySize)
+				Length = EntrySize;
+
+			if (_Count == Capacity)
+			{
+				_Head = (_Head + 1) % Capacity;
+				_Count--;
+				_Statistics.Dropped++;
+			}
+
+			const unsigned long tail = (_Head + _Count) % Capacity;
+
+			Copy(_Entries[tail], Data, Length);
+			_Lengths[tail] = Length;
+			_Count++;
+			_Statistics.Buffered++;
+		}
+
+		//
+		// Returns the counters accumulated since the previous call
+		//
+		NotificationStatistics TakeStatistics()
+		{
+			const NotificationStatistics statistics = _Statistics;
+			_Statistics = {};
+			return statistics;
+		}
+
+	private:
+		static void Copy(void* Destination, const void* Source, unsigned long Length)
+		{
+			auto dst = static_cast<unsigned char*>(Destination);
+			auto src = static_cast<const unsigned char*>(Source);
+
+			for (unsigned long i = 0; i < Length; i++)
+				dst[i] = src[i];
+		}
+
+		bool _Interested = false;
+		unsigned char _Entries[Capacity][EntrySize]{};
+		unsigned long _Lengths[Capacity]{};
+		unsigned long _Head = 0;
+		unsigned long _Count = 0;
+		NotificationStatistics _Statistics{};
+	};
+}
@@ -0,0 +1,163 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2022, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+//
+// Interrupt IN polling pump: the per-target schedule that stands in for
+// the host controller polling the input endpoint once per interval.
+//
+// Each poll records how far the measured period strayed from the
+// configured one, so a 1 ms interval can be confirmed to really deliver
+// at 1000 Hz under load, and decides whether the cached report must be
+// resent or the host has already been handed one this interval. Polling
+// only runs while URBs are pending, Pause marks the gap so the first poll
+// after it resumes isn't counted as missed polls.
+//
+// Times are in performance counter ticks, frames are bus frames (see
+// FrameClock.h). Not thread safe, the owner serialises access.
+//
+// Portable (no CRT, no Windows headers required) so the period logic can
+// be tested against a simulated clock.
+//
+
+namespace ViGEm::Reports
+{
+	constexpr unsigned long PollingIntervalMinMs = 1;
+	constexpr unsigned long PollingIntervalMaxMs = 16;
+
+	inline unsigned long ClampPollingInterval(unsigned long IntervalMs)
+	{
+		if (IntervalMs < PollingIntervalMinMs)
+			return PollingIntervalMinMs;
+
+		if (IntervalMs > PollingIntervalMaxMs)
+			return PollingIntervalMaxMs;
+
+		return IntervalMs;
+	}
+
+	struct PollPump
+	{
+		unsigned long IntervalMs;
+		long long Period;
+		long long LastPoll;
+		bool Started;
+
+		//
+		// Statistics, see ResetStatistics
+		//
+		unsigned long Polls;
+		unsigned long Useful;
+		unsigned long Missed;
+		unsigned long Periods;
+		unsigned long long JitterSum;
+		long long MaxJitter;
+
+		void Init(unsigned long RequestedIntervalMs, long long TicksPerSecond)
+		{
+			*this = {};
+			IntervalMs = ClampPollingInterval(RequestedIntervalMs);
+			Period = TicksPerSecond * static_cast<long long>(IntervalMs) / 1000;
+		}
+
+		//
+		// Records a poll at Now, Delivered if it completed a URB
+		//
+		void Poll(long long Now, bool Delivered)
+		{
+			if (Started)
+			{
+				const long long measured = Now - LastPoll;
+				const long long jitter = measured > Period ? measured - Period : Period - measured;
+
+				Periods++;
+				JitterSum += static_cast<unsigned long long>(jitter);
+
+				if (jitter > MaxJitter)
+					MaxJitter = jitter;
+
+				//
+				// Whole intervals the host would have polled but we didn't
+				//
+				if (Period > 0 && measured >= 2 * Period)
+					Missed += static_cast<unsigned long>(measured / Period - 1);
+			}
+
+			LastPoll = Now;
+			Started = true;
+			Polls++;
+
+			if (Delivered)
+				Useful++;
+		}
+
+		//
+		// Polling stopped, the next poll starts a new period
+		//
+		void Pause()
+		{
+			Started = false;
+		}
+
+		//
+		// A real device answers every poll, but a report completed by a
+		// submit since the last poll already answered this one. One frame
+		// of slack absorbs tick jitter against our own last resend.
+		//
+		bool ShouldResend(unsigned long FramesSinceDelivery, bool Undelivered) const
+		{
+			return Undelivered || FramesSinceDelivery + 1 >= IntervalMs;
+		}
+
+		//
+		// Mean absolute deviation from Period over the measured periods
+		// since the last reset, in ticks
+		//
+		unsigned long long MeanJitter() const
+		{
+			return Periods > 0 ? JitterSum / Periods : 0;
+		}
+
+		void ResetStatistics()
+		{
+			Polls = 0;
+			Useful = 0;
+			Periods = 0;
+			Missed = 0;
+			JitterSum = 0;
+			MaxJitter = 0;
+		}
+	};
+}
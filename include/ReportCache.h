@@ -0,0 +1,256 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2022, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//
+// Seqlock-protected report cache shared by the bus driver targets.
+//
+// Writers publish a complete report; readers copy a consistent snapshot
+// without taking a lock and retry if a write overlapped the copy. Writers
+// are serialized by claiming the sequence (odd while a write is in flight).
+//
+// In kernel builds the write window runs at DISPATCH_LEVEL, so a DPC reader
+// can never spin on a writer preempted on the same processor. The header
+// has no other kernel dependencies and builds with GCC/Clang, which allows
+// stress testing it in user mode.
+//
+// T must be trivially copyable (structs or byte arrays).
+//
+namespace ViGEm::Reports
+{
+	namespace Detail
+	{
+#if defined(_MSC_VER)
+		inline long LoadAcquire(const volatile long* Source)
+		{
+			const long value = *Source;
+#if defined(_M_ARM64)
+			__dmb(_ARM64_BARRIER_ISHLD);
+#else
+			_ReadWriteBarrier();
+#endif
+			return value;
+		}
+
+		inline long LoadRelaxed(const volatile long* Source)
+		{
+			return *Source;
+		}
+
+		inline void StoreRelease(volatile long* Target, long Value)
+		{
+#if defined(_M_ARM64)
+			__dmb(_ARM64_BARRIER_ISH);
+#else
+			_ReadWriteBarrier();
+#endif
+			*Target = Value;
+		}
+
+		inline void StoreRelaxed(volatile long* Target, long Value)
+		{
+			*Target = Value;
+		}
+
+		inline bool CompareExchange(volatile long* Target, long Expected, long Desired)
+		{
+			return _InterlockedCompareExchange(Target, Desired, Expected) == Expected;
+		}
+
+		inline void ReleaseFence()
+		{
+#if defined(_M_ARM64)
+			__dmb(_ARM64_BARRIER_ISH);
+#else
+			_ReadWriteBarrier();
+#endif
+		}
+
+		inline void AcquireFence()
+		{
+#if defined(_M_ARM64)
+			__dmb(_ARM64_BARRIER_ISHLD);
+#else
+			_ReadWriteBarrier();
+#endif
+		}
+
+		inline void Pause()
+		{
+#if defined(_M_ARM64)
+			__yield();
+#else
+			_mm_pause();
+#endif
+		}
+#else
+		inline long LoadAcquire(const volatile long* Source)
+		{
+			return __atomic_load_n(Source, __ATOMIC_ACQUIRE);
+		}
+
+		inline long LoadRelaxed(const volatile long* Source)
+		{
+			return __atomic_load_n(Source, __ATOMIC_RELAXED);
+		}
+
+		inline void StoreRelease(volatile long* Target, long Value)
+		{
+			__atomic_store_n(Target, Value, __ATOMIC_RELEASE);
+		}
+
+		inline void StoreRelaxed(volatile long* Target, long Value)
+		{
+			__atomic_store_n(Target, Value, __ATOMIC_RELAXED);
+		}
+
+		inline bool CompareExchange(volatile long* Target, long Expected, long Desired)
+		{
+			return __atomic_compare_exchange_n(Target, &Expected, Desired, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+		}
+
+		inline void ReleaseFence()
+		{
+			__atomic_thread_fence(__ATOMIC_RELEASE);
+		}
+
+		inline void AcquireFence()
+		{
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		}
+
+		inline void Pause()
+		{
+#if defined(__x86_64__) || defined(__i386__)
+			__builtin_ia32_pause();
+#elif defined(__aarch64__)
+			__asm__ __volatile__("yield");
+#endif
+		}
+#endif
+	}
+
+	template <typename T>
+	class ReportCache
+	{
+	public:
+		//
+		// Mutate the cached report in place. Mutate(T&) runs with exclusive
+		// access and its result is returned; readers see either the old or
+		// the new report, never a mix.
+		//
+		template <typename Fn>
+		bool Update(Fn&& Mutate)
+		{
+#if defined(_KERNEL_MODE)
+			KIRQL irql;
+			KeRaiseIrql(DISPATCH_LEVEL, &irql);
+#endif
+			long sequence;
+
+			for (;;)
+			{
+				sequence = Detail::LoadRelaxed(&_Sequence);
+
+				if ((sequence & 1) == 0 && Detail::CompareExchange(&_Sequence, sequence, sequence + 1))
+					break;
+
+				Detail::Pause();
+			}
+
+			// the claim is only an acquire; keep the data stores behind the odd sequence
+			Detail::ReleaseFence();
+
+			const bool result = Mutate(_Value);
+
+			Detail::StoreRelease(&_Sequence, sequence + 2);
+
+#if defined(_KERNEL_MODE)
+			KeLowerIrql(irql);
+#endif
+			return result;
+		}
+
+		void Write(const T& Value)
+		{
+			Update([&Value](T& Cached)
+			{
+				Copy(&Cached, &Value);
+				return true;
+			});
+		}
+
+		//
+		// Copy a consistent snapshot (sizeof(T) bytes) to Buffer.
+		//
+		void Read(void* Buffer) const
+		{
+			for (;;)
+			{
+				const long begin = Detail::LoadAcquire(&_Sequence);
+
+				if ((begin & 1) == 0)
+				{
+					Copy(Buffer, &_Value);
+
+					Detail::AcquireFence();
+
+					if (Detail::LoadRelaxed(&_Sequence) == begin)
+						return;
+				}
+
+				Detail::Pause();
+			}
+		}
+
+	private:
+		static void Copy(void* Destination, const void* Source)
+		{
+			auto dst = static_cast<unsigned char*>(Destination);
+			auto src = static_cast<const unsigned char*>(Source);
+
+			for (unsigned long i = 0; i < sizeof(T); i++)
+				dst[i] = src[i];
+		}
+
+		volatile long _Sequence = 0;
+		T _Value{};
+	};
+}
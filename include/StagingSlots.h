@@ -0,0 +1,155 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2022, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "ReportCache.h"
+
+//
+// Claim bitmap for a small set of preallocated per-target staging buffers.
+// Callers that may run concurrently (ISO OUT URBs) each claim a free slot;
+// when all are busy Claim returns -1 and the caller falls back to a pool
+// allocation, which is counted as an overflow. Lifetime high-water marks
+// of busy slots and staged bytes are kept for tracing.
+//
+// Lock free. Portable (no CRT, no Windows headers required) so it can be
+// tested in user mode.
+//
+
+namespace ViGEm::Audio
+{
+	template <unsigned long Slots>
+	class StagingSlots
+	{
+		static_assert(Slots > 0 && Slots < 31, "StagingSlots supports 1 to 30 slots");
+
+	public:
+		//
+		// Returns the claimed slot, or -1 if every slot is busy
+		//
+		long Claim()
+		{
+			long busy = Reports::Detail::LoadRelaxed(&_Busy);
+
+			for (unsigned long slot = 0; slot < Slots; slot++)
+			{
+				const long bit = 1L << slot;
+
+				if ((busy & bit) != 0)
+					continue;
+
+				if (Reports::Detail::CompareExchange(&_Busy, busy, busy | bit))
+				{
+					RaiseHighWater(&_PeakBusy, CountBits(busy) + 1);
+					return static_cast<long>(slot);
+				}
+
+				//
+				// Lost a race, rescan with the fresh mask
+				//
+				busy = Reports::Detail::LoadRelaxed(&_Busy);
+				slot = ~0UL;
+			}
+
+			Add(&_Overflows, 1);
+			return -1;
+		}
+
+		//
+		// Slot is what Claim returned (-1 for a pool fallback), Bytes the
+		// length staged in it
+		//
+		void Release(long Slot, unsigned long Bytes)
+		{
+			RaiseHighWater(&_PeakBytes, static_cast<long>(Bytes));
+
+			if (Slot < 0)
+				return;
+
+			//
+			// The claim is only an acquire; keep the buffer accesses
+			// ahead of handing the slot back
+			//
+			Reports::Detail::ReleaseFence();
+			Add(&_Busy, -(1L << Slot));
+		}
+
+		long PeakBusy() const
+		{
+			return Reports::Detail::LoadRelaxed(&_PeakBusy);
+		}
+
+		long PeakBytes() const
+		{
+			return Reports::Detail::LoadRelaxed(&_PeakBytes);
+		}
+
+		long Overflows() const
+		{
+			return Reports::Detail::LoadRelaxed(&_Overflows);
+		}
+
+	private:
+		static long CountBits(long Value)
+		{
+			long count = 0;
+
+			for (; Value != 0; Value &= Value - 1)
+				count++;
+
+			return count;
+		}
+
+		static void RaiseHighWater(volatile long* Mark, long Value)
+		{
+			long current = Reports::Detail::LoadRelaxed(Mark);
+
+			while (Value > current && !Reports::Detail::CompareExchange(Mark, current, Value))
+				current = Reports::Detail::LoadRelaxed(Mark);
+		}
+
+		static void Add(volatile long* Target, long Delta)
+		{
+			long current = Reports::Detail::LoadRelaxed(Target);
+
+			while (!Reports::Detail::CompareExchange(Target, current, current + Delta))
+				current = Reports::Detail::LoadRelaxed(Target);
+		}
+
+		volatile long _Busy = 0;
+		volatile long _PeakBusy = 0;
+		volatile long _PeakBytes = 0;
+		volatile long _Overflows = 0;
+	};
+}
@@ -0,0 +1,227 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2022, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+//
+// Batched input submission: one IOCTL carries reports for many targets.
+//
+// Layout (METHOD_BUFFERED, the same buffer is used for input and output):
+//
+//   SUBMIT_BATCH_HEADER
+//   SUBMIT_BATCH_ENTRY[Count]
+//
+// The driver applies the entries in order and writes each entry's NTSTATUS
+// back into its Status field. The IOCTL itself only fails if the batch as a
+// whole is malformed.
+//
+// Portable (no CRT, no Windows headers required) so the packing and
+// validation logic builds in user mode and on other platforms.
+//
+
+//
+// Function codes 0xE00+ are reserved for extensions of this fork
+//
+#if defined(CTL_CODE)
+#define IOCTL_VIGEM_SUBMIT_BATCH CTL_CODE(FILE_DEVICE_BUS_EXTENDER, 0xE00, METHOD_BUFFERED, FILE_READ_DATA | FILE_WRITE_DATA)
+#endif
+
+namespace ViGEm::Batch
+{
+	using SizeType = decltype(sizeof(0));
+
+	enum SubmitBatchTarget : unsigned int
+	{
+		SubmitBatchTargetXusb = 1,
+		SubmitBatchTargetDs5 = 2
+	};
+
+	constexpr unsigned int SubmitBatchMaxEntries = 64;
+	constexpr unsigned int SubmitBatchMaxReportSize = 64;
+
+	typedef struct _SUBMIT_BATCH_HEADER
+	{
+		//
+		// sizeof(SUBMIT_BATCH_HEADER)
+		//
+		unsigned int Size;
+
+		//
+		// Number of entries following the header
+		//
+		unsigned int Count;
+	} SUBMIT_BATCH_HEADER, *PSUBMIT_BATCH_HEADER;
+
+	typedef struct _SUBMIT_BATCH_ENTRY
+	{
+		unsigned int SerialNo;
+
+		//
+		// SubmitBatchTarget
+		//
+		unsigned int Target;
+
+		//
+		// Bytes used in Report, must match the target's report size
+		//
+		unsigned int ReportSize;
+
+		//
+		// Out: NTSTATUS of this entry
+		//
+		int Status;
+
+		unsigned char Report[SubmitBatchMaxReportSize];
+	} SUBMIT_BATCH_ENTRY, *PSUBMIT_BATCH_ENTRY;
+
+	enum class SubmitBatchError
+	{
+		None,
+		BufferTooSmall,
+		InvalidHeader,
+		TooManyEntries,
+		LengthMismatch
+	};
+
+	constexpr SizeType SubmitBatchLength(unsigned int Count)
+	{
+		return sizeof(SUBMIT_BATCH_HEADER) + static_cast<SizeType>(Count) * sizeof(SUBMIT_BATCH_ENTRY);
+	}
+
+	inline PSUBMIT_BATCH_ENTRY SubmitBatchEntries(void* Buffer)
+	{
+		return reinterpret_cast<PSUBMIT_BATCH_ENTRY>(static_cast<unsigned char*>(Buffer) + sizeof(SUBMIT_BATCH_HEADER));
+	}
+
+	//
+	// Validates the batch framing. Entries are validated one by one by the
+	// consumer so a bad entry doesn't reject the whole batch.
+	//
+	inline SubmitBatchError ValidateSubmitBatch(const void* Buffer, SizeType Length, unsigned int* Count)
+	{
+		if (Buffer == nullptr || Length < sizeof(SUBMIT_BATCH_HEADER))
+			return SubmitBatchError::BufferTooSmall;
+
+		const auto header = static_cast<const SUBMIT_BATCH_HEADER*>(Buffer);
+
+		if (header->Size != sizeof(SUBMIT_BATCH_HEADER))
+			return SubmitBatchError::InvalidHeader;
+
+		if (header->Count > SubmitBatchMaxEntries)
+			return SubmitBatchError::TooManyEntries;
+
+		if (Length != SubmitBatchLength(header->Count))
+			return SubmitBatchError::LengthMismatch;
+
+		*Count = header->Count;
+
+		return SubmitBatchError::None;
+	}
+
+	//
+	// TRUE if the entry targets a known type with the expected report size.
+	//
+	inline bool ValidateSubmitBatchEntry(const SUBMIT_BATCH_ENTRY& Entry, unsigned int XusbReportSize, unsigned int Ds5ReportSize)
+	{
+		if (Entry.SerialNo == 0)
+			return false;
+
+		switch (Entry.Target)
+		{
+		case SubmitBatchTargetXusb:
+			return Entry.ReportSize == XusbReportSize;
+		case SubmitBatchTargetDs5:
+			return Entry.ReportSize == Ds5ReportSize;
+		default:
+			return false;
+		}
+	}
+
+	//
+	// Packs entries into a caller-provided buffer of SubmitBatchLength(N) bytes.
+	//
+	class SubmitBatchBuilder
+	{
+	public:
+		SubmitBatchBuilder(void* Buffer, SizeType Capacity) : _Buffer(Buffer), _Capacity(Capacity)
+		{
+			Reset();
+		}
+
+		void Reset()
+		{
+			const auto header = static_cast<PSUBMIT_BATCH_HEADER>(_Buffer);
+			header->Size = sizeof(SUBMIT_BATCH_HEADER);
+			header->Count = 0;
+		}
+
+		//
+		// Returns FALSE if the batch is full or the report doesn't fit.
+		//
+		bool Add(SubmitBatchTarget Target, unsigned int SerialNo, const void* Report, unsigned int ReportSize)
+		{
+			const auto header = static_cast<PSUBMIT_BATCH_HEADER>(_Buffer);
+
+			if (header->Count >= SubmitBatchMaxEntries
+				|| SubmitBatchLength(header->Count + 1) > _Capacity
+				|| ReportSize > SubmitBatchMaxReportSize)
+				return false;
+
+			auto& entry = SubmitBatchEntries(_Buffer)[header->Count];
+			entry.SerialNo = SerialNo;
+			entry.Target = Target;
+			entry.ReportSize = ReportSize;
+			entry.Status = 0;
+
+			const auto src = static_cast<const unsigned char*>(Report);
+			for (unsigned int i = 0; i < SubmitBatchMaxReportSize; i++)
+				entry.Report[i] = (i < ReportSize) ? src[i] : 0;
+
+			header->Count++;
+
+			return true;
+		}
+
+		unsigned int Count() const { return static_cast<const SUBMIT_BATCH_HEADER*>(_Buffer)->Count; }
+
+		SizeType Length() const { return SubmitBatchLength(Count()); }
+
+		const SUBMIT_BATCH_ENTRY& Entry(unsigned int Index) const { return SubmitBatchEntries(_Buffer)[Index]; }
+
+	private:
+		void* _Buffer;
+		SizeType _Capacity;
+	};
+}
@@ -0,0 +1,308 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2020, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "Driver.h"
+#include "trace.h"
+#include "BusScheduler.tmh"
+
+#include "EmulationTargetPDO.hpp"
+
+using ViGEm::Bus::Core::BusScheduler;
+using ViGEm::Bus::Core::EmulationTargetPDO;
+
+
+NTSTATUS BusScheduler::Init(WDFDEVICE BusDevice)
+{
+	WDF_TIMER_CONFIG timerConfig;
+	WDF_OBJECT_ATTRIBUTES timerAttribs;
+
+	KeInitializeSpinLock(&this->_Lock);
+	KeInitializeEvent(&this->_BatchDone, NotificationEvent, TRUE);
+
+	this->_Deadlines.Init();
+	this->_StatisticsStart = EmulationTargetPDO::CurrentMicroframe();
+
+	//
+	// One-shot, armed for the earliest deadline by Schedule and Tick
+	//
+	WDF_TIMER_CONFIG_INIT(&timerConfig, EvtTick);
+	timerConfig.UseHighResolutionTimer = WdfTrue;
+
+	WDF_OBJECT_ATTRIBUTES_INIT(&timerAttribs);
+	timerAttribs.ParentObject = BusDevice;
+
+	return WdfTimerCreate(&timerConfig, &timerAttribs, &this->_Timer);
+}
+
+NTSTATUS BusScheduler::Register(EmulationTargetPDO* Target, PULONG Slot)
+{
+	NTSTATUS status = STATUS_INSUFFICIENT_RESOURCES;
+	KIRQL irql;
+
+	KeAcquireSpinLock(&this->_Lock, &irql);
+
+	for (ULONG slot = 0; slot < MaxTargets; slot++)
+	{
+		if (this->_Targets[slot] == nullptr)
+		{
+			this->_Targets[slot] = Target;
+			this->_Registered++;
+			*Slot = slot;
+			status = STATUS_SUCCESS;
+			break;
+		}
+	}
+
+	KeReleaseSpinLock(&this->_Lock, irql);
+
+	if (!NT_SUCCESS(status))
+	{
+		TraceError(
+			TRACE_BUSENUM,
+			"All %u scheduler slots are in use",
+			MaxTargets);
+	}
+
+	return status;
+}
+
+VOID BusScheduler::Unregister(ULONG Slot)
+{
+	KIRQL irql;
+
+	NT_ASSERT(KeGetCurrentIrql() == PASSIVE_LEVEL);
+
+	if (Slot >= MaxTargets)
+		return;
+
+	KeAcquireSpinLock(&this->_Lock, &irql);
+
+	if (this->_Targets[Slot] != nullptr)
+	{
+		for (ULONG work = 0; work < WorkCount; work++)
+			this->_Deadlines.Cancel(Slot * WorkCount + work);
+
+		//
+		// Also keeps a running batch from queueing the target again
+		//
+		this->_Targets[Slot] = nullptr;
+		this->_Registered--;
+	}
+
+	KeReleaseSpinLock(&this->_Lock, irql);
+
+	WaitForBatch();
+}
+
+VOID BusScheduler::Schedule(ULONG Slot, ScheduledWork Work, ULONGLONG Deadline)
+{
+	KIRQL irql;
+
+	if (Slot >= MaxTargets)
+		return;
+
+	KeAcquireSpinLock(&this->_Lock, &irql);
+
+	if (this->_Targets[Slot] != nullptr && !this->_Cancelling[Slot])
+	{
+		this->_Deadlines.Schedule(Slot * WorkCount + static_cast<ULONG>(Work), Deadline);
+
+		//
+		// A running batch arms the timer once it's done
+		//
+		if (!this->_Servicing)
+			ArmTimer(EmulationTargetPDO::CurrentMicroframe());
+	}
+
+	KeReleaseSpinLock(&this->_Lock, irql);
+}
+
+VOID BusScheduler::Cancel(ULONG Slot)
+{
+	KIRQL irql;
+
+	NT_ASSERT(KeGetCurrentIrql() == PASSIVE_LEVEL);
+
+	if (Slot >= MaxTargets)
+		return;
+
+	//
+	// While cancelling, neither Schedule nor a running batch may queue the
+	// target again, so the batch is the last to touch it
+	//
+	KeAcquireSpinLock(&this->_Lock, &irql);
+
+	this->_Cancelling[Slot] = TRUE;
+
+	for (ULONG work = 0; work < WorkCount; work++)
+		this->_Deadlines.Cancel(Slot * WorkCount + work);
+
+	KeReleaseSpinLock(&this->_Lock, irql);
+
+	WaitForBatch();
+
+	KeAcquireSpinLock(&this->_Lock, &irql);
+
+	this->_Cancelling[Slot] = FALSE;
+
+	KeReleaseSpinLock(&this->_Lock, irql);
+}
+
+VOID BusScheduler::WaitForBatch()
+{
+	KeWaitForSingleObject(&this->_BatchDone, Executive, KernelMode, FALSE, nullptr);
+}
+
+VOID BusScheduler::EvtTick(_In_ WDFTIMER Timer)
+{
+	FdoGetData(WdfTimerGetParentObject(Timer))->Scheduler.Tick();
+}
+
+VOID BusScheduler::Tick()
+{
+	const ULONGLONG now = EmulationTargetPDO::CurrentMicroframe();
+	ULONG count;
+	KIRQL irql;
+
+	KeAcquireSpinLock(&this->_Lock, &irql);
+
+	this->_Ticks++;
+	this->_Armed = FALSE;
+
+	//
+	// A tick that fires while the previous batch still runs leaves the
+	// work to it, it re-arms the timer when done
+	//
+	if (this->_Servicing)
+	{
+		KeReleaseSpinLock(&this->_Lock, irql);
+		return;
+	}
+
+	count = this->_Deadlines.PopAllDue(now, this->_Batch);
+
+	for (ULONG index = 0; index < count; index++)
+		this->_BatchTargets[index] = this->_Targets[this->_Batch[index].Id / WorkCount];
+
+	if (count == 0)
+		this->_IdleTicks++;
+	else
+	{
+		this->_Servicing = TRUE;
+		KeClearEvent(&this->_BatchDone);
+	}
+
+	this->_Serviced += count;
+
+	if (count > this->_PeakBatch)
+		this->_PeakBatch = count;
+
+	if (now - this->_StatisticsStart >= StatisticsPeriodS * ViGEm::Timing::MicroframesPerSecond)
+	{
+		TraceInformation(
+			TRACE_BUSENUM,
+			"Scheduler: targets=%lu ticks=%lu idle=%lu serviced=%lu peak batch=%lu",
+			this->_Registered,
+			this->_Ticks,
+			this->_IdleTicks,
+			this->_Serviced,
+			this->_PeakBatch
+		);
+
+		this->_StatisticsStart = now;
+		this->_Ticks = 0;
+		this->_IdleTicks = 0;
+		this->_Serviced = 0;
+		this->_PeakBatch = 0;
+	}
+
+	KeReleaseSpinLock(&this->_Lock, irql);
+
+	for (ULONG index = 0; index < count; index++)
+	{
+		ViGEm::Timing::DueWork* entry = &this->_Batch[index];
+
+		entry->Next = this->_BatchTargets[index]->ServiceScheduledWork(
+			static_cast<ScheduledWork>(entry->Id % WorkCount),
+			entry->Deadline,
+			now
+		);
+	}
+
+	KeAcquireSpinLock(&this->_Lock, &irql);
+
+	this->_Deadlines.Requeue(this->_Batch, count, [this](ULONG Index)
+	{
+		const ULONG slot = this->_Batch[Index].Id / WorkCount;
+
+		return this->_Targets[slot] == this->_BatchTargets[Index] && !this->_Cancelling[slot];
+	});
+
+	if (count != 0)
+	{
+		this->_Servicing = FALSE;
+		KeSetEvent(&this->_BatchDone, IO_NO_INCREMENT, FALSE);
+	}
+
+	//
+	// Wake up for the new earliest deadline, with nothing queued stay quiet
+	// until the next Schedule
+	//
+	ArmTimer(EmulationTargetPDO::CurrentMicroframe());
+
+	KeReleaseSpinLock(&this->_Lock, irql);
+}
+
+VOID BusScheduler::ArmTimer(ULONGLONG Now)
+{
+	if (this->_Deadlines.IsEmpty())
+		return;
+
+	const ULONGLONG delay = ViGEm::Timing::TimerDelay(this->_Deadlines.NextDeadline(), Now, MinTimerDelay);
+
+	if (this->_Armed && this->_ArmedAt <= Now + delay)
+		return;
+
+	this->_Armed = TRUE;
+	this->_ArmedAt = Now + delay;
+
+	//
+	// Restarting a queued one-shot timer moves it
+	//
+	WdfTimerStart(
+		this->_Timer,
+		WDF_REL_TIMEOUT_IN_US(delay * (1000000 / ViGEm::Timing::MicroframesPerSecond))
+	);
+}
@@ -0,0 +1,176 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2020, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+#include <ntddk.h>
+#include <wdf.h>
+#include <DeadlineHeap.h>
+
+namespace ViGEm::Bus::Core
+{
+	class EmulationTargetPDO;
+
+	//
+	// Periodic work a target can have the bus scheduler run for it
+	//
+	enum class ScheduledWork : ULONG
+	{
+		InterruptIn = 0,
+		IsoOut,
+		Count
+	};
+
+	//
+	// Bus-wide deadline scheduler. Targets queue deadlines (in microframes
+	// of the bus frame clock) instead of running timers of their own, and
+	// a single one-shot high resolution timer on the FDO fires at the
+	// earliest queued deadline, servicing every due piece of work in one
+	// batch. Nothing queued, nothing fires.
+	//
+	// Work is serviced outside the lock, so a target's service routine may
+	// complete requests whose completion routines queue new deadlines.
+	// Unregister and Cancel wait for a running batch, so once they return
+	// the scheduler no longer touches the target.
+	//
+	// Lives in the FDO context (zero-initialised, no constructor runs)
+	// so it outlives its timer, Init has to be called before use.
+	//
+	class BusScheduler
+	{
+	public:
+		static const ULONG MaxTargets = 128;
+
+		//
+		// Slot of a target that isn't registered, ignored by every call
+		//
+		static const ULONG InvalidSlot = MaxTargets;
+
+		//
+		// Shortest timer delay in microframes, the resolution the timer is
+		// armed with
+		//
+		static const ULONG MinTimerDelay = ViGEm::Timing::MicroframesPerFrame;
+
+		NTSTATUS Init(WDFDEVICE BusDevice);
+
+		NTSTATUS Register(EmulationTargetPDO* Target, PULONG Slot);
+
+		//
+		// Drops the target and its queued work, PASSIVE_LEVEL only
+		//
+		VOID Unregister(ULONG Slot);
+
+		//
+		// Queues work at Deadline, or moves it earlier if already queued
+		//
+		VOID Schedule(ULONG Slot, ScheduledWork Work, ULONGLONG Deadline);
+
+		//
+		// Drops all of a target's queued work, PASSIVE_LEVEL only. Work
+		// queued while it runs is dropped too.
+		//
+		VOID Cancel(ULONG Slot);
+
+	private:
+		static const ULONG WorkCount = static_cast<ULONG>(ScheduledWork::Count);
+
+		static const ULONG Capacity = MaxTargets * WorkCount;
+
+		//
+		// Interval in seconds between statistics dumps
+		//
+		static const ULONG StatisticsPeriodS = 5;
+
+		static EVT_WDF_TIMER EvtTick;
+
+		VOID Tick();
+
+		//
+		// Arms the timer for the earliest deadline unless it already fires
+		// earlier, called with _Lock held
+		//
+		VOID ArmTimer(ULONGLONG Now);
+
+		VOID WaitForBatch();
+
+		KSPIN_LOCK _Lock;
+
+		//
+		// Signalled while no batch is being serviced
+		//
+		KEVENT _BatchDone;
+
+		WDFTIMER _Timer;
+
+		BOOLEAN _Armed;
+
+		//
+		// Microframe the armed timer fires at
+		//
+		ULONGLONG _ArmedAt;
+
+		BOOLEAN _Servicing;
+
+		EmulationTargetPDO* _Targets[MaxTargets];
+
+		//
+		// Set while Cancel waits for a running batch
+		//
+		BOOLEAN _Cancelling[MaxTargets];
+
+		ViGEm::Timing::DeadlineHeap<Capacity> _Deadlines;
+
+		//
+		// Only used by Tick, which _Servicing keeps from overlapping itself
+		//
+		ViGEm::Timing::DueWork _Batch[Capacity];
+
+		//
+		// Target of each batch entry, a slot can be reused while it runs
+		//
+		EmulationTargetPDO* _BatchTargets[Capacity];
+
+		//
+		// Statistics, guarded by _Lock
+		//
+		ULONGLONG _StatisticsStart;
+		ULONG _Ticks;
+		ULONG _IdleTicks;
+		ULONG _Serviced;
+		ULONG _PeakBatch;
+		ULONG _Registered;
+	};
+}
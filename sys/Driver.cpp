@@ -72,6 +72,10 @@ IoctlHandler_IoctlRecord ViGEmBus_IoctlSpecification[] =
 	{IOCTL_XUSB_GET_USER_INDEX, sizeof(XUSB_GET_USER_INDEX), sizeof(XUSB_GET_USER_INDEX), Bus_XusbGetUserIndexHandler},
 	{IOCTL_DS5_AWAIT_OUTPUT_AVAILABLE, sizeof(DS5_AWAIT_OUTPUT), sizeof(DS5_AWAIT_OUTPUT), Bus_Ds5AwaitOutputHandler},
 	{IOCTL_DS5_AWAIT_AUDIO_DATA, sizeof(DS5_AUDIO_DATA), sizeof(DS5_AUDIO_DATA), Bus_Ds5AwaitAudioHandler},
+	{IOCTL_VIGEM_SUBMIT_BATCH, sizeof(ViGEm::Batch::SUBMIT_BATCH_HEADER), sizeof(ViGEm::Batch::SUBMIT_BATCH_HEADER), Bus_SubmitBatchHandler},
+	{IOCTL_VIGEM_ATTACH_INPUT_SLOT, sizeof(ViGEm::Reports::INPUT_SLOT_ATTACH), sizeof(ViGEm::Reports::INPUT_SLOT), Bus_Ds5AttachInputSlotHandler},
+	{IOCTL_VIGEM_ATTACH_AUDIO_RING, sizeof(ViGEm::Audio::AUDIO_RING_ATTACH), sizeof(ViGEm::Audio::AUDIO_RING_HEADER) + ViGEm::Audio::AudioRingMinCapacity, Bus_Ds5AttachAudioRingHandler},
+	{IOCTL_VIGEM_AUDIO_RING_DOORBELL, sizeof(ViGEm::Audio::AUDIO_RING_ATTACH), 0, Bus_Ds5AudioRingDoorbellHandler},
 };
 
 //
@@ -98,6 +102,11 @@ NTSTATUS DriverEntry(IN PDRIVER_OBJECT DriverObject, IN PUNICODE_STRING Registry
 
 	ExInitializeDriverRuntime(DrvRtPoolNxOptIn);
 
+	//
+	// Shared by every target's bus interface, ISO pacing and polling
+	// 
+	ViGEm::Bus::Core::EmulationTargetPDO::InitializeFrameClock();
+
 	//
 	// Register cleanup callback
 	// 
@@ -242,6 +251,15 @@ NTSTATUS Bus_EvtDeviceAdd(IN WDFDRIVER Driver, IN PWDFDEVICE_INIT DeviceInit)
 		pFDOData->InterfaceReferenceCounter = 0;
 		pFDOData->NextSessionId = FDO_FIRST_SESSION_ID;
 
+		if (!NT_SUCCESS(status = pFDOData->Scheduler.Init(device)))
+		{
+			TraceError(
+				TRACE_DRIVER,
+				"BusScheduler::Init failed with status %!STATUS!",
+				status);
+			break;
+		}
+
 #pragma endregion
 
 #pragma region Expose FDO interface
@@ -638,9 +656,14 @@ void Bus_EvtAudioNotifyRequestComplete(
 		reinterpret_cast<PVOID*>(&pNotify),
 		&length)))
 	{
-		RtlCopyMemory(pNotify, pOutput, sizeof(DS5_AUDIO_DATA));
+		//
+		// Only the header and the captured bytes were broadcast
+		//
+		const size_t copyLength = FIELD_OFFSET(DS5_AUDIO_DATA, AudioData) + pOutput->AudioDataLength;
+
+		RtlCopyMemory(pNotify, pOutput, copyLength);
 
-		WdfRequestSetInformation(Request, sizeof(DS5_AUDIO_DATA));
+		WdfRequestSetInformation(Request, copyLength);
 	}
 
 	WdfRequestComplete(Request, NtStatus);
@@ -43,6 +43,8 @@
 #define NTSTRSAFE_LIB
 #include <ntstrsafe.h>
 
+#include "BusScheduler.hpp"
+
 
 #pragma region Macros
 
@@ -75,6 +77,11 @@ typedef struct _FDO_DEVICE_DATA
     // 
     DMFMODULE AudioNotification;
 
+    //
+    // Services every target's interrupt IN and ISO OUT deadlines
+    // 
+    ViGEm::Bus::Core::BusScheduler Scheduler;
+
 } FDO_DEVICE_DATA, * PFDO_DEVICE_DATA;
 
 #define FDO_FIRST_SESSION_ID 100
@@ -62,6 +62,37 @@ ViGEm::Bus::Targets::EmulationTargetDS5::EmulationTargetDS5(ULONG Serial, LONG S
     // 
     this->_PowerCapabilities.DeviceState[PowerSystemWorking] = PowerDeviceD0;
     this->_PowerCapabilities.WakeFromD0 = WdfTrue;
+
+    KeInitializeSpinLock(&this->_InputSlotLock);
+    KeInitializeEvent(&this->_InputSlotDetached, NotificationEvent, TRUE);
+    KeInitializeSpinLock(&this->_AudioRingLock);
+    KeInitializeEvent(&this->_AudioRingDetached, NotificationEvent, TRUE);
+    KeInitializeSpinLock(&this->_IsoOutLock);
+}
+
+ViGEm::Bus::Targets::EmulationTargetDS5::~EmulationTargetDS5()
+{
+    //
+    // The feeder's attach requests may outlive the PDO, release them and
+    // wait for cancel routines that are already running
+    //
+    DetachInputSlot();
+    DetachAudioRing();
+
+    KeWaitForSingleObject(&this->_InputSlotDetached, Executive, KernelMode, FALSE, nullptr);
+    KeWaitForSingleObject(&this->_AudioRingDetached, Executive, KernelMode, FALSE, nullptr);
+
+    //
+    // These queues parent is the FDO so explicitly free memory
+    //
+    this->_OutputAwaits.Destroy();
+    this->_AudioAwaits.Destroy();
+
+    if (this->_AudioRingDoorbells != nullptr)
+    {
+        WdfIoQueuePurgeSynchronously(this->_AudioRingDoorbells);
+        WdfObjectDelete(this->_AudioRingDoorbells);
+    }
 }
 
 NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::PdoPrepareDevice(PWDFDEVICE_INIT DeviceInit,
@@ -229,57 +260,73 @@ NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::PdoPrepareHardware()
     };
 
     // Initialize HID reports to defaults
-    RtlCopyBytes(this->_Report, DefaultHidReport, DS5_REPORT_SIZE);
+    this->_Report.Write(DefaultHidReport);
     RtlZeroMemory(&this->_OutputReport, sizeof(DS5_OUTPUT_REPORT));
 
-    // Start pending IRP queue flush timer
-    WdfTimerStart(this->_PendingUsbInRequestsTimer, DS5_QUEUE_FLUSH_PERIOD);
-
-    // Start ISO OUT completion timer
-    WdfTimerStart(this->_PendingIsoOutTimer, WDF_REL_TIMEOUT_IN_MS(DS5_ISO_OUT_COMPLETION_PERIOD_MS));
+    //
+    // Polling and ISO OUT pacing are scheduled on the bus scheduler by the
+    // first URB queued to them and drop out once their queue runs dry
+    //
+    if (this->_Scheduler != nullptr && this->_SchedulerSlot == Core::BusScheduler::InvalidSlot)
+    {
+        status = this->_Scheduler->Register(this, &this->_SchedulerSlot);
+        if (!NT_SUCCESS(status))
+        {
+            TraceError(
+                TRACE_DS5,
+                "BusScheduler::Register failed with status %!STATUS!",
+                status);
+            return status;
+        }
+    }
 
     return STATUS_SUCCESS;
 }
 
-NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::PdoInitContext()
+VOID ViGEm::Bus::Targets::EmulationTargetDS5::PdoReleaseHardware()
 {
-    NTSTATUS status;
-
-    // Initialize periodic timer
-    WDF_TIMER_CONFIG timerConfig;
-    WDF_TIMER_CONFIG_INIT_PERIODIC(
-        &timerConfig,
-        PendingUsbRequestsTimerFunc,
-        DS5_QUEUE_FLUSH_PERIOD
-    );
+    NT_ASSERT(KeGetCurrentIrql() == PASSIVE_LEVEL);
 
-    // Timer object attributes
-    WDF_OBJECT_ATTRIBUTES timerAttribs;
-    WDF_OBJECT_ATTRIBUTES_INIT(&timerAttribs);
+    //
+    // The scheduler's timer belongs to the FDO and outlives us, returns
+    // once no batch is servicing our queues any more
+    //
+    if (this->_Scheduler != nullptr && this->_SchedulerSlot != Core::BusScheduler::InvalidSlot)
+    {
+        this->_Scheduler->Unregister(this->_SchedulerSlot);
+        this->_SchedulerSlot = Core::BusScheduler::InvalidSlot;
+    }
+}
 
-    // PDO is parent
-    timerAttribs.ParentObject = this->_PdoDevice;
+NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::PdoInitContext()
+{
+    NTSTATUS status;
 
     do
     {
-        // Create timer
-        if (!NT_SUCCESS(status = WdfTimerCreate(
-            &timerConfig,
-            &timerAttribs,
-            &this->_PendingUsbInRequestsTimer
+        WDF_OBJECT_ATTRIBUTES lockAttribs;
+        WDF_OBJECT_ATTRIBUTES_INIT(&lockAttribs);
+        lockAttribs.ParentObject = this->_PdoDevice;
+
+        if (!NT_SUCCESS(status = WdfSpinLockCreate(
+            &lockAttribs,
+            &this->_LatencyLock
         )))
         {
             TraceError(
                 TRACE_DS5,
-                "WdfTimerCreate failed with status %!STATUS!",
+                "WdfSpinLockCreate failed with status %!STATUS!",
                 status);
             break;
         }
 
+        this->_LatencyWindowStart = KeQueryPerformanceCounter(&this->_LatencyFrequency).QuadPart;
+        this->_IsoOutPacer.Init();
+
         //
         // Create manual dispatch queue for pending ISO OUT requests.
-        // Requests are held here and completed by a periodic timer
-        // to simulate real USB isochronous transfer timing.
+        // Requests are held here and completed by the bus scheduler
+        // once due to simulate real USB isochronous transfer timing.
         //
         {
             WDF_IO_QUEUE_CONFIG isoQueueConfig;
@@ -300,37 +347,6 @@ NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::PdoInitContext()
             }
         }
 
-        //
-        // Create periodic timer for ISO OUT completion.
-        // Fires every DS5_ISO_OUT_COMPLETION_PERIOD_MS to dequeue
-        // and complete one pending ISO OUT request, throttling the rate.
-        //
-        {
-            WDF_TIMER_CONFIG isoTimerConfig;
-            WDF_TIMER_CONFIG_INIT_PERIODIC(
-                &isoTimerConfig,
-                PendingIsoOutTimerFunc,
-                DS5_ISO_OUT_COMPLETION_PERIOD_MS
-            );
-
-            WDF_OBJECT_ATTRIBUTES isoTimerAttribs;
-            WDF_OBJECT_ATTRIBUTES_INIT(&isoTimerAttribs);
-            isoTimerAttribs.ParentObject = this->_PdoDevice;
-
-            if (!NT_SUCCESS(status = WdfTimerCreate(
-                &isoTimerConfig,
-                &isoTimerAttribs,
-                &this->_PendingIsoOutTimer
-            )))
-            {
-                TraceError(
-                    TRACE_DS5,
-                    "WdfTimerCreate (IsoOut) failed with status %!STATUS!",
-                    status);
-                break;
-            }
-        }
-
         // Load/generate MAC address
 
         // 
@@ -461,6 +477,66 @@ NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::PdoInitContext()
             break;
         }
 
+        //
+        // Optional change suppression policy, defaults to ignoring all volatile fields
+        //
+        ULONG significantFields = 0;
+        RtlUnicodeStringInit(&valueName, L"InputSignificantFields");
+
+        status = WdfRegistryQueryULong(keySerial, &valueName, &significantFields);
+
+        if (status == STATUS_OBJECT_NAME_NOT_FOUND)
+        {
+            significantFields = 0;
+            status = STATUS_SUCCESS;
+        }
+        else if (!NT_SUCCESS(status))
+        {
+            TraceError(
+                TRACE_DS5,
+                "WdfRegistryQueryULong failed with status %!STATUS!",
+                status);
+            break;
+        }
+
+        this->_InputFilter.SetSignificantFields(significantFields & ViGEm::Reports::Ds5FieldAll);
+
+        TraceInformation(
+            TRACE_DS5,
+            "Input significant fields: 0x%02X",
+            significantFields);
+
+        //
+        // Optional interrupt IN polling interval in ms (1-16), a real
+        // wired DualSense is polled every 1 ms
+        //
+        ULONG pollingInterval = DS5_QUEUE_FLUSH_PERIOD;
+        RtlUnicodeStringInit(&valueName, L"PollingIntervalMs");
+
+        status = WdfRegistryQueryULong(keySerial, &valueName, &pollingInterval);
+
+        if (status == STATUS_OBJECT_NAME_NOT_FOUND)
+        {
+            pollingInterval = DS5_QUEUE_FLUSH_PERIOD;
+            status = STATUS_SUCCESS;
+        }
+        else if (!NT_SUCCESS(status))
+        {
+            TraceError(
+                TRACE_DS5,
+                "WdfRegistryQueryULong failed with status %!STATUS!",
+                status);
+            break;
+        }
+
+        this->_PollPump.Init(pollingInterval, this->_LatencyFrequency.QuadPart);
+
+        TraceInformation(
+            TRACE_DS5,
+            "Polling interval: %u ms (requested %u)",
+            this->_PollPump.IntervalMs,
+            pollingInterval);
+
         WdfRegistryClose(keySerial);
         WdfRegistryClose(keyDS);
         WdfRegistryClose(keyTargets);
@@ -849,8 +925,11 @@ NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::SelectConfiguration(PURB Urb)
 void ViGEm::Bus::Targets::EmulationTargetDS5::AbortPipe()
 {
     // Higher driver shutting down, emptying PDOs queues
-    WdfTimerStop(this->_PendingUsbInRequestsTimer, TRUE);
-    WdfTimerStop(this->_PendingIsoOutTimer, TRUE);
+    if (this->_Scheduler != nullptr)
+    {
+        // The next URB schedules them again
+        this->_Scheduler->Cancel(this->_SchedulerSlot);
+    }
 
     // Drain all pending ISO OUT requests
     if (this->_PendingIsoOutRequests != nullptr)
@@ -1353,9 +1432,38 @@ NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::UsbIsochronousTransfer(PURB Ur
     //
     // Queue the request for delayed completion by the periodic timer.
     // This prevents USBAudio from instantly submitting the next URB,
-    // matching real USB isochronous transfer timing (~10-20ms per URB).
+    // matching real USB isochronous transfer timing (one packet per frame).
+    //
+    WDF_OBJECT_ATTRIBUTES attributes;
+    PDS5_ISO_OUT_REQUEST_CONTEXT context;
+    LONGLONG dueTime;
+    KIRQL irql;
+
+    WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(&attributes, DS5_ISO_OUT_REQUEST_CONTEXT);
+
+    NTSTATUS status = WdfObjectAllocateContext(Request, &attributes, reinterpret_cast<PVOID*>(&context));
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_WARNING, TRACE_DS5,
+            "WdfObjectAllocateContext (IsoOut) failed with status %!STATUS!, completing immediately",
+            status);
+        return STATUS_SUCCESS;
+    }
+
+    context->Packets = Urb->UrbIsochronousTransfer.NumberOfPackets;
+
     //
-    NTSTATUS status = WdfRequestForwardToIoQueue(Request, this->_PendingIsoOutRequests);
+    // Scheduled and queued under the lock so due times stay in queue order
+    //
+    KeAcquireSpinLock(&this->_IsoOutLock, &irql);
+
+    context->DueTime = this->_IsoOutPacer.Schedule(static_cast<LONGLONG>(CurrentMicroframe()), context->Packets);
+    dueTime = context->DueTime;
+
+    status = WdfRequestForwardToIoQueue(Request, this->_PendingIsoOutRequests);
+
+    KeReleaseSpinLock(&this->_IsoOutLock, irql);
+
     if (!NT_SUCCESS(status))
     {
         TraceEvents(TRACE_LEVEL_WARNING, TRACE_DS5,
@@ -1364,6 +1472,14 @@ NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::UsbIsochronousTransfer(PURB Ur
         return STATUS_SUCCESS;
     }
 
+    //
+    // After queuing, so a service pass that found the queue empty can't
+    // leave this request behind. Keeps the earlier deadline if the head
+    // request is already scheduled. The request may be completed by now,
+    // hence the copy of its due time.
+    //
+    ScheduleWork(Core::ScheduledWork::IsoOut, static_cast<ULONGLONG>(dueTime));
+
     return STATUS_PENDING;
 }
 
@@ -1770,7 +1886,24 @@ NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::UsbBulkOrInterruptTransfer(
            The request gets completed as soon as the "feeder" sent an update. */
         status = WdfRequestForwardToIoQueue(Request, this->_PendingUsbInRequests);
 
-        return (NT_SUCCESS(status)) ? STATUS_PENDING : status;
+        if (!NT_SUCCESS(status))
+            return status;
+
+        ScheduleWork(
+            Core::ScheduledWork::InterruptIn,
+            CurrentMicroframe() + this->_PollPump.IntervalMs * ViGEm::Timing::MicroframesPerFrame
+        );
+
+        //
+        // A report posted while no URB was pending is delivered right away.
+        // Checked after queuing so a concurrent submit can't miss this URB.
+        //
+        PullInputSlot();
+
+        if (ReadAcquire(&this->_ReportUndelivered))
+            DeliverReport();
+
+        return STATUS_PENDING;
     }
 
     // Store relevant bytes of buffer in PDO context
@@ -1794,6 +1927,8 @@ NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::UsbBulkOrInterruptTransfer(
               sizeof(DS5_AWAIT_OUTPUT)
     );
 
+    this->_OutputAwaits.Deliver(&this->_AwaitOutputCache, sizeof(DS5_AWAIT_OUTPUT));
+
     if (!NT_SUCCESS(status = DMF_NotifyUserWithRequestMultiple_DataBroadcast(
         this->_OutputReportNotify,
         &this->_AwaitOutputCache,
@@ -1901,36 +2036,20 @@ NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::UsbControlTransfer(PURB Urb)
 
 NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::SubmitReportImpl(PVOID NewReport)
 {
-    NTSTATUS status;
-    WDFREQUEST usbRequest;
-
     /*
      * The logic here is unusual to keep backwards compatibility with the
      * original API that didn't allow submitting the full report.
      */
 
-    status = WdfIoQueueRetrieveNextRequest(this->_PendingUsbInRequests, &usbRequest);
-
-    if (!NT_SUCCESS(status))
-        return status;
-
-    // Get pending IRP
-    PIRP pendingIrp = WdfRequestWdmGetIrp(usbRequest);
-
-    // Get USB request block
-    const auto urb = static_cast<PURB>(URB_FROM_IRP(pendingIrp));
-
-    // Get transfer buffer
-    const auto buffer = static_cast<PUCHAR>(urb->UrbBulkOrInterruptTransfer.TransferBuffer);
-
-    // Set correct buffer size
-    urb->UrbBulkOrInterruptTransfer.TransferBufferLength = DS5_REPORT_SIZE;
+    const LONGLONG arrivedAt = KeQueryPerformanceCounter(nullptr).QuadPart;
 
     // Cast to expected struct
     const auto pSubmit = static_cast<PDS5_SUBMIT_REPORT>(NewReport);
 
+    BOOLEAN changed = TRUE;
+
     /*
-     * Copy report to cache and transfer buffer
+     * Copy report to cache
      * Skip first byte as it contains the never changing report ID
      */
 
@@ -1938,188 +2057,984 @@ NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::SubmitReportImpl(PVOID NewRepo
     {
         TraceVerbose(TRACE_DS5, "Received DS5_SUBMIT_REPORT update");
 
-        RtlCopyBytes(
-            &this->_Report[1],
-            &(static_cast<PDS5_SUBMIT_REPORT>(NewReport))->Report,
-            sizeof((static_cast<PDS5_SUBMIT_REPORT>(NewReport))->Report)
-        );
+        //
+        // Always refresh the cache so the timer delivers current volatile fields
+        //
+        changed = WriteReport(reinterpret_cast<PUCHAR>(&pSubmit->Report));
     }
 
-    if (buffer)
-        RtlCopyBytes(buffer, this->_Report, DS5_REPORT_SIZE);
+    // Don't waste pending URB if input hasn't changed
+    if (!PostReport(changed, arrivedAt))
+    {
+        TraceVerbose(
+            TRACE_DS5,
+            "Input report hasn't changed since last update, leaving URB pending");
 
-    // Complete pending request
-    WdfRequestComplete(usbRequest, status);
+        return STATUS_SUCCESS;
+    }
 
-    return status;
+    //
+    // Without a pending URB the report stays in the mailbox until the
+    // next URB arrives or the timer fires, the submit itself succeeds
+    //
+    DeliverReport();
+
+    return STATUS_SUCCESS;
 }
 
-VOID ViGEm::Bus::Targets::EmulationTargetDS5::ReverseByteArray(PUCHAR Array, INT Length)
+//
+// Posts a freshly cached report to the mailbox; a report still waiting
+// there is superseded. Unchanged reports are only counted. Returns Changed.
+//
+BOOLEAN ViGEm::Bus::Targets::EmulationTargetDS5::PostReport(BOOLEAN Changed, LONGLONG ArrivedAt)
 {
-    const auto s = static_cast<PUCHAR>(ExAllocatePoolZero(
-        NonPagedPoolNx,
-        sizeof(UCHAR) * Length,
-        'U4SD'
-    ));
-    INT c, d;
-
-    if (s == nullptr)
-        return;
+    WdfSpinLockAcquire(this->_LatencyLock);
 
-    for (c = Length - 1, d = 0; c >= 0; c--, d++)
-        *(s + d) = *(Array + c);
+    if (!Changed)
+        this->_UrbCompletionsAvoided++;
+    else
+    {
+        if (InterlockedExchange(&this->_ReportUndelivered, TRUE))
+            this->_ReportsOverwritten++;
+        this->_ReportCachedAt = ArrivedAt;
+    }
 
-    for (c = 0; c < Length; c++)
-        *(Array + c) = *(s + c);
+    WdfSpinLockRelease(this->_LatencyLock);
 
-    ExFreePoolWithTag(s, 'U4SD');
+    return Changed;
 }
 
-VOID ViGEm::Bus::Targets::EmulationTargetDS5::GenerateRandomMacAddress(PMAC_ADDRESS Address)
+//
+// Updates the cached input report (without report ID).
+// Returns TRUE if a significant field changed.
+//
+BOOLEAN ViGEm::Bus::Targets::EmulationTargetDS5::WriteReport(const UCHAR* Payload)
 {
-    // Vendor "C0:13:37"
-    Address->Vendor0 = 0xC0;
-    Address->Vendor1 = 0x13;
-    Address->Vendor2 = 0x37;
+    return this->_Report.Update([this, Payload](UCHAR (&Report)[DS5_REPORT_SIZE])
+    {
+        const bool changed = this->_InputFilter.Changed(&Report[1], Payload);
 
-    ULONG seed = KeQueryPerformanceCounter(NULL).LowPart;
+        RtlCopyBytes(&Report[1], Payload, DS5_REPORT_SIZE - 1);
 
-    Address->Nic0 = RtlRandomEx(&seed) % 0xFF;
-    Address->Nic1 = RtlRandomEx(&seed) % 0xFF;
-    Address->Nic2 = RtlRandomEx(&seed) % 0xFF;
+        return changed;
+    }) ? TRUE : FALSE;
 }
 
-void ViGEm::Bus::Targets::EmulationTargetDS5::ProcessPendingNotification(WDFQUEUE Queue)
+//
+// Completes the oldest pending interrupt IN URB with the cached report and
+// empties the mailbox. Returns FALSE if no URB is pending.
+//
+BOOLEAN ViGEm::Bus::Targets::EmulationTargetDS5::DeliverReport()
 {
-    NTSTATUS status;
-    WDFREQUEST request;
-    PVOID clientBuffer, contextBuffer;
-    PDS5_REQUEST_NOTIFICATION notify = nullptr;
+    WDFREQUEST usbRequest;
 
-    FuncEntry(TRACE_DS5);
+    if (!NT_SUCCESS(WdfIoQueueRetrieveNextRequest(this->_PendingUsbInRequests, &usbRequest)))
+        return FALSE;
 
     //
-    // Loop through and drain all queued requests until buffer is empty
-    // 
-    while (NT_SUCCESS(WdfIoQueueRetrieveNextRequest(Queue, &request)))
-    {
-        status = DMF_BufferQueue_Dequeue(
-            this->_UsbInterruptOutBufferQueue,
-            &clientBuffer,
-            &contextBuffer
-        );
+    // Clear before copying: a submit racing with us re-posts and is
+    // picked up by the next URB instead of being lost
+    //
+    InterlockedExchange(&this->_ReportUndelivered, FALSE);
 
-        //
-        // Shouldn't happen, but if so, error out
-        // 
-        if (!NT_SUCCESS(status))
-        {
-            //
-            // Don't requeue request as we may be out of order now
-            // 
-            WdfRequestComplete(request, status);
-            continue;
-        }
+    // Get pending IRP
+    const auto pendingIrp = WdfRequestWdmGetIrp(usbRequest);
 
-        if (NT_SUCCESS(WdfRequestRetrieveOutputBuffer(
-            request,
-            sizeof(DS5_REQUEST_NOTIFICATION),
-            reinterpret_cast<PVOID*>(&notify),
-            nullptr
-        )))
-        {
-            // 
-            // Assign values to output buffer
-            // 
-            notify->Size = sizeof(DS5_REQUEST_NOTIFICATION);
-            notify->SerialNo = this->_SerialNo;
-            notify->Report = *static_cast<PDS5_OUTPUT_REPORT>(clientBuffer);
+    // Get USB request block
+    const auto urb = static_cast<PURB>(URB_FROM_IRP(pendingIrp));
 
-            DumpAsHex("!! XUSB_REQUEST_NOTIFICATION",
-                      notify,
-                      sizeof(DS5_REQUEST_NOTIFICATION)
-            );
+    // Get transfer buffer
+    const auto buffer = static_cast<PUCHAR>(urb->UrbBulkOrInterruptTransfer.TransferBuffer);
 
-            WdfRequestCompleteWithInformation(request, status, notify->Size);
-        }
+    // Set correct buffer size
+    urb->UrbBulkOrInterruptTransfer.TransferBufferLength = DS5_REPORT_SIZE;
 
-        DMF_BufferQueue_Reuse(this->_UsbInterruptOutBufferQueue, clientBuffer);
+    // Copy consistent snapshot of cached report to URB transfer buffer
+    if (buffer)
+        this->_Report.Read(buffer);
 
-        //
-        // If no more buffer to process, exit loop and await next callback
-        // 
-        if (DMF_BufferQueue_Count(this->_UsbInterruptOutBufferQueue) == 0)
-        {
-            break;
-        }
-    }
+    // Complete pending request
+    WdfRequestComplete(usbRequest, STATUS_SUCCESS);
 
-    TraceVerbose(TRACE_USBPDO, "%!FUNC! Exit");
-}
+    WriteNoFence(&this->_LastDeliveryFrame, static_cast<LONG>(CurrentFrame()));
 
-VOID ViGEm::Bus::Targets::EmulationTargetDS5::PendingUsbRequestsTimerFunc(
-    _In_ WDFTIMER Timer
-)
-{
-    const auto ctx = reinterpret_cast<EmulationTargetDS5*>(Core::EmulationTargetPdoGetContext(
-        WdfTimerGetParentObject(Timer))->Target);
+    RecordReportDelivered();
 
-    WDFREQUEST usbRequest;
+    return TRUE;
+}
 
-    FuncEntry(TRACE_DS5);
+//
+// Maps the feeder's input slot (the output buffer of a METHOD_OUT_DIRECT
+// request) and keeps the request pending until it's cancelled or the PDO
+// goes away. Only one slot can be attached at a time.
+//
+NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::AttachInputSlot(WDFREQUEST Request)
+{
+    NTSTATUS status;
+    PMDL mdl;
+    WDF_OBJECT_ATTRIBUTES attributes;
+    PDS5_SHARED_MEMORY_REQUEST_CONTEXT context;
+    KIRQL irql;
+
+    if (!this->IsOwnerProcess())
+        return STATUS_ACCESS_DENIED;
+
+    if (!NT_SUCCESS(status = WdfRequestRetrieveOutputWdmMdl(Request, &mdl)))
+        return status;
+
+    if (MmGetMdlByteCount(mdl) < sizeof(ViGEm::Reports::INPUT_SLOT))
+        return STATUS_BUFFER_TOO_SMALL;
+
+    const auto slot = static_cast<const ViGEm::Reports::INPUT_SLOT*>(
+        MmGetSystemAddressForMdlSafe(mdl, NormalPagePriority | MdlMappingNoExecute));
+
+    if (slot == nullptr)
+        return STATUS_INSUFFICIENT_RESOURCES;
+
+    WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(&attributes, DS5_SHARED_MEMORY_REQUEST_CONTEXT);
+
+    if (!NT_SUCCESS(status = WdfObjectAllocateContext(Request, &attributes, reinterpret_cast<PVOID*>(&context))))
+        return status;
 
-    // Get pending USB request
-    const auto status = WdfIoQueueRetrieveNextRequest(ctx->_PendingUsbInRequests, &usbRequest);
+    context->Target = this;
+
+    KeAcquireSpinLock(&this->_InputSlotLock, &irql);
+
+    if (this->_InputSlotRequest != nullptr)
+        status = STATUS_DEVICE_BUSY;
+    else if (NT_SUCCESS(status = WdfRequestMarkCancelableEx(Request, EvtInputSlotCanceled)))
+    {
+        KeClearEvent(&this->_InputSlotDetached);
+
+        this->_InputSlotRequest = Request;
+        this->_InputSlot = slot;
+        //
+        // Anything published before the attach is ignored, a zeroed slot
+        // would otherwise be delivered as a report
+        //
+        this->_InputSlotSequence = slot->Sequence;
+    }
+
+    KeReleaseSpinLock(&this->_InputSlotLock, irql);
 
     if (NT_SUCCESS(status))
     {
-        // Get pending IRP
-        const auto pendingIrp = WdfRequestWdmGetIrp(usbRequest);
+        TraceInformation(
+            TRACE_DS5,
+            "Serial %u attached input slot",
+            this->_SerialNo);
+    }
+
+    return status;
+}
+
+VOID ViGEm::Bus::Targets::EmulationTargetDS5::EvtInputSlotCanceled(
+    _In_ WDFREQUEST Request
+)
+{
+    const auto target = Ds5SharedMemoryRequestGetContext(Request)->Target;
+    KIRQL irql;
+
+    KeAcquireSpinLock(&target->_InputSlotLock, &irql);
+
+    if (target->_InputSlotRequest == Request)
+    {
+        target->_InputSlotRequest = nullptr;
+        target->_InputSlot = nullptr;
+    }
+
+    KeReleaseSpinLock(&target->_InputSlotLock, irql);
+
+    TraceInformation(
+        TRACE_DS5,
+        "Serial %u detached input slot",
+        target->_SerialNo);
+
+    //
+    // Last access to the target, it may be freed once this is signaled
+    //
+    KeSetEvent(&target->_InputSlotDetached, IO_NO_INCREMENT, FALSE);
+
+    WdfRequestComplete(Request, STATUS_CANCELLED);
+}
+
+//
+// Completes the attach request unless its cancel routine already owns it.
+//
+VOID ViGEm::Bus::Targets::EmulationTargetDS5::DetachInputSlot()
+{
+    WDFREQUEST request;
+    KIRQL irql;
+
+    KeAcquireSpinLock(&this->_InputSlotLock, &irql);
+
+    request = this->_InputSlotRequest;
+    this->_InputSlotRequest = nullptr;
+    this->_InputSlot = nullptr;
+
+    KeReleaseSpinLock(&this->_InputSlotLock, irql);
+
+    if (request == nullptr || !NT_SUCCESS(WdfRequestUnmarkCancelable(request)))
+        return;
+
+    KeSetEvent(&this->_InputSlotDetached, IO_NO_INCREMENT, FALSE);
+
+    WdfRequestComplete(request, STATUS_DEVICE_REMOVED);
+}
+
+//
+// Picks up a report published in the attached input slot since the last
+// poll and posts it to the mailbox. Returns TRUE if it changed the report.
+//
+BOOLEAN ViGEm::Bus::Targets::EmulationTargetDS5::PullInputSlot()
+{
+    UCHAR payload[DS5_REPORT_SIZE - 1];
+    auto read = ViGEm::Reports::InputSlotRead::Unchanged;
+    KIRQL irql;
+
+    //
+    // Unlocked peek, most targets never attach a slot
+    //
+    if (ReadPointerNoFence(reinterpret_cast<PVOID const volatile*>(&this->_InputSlot)) == nullptr)
+        return FALSE;
+
+    KeAcquireSpinLock(&this->_InputSlotLock, &irql);
+
+    if (this->_InputSlot != nullptr)
+        read = ViGEm::Reports::ReadInputSlot(this->_InputSlot, payload, sizeof(payload), &this->_InputSlotSequence);
+
+    KeReleaseSpinLock(&this->_InputSlotLock, irql);
+
+    //
+    // A torn read (feeder mid-write) is retried on the next poll
+    //
+    if (read != ViGEm::Reports::InputSlotRead::Updated)
+        return FALSE;
+
+    return PostReport(WriteReport(payload), KeQueryPerformanceCounter(nullptr).QuadPart);
+}
+
+//
+// Maps the consumer's audio ring (the output buffer of a METHOD_OUT_DIRECT
+// request) and keeps the request pending until it's cancelled or the PDO
+// goes away. Only one ring can be attached at a time.
+//
+NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::AttachAudioRing(WDFREQUEST Request)
+{
+    NTSTATUS status;
+    PMDL mdl;
+    WDF_OBJECT_ATTRIBUTES attributes;
+    PDS5_SHARED_MEMORY_REQUEST_CONTEXT context;
+    KIRQL irql;
+
+    if (!this->IsOwnerProcess())
+        return STATUS_ACCESS_DENIED;
+
+    if (!NT_SUCCESS(status = WdfRequestRetrieveOutputWdmMdl(Request, &mdl)))
+        return status;
+
+    const ULONG capacity = ViGEm::Audio::AudioRingCapacityFor(MmGetMdlByteCount(mdl));
+
+    if (capacity == 0)
+        return STATUS_BUFFER_TOO_SMALL;
+
+    const auto ring = static_cast<ViGEm::Audio::AUDIO_RING_HEADER*>(
+        MmGetSystemAddressForMdlSafe(mdl, NormalPagePriority | MdlMappingNoExecute));
+
+    if (ring == nullptr)
+        return STATUS_INSUFFICIENT_RESOURCES;
+
+    WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(&attributes, DS5_SHARED_MEMORY_REQUEST_CONTEXT);
+
+    if (!NT_SUCCESS(status = WdfObjectAllocateContext(Request, &attributes, reinterpret_cast<PVOID*>(&context))))
+        return status;
+
+    context->Target = this;
+
+    KeAcquireSpinLock(&this->_AudioRingLock, &irql);
+
+    if (this->_AudioRingRequest != nullptr)
+        status = STATUS_DEVICE_BUSY;
+    else if (NT_SUCCESS(status = WdfRequestMarkCancelableEx(Request, EvtAudioRingCanceled)))
+    {
+        KeClearEvent(&this->_AudioRingDetached);
+
+        this->_AudioRingRequest = Request;
+        this->_AudioRing.Attach(ring, capacity);
+    }
+
+    KeReleaseSpinLock(&this->_AudioRingLock, irql);
+
+    if (NT_SUCCESS(status))
+    {
+        TraceInformation(
+            TRACE_DS5,
+            "Serial %u attached audio ring of %u bytes",
+            this->_SerialNo,
+            capacity);
+    }
+
+    return status;
+}
+
+VOID ViGEm::Bus::Targets::EmulationTargetDS5::EvtAudioRingCanceled(
+    _In_ WDFREQUEST Request
+)
+{
+    const auto target = Ds5SharedMemoryRequestGetContext(Request)->Target;
+    KIRQL irql;
+
+    KeAcquireSpinLock(&target->_AudioRingLock, &irql);
+
+    if (target->_AudioRingRequest == Request)
+    {
+        target->_AudioRingRequest = nullptr;
+        target->_AudioRing.Ring = nullptr;
+    }
+
+    KeReleaseSpinLock(&target->_AudioRingLock, irql);
+
+    target->FlushAudioDoorbells();
+
+    TraceInformation(
+        TRACE_DS5,
+        "Serial %u detached audio ring",
+        target->_SerialNo);
+
+    //
+    // Last access to the target, it may be freed once this is signaled
+    //
+    KeSetEvent(&target->_AudioRingDetached, IO_NO_INCREMENT, FALSE);
+
+    WdfRequestComplete(Request, STATUS_CANCELLED);
+}
+
+//
+// Completes the attach request unless its cancel routine already owns it.
+//
+VOID ViGEm::Bus::Targets::EmulationTargetDS5::DetachAudioRing()
+{
+    WDFREQUEST request;
+    KIRQL irql;
+
+    KeAcquireSpinLock(&this->_AudioRingLock, &irql);
+
+    request = this->_AudioRingRequest;
+    this->_AudioRingRequest = nullptr;
+    this->_AudioRing.Ring = nullptr;
+
+    KeReleaseSpinLock(&this->_AudioRingLock, irql);
+
+    if (request == nullptr || !NT_SUCCESS(WdfRequestUnmarkCancelable(request)))
+        return;
+
+    FlushAudioDoorbells();
+
+    KeSetEvent(&this->_AudioRingDetached, IO_NO_INCREMENT, FALSE);
+
+    WdfRequestComplete(request, STATUS_DEVICE_REMOVED);
+}
+
+//
+// Fails doorbells left waiting on a ring that went away.
+//
+VOID ViGEm::Bus::Targets::EmulationTargetDS5::FlushAudioDoorbells()
+{
+    WDFREQUEST request;
+
+    while (NT_SUCCESS(WdfIoQueueRetrieveNextRequest(this->_AudioRingDoorbells, &request)))
+    {
+        WdfRequestComplete(request, STATUS_INVALID_DEVICE_STATE);
+    }
+}
 
-        const auto irpStack = IoGetCurrentIrpStackLocation(pendingIrp);
+//
+// Completes right away (STATUS_SUCCESS) if the ring already holds enough
+// data, otherwise parks the request until the ISO OUT handler fills it.
+//
+NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::RingAudioDoorbell(WDFREQUEST Request)
+{
+    NTSTATUS status;
+    KIRQL irql;
 
-        // Get USB request block
-        const auto urb = static_cast<PURB>(irpStack->Parameters.Others.Argument1);
+    if (!this->IsOwnerProcess())
+        return STATUS_ACCESS_DENIED;
 
-        // Get transfer buffer
-        const auto buffer = static_cast<PUCHAR>(urb->UrbBulkOrInterruptTransfer.TransferBuffer);
+    KeAcquireSpinLock(&this->_AudioRingLock, &irql);
 
-        // Set buffer length to report size
-        urb->UrbBulkOrInterruptTransfer.TransferBufferLength = DS5_REPORT_SIZE;
+    if (this->_AudioRing.Ring == nullptr)
+        status = STATUS_INVALID_DEVICE_STATE;
+    else if (this->_AudioRing.ShouldWake())
+        status = STATUS_SUCCESS;
+    else
+    {
+        //
+        // Forwarded under the lock so a write landing now rings it
+        //
+        status = WdfRequestForwardToIoQueue(Request, this->_AudioRingDoorbells);
 
-        // Copy cached report to transfer buffer 
-        if (buffer)
-            RtlCopyBytes(buffer, ctx->_Report, DS5_REPORT_SIZE);
+        status = (NT_SUCCESS(status)) ? STATUS_PENDING : status;
+    }
+
+    KeReleaseSpinLock(&this->_AudioRingLock, irql);
+
+    return status;
+}
+
+//
+// Writes the URB's audio straight into the attached ring. Returns FALSE
+// if no ring is attached and the audio should take the await path.
+//
+BOOLEAN ViGEm::Bus::Targets::EmulationTargetDS5::WriteAudioRing(const _URB_ISOCH_TRANSFER* IsoUrb)
+{
+    WDFREQUEST doorbell = nullptr;
+    BOOLEAN attached = FALSE;
+    ULONG total = 0;
+    KIRQL irql;
+
+    //
+    // Unlocked peek, most targets never attach a ring
+    //
+    if (ReadPointerNoFence(reinterpret_cast<PVOID const volatile*>(&this->_AudioRing.Ring)) == nullptr)
+        return FALSE;
+
+    for (ULONG i = 0; i < IsoUrb->NumberOfPackets; i++)
+        total += IsoOutPacketLength(IsoUrb, i);
+
+    KeAcquireSpinLock(&this->_AudioRingLock, &irql);
+
+    if (this->_AudioRing.Ring != nullptr)
+    {
+        attached = TRUE;
+
+        //
+        // A full ring drops the whole URB so the stream stays frame aligned
+        //
+        if (total > 0 && this->_AudioRing.Reserve(total))
+        {
+            ULONG staged = 0;
+
+            for (ULONG i = 0; i < IsoUrb->NumberOfPackets; i++)
+            {
+                const ULONG packetLength = IsoOutPacketLength(IsoUrb, i);
+
+                this->_AudioRing.Stage(
+                    staged,
+                    static_cast<PUCHAR>(IsoUrb->TransferBuffer) + IsoUrb->IsoPacket[i].Offset,
+                    packetLength
+                );
+                staged += packetLength;
+            }
+
+            this->_AudioRing.Commit(staged);
+        }
 
-        // Complete pending request
-        WdfRequestComplete(usbRequest, status);
+        if (this->_AudioRing.ShouldWake()
+            && !NT_SUCCESS(WdfIoQueueRetrieveNextRequest(this->_AudioRingDoorbells, &doorbell)))
+        {
+            doorbell = nullptr;
+        }
     }
 
-    TraceVerbose(TRACE_DS5, "%!FUNC! Exit with status %!STATUS!", status);
+    KeReleaseSpinLock(&this->_AudioRingLock, irql);
+
+    if (doorbell != nullptr)
+        WdfRequestComplete(doorbell, STATUS_SUCCESS);
+
+    return attached;
 }
 
 //
-// Timer callback for delayed ISO OUT URB completion.
-// Fires every DS5_ISO_OUT_COMPLETION_PERIOD_MS and completes one
-// pending ISO OUT request, throttling USBAudio's submission rate
-// to match real USB isochronous transfer timing.
+// Claims a staging buffer for one ISO OUT URB with only its header set up.
+// Returns nullptr if every slot is busy and the pool is exhausted.
 //
-VOID ViGEm::Bus::Targets::EmulationTargetDS5::PendingIsoOutTimerFunc(
-    _In_ WDFTIMER Timer
+PDS5_AUDIO_DATA ViGEm::Bus::Targets::EmulationTargetDS5::ClaimAudioStaging(PLONG Slot)
+{
+    PDS5_AUDIO_DATA staging;
+
+    *Slot = this->_AudioStagingSlots.Claim();
+
+    if (*Slot >= 0)
+    {
+        staging = &this->_AudioStaging[*Slot];
+    }
+    else
+    {
+        staging = static_cast<PDS5_AUDIO_DATA>(ExAllocatePoolUninitialized(
+            NonPagedPoolNx,
+            sizeof(DS5_AUDIO_DATA),
+            'A5SD'
+        ));
+
+        if (staging == nullptr)
+            return nullptr;
+    }
+
+    staging->Size = sizeof(DS5_AUDIO_DATA);
+    staging->SerialNo = this->_SerialNo;
+    staging->AudioDataLength = 0;
+
+    return staging;
+}
+
+VOID ViGEm::Bus::Targets::EmulationTargetDS5::ReleaseAudioStaging(PDS5_AUDIO_DATA Staging, LONG Slot, ULONG Length)
+{
+    this->_AudioStagingSlots.Release(Slot, Length);
+
+    if (Slot < 0)
+        ExFreePoolWithTag(Staging, 'A5SD');
+}
+
+//
+// ISOCH OUT 的 Length 字段在提交时不被填充（始终为0），
+// 每个包的实际数据长度需要通过相邻包的 Offset 差值计算
+//
+ULONG ViGEm::Bus::Targets::EmulationTargetDS5::IsoOutPacketLength(const _URB_ISOCH_TRANSFER* IsoUrb, ULONG Index)
+{
+    if (Index < IsoUrb->NumberOfPackets - 1)
+        return IsoUrb->IsoPacket[Index + 1].Offset - IsoUrb->IsoPacket[Index].Offset;
+
+    return IsoUrb->TransferBufferLength - IsoUrb->IsoPacket[Index].Offset;
+}
+
+NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::CreateNotificationChannels(WDFDEVICE ParentDevice)
+{
+    NTSTATUS status;
+
+    if (!NT_SUCCESS(status = this->_OutputAwaits.Create(ParentDevice)))
+    {
+        TraceError(
+            TRACE_DS5,
+            "WdfIoQueueCreate (OutputAwaits) failed with status %!STATUS!",
+            status);
+        return status;
+    }
+
+    if (!NT_SUCCESS(status = this->_AudioAwaits.Create(ParentDevice)))
+    {
+        TraceError(
+            TRACE_DS5,
+            "WdfIoQueueCreate (AudioAwaits) failed with status %!STATUS!",
+            status);
+        return status;
+    }
+
+    WDF_IO_QUEUE_CONFIG queueConfig;
+
+    WDF_IO_QUEUE_CONFIG_INIT(&queueConfig, WdfIoQueueDispatchManual);
+
+    if (!NT_SUCCESS(status = WdfIoQueueCreate(
+        ParentDevice,
+        &queueConfig,
+        WDF_NO_OBJECT_ATTRIBUTES,
+        &this->_AudioRingDoorbells
+    )))
+    {
+        TraceError(
+            TRACE_DS5,
+            "WdfIoQueueCreate (AudioRingDoorbells) failed with status %!STATUS!",
+            status);
+    }
+
+    return status;
+}
+
+NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::EnqueueOutputAwait(WDFREQUEST Request, PVOID OutputBuffer, size_t* BytesReturned)
+{
+    if (!this->IsOwnerProcess())
+        return STATUS_ACCESS_DENIED;
+
+    return this->_OutputAwaits.Enqueue(Request, OutputBuffer, BytesReturned);
+}
+
+NTSTATUS ViGEm::Bus::Targets::EmulationTargetDS5::EnqueueAudioAwait(WDFREQUEST Request, PVOID OutputBuffer, size_t* BytesReturned)
+{
+    if (!this->IsOwnerProcess())
+        return STATUS_ACCESS_DENIED;
+
+    return this->_AudioAwaits.Enqueue(Request, OutputBuffer, BytesReturned);
+}
+
+//
+// Called after an interrupt IN URB has been completed with the cached report.
+// Records the latency of the first delivery of each submitted report and
+// periodically dumps the histogram via WPP.
+//
+VOID ViGEm::Bus::Targets::EmulationTargetDS5::RecordReportDelivered()
+{
+    const LONGLONG now = KeQueryPerformanceCounter(nullptr).QuadPart;
+    const LONGLONG freq = this->_LatencyFrequency.QuadPart;
+    ViGEm::Stats::LatencySummary latency;
+    ULONGLONG overwritten;
+    ULONGLONG avoided;
+    ULONG interval;
+    ULONG polls;
+    ULONG useful;
+    ULONG missed;
+    ULONGLONG meanJitter;
+    LONGLONG maxJitter;
+
+    if (freq == 0)
+        return;
+
+    WdfSpinLockAcquire(this->_LatencyLock);
+
+    if (this->_ReportCachedAt != 0)
+    {
+        // QPC ticks to nanoseconds
+        const auto elapsed = static_cast<ULONGLONG>(now - this->_ReportCachedAt);
+        this->_InputLatency.Record(elapsed * 1000000000ULL / static_cast<ULONGLONG>(freq));
+        this->_ReportCachedAt = 0;
+    }
+
+    if (now - this->_LatencyWindowStart < DS5_LATENCY_DUMP_PERIOD_S * freq)
+    {
+        WdfSpinLockRelease(this->_LatencyLock);
+        return;
+    }
+
+    //
+    // Copy the window out and trace after releasing the lock, the submit
+    // and polling paths wait on it
+    //
+    latency = this->_InputLatency.Summarize();
+    overwritten = this->_ReportsOverwritten;
+    avoided = this->_UrbCompletionsAvoided;
+
+    interval = this->_PollPump.IntervalMs;
+    polls = this->_PollPump.Polls;
+    useful = this->_PollPump.Useful;
+    missed = this->_PollPump.Missed;
+    meanJitter = this->_PollPump.MeanJitter();
+    maxJitter = this->_PollPump.MaxJitter;
+
+    this->_PollPump.ResetStatistics();
+    this->_InputLatency.Reset();
+    this->_ReportsOverwritten = 0;
+    this->_UrbCompletionsAvoided = 0;
+    this->_LatencyWindowStart = now;
+
+    WdfSpinLockRelease(this->_LatencyLock);
+
+    TraceInformation(
+        TRACE_DS5,
+        "Serial %u input latency (ns): count=%llu p50=%llu p99=%llu p999=%llu max=%llu overwritten=%llu avoided=%llu",
+        this->_SerialNo,
+        latency.Count,
+        latency.P50,
+        latency.P99,
+        latency.P999,
+        latency.Max,
+        overwritten,
+        avoided
+    );
+
+    const auto output = this->_OutputAwaits.TakeStatistics();
+    const auto audio = this->_AudioAwaits.TakeStatistics();
+
+    TraceInformation(
+        TRACE_DS5,
+        "Serial %u output reports: routed=%llu buffered=%llu dropped=%llu",
+        this->_SerialNo,
+        output.Routed,
+        output.Buffered,
+        output.Dropped
+    );
+
+    TraceInformation(
+        TRACE_DS5,
+        "Serial %u audio: routed=%llu buffered=%llu dropped=%llu bytes=%llu staging peak=%d slots/%d bytes overflows=%d",
+        this->_SerialNo,
+        audio.Routed,
+        audio.Buffered,
+        audio.Dropped,
+        audio.BytesCopied,
+        this->_AudioStagingSlots.PeakBusy(),
+        this->_AudioStagingSlots.PeakBytes(),
+        this->_AudioStagingSlots.Overflows()
+    );
+
+    KIRQL irql;
+    KeAcquireSpinLock(&this->_IsoOutLock, &irql);
+
+    const ViGEm::Audio::IsoOutPacer pacer = this->_IsoOutPacer;
+    this->_IsoOutPacer.ResetStatistics();
+
+    KeReleaseSpinLock(&this->_IsoOutLock, irql);
+
+    TraceInformation(
+        TRACE_DS5,
+        "Serial %u ISO OUT pacing: passes=%lu useful=%lu drift=%lld frames late=%lu resyncs=%lu max lateness=%llu us",
+        this->_SerialNo,
+        pacer.Passes,
+        pacer.UsefulPasses,
+        pacer.DriftFrames(static_cast<LONGLONG>(CurrentMicroframe())),
+        pacer.LateCompletions,
+        pacer.Resyncs,
+        static_cast<ULONGLONG>(pacer.MaxLateness) * 125ULL
+    );
+
+    TraceInformation(
+        TRACE_DS5,
+        "Serial %u polling: interval=%u ms polls=%lu useful=%lu missed=%lu jitter mean=%llu us max=%llu us",
+        this->_SerialNo,
+        interval,
+        polls,
+        useful,
+        missed,
+        meanJitter * 1000000ULL / static_cast<ULONGLONG>(freq),
+        static_cast<ULONGLONG>(maxJitter) * 1000000ULL / static_cast<ULONGLONG>(freq)
+    );
+}
+
+VOID ViGEm::Bus::Targets::EmulationTargetDS5::ReverseByteArray(PUCHAR Array, INT Length)
+{
+    const auto s = static_cast<PUCHAR>(ExAllocatePoolZero(
+        NonPagedPoolNx,
+        sizeof(UCHAR) * Length,
+        'U4SD'
+    ));
+    INT c, d;
+
+    if (s == nullptr)
+        return;
+
+    for (c = Length - 1, d = 0; c >= 0; c--, d++)
+        *(s + d) = *(Array + c);
+
+    for (c = 0; c < Length; c++)
+        *(Array + c) = *(s + c);
+
+    ExFreePoolWithTag(s, 'U4SD');
+}
+
+VOID ViGEm::Bus::Targets::EmulationTargetDS5::GenerateRandomMacAddress(PMAC_ADDRESS Address)
+{
+    // Vendor "C0:13:37"
+    Address->Vendor0 = 0xC0;
+    Address->Vendor1 = 0x13;
+    Address->Vendor2 = 0x37;
+
+    ULONG seed = KeQueryPerformanceCounter(NULL).LowPart;
+
+    Address->Nic0 = RtlRandomEx(&seed) % 0xFF;
+    Address->Nic1 = RtlRandomEx(&seed) % 0xFF;
+    Address->Nic2 = RtlRandomEx(&seed) % 0xFF;
+}
+
+void ViGEm::Bus::Targets::EmulationTargetDS5::ProcessPendingNotification(WDFQUEUE Queue)
+{
+    NTSTATUS status;
+    WDFREQUEST request;
+    PVOID clientBuffer, contextBuffer;
+    PDS5_REQUEST_NOTIFICATION notify = nullptr;
+
+    FuncEntry(TRACE_DS5);
+
+    //
+    // Loop through and drain all queued requests until buffer is empty
+    // 
+    while (NT_SUCCESS(WdfIoQueueRetrieveNextRequest(Queue, &request)))
+    {
+        status = DMF_BufferQueue_Dequeue(
+            this->_UsbInterruptOutBufferQueue,
+            &clientBuffer,
+            &contextBuffer
+        );
+
+        //
+        // Shouldn't happen, but if so, error out
+        // 
+        if (!NT_SUCCESS(status))
+        {
+            //
+            // Don't requeue request as we may be out of order now
+            // 
+            WdfRequestComplete(request, status);
+            continue;
+        }
+
+        if (NT_SUCCESS(WdfRequestRetrieveOutputBuffer(
+            request,
+            sizeof(DS5_REQUEST_NOTIFICATION),
+            reinterpret_cast<PVOID*>(&notify),
+            nullptr
+        )))
+        {
+            // 
+            // Assign values to output buffer
+            // 
+            notify->Size = sizeof(DS5_REQUEST_NOTIFICATION);
+            notify->SerialNo = this->_SerialNo;
+            notify->Report = *static_cast<PDS5_OUTPUT_REPORT>(clientBuffer);
+
+            DumpAsHex("!! XUSB_REQUEST_NOTIFICATION",
+                      notify,
+                      sizeof(DS5_REQUEST_NOTIFICATION)
+            );
+
+            WdfRequestCompleteWithInformation(request, status, notify->Size);
+        }
+
+        DMF_BufferQueue_Reuse(this->_UsbInterruptOutBufferQueue, clientBuffer);
+
+        //
+        // If no more buffer to process, exit loop and await next callback
+        // 
+        if (DMF_BufferQueue_Count(this->_UsbInterruptOutBufferQueue) == 0)
+        {
+            break;
+        }
+    }
+
+    TraceVerbose(TRACE_USBPDO, "%!FUNC! Exit");
+}
+
+//
+// Bus scheduler entry point, see Core::BusScheduler
+//
+ULONGLONG ViGEm::Bus::Targets::EmulationTargetDS5::ServiceScheduledWork(
+    Core::ScheduledWork Work,
+    ULONGLONG Deadline,
+    ULONGLONG Now
 )
 {
-    const auto ctx = reinterpret_cast<EmulationTargetDS5*>(Core::EmulationTargetPdoGetContext(
-        WdfTimerGetParentObject(Timer))->Target);
+    switch (Work)
+    {
+    case Core::ScheduledWork::InterruptIn:
+        return ServicePolling(Deadline, Now);
+    case Core::ScheduledWork::IsoOut:
+        return ServiceIsoOut(Now);
+    default:
+        return 0;
+    }
+}
 
-    WDFREQUEST isoRequest;
+VOID ViGEm::Bus::Targets::EmulationTargetDS5::ScheduleWork(Core::ScheduledWork Work, ULONGLONG Deadline)
+{
+    if (this->_Scheduler != nullptr)
+        this->_Scheduler->Schedule(this->_SchedulerSlot, Work, Deadline);
+}
 
-    const auto status = WdfIoQueueRetrieveNextRequest(
-        ctx->_PendingIsoOutRequests, &isoRequest);
+VOID ViGEm::Bus::Targets::EmulationTargetDS5::SetScheduler(Core::BusScheduler* Scheduler)
+{
+    this->_Scheduler = Scheduler;
+}
 
-    if (NT_SUCCESS(status))
+//
+// Interrupt IN polling, once per polling interval while URBs are pending.
+// Resends the cached report unless the host has already been handed one
+// this interval.
+//
+ULONGLONG ViGEm::Bus::Targets::EmulationTargetDS5::ServicePolling(ULONGLONG Deadline, ULONGLONG Now)
+{
+    const LONGLONG now = KeQueryPerformanceCounter(nullptr).QuadPart;
+    const ULONGLONG period = this->_PollPump.IntervalMs * ViGEm::Timing::MicroframesPerFrame;
+    BOOLEAN delivered = FALSE;
+    ULONG pending = 0;
+
+    FuncEntry(TRACE_DS5);
+
+    PullInputSlot();
+
+    const ULONG sinceDelivery = static_cast<ULONG>(Now / ViGEm::Timing::MicroframesPerFrame)
+        - static_cast<ULONG>(ReadNoFence(&this->_LastDeliveryFrame));
+
+    // Resend cached report on one pending USB request
+    if (this->_PollPump.ShouldResend(sinceDelivery, ReadAcquire(&this->_ReportUndelivered) != FALSE))
+        delivered = DeliverReport();
+
+    WdfIoQueueGetState(this->_PendingUsbInRequests, &pending, nullptr);
+
+    WdfSpinLockAcquire(this->_LatencyLock);
+
+    this->_PollPump.Poll(now, delivered != FALSE);
+
+    if (pending == 0)
+        this->_PollPump.Pause();
+
+    WdfSpinLockRelease(this->_LatencyLock);
+
+    TraceVerbose(TRACE_DS5, "%!FUNC! Exit (delivered=%d, pending=%u)", delivered, pending);
+
+    //
+    // Nothing left to poll, the next queued URB schedules polling again
+    //
+    if (pending == 0)
+        return 0;
+
+    //
+    // Stay on the original grid, a late tick doesn't push later polls back
+    //
+    return ViGEm::Timing::NextPeriodicDeadline(Deadline, period, Now);
+}
+
+//
+// Completes every pending ISO OUT request whose due time has passed,
+// throttling USBAudio's submission rate to match real USB isochronous
+// timing. Scheduled again at the due time of the new head request.
+//
+ULONGLONG ViGEm::Bus::Targets::EmulationTargetDS5::ServiceIsoOut(ULONGLONG Now)
+{
+    const LONGLONG now = static_cast<LONGLONG>(Now);
+    WDFREQUEST found;
+    WDFREQUEST isoRequest;
+    ULONG completed = 0;
+    ULONGLONG next = 0;
+    KIRQL irql;
+
+    for (;;)
     {
-        WdfRequestComplete(isoRequest, STATUS_SUCCESS);
+        isoRequest = nullptr;
+
+        KeAcquireSpinLock(&this->_IsoOutLock, &irql);
+
+        //
+        // Peek at the head, due times are in queue order
+        //
+        if (!NT_SUCCESS(WdfIoQueueFindRequest(this->_PendingIsoOutRequests, nullptr, nullptr, nullptr, &found)))
+        {
+            //
+            // Drained, the next queued URB schedules pacing again
+            //
+            this->_IsoOutPacer.RecordPass(completed != 0);
+
+            KeReleaseSpinLock(&this->_IsoOutLock, irql);
+            break;
+        }
+
+        const auto context = Ds5IsoOutRequestGetContext(found);
+        const BOOLEAN due = context->DueTime <= now;
+
+        //
+        // A request cancelled since the peek is simply skipped
+        //
+        if (due && NT_SUCCESS(WdfIoQueueRetrieveFoundRequest(this->_PendingIsoOutRequests, found, &isoRequest)))
+        {
+            this->_IsoOutPacer.Complete(now, context->DueTime, context->Packets);
+        }
+
+        if (!due)
+        {
+            next = static_cast<ULONGLONG>(context->DueTime);
+            this->_IsoOutPacer.RecordPass(completed != 0);
+        }
+
+        WdfObjectDereference(found);
+
+        KeReleaseSpinLock(&this->_IsoOutLock, irql);
+
+        if (!due)
+            break;
+
+        if (isoRequest != nullptr)
+        {
+            WdfRequestComplete(isoRequest, STATUS_SUCCESS);
+            completed++;
+        }
     }
+
+    return next;
 }
 
 VOID ViGEm::Bus::Targets::EmulationTargetDS5::DmfDeviceModulesAdd(_In_ PDMFMODULE_INIT DmfModuleInit)
@@ -2147,33 +3062,24 @@ NTSTATUS USB_BUSIFFN ViGEm::Bus::Targets::EmulationTargetDS5::UsbInterfaceSubmit
 
     auto isoUrb = &Urb->UrbIsochronousTransfer;
         
+    // 挂了共享音频环时直接写进环里，不再经过下面的缓存和 await 请求
+    const BOOLEAN ringWritten = pdo->WriteAudioRing(isoUrb);
+
     // 处理所有 ISO 数据包
-    // 首先将整个 URB 的音频数据收集到缓存中，然后一次性广播给用户态
+    // 首先将整个 URB 的音频数据收集到暂存区中，然后一次性广播给用户态
     ULONG totalAudioLength = 0;
-    DS5_AUDIO_DATA audioCache = {};
-    audioCache.Size = sizeof(DS5_AUDIO_DATA);
-    audioCache.SerialNo = pdo->_SerialNo;
+    LONG stagingSlot = -1;
+    const PDS5_AUDIO_DATA audioCache = ringWritten ? nullptr : pdo->ClaimAudioStaging(&stagingSlot);
 
     for (ULONG i = 0; i < isoUrb->NumberOfPackets; i++)
     {
         PUSBD_ISO_PACKET_DESCRIPTOR packet = &isoUrb->IsoPacket[i];
+        const ULONG packetLength = IsoOutPacketLength(isoUrb, i);
         
-        // ISOCH OUT 的 Length 字段在提交时不被填充（始终为0），
-        // 每个包的实际数据长度需要通过相邻包的 Offset 差值计算
-        ULONG packetLength;
-        if (i < isoUrb->NumberOfPackets - 1)
-        {
-            packetLength = isoUrb->IsoPacket[i + 1].Offset - packet->Offset;
-        }
-        else
-        {
-            packetLength = isoUrb->TransferBufferLength - packet->Offset;
-        }
-        
-        if (packetLength > 0 && (totalAudioLength + packetLength) <= DS5_AUDIO_DATA_MAX_SIZE)
+        if (audioCache != nullptr && packetLength > 0 && (totalAudioLength + packetLength) <= DS5_AUDIO_DATA_MAX_SIZE)
         {
             PUCHAR audioData = (PUCHAR)isoUrb->TransferBuffer + packet->Offset;
-            RtlCopyMemory(&audioCache.AudioData[totalAudioLength], audioData, packetLength);
+            RtlCopyMemory(&audioCache->AudioData[totalAudioLength], audioData, packetLength);
             totalAudioLength += packetLength;
         }
             
@@ -2184,17 +3090,21 @@ NTSTATUS USB_BUSIFFN ViGEm::Bus::Targets::EmulationTargetDS5::UsbInterfaceSubmit
         packet->Status = USBD_STATUS_SUCCESS;
     }
 
-    // 如果有音频数据，广播给用户态应用
+    // 如果有音频数据，交给等待本手柄的请求，并广播给未指定序号的用户态应用
     if (totalAudioLength > 0 && pdo->_AudioNotify != nullptr)
     {
-        audioCache.AudioDataLength = totalAudioLength;
+        audioCache->AudioDataLength = totalAudioLength;
+
+        const ULONG notifyLength = FIELD_OFFSET(DS5_AUDIO_DATA, AudioData) + totalAudioLength;
 
         TraceVerbose(TRACE_DS5, "Broadcasting audio data: %u bytes", totalAudioLength);
 
+        pdo->_AudioAwaits.Deliver(audioCache, notifyLength);
+
         NTSTATUS broadcastStatus = DMF_NotifyUserWithRequestMultiple_DataBroadcast(
             pdo->_AudioNotify,
-            &audioCache,
-            sizeof(DS5_AUDIO_DATA),
+            audioCache,
+            notifyLength,
             STATUS_SUCCESS
         );
 
@@ -2206,6 +3116,11 @@ NTSTATUS USB_BUSIFFN ViGEm::Bus::Targets::EmulationTargetDS5::UsbInterfaceSubmit
         }
     }
 
+    if (audioCache != nullptr)
+    {
+        pdo->ReleaseAudioStaging(audioCache, stagingSlot, totalAudioLength);
+    }
+
     // 设置 URB 完成状态
     Urb->UrbHeader.Status = USBD_STATUS_SUCCESS;
     isoUrb->ErrorCount = 0;
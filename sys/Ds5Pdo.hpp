@@ -37,6 +37,15 @@
 
 #include "EmulationTargetPDO.hpp"
 #include <ViGEm/km/BusShared.h>
+#include <LatencyHistogram.h>
+#include "NotificationChannel.hpp"
+#include <Ds5ReportFilter.h>
+#include <ReportCache.h>
+#include <InputSlot.h>
+#include <AudioRing.h>
+#include <StagingSlots.h>
+#include <IsoPacer.h>
+#include <PollPump.h>
 
 
 namespace ViGEm::Bus::Targets
@@ -69,12 +78,16 @@ namespace ViGEm::Bus::Targets
 	public:
 		EmulationTargetDS5(ULONG Serial, LONG SessionId, USHORT VendorId = 0x054C, USHORT ProductId = 0x05C4);
 
+		~EmulationTargetDS5() override;
+
 		NTSTATUS PdoPrepareDevice(PWDFDEVICE_INIT DeviceInit,
 			PUNICODE_STRING DeviceId,
 			PUNICODE_STRING DeviceDescription) override;
 
 		NTSTATUS PdoPrepareHardware() override;
 
+		VOID PdoReleaseHardware() override;
+
 		NTSTATUS PdoInitContext() override;
 
 		VOID GetConfigurationDescriptorType(PUCHAR Buffer, ULONG Length) override;
@@ -105,16 +118,62 @@ namespace ViGEm::Bus::Targets
 
 		VOID SetAudioNotifyModule(DMFMODULE Module);
 
+		NTSTATUS AttachInputSlot(WDFREQUEST Request);
+
+		NTSTATUS CreateNotificationChannels(WDFDEVICE ParentDevice);
+
+		NTSTATUS EnqueueOutputAwait(WDFREQUEST Request, PVOID OutputBuffer, size_t* BytesReturned);
+
+		NTSTATUS EnqueueAudioAwait(WDFREQUEST Request, PVOID OutputBuffer, size_t* BytesReturned);
+
+		NTSTATUS AttachAudioRing(WDFREQUEST Request);
+
+		NTSTATUS RingAudioDoorbell(WDFREQUEST Request);
+
+		VOID SetScheduler(Core::BusScheduler* Scheduler);
+
+		ULONGLONG ServiceScheduledWork(Core::ScheduledWork Work, ULONGLONG Deadline, ULONGLONG Now) override;
+
 		static NTSTATUS USB_BUSIFFN UsbInterfaceSubmitIsoOutUrb(IN PVOID BusContext, IN PURB Urb);
 
 	private:
-		static EVT_WDF_TIMER PendingUsbRequestsTimerFunc;
-		static EVT_WDF_TIMER PendingIsoOutTimerFunc;
+		static EVT_WDF_REQUEST_CANCEL EvtInputSlotCanceled;
+		static EVT_WDF_REQUEST_CANCEL EvtAudioRingCanceled;
 
 		static VOID ReverseByteArray(PUCHAR Array, INT Length);
 
+		static ULONG IsoOutPacketLength(const _URB_ISOCH_TRANSFER* IsoUrb, ULONG Index);
+
 		static VOID GenerateRandomMacAddress(PMAC_ADDRESS Address);
 
+		VOID RecordReportDelivered();
+
+		BOOLEAN WriteReport(const UCHAR* Payload);
+
+		BOOLEAN DeliverReport();
+
+		VOID ScheduleWork(Core::ScheduledWork Work, ULONGLONG Deadline);
+
+		ULONGLONG ServicePolling(ULONGLONG Deadline, ULONGLONG Now);
+
+		ULONGLONG ServiceIsoOut(ULONGLONG Now);
+
+		BOOLEAN PostReport(BOOLEAN Changed, LONGLONG ArrivedAt);
+
+		BOOLEAN PullInputSlot();
+
+		VOID DetachInputSlot();
+
+		BOOLEAN WriteAudioRing(const _URB_ISOCH_TRANSFER* IsoUrb);
+
+		VOID DetachAudioRing();
+
+		VOID FlushAudioDoorbells();
+
+		PDS5_AUDIO_DATA ClaimAudioStaging(PLONG Slot);
+
+		VOID ReleaseAudioStaging(PDS5_AUDIO_DATA Staging, LONG Slot, ULONG Length);
+
 	protected:
 		void ProcessPendingNotification(WDFQUEUE Queue) override;
 
@@ -151,19 +210,34 @@ namespace ViGEm::Bus::Targets
 		static const int DS5_OUTPUT_BUFFER_LENGTH = 0x05;
 
 		static const int DS5_REPORT_SIZE = 0x40;
+		static const int DS5_OUTPUT_BACKLOG = 8;
+		static const int DS5_AUDIO_BACKLOG = 4;
+		static const int DS5_AUDIO_STAGING_SLOTS = 2;
+
+		//
+		// Default interrupt IN polling interval in milliseconds, overridden
+		// per target by the PollingIntervalMs registry value
+		//
 		static const int DS5_QUEUE_FLUSH_PERIOD = 0x06;
 
 		//
-		// ISO OUT completion delay period in milliseconds.
-		// Real USB hardware takes ~10-20ms to complete an isochronous OUT URB.
-		// This throttles USBAudio's submission rate to match real-time audio flow.
+		// Interval in seconds between input latency histogram dumps
 		//
-		static const int DS5_ISO_OUT_COMPLETION_PERIOD_MS = 10;
+		static const int DS5_LATENCY_DUMP_PERIOD_S = 5;
 
 		//
-		// HID Input Report buffer
+		// HID Input Report buffer, doubles as a latest-wins mailbox.
+		// _ReportUndelivered is set while a changed report hasn't reached
+		// a URB yet.
 		//
-		UCHAR _Report[DS5_REPORT_SIZE];
+		ViGEm::Reports::ReportCache<UCHAR[DS5_REPORT_SIZE]> _Report;
+		volatile LONG _ReportUndelivered = FALSE;
+
+		//
+		// Bus frame (see EmulationTargetPDO::CurrentFrame) of the last
+		// interrupt IN completion, paces the keep-alive resend
+		//
+		volatile LONG _LastDeliveryFrame = 0;
 
 		//
 		// Output report cache
@@ -171,17 +245,28 @@ namespace ViGEm::Bus::Targets
 		DS5_OUTPUT_REPORT _OutputReport;
 
 		//
-		// Timer for dispatching interrupt transfer
+		// Bus scheduler running interrupt IN polling and ISO OUT pacing,
+		// the slot is held from prepare to release hardware
+		//
+		Core::BusScheduler* _Scheduler{};
+		ULONG _SchedulerSlot{ Core::BusScheduler::InvalidSlot };
+
+		//
+		// Interrupt IN polling schedule and jitter, guarded by _LatencyLock
 		//
-		WDFTIMER _PendingUsbInRequestsTimer;
+		ViGEm::Reports::PollPump _PollPump{};
 
 		//
-		// Queue and timer for delayed ISO OUT URB completion.
+		// Queue for delayed ISO OUT URB completion.
 		// Simulates real USB isochronous transfer timing to prevent
 		// USBAudio from draining the audio buffer faster than real-time.
+		// Each URB is completed once its packets would have been consumed
+		// by real hardware, one per frame, so USBAudio's submission rate
+		// matches real-time audio flow whatever its URB size.
 		//
 		WDFQUEUE _PendingIsoOutRequests{};
-		WDFTIMER _PendingIsoOutTimer{};
+		KSPIN_LOCK _IsoOutLock{};
+		ViGEm::Audio::IsoOutPacer _IsoOutPacer{};
 
 		//
 		// Auto-generated MAC address of the target device
@@ -209,9 +294,66 @@ namespace ViGEm::Bus::Targets
 		DS5_AWAIT_OUTPUT _AwaitOutputCache;
 
 		//
-		// Memory for audio data notification
+		// Awaits naming this target's serial, woken only by its own output
+		// reports and audio (serial 0 awaits keep using the bus-wide broadcast)
 		//
-		DS5_AUDIO_DATA _AudioCache;
+		Core::NotificationChannel<sizeof(DS5_AWAIT_OUTPUT), DS5_OUTPUT_BACKLOG> _OutputAwaits;
+		Core::NotificationChannel<sizeof(DS5_AUDIO_DATA), DS5_AUDIO_BACKLOG> _AudioAwaits;
+
+		//
+		// Staging for audio data notification. ISO OUT URBs may be submitted
+		// concurrently so each one claims a slot, falling back to the pool
+		// when all are busy. Only the header is initialised, consumers copy
+		// the header plus AudioDataLength bytes. Peaks are kept for the
+		// lifetime of the target.
+		//
+		DS5_AUDIO_DATA _AudioStaging[DS5_AUDIO_STAGING_SLOTS];
+		ViGEm::Audio::StagingSlots<DS5_AUDIO_STAGING_SLOTS> _AudioStagingSlots;
+
+		//
+		// Input latency tracing: time from a report arriving in SubmitReportImpl
+		// to the interrupt IN URB carrying it being completed (QPC timeline,
+		// same clock as user-mode QueryPerformanceCounter).
+		//
+		WDFSPINLOCK _LatencyLock{};
+		LARGE_INTEGER _LatencyFrequency{};
+		LONGLONG _ReportCachedAt = 0;
+		LONGLONG _LatencyWindowStart = 0;
+		ULONGLONG _ReportsOverwritten = 0;
+		ViGEm::Stats::LatencyHistogram _InputLatency;
+
+		//
+		// Change suppression: reports that differ from the cache only in
+		// volatile fields update the cache but don't complete a pending URB;
+		// the periodic timer delivers them. Significant fields are read from
+		// the InputSignificantFields value in the per-serial registry key.
+		//
+		ViGEm::Reports::Ds5ReportFilter _InputFilter;
+		ULONGLONG _UrbCompletionsAvoided = 0;
+
+		//
+		// Feeder's shared input slot, mapped from the pending attach request.
+		// Polled before an interrupt IN URB is completed. The lock and event
+		// are plain kernel objects because the destructor must be able to
+		// wait for a concurrent cancel after the WDF children are gone.
+		//
+		KSPIN_LOCK _InputSlotLock{};
+		KEVENT _InputSlotDetached{};
+		WDFREQUEST _InputSlotRequest{};
+		const ViGEm::Reports::INPUT_SLOT* _InputSlot = nullptr;
+		long _InputSlotSequence = 0;
+
+		//
+		// Consumer's shared audio ring, mapped from the pending attach
+		// request and written by the ISO OUT handler instead of the await
+		// path. Doorbell requests wait in an FDO-parented queue until the
+		// ring holds data.
+		//
+		KSPIN_LOCK _AudioRingLock{};
+		KEVENT _AudioRingDetached{};
+		WDFREQUEST _AudioRingRequest{};
+		ViGEm::Audio::AudioRingProducer _AudioRing{};
+		WDFQUEUE _AudioRingDoorbells{};
 
 		// Cached audio feature values
 		UCHAR _AudioMute0200[1]{0x00};
@@ -219,4 +361,25 @@ namespace ViGEm::Bus::Targets
 		UCHAR _Volume0200[2]{0x00, 0x00};
 		UCHAR _Volume0500[2]{0xe1, 0x0e};
 	};
+
+	//
+	// Attached to the pending input slot and audio ring requests
+	//
+	typedef struct _DS5_SHARED_MEMORY_REQUEST_CONTEXT
+	{
+		EmulationTargetDS5* Target;
+	} DS5_SHARED_MEMORY_REQUEST_CONTEXT, * PDS5_SHARED_MEMORY_REQUEST_CONTEXT;
+
+	WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(DS5_SHARED_MEMORY_REQUEST_CONTEXT, Ds5SharedMemoryRequestGetContext)
+
+	//
+	// Attached to queued ISO OUT requests
+	//
+	typedef struct _DS5_ISO_OUT_REQUEST_CONTEXT
+	{
+		LONGLONG DueTime;
+		ULONG Packets;
+	} DS5_ISO_OUT_REQUEST_CONTEXT, * PDS5_ISO_OUT_REQUEST_CONTEXT;
+
+	WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(DS5_ISO_OUT_REQUEST_CONTEXT, Ds5IsoOutRequestGetContext)
 }
@@ -45,6 +45,8 @@
 
 PCWSTR ViGEm::Bus::Core::EmulationTargetPDO::_deviceLocation = L"Virtual Gamepad Emulation Bus";
 
+ViGEm::Timing::FrameClock ViGEm::Bus::Core::EmulationTargetPDO::_FrameClock;
+
 NTSTATUS ViGEm::Bus::Core::EmulationTargetPDO::PdoCreateDevice(WDFDEVICE ParentDevice, PWDFDEVICE_INIT DeviceInit)
 {
 	NTSTATUS status = STATUS_UNSUCCESSFUL;
@@ -151,6 +153,7 @@ NTSTATUS ViGEm::Bus::Core::EmulationTargetPDO::PdoCreateDevice(WDFDEVICE ParentD
 		WDF_PNPPOWER_EVENT_CALLBACKS_INIT(&pnpPowerCallbacks);
 
 		pnpPowerCallbacks.EvtDevicePrepareHardware = EvtDevicePrepareHardware;
+		pnpPowerCallbacks.EvtDeviceReleaseHardware = EvtDeviceReleaseHardware;
 
 		WdfDeviceInitSetPnpPowerEventCallbacks(DeviceInit, &pnpPowerCallbacks);
 
@@ -659,19 +662,51 @@ NTSTATUS USB_BUSIFFN ViGEm::Bus::Core::EmulationTargetPDO::UsbInterfaceQueryBusT
 		//
 		// USB 2.0 frame number increments every 1ms.
 		// Derive from actual wall-clock time so USBAudio can
-		// synchronize isochronous transfers correctly.
+		// synchronize isochronous transfers correctly, on the
+		// same clock ISO OUT pacing and interrupt polling use.
 		//
-		LARGE_INTEGER perfFreq;
-		LARGE_INTEGER perfCount = KeQueryPerformanceCounter(&perfFreq);
-
-		*CurrentUsbFrame = static_cast<ULONG>(
-			(perfCount.QuadPart * 1000) / perfFreq.QuadPart
-		);
+		*CurrentUsbFrame = CurrentFrame();
 	}
 
 	return STATUS_SUCCESS;
 }
 
+ULONGLONG ViGEm::Bus::Core::EmulationTargetPDO::ServiceScheduledWork(ScheduledWork Work, ULONGLONG Deadline, ULONGLONG Now)
+{
+	UNREFERENCED_PARAMETER(Work);
+	UNREFERENCED_PARAMETER(Deadline);
+	UNREFERENCED_PARAMETER(Now);
+
+	return 0;
+}
+
+VOID ViGEm::Bus::Core::EmulationTargetPDO::InitializeFrameClock()
+{
+	LARGE_INTEGER perfFreq;
+
+	KeQueryPerformanceCounter(&perfFreq);
+
+	//
+	// Origin 0 keeps frame numbers counting from boot, as before
+	// 
+	_FrameClock.Init(perfFreq.QuadPart);
+}
+
+static LONGLONG QueryPerformanceTicks()
+{
+	return KeQueryPerformanceCounter(nullptr).QuadPart;
+}
+
+ULONGLONG ViGEm::Bus::Core::EmulationTargetPDO::CurrentMicroframe()
+{
+	return _FrameClock.CurrentMicroframe(QueryPerformanceTicks);
+}
+
+ULONG ViGEm::Bus::Core::EmulationTargetPDO::CurrentFrame()
+{
+	return _FrameClock.CurrentFrame(QueryPerformanceTicks);
+}
+
 VOID USB_BUSIFFN ViGEm::Bus::Core::EmulationTargetPDO::UsbInterfaceGetUSBDIVersion(IN PVOID BusContext,
 	IN OUT PUSBD_VERSION_INFORMATION
 	VersionInformation,
@@ -1002,6 +1037,28 @@ NTSTATUS ViGEm::Bus::Core::EmulationTargetPDO::EvtDevicePrepareHardware(
 	return status;
 }
 
+NTSTATUS ViGEm::Bus::Core::EmulationTargetPDO::EvtDeviceReleaseHardware(
+	_In_ WDFDEVICE Device,
+	_In_ WDFCMRESLIST ResourcesTranslated
+)
+{
+	FuncEntry(TRACE_BUSPDO);
+
+	UNREFERENCED_PARAMETER(ResourcesTranslated);
+
+	const auto ctx = EmulationTargetPdoGetContext(Device);
+
+	ctx->Target->PdoReleaseHardware();
+
+	FuncExitNoReturn(TRACE_BUSPDO);
+
+	return STATUS_SUCCESS;
+}
+
+VOID ViGEm::Bus::Core::EmulationTargetPDO::PdoReleaseHardware()
+{
+}
+
 VOID ViGEm::Bus::Core::EmulationTargetPDO::EvtIoInternalDeviceControl(
 	_In_ WDFQUEUE Queue,
 	_In_ WDFREQUEST Request,
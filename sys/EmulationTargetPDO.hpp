@@ -46,6 +46,8 @@
 #include <usbbusif.h>
 
 #include <ViGEm/Common.h>
+#include <FrameClock.h>
+#include "BusScheduler.hpp"
 
 //
 // Some insane macro-magic =3
@@ -85,6 +87,11 @@ namespace ViGEm::Bus::Core
 
 		virtual NTSTATUS PdoPrepareHardware() = 0;
 
+		//
+		// Undoes PdoPrepareHardware, PASSIVE_LEVEL
+		// 
+		virtual VOID PdoReleaseHardware();
+
 		virtual NTSTATUS PdoInitContext() = 0;
 
 		NTSTATUS PdoCreateDevice(_In_ WDFDEVICE ParentDevice,
@@ -128,6 +135,21 @@ namespace ViGEm::Bus::Core
 
 		NTSTATUS PdoPrepare(WDFDEVICE ParentDevice);
 
+		//
+		// Runs work the target queued on the bus scheduler. Returns the
+		// next deadline, or 0 to leave the work unscheduled.
+		// 
+		virtual ULONGLONG ServiceScheduledWork(ScheduledWork Work, ULONGLONG Deadline, ULONGLONG Now);
+
+		//
+		// Bus-wide virtual USB frame clock, initialised once by DriverEntry
+		// 
+		static VOID InitializeFrameClock();
+
+		static ULONGLONG CurrentMicroframe();
+
+		static ULONG CurrentFrame();
+
 	private:
 		static unsigned long current_process_id();
 
@@ -154,6 +176,8 @@ namespace ViGEm::Bus::Core
 
 		static PCWSTR _deviceLocation;
 
+		static ViGEm::Timing::FrameClock _FrameClock;
+
 		static BOOLEAN USB_BUSIFFN UsbInterfaceIsDeviceHighSpeed(IN PVOID BusContext);
 
 		static NTSTATUS USB_BUSIFFN UsbInterfaceQueryBusInformation(
@@ -176,6 +200,8 @@ namespace ViGEm::Bus::Core
 
 		static EVT_WDF_DEVICE_PREPARE_HARDWARE EvtDevicePrepareHardware;
 
+		static EVT_WDF_DEVICE_RELEASE_HARDWARE EvtDeviceReleaseHardware;
+
 		static EVT_WDF_IO_QUEUE_IO_INTERNAL_DEVICE_CONTROL EvtIoInternalDeviceControl;
 
 		static EVT_WDF_IO_QUEUE_STATE EvtWdfIoPendingNotificationQueueState;
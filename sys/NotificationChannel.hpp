@@ -0,0 +1,187 @@
+/*
+* Virtual Gamepad Emulation Framework - Windows kernel-mode bus driver
+*
+* BSD 3-Clause License
+*
+* Copyright (c) 2018-2020, Nefarius Software Solutions e.U. and Contributors
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its
+*    contributors may be used to endorse or promote products derived from
+*    this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+#include <ntddk.h>
+#include <wdf.h>
+#include <NotificationBacklog.h>
+
+namespace ViGEm::Bus::Core
+{
+	//
+	// Per-target user-mode notification channel. Await requests are parked
+	// in a manual queue and each notification completes the oldest one with
+	// only the bytes it carries. Notifications arriving while nobody waits
+	// go to the backlog (see NotificationBacklog.h).
+	//
+	// The queue's parent is the FDO (requests arrive on the bus' queue and
+	// can only be forwarded within the same device) so the owner has to
+	// call Destroy() explicitly.
+	//
+	template <size_t EntrySize, ULONG Capacity>
+	class NotificationChannel
+	{
+	public:
+		typedef Notifications::NotificationStatistics STATISTICS;
+
+		NotificationChannel()
+		{
+			KeInitializeSpinLock(&this->_Lock);
+		}
+
+		NTSTATUS Create(WDFDEVICE ParentDevice)
+		{
+			WDF_IO_QUEUE_CONFIG queueConfig;
+
+			WDF_IO_QUEUE_CONFIG_INIT(&queueConfig, WdfIoQueueDispatchManual);
+
+			return WdfIoQueueCreate(
+				ParentDevice,
+				&queueConfig,
+				WDF_NO_OBJECT_ATTRIBUTES,
+				&this->_PendingRequests
+			);
+		}
+
+		VOID Destroy()
+		{
+			if (this->_PendingRequests == nullptr)
+				return;
+
+			WdfIoQueuePurgeSynchronously(this->_PendingRequests);
+			WdfObjectDelete(this->_PendingRequests);
+			this->_PendingRequests = nullptr;
+		}
+
+		//
+		// Returns STATUS_SUCCESS with the output buffer filled from the
+		// backlog, or STATUS_PENDING once the request has been parked
+		//
+		NTSTATUS Enqueue(WDFREQUEST Request, PVOID OutputBuffer, size_t* BytesReturned)
+		{
+			NTSTATUS status;
+			ULONG length;
+			KIRQL irql;
+
+			KeAcquireSpinLock(&this->_Lock, &irql);
+
+			if (this->_Backlog.Take(OutputBuffer, &length))
+			{
+				*BytesReturned = length;
+				status = STATUS_SUCCESS;
+			}
+			else
+			{
+				//
+				// Forwarded under the lock so a notification arriving now
+				// can't slip into the backlog past this request
+				//
+				status = WdfRequestForwardToIoQueue(Request, this->_PendingRequests);
+
+				status = (NT_SUCCESS(status)) ? STATUS_PENDING : status;
+			}
+
+			KeReleaseSpinLock(&this->_Lock, irql);
+
+			return status;
+		}
+
+		VOID Deliver(const VOID* Data, ULONG Length)
+		{
+			NTSTATUS status;
+			WDFREQUEST request;
+			PVOID buffer = nullptr;
+			KIRQL irql;
+
+			NT_ASSERT(Length <= EntrySize);
+
+			KeAcquireSpinLock(&this->_Lock, &irql);
+
+			if (NT_SUCCESS(WdfIoQueueRetrieveNextRequest(this->_PendingRequests, &request)))
+			{
+				this->_Backlog.CountRouted(Length);
+			}
+			else
+			{
+				request = nullptr;
+
+				this->_Backlog.Store(Data, Length);
+			}
+
+			KeReleaseSpinLock(&this->_Lock, irql);
+
+			if (request == nullptr)
+				return;
+
+			if (NT_SUCCESS(status = WdfRequestRetrieveOutputBuffer(
+				request,
+				Length,
+				&buffer,
+				nullptr
+			)))
+			{
+				RtlCopyMemory(buffer, Data, Length);
+
+				WdfRequestCompleteWithInformation(request, STATUS_SUCCESS, Length);
+			}
+			else
+			{
+				WdfRequestComplete(request, status);
+			}
+		}
+
+		//
+		// Returns the counters accumulated since the previous call
+		//
+		STATISTICS TakeStatistics()
+		{
+			KIRQL irql;
+
+			KeAcquireSpinLock(&this->_Lock, &irql);
+
+			const STATISTICS statistics = this->_Backlog.TakeStatistics();
+
+			KeReleaseSpinLock(&this->_Lock, irql);
+
+			return statistics;
+		}
+
+	private:
+		WDFQUEUE _PendingRequests{};
+		KSPIN_LOCK _Lock{};
+		Notifications::NotificationBacklog<EntrySize, Capacity> _Backlog;
+	};
+}
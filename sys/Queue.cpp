@@ -499,18 +499,33 @@ Bus_Ds5AwaitOutputHandler(
 	_Out_ size_t* BytesReturned
 )
 {
-	UNREFERENCED_PARAMETER(Queue);
 	UNREFERENCED_PARAMETER(IoctlCode);
 	UNREFERENCED_PARAMETER(OutputBufferSize);
 	UNREFERENCED_PARAMETER(InputBufferSize);
-	UNREFERENCED_PARAMETER(InputBuffer);
-	UNREFERENCED_PARAMETER(OutputBuffer);
-	UNREFERENCED_PARAMETER(BytesReturned);
 
 	FuncEntry(TRACE_QUEUE);
 
 	NTSTATUS status;
+	EmulationTargetPDO* pdo;
+	PDS5_AWAIT_OUTPUT pAwait = (PDS5_AWAIT_OUTPUT)InputBuffer;
 	PFDO_DEVICE_DATA pDevCtx = FdoGetData(DMF_ParentDeviceGet(DmfModule));
+
+	//
+	// A request naming a target is only woken by that target's output
+	// reports, serial 0 keeps receiving the bus-wide broadcast
+	//
+	if (pAwait->SerialNo != 0)
+	{
+		if (!EmulationTargetPDO::GetPdoByTypeAndSerial(WdfIoQueueGetDevice(Queue), DualSense5Wired, pAwait->SerialNo, &pdo))
+		{
+			status = STATUS_DEVICE_DOES_NOT_EXIST;
+			goto exit;
+		}
+
+		status = static_cast<EmulationTargetDS5*>(pdo)->EnqueueOutputAwait(Request, OutputBuffer, BytesReturned);
+
+		goto exit;
+	}
 	
 	if (!NT_SUCCESS(status = DMF_NotifyUserWithRequestMultiple_RequestProcess(
 		pDevCtx->UserNotification,
@@ -541,18 +556,33 @@ Bus_Ds5AwaitAudioHandler(
 	_Out_ size_t* BytesReturned
 )
 {
-	UNREFERENCED_PARAMETER(Queue);
 	UNREFERENCED_PARAMETER(IoctlCode);
 	UNREFERENCED_PARAMETER(OutputBufferSize);
 	UNREFERENCED_PARAMETER(InputBufferSize);
-	UNREFERENCED_PARAMETER(InputBuffer);
-	UNREFERENCED_PARAMETER(OutputBuffer);
-	UNREFERENCED_PARAMETER(BytesReturned);
 
 	FuncEntry(TRACE_QUEUE);
 
 	NTSTATUS status;
+	EmulationTargetPDO* pdo;
+	PDS5_AUDIO_DATA pAwait = (PDS5_AUDIO_DATA)InputBuffer;
 	PFDO_DEVICE_DATA pDevCtx = FdoGetData(DMF_ParentDeviceGet(DmfModule));
+
+	//
+	// Same routing as output reports, completions carry only the header
+	// and the captured bytes
+	//
+	if (pAwait->SerialNo != 0)
+	{
+		if (!EmulationTargetPDO::GetPdoByTypeAndSerial(WdfIoQueueGetDevice(Queue), DualSense5Wired, pAwait->SerialNo, &pdo))
+		{
+			status = STATUS_DEVICE_DOES_NOT_EXIST;
+			goto exit;
+		}
+
+		status = static_cast<EmulationTargetDS5*>(pdo)->EnqueueAudioAwait(Request, OutputBuffer, BytesReturned);
+
+		goto exit;
+	}
 	
 	if (!NT_SUCCESS(status = DMF_NotifyUserWithRequestMultiple_RequestProcess(
 		pDevCtx->AudioNotification,
@@ -570,4 +600,319 @@ exit:
 	return status;
 }
 
+//
+// Applies an array of input reports for any number of targets in one pass.
+//
+NTSTATUS
+Bus_SubmitBatchHandler(
+	_In_ DMFMODULE DmfModule,
+	_In_ WDFQUEUE Queue,
+	_In_ WDFREQUEST Request,
+	_In_ ULONG IoctlCode,
+	_In_reads_(InputBufferSize) VOID* InputBuffer,
+	_In_ size_t InputBufferSize,
+	_Out_writes_(OutputBufferSize) VOID* OutputBuffer,
+	_In_ size_t OutputBufferSize,
+	_Out_ size_t* BytesReturned
+)
+{
+	UNREFERENCED_PARAMETER(DmfModule);
+	UNREFERENCED_PARAMETER(Request);
+	UNREFERENCED_PARAMETER(IoctlCode);
+
+	using namespace ViGEm::Batch;
+
+	FuncEntry(TRACE_QUEUE);
+
+	NTSTATUS status = STATUS_SUCCESS;
+	unsigned int count = 0;
+	PSUBMIT_BATCH_ENTRY entries;
+	EmulationTargetPDO* pdo;
+	XUSB_SUBMIT_REPORT xusbSubmit;
+	DS5_SUBMIT_REPORT ds5Submit;
+
+	//
+	// Statuses are written back in place, so input and output must match
+	//
+	if (OutputBufferSize != InputBufferSize)
+	{
+		TraceVerbose(
+			TRACE_QUEUE,
+			"Output buffer size %d doesn't match input buffer size %d",
+			static_cast<ULONG>(OutputBufferSize),
+			static_cast<ULONG>(InputBufferSize)
+		);
+
+		status = STATUS_INVALID_BUFFER_SIZE;
+		goto exit;
+	}
+
+	if (ValidateSubmitBatch(InputBuffer, InputBufferSize, &count) != SubmitBatchError::None)
+	{
+		TraceVerbose(
+			TRACE_QUEUE,
+			"Malformed batch of size %d",
+			static_cast<ULONG>(InputBufferSize)
+		);
+
+		status = STATUS_INVALID_PARAMETER;
+		goto exit;
+	}
+
+	entries = SubmitBatchEntries(OutputBuffer);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		auto& entry = entries[i];
+
+		if (!ValidateSubmitBatchEntry(entry, sizeof(xusbSubmit.Report), sizeof(ds5Submit.Report)))
+		{
+			entry.Status = STATUS_INVALID_PARAMETER;
+			continue;
+		}
+
+		switch (entry.Target)
+		{
+		case SubmitBatchTargetXusb:
+
+			if (!EmulationTargetPDO::GetPdoByTypeAndSerial(WdfIoQueueGetDevice(Queue), Xbox360Wired, entry.SerialNo, &pdo))
+			{
+				entry.Status = STATUS_DEVICE_DOES_NOT_EXIST;
+				break;
+			}
+
+			RtlZeroMemory(&xusbSubmit, sizeof(xusbSubmit));
+			xusbSubmit.Size = sizeof(XUSB_SUBMIT_REPORT);
+			xusbSubmit.SerialNo = entry.SerialNo;
+			RtlCopyMemory(&xusbSubmit.Report, entry.Report, sizeof(xusbSubmit.Report));
+
+			entry.Status = pdo->SubmitReport(&xusbSubmit);
+
+			break;
+
+		case SubmitBatchTargetDs5:
+
+			if (!EmulationTargetPDO::GetPdoByTypeAndSerial(WdfIoQueueGetDevice(Queue), DualSense5Wired, entry.SerialNo, &pdo))
+			{
+				entry.Status = STATUS_DEVICE_DOES_NOT_EXIST;
+				break;
+			}
+
+			RtlZeroMemory(&ds5Submit, sizeof(ds5Submit));
+			ds5Submit.Size = sizeof(DS5_SUBMIT_REPORT);
+			ds5Submit.SerialNo = entry.SerialNo;
+			RtlCopyMemory(&ds5Submit.Report, entry.Report, sizeof(ds5Submit.Report));
+
+			entry.Status = pdo->SubmitReport(&ds5Submit);
+
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	*BytesReturned = InputBufferSize;
+
+	TraceVerbose(TRACE_QUEUE, "Applied batch of %d entries", count);
+
+exit:
+	FuncExit(TRACE_QUEUE, "status=%!STATUS!", status);
+
+	return status;
+}
+
+//
+// Attaches the feeder's shared input slot to a DS5 target. The request
+// stays pending while the slot is in use, cancelling it detaches the slot.
+//
+NTSTATUS
+Bus_Ds5AttachInputSlotHandler(
+	_In_ DMFMODULE DmfModule,
+	_In_ WDFQUEUE Queue,
+	_In_ WDFREQUEST Request,
+	_In_ ULONG IoctlCode,
+	_In_reads_(InputBufferSize) VOID* InputBuffer,
+	_In_ size_t InputBufferSize,
+	_Out_writes_(OutputBufferSize) VOID* OutputBuffer,
+	_In_ size_t OutputBufferSize,
+	_Out_ size_t* BytesReturned
+)
+{
+	UNREFERENCED_PARAMETER(DmfModule);
+	UNREFERENCED_PARAMETER(IoctlCode);
+	UNREFERENCED_PARAMETER(InputBufferSize);
+	UNREFERENCED_PARAMETER(OutputBuffer);
+	UNREFERENCED_PARAMETER(OutputBufferSize);
+	UNREFERENCED_PARAMETER(BytesReturned);
+
+	FuncEntry(TRACE_QUEUE);
+
+	NTSTATUS status;
+	EmulationTargetPDO* pdo;
+	const auto attach = static_cast<ViGEm::Reports::PINPUT_SLOT_ATTACH>(InputBuffer);
+
+	if (attach->Size != sizeof(ViGEm::Reports::INPUT_SLOT_ATTACH))
+	{
+		TraceVerbose(
+			TRACE_QUEUE,
+			"Invalid buffer size: %d",
+			attach->Size
+		);
+
+		status = STATUS_INVALID_BUFFER_SIZE;
+		goto exit;
+	}
+
+	// This request only supports a single PDO at a time
+	if (attach->SerialNo == 0)
+	{
+		TraceError(
+			TRACE_QUEUE,
+			"Invalid serial 0 submitted");
+
+		status = STATUS_INVALID_PARAMETER;
+		goto exit;
+	}
+
+	if (!EmulationTargetPDO::GetPdoByTypeAndSerial(WdfIoQueueGetDevice(Queue), DualSense5Wired, attach->SerialNo, &pdo))
+	{
+		status = STATUS_DEVICE_DOES_NOT_EXIST;
+		goto exit;
+	}
+
+	status = static_cast<EmulationTargetDS5*>(pdo)->AttachInputSlot(Request);
+
+	status = NT_SUCCESS(status) ? STATUS_PENDING : status;
+
+exit:
+	FuncExit(TRACE_QUEUE, "status=%!STATUS!", status);
+
+	return status;
+}
+
+//
+// Attaches the consumer's shared audio ring to a DS5 target. The request
+// stays pending while the ring is in use, cancelling it detaches the ring.
+//
+NTSTATUS
+Bus_Ds5AttachAudioRingHandler(
+	_In_ DMFMODULE DmfModule,
+	_In_ WDFQUEUE Queue,
+	_In_ WDFREQUEST Request,
+	_In_ ULONG IoctlCode,
+	_In_reads_(InputBufferSize) VOID* InputBuffer,
+	_In_ size_t InputBufferSize,
+	_Out_writes_(OutputBufferSize) VOID* OutputBuffer,
+	_In_ size_t OutputBufferSize,
+	_Out_ size_t* BytesReturned
+)
+{
+	UNREFERENCED_PARAMETER(DmfModule);
+	UNREFERENCED_PARAMETER(IoctlCode);
+	UNREFERENCED_PARAMETER(InputBufferSize);
+	UNREFERENCED_PARAMETER(OutputBuffer);
+	UNREFERENCED_PARAMETER(OutputBufferSize);
+	UNREFERENCED_PARAMETER(BytesReturned);
+
+	FuncEntry(TRACE_QUEUE);
+
+	NTSTATUS status;
+	EmulationTargetPDO* pdo;
+	const auto attach = static_cast<ViGEm::Audio::PAUDIO_RING_ATTACH>(InputBuffer);
+
+	if (attach->Size != sizeof(ViGEm::Audio::AUDIO_RING_ATTACH))
+	{
+		TraceVerbose(
+			TRACE_QUEUE,
+			"Invalid buffer size: %d",
+			attach->Size
+		);
+
+		status = STATUS_INVALID_BUFFER_SIZE;
+		goto exit;
+	}
+
+	// This request only supports a single PDO at a time
+	if (attach->SerialNo == 0)
+	{
+		TraceError(
+			TRACE_QUEUE,
+			"Invalid serial 0 submitted");
+
+		status = STATUS_INVALID_PARAMETER;
+		goto exit;
+	}
+
+	if (!EmulationTargetPDO::GetPdoByTypeAndSerial(WdfIoQueueGetDevice(Queue), DualSense5Wired, attach->SerialNo, &pdo))
+	{
+		status = STATUS_DEVICE_DOES_NOT_EXIST;
+		goto exit;
+	}
+
+	status = static_cast<EmulationTargetDS5*>(pdo)->AttachAudioRing(Request);
+
+	status = NT_SUCCESS(status) ? STATUS_PENDING : status;
+
+exit:
+	FuncExit(TRACE_QUEUE, "status=%!STATUS!", status);
+
+	return status;
+}
+
+//
+// Blocks until the target's attached audio ring holds data.
+//
+NTSTATUS
+Bus_Ds5AudioRingDoorbellHandler(
+	_In_ DMFMODULE DmfModule,
+	_In_ WDFQUEUE Queue,
+	_In_ WDFREQUEST Request,
+	_In_ ULONG IoctlCode,
+	_In_reads_(InputBufferSize) VOID* InputBuffer,
+	_In_ size_t InputBufferSize,
+	_Out_writes_(OutputBufferSize) VOID* OutputBuffer,
+	_In_ size_t OutputBufferSize,
+	_Out_ size_t* BytesReturned
+)
+{
+	UNREFERENCED_PARAMETER(DmfModule);
+	UNREFERENCED_PARAMETER(IoctlCode);
+	UNREFERENCED_PARAMETER(InputBufferSize);
+	UNREFERENCED_PARAMETER(OutputBuffer);
+	UNREFERENCED_PARAMETER(OutputBufferSize);
+	UNREFERENCED_PARAMETER(BytesReturned);
+
+	FuncEntry(TRACE_QUEUE);
+
+	NTSTATUS status;
+	EmulationTargetPDO* pdo;
+	const auto doorbell = static_cast<ViGEm::Audio::PAUDIO_RING_ATTACH>(InputBuffer);
+
+	if (doorbell->Size != sizeof(ViGEm::Audio::AUDIO_RING_ATTACH))
+	{
+		TraceVerbose(
+			TRACE_QUEUE,
+			"Invalid buffer size: %d",
+			doorbell->Size
+		);
+
+		status = STATUS_INVALID_BUFFER_SIZE;
+		goto exit;
+	}
+
+	if (!EmulationTargetPDO::GetPdoByTypeAndSerial(WdfIoQueueGetDevice(Queue), DualSense5Wired, doorbell->SerialNo, &pdo))
+	{
+		status = STATUS_DEVICE_DOES_NOT_EXIST;
+		goto exit;
+	}
+
+	status = static_cast<EmulationTargetDS5*>(pdo)->RingAudioDoorbell(Request);
+
+exit:
+	FuncExit(TRACE_QUEUE, "status=%!STATUS!", status);
+
+	return status;
+}
+
 EXTERN_C_END
@@ -35,6 +35,10 @@
 
 #pragma once
 
+#include <SubmitBatch.h>
+#include <InputSlot.h>
+#include <AudioRing.h>
+
 EXTERN_C_START
 
 EVT_DMF_IoctlHandler_Callback Bus_CheckVersionHandler;
@@ -48,5 +52,9 @@ EVT_DMF_IoctlHandler_Callback Bus_Ds5RequestNotificationHandler;
 EVT_DMF_IoctlHandler_Callback Bus_XusbGetUserIndexHandler;
 EVT_DMF_IoctlHandler_Callback Bus_Ds5AwaitOutputHandler;
 EVT_DMF_IoctlHandler_Callback Bus_Ds5AwaitAudioHandler;
+EVT_DMF_IoctlHandler_Callback Bus_SubmitBatchHandler;
+EVT_DMF_IoctlHandler_Callback Bus_Ds5AttachInputSlotHandler;
+EVT_DMF_IoctlHandler_Callback Bus_Ds5AttachAudioRingHandler;
+EVT_DMF_IoctlHandler_Callback Bus_Ds5AudioRingDoorbellHandler;
 
 EXTERN_C_END
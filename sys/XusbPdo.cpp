@@ -220,9 +220,11 @@ NTSTATUS ViGEm::Bus::Targets::EmulationTargetXUSB::PdoInitContext()
 	// Is later overwritten by actual XInput slot
 	this->_LedNumber = -1;
 
-	RtlZeroMemory(&this->_Packet, sizeof(XUSB_INTERRUPT_IN_PACKET));
+	XUSB_INTERRUPT_IN_PACKET packet;
+	RtlZeroMemory(&packet, sizeof(XUSB_INTERRUPT_IN_PACKET));
 	// Packet size (20 bytes = 0x14)
-	this->_Packet.Size = 0x14;
+	packet.Size = 0x14;
+	this->_Packet.Write(packet);
 
 	this->_ReportedCapabilities = FALSE;
 
@@ -980,8 +982,11 @@ NTSTATUS ViGEm::Bus::Targets::EmulationTargetXUSB::SubmitReportImpl(PVOID NewRep
 	NTSTATUS    status = STATUS_SUCCESS;
 	BOOLEAN     changed;
 	WDFREQUEST  usbRequest;
+	XUSB_INTERRUPT_IN_PACKET cached;
 
-	changed = (RtlCompareMemory(&this->_Packet.Report,
+	this->_Packet.Read(&cached);
+
+	changed = (RtlCompareMemory(&cached.Report,
 		&static_cast<PXUSB_SUBMIT_REPORT>(NewReport)->Report,
 		sizeof(XUSB_REPORT)) != sizeof(XUSB_REPORT));
 
@@ -1015,10 +1020,14 @@ NTSTATUS ViGEm::Bus::Targets::EmulationTargetXUSB::SubmitReportImpl(PVOID NewRep
 
 	urb->UrbBulkOrInterruptTransfer.TransferBufferLength = sizeof(XUSB_INTERRUPT_IN_PACKET);
 
-	// Copy submitted report to cache
-	RtlCopyBytes(&this->_Packet.Report, &(static_cast<PXUSB_SUBMIT_REPORT>(NewReport))->Report, sizeof(XUSB_REPORT));
-	// Copy cached report to URB transfer buffer
-	RtlCopyBytes(Buffer, &this->_Packet, sizeof(XUSB_INTERRUPT_IN_PACKET));
+	this->_Packet.Update([NewReport, Buffer](XUSB_INTERRUPT_IN_PACKET& Packet)
+	{
+		// Copy submitted report to cache
+		RtlCopyBytes(&Packet.Report, &(static_cast<PXUSB_SUBMIT_REPORT>(NewReport))->Report, sizeof(XUSB_REPORT));
+		// Copy cached report to URB transfer buffer
+		RtlCopyBytes(Buffer, &Packet, sizeof(XUSB_INTERRUPT_IN_PACKET));
+		return true;
+	});
 
 	// Complete pending request
 	WdfRequestComplete(usbRequest, status);
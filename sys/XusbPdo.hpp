@@ -36,6 +36,7 @@
 #pragma once
 
 #include "EmulationTargetPDO.hpp"
+#include <ReportCache.h>
 
 namespace ViGEm::Bus::Targets
 {
@@ -137,7 +138,7 @@ namespace ViGEm::Bus::Targets
 		//
 		// Report packet
 		//
-		XUSB_INTERRUPT_IN_PACKET _Packet;
+		ViGEm::Reports::ReportCache<XUSB_INTERRUPT_IN_PACKET> _Packet;
 
 		//
 		// Queue for incoming control interrupt transfer
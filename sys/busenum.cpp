@@ -186,7 +186,7 @@ EXTERN_C NTSTATUS Bus_PlugInDevice(
 		}
 	}
 
-	if (!NT_SUCCESS(description.Target->PdoPrepare(Device)))
+	if (!NT_SUCCESS(status = description.Target->PdoPrepare(Device)))
 	{
 		goto pluginEnd;
 	}
@@ -195,6 +195,12 @@ EXTERN_C NTSTATUS Bus_PlugInDevice(
 	{
 		static_cast<EmulationTargetDS5*>(description.Target)->SetOutputReportNotifyModule(FdoGetData(Device)->UserNotification);
 		static_cast<EmulationTargetDS5*>(description.Target)->SetAudioNotifyModule(FdoGetData(Device)->AudioNotification);
+		static_cast<EmulationTargetDS5*>(description.Target)->SetScheduler(&FdoGetData(Device)->Scheduler);
+
+		if (!NT_SUCCESS(status = static_cast<EmulationTargetDS5*>(description.Target)->CreateNotificationChannels(Device)))
+		{
+			goto pluginEnd;
+		}
 	}
 
 	status = WdfChildListAddOrUpdateChildDescriptionAsPresent(
@@ -230,6 +236,15 @@ EXTERN_C NTSTATUS Bus_PlugInDevice(
 
 pluginEnd:
 
+	//
+	// The child list didn't take the target, nothing else references it.
+	// Its destructor frees the notification channels parented to the FDO.
+	//
+	if (!NT_SUCCESS(status))
+	{
+		delete description.Target;
+	}
+
 	TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_BUSENUM, "%!FUNC! Exit with status %!STATUS!", status);
 
 	return status;
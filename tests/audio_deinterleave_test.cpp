@@ -0,0 +1,82 @@
+#include "audio_deinterleave.h"
+#include "check.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//
+// ds5_deinterleave（运行时选中的内核 + 标量尾部）与逐帧参考实现逐样本对照
+//
+namespace
+{
+    struct planes
+    {
+        std::vector<float> speakerL, speakerR, hapticL, hapticR;
+
+        explicit planes(size_t frames)
+            : speakerL(frames, -2.0f), speakerR(frames, -2.0f), hapticL(frames, -2.0f), hapticR(frames, -2.0f)
+        {
+        }
+
+        ds5_audio_planes view(size_t offset = 0)
+        {
+            return { speakerL.data() + offset, speakerR.data() + offset, hapticL.data() + offset, hapticR.data() + offset };
+        }
+    };
+
+    size_t compare(const std::vector<int16_t>& in, size_t first, size_t frames, planes& out)
+    {
+        size_t mismatches = 0;
+        for (size_t i = 0; i < frames; i++)
+        {
+            const int16_t* frame = &in[4 * (first + i)];
+            mismatches += out.speakerL[i] != frame[0] / 32768.0f;
+            mismatches += out.speakerR[i] != frame[1] / 32768.0f;
+            mismatches += out.hapticL[i] != frame[2] / 32768.0f;
+            mismatches += out.hapticR[i] != frame[3] / 32768.0f;
+        }
+        return mismatches;
+    }
+}
+
+int main()
+{
+    std::printf("deinterleave kernel: %s\n", ds5_deinterleave_kernel_name());
+
+    std::vector<int16_t> in(4 * 1100);
+    std::mt19937 rng(7);
+    for (auto& s : in)
+        s = static_cast<int16_t>(rng());
+
+    // 端点值
+    in[0] = -32768;
+    in[1] = 32767;
+    in[2] = 0;
+    in[3] = -1;
+
+    // 各种帧数覆盖向量主体和标量尾部；起点不对齐时输入也不对齐
+    for (const size_t frames : { 0, 1, 7, 8, 9, 15, 16, 17, 48, 63, 512, 1024 })
+    {
+        for (const size_t first : { 0, 1, 3 })
+        {
+            planes out(frames + 1);
+            ds5_deinterleave(&in[4 * first], frames, out.view());
+
+            CHECK_EQ(compare(in, first, frames, out), 0u);
+            // 不写越界
+            CHECK(out.speakerL[frames] == -2.0f && out.hapticR[frames] == -2.0f);
+        }
+    }
+
+    // 范围与符号
+    planes out(1);
+    ds5_deinterleave(in.data(), 1, out.view());
+    CHECK(out.speakerL[0] == -1.0f);
+    CHECK(out.speakerR[0] < 1.0f && out.speakerR[0] > 0.9999f);
+    CHECK(out.hapticL[0] == 0.0f);
+    CHECK(out.hapticR[0] < 0.0f);
+
+    return check_result("audio_deinterleave_test");
+}
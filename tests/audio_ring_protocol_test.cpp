@@ -0,0 +1,183 @@
+#include "check.h"
+
+#include <AudioRing.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+//
+// AudioRing.h protocol: bus-side producer and user-mode consumer on two
+// threads over one shared buffer. The stream must arrive intact and in
+// order across wraps, URBs that don't fit are dropped whole, and a
+// consumer that corrupts ReadIndex can't make the producer overrun.
+//
+namespace
+{
+	using namespace ViGEm::Audio;
+
+	struct shared_ring
+	{
+		explicit shared_ring(unsigned long size) : storage((size + 63) / 64) {}
+
+		AUDIO_RING_HEADER* header() { return reinterpret_cast<AUDIO_RING_HEADER*>(storage.data()); }
+
+		struct alignas(64) line { unsigned char bytes[64]; };
+		std::vector<line> storage;
+	};
+
+	bool write_urb(AudioRingProducer& producer, const unsigned char* data, unsigned long length)
+	{
+		if (!producer.Reserve(length))
+			return false;
+		producer.Stage(0, data, length);
+		producer.Commit(length);
+		return true;
+	}
+
+	void test_capacity()
+	{
+		CHECK_EQ(AudioRingCapacityFor(100), 0u);
+		CHECK_EQ(AudioRingCapacityFor(sizeof(AUDIO_RING_HEADER) + 4095), 0u);
+		CHECK_EQ(AudioRingCapacityFor(sizeof(AUDIO_RING_HEADER) + 4096), 4096u);
+		CHECK_EQ(AudioRingCapacityFor(sizeof(AUDIO_RING_HEADER) + 12000), 8192u);
+		CHECK_EQ(AudioRingCapacityFor(64 * 1024 * 1024), AudioRingMaxCapacity);
+	}
+
+	void test_stream()
+	{
+		const unsigned long capacity = 8192;
+		shared_ring shared(sizeof(AUDIO_RING_HEADER) + capacity);
+		AudioRingProducer producer;
+		producer.Attach(shared.header(), capacity);
+
+		constexpr unsigned long TOTAL = 4 << 20;
+		std::atomic<bool> done = false;
+
+		std::thread bus([&] {
+			unsigned char urb[3840];
+			unsigned char next = 0;
+			unsigned long written = 0;
+			unsigned long i = 0;
+			while (written < TOTAL)
+			{
+				const unsigned long length = std::min<unsigned long>(384 * (1 + i++ % 10), TOTAL - written);
+				for (unsigned long k = 0; k < length; k++)
+					urb[k] = static_cast<unsigned char>(next + k);
+				if (write_urb(producer, urb, length))
+				{
+					next = static_cast<unsigned char>(next + length);
+					written += length;
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+			done = true;
+		});
+
+		unsigned char expected = 0;
+		unsigned long read = 0;
+		unsigned long mismatches = 0;
+		while (read < TOTAL)
+		{
+			AudioRingSpans spans;
+			const unsigned long used = PeekAudioRing(shared.header(), &spans);
+			if (used == 0)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			CHECK_EQ(spans.FirstLength + spans.SecondLength, used);
+			for (unsigned long k = 0; k < spans.FirstLength; k++)
+				mismatches += spans.First[k] != expected++;
+			for (unsigned long k = 0; k < spans.SecondLength; k++)
+				mismatches += spans.Second[k] != expected++;
+			ReleaseAudioRing(shared.header(), used);
+			read += used;
+		}
+		bus.join();
+
+		CHECK_EQ(mismatches, 0u);
+		CHECK(done.load());
+		std::printf("stream: %lu bytes, %ld dropped\n", read, shared.header()->DroppedBytes);
+	}
+
+	void test_drop_whole_urb()
+	{
+		const unsigned long capacity = 4096;
+		shared_ring shared(sizeof(AUDIO_RING_HEADER) + capacity);
+		AudioRingProducer producer;
+		producer.Attach(shared.header(), capacity);
+
+		std::vector<unsigned char> urb(3840, 1);
+		CHECK(write_urb(producer, urb.data(), 3840));
+		CHECK(!write_urb(producer, urb.data(), 384));
+		CHECK_EQ(shared.header()->DroppedBytes, 384);
+		CHECK(write_urb(producer, urb.data(), 256));
+
+		AudioRingSpans spans;
+		CHECK_EQ(PeekAudioRing(shared.header(), &spans), 4096u);
+		ReleaseAudioRing(shared.header(), 4096);
+		CHECK_EQ(PeekAudioRing(shared.header(), &spans), 0u);
+		CHECK(write_urb(producer, urb.data(), 3840));
+	}
+
+	void test_bogus_read_index()
+	{
+		const unsigned long capacity = 4096;
+		shared_ring shared(sizeof(AUDIO_RING_HEADER) + capacity);
+		AudioRingProducer producer;
+		producer.Attach(shared.header(), capacity);
+
+		unsigned char urb[384] = {};
+		CHECK(write_urb(producer, urb, sizeof(urb)));
+
+		// Read index ahead of the write index looks like a full ring
+		shared.header()->ReadIndex = 1000000;
+		CHECK_EQ(producer.Used(), capacity);
+		CHECK(!write_urb(producer, urb, sizeof(urb)));
+
+		shared.header()->ReadIndex = static_cast<long>(producer.WriteIndex);
+		CHECK(write_urb(producer, urb, sizeof(urb)));
+	}
+
+	void test_wake_threshold()
+	{
+		const unsigned long capacity = 4096;
+		shared_ring shared(sizeof(AUDIO_RING_HEADER) + capacity);
+		AudioRingProducer producer;
+		producer.Attach(shared.header(), capacity);
+
+		unsigned char urb[384] = {};
+		CHECK(!producer.ShouldWake());
+
+		shared.header()->WakeThreshold = 1000;
+		write_urb(producer, urb, sizeof(urb));
+		write_urb(producer, urb, sizeof(urb));
+		CHECK(!producer.ShouldWake());
+		write_urb(producer, urb, sizeof(urb));
+		CHECK(producer.ShouldWake());
+
+		// Thresholds above capacity are clamped, 0 wakes on any data
+		shared.header()->WakeThreshold = 1 << 30;
+		CHECK(!producer.ShouldWake());
+		shared.header()->WakeThreshold = 0;
+		CHECK(producer.ShouldWake());
+	}
+}
+
+int main()
+{
+	test_capacity();
+	test_stream();
+	test_drop_whole_urb();
+	test_bogus_read_index();
+	test_wake_threshold();
+
+	return check_result("audio_ring_protocol_test");
+}
@@ -0,0 +1,128 @@
+#include "audio_ring.h"
+#include "check.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+//
+// audio_ring：跨回绕的字节流完整性、写满丢整包、按块读取不足计 underrun、等待唤醒
+//
+namespace
+{
+    // 生产者按不规则包长写入递增字节，消费者按不规则块长读出，逐字节校验
+    void test_stream_integrity()
+    {
+        audio_ring ring(4096);
+        constexpr size_t TOTAL = 4 << 20;
+
+        std::jthread producer([&] {
+            uint8_t packet[700];
+            uint8_t next = 0;
+            size_t written = 0;
+            size_t i = 0;
+            while (written < TOTAL)
+            {
+                const size_t size = std::min<size_t>(1 + (i++ * 37) % sizeof(packet), TOTAL - written);
+                for (size_t k = 0; k < size; k++)
+                    packet[k] = static_cast<uint8_t>(next + k);
+                if (ring.write(packet, size))
+                {
+                    next = static_cast<uint8_t>(next + size);
+                    written += size;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        uint8_t block[511];
+        uint8_t expected = 0;
+        size_t read = 0;
+        size_t mismatches = 0;
+        size_t i = 0;
+        while (read < TOTAL)
+        {
+            const uint32_t seen = ring.signal();
+            const size_t n = ring.read(block, 1 + (i++ * 53) % sizeof(block));
+            if (n == 0)
+            {
+                ring.wait(seen);
+                continue;
+            }
+            for (size_t k = 0; k < n; k++)
+                mismatches += block[k] != expected++;
+            read += n;
+        }
+
+        CHECK_EQ(mismatches, 0u);
+        CHECK_EQ(ring.size(), 0u);
+    }
+
+    void test_overflow_drops_whole_packet()
+    {
+        audio_ring ring(1024);
+        uint8_t packet[384] = {};
+
+        CHECK(ring.write(packet, sizeof(packet)));
+        CHECK(ring.write(packet, sizeof(packet)));
+        CHECK(!ring.write(packet, sizeof(packet)));
+        CHECK_EQ(ring.size(), 768u);
+        CHECK_EQ(ring.overflows(), 1u);
+        CHECK_EQ(ring.overflow_bytes(), 384u);
+
+        // 腾出空间后恢复写入
+        CHECK_EQ(ring.read(packet, sizeof(packet)), 384u);
+        CHECK(ring.write(packet, sizeof(packet)));
+        CHECK_EQ(ring.overflows(), 1u);
+    }
+
+    void test_underrun()
+    {
+        audio_ring ring(1024);
+        uint8_t block[256] = {};
+
+        CHECK(!ring.read_exact(block, sizeof(block)));
+        CHECK_EQ(ring.underruns(), 1u);
+
+        ring.write(block, 200);
+        CHECK(!ring.read_exact(block, sizeof(block)));
+        CHECK_EQ(ring.underruns(), 2u);
+        CHECK_EQ(ring.size(), 200u);
+
+        ring.write(block, 56);
+        CHECK(ring.read_exact(block, sizeof(block)));
+        CHECK_EQ(ring.size(), 0u);
+        CHECK_EQ(ring.underruns(), 2u);
+    }
+
+    // 写入同时敲响共享消费线程的门铃
+    void test_doorbell()
+    {
+        audio_ring ring(1024);
+        std::atomic<uint32_t> doorbell = 0;
+        ring.attach(&doorbell);
+
+        const uint32_t seen = doorbell.load();
+        std::jthread producer([&] {
+            uint8_t packet[16] = {};
+            ring.write(packet, sizeof(packet));
+        });
+        doorbell.wait(seen);
+        CHECK(doorbell.load() != seen);
+        producer.join();
+        CHECK_EQ(ring.size(), 16u);
+    }
+}
+
+int main()
+{
+    test_stream_integrity();
+    test_overflow_drops_whole_packet();
+    test_underrun();
+    test_doorbell();
+
+    return check_result("audio_ring_test");
+}
@@ -0,0 +1,198 @@
+#include "check.h"
+
+#include <StagingSlots.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+//
+// Bytes touched per ISO OUT URB: the old stack DS5_AUDIO_DATA path (zero
+// the whole structure, stage the packets, DMF and the completion each copy
+// the whole structure) against per-target staging slots (header only,
+// copies of header plus captured bytes). Staging buffers are poisoned so
+// the harness can also check that nothing past the captured audio is
+// written. StagingSlots itself is hammered from several threads.
+//
+namespace
+{
+	using namespace ViGEm::Audio;
+
+	constexpr unsigned long HEADER = 12;  // Size, SerialNo, AudioDataLength
+	constexpr unsigned long PACKETS = 10;
+	constexpr unsigned long PACKET_SIZE = 384;  // 1 ms at 48 kHz x 4 ch 16-bit
+
+	struct touch_counter
+	{
+		uint64_t bytes = 0;
+
+		void fill(unsigned char* dst, unsigned char value, size_t size)
+		{
+			std::memset(dst, value, size);
+			bytes += size;
+		}
+
+		void copy(unsigned char* dst, const unsigned char* src, size_t size)
+		{
+			std::memcpy(dst, src, size);
+			bytes += size;
+		}
+	};
+
+	void write_header(touch_counter& touched, unsigned char* data, unsigned long size, unsigned long length)
+	{
+		const uint32_t header[3] = { static_cast<uint32_t>(size), 1, static_cast<uint32_t>(length) };
+		touched.copy(data, reinterpret_cast<const unsigned char*>(header), HEADER);
+	}
+
+	// DMF broadcast buffer, then the client's request buffer
+	void deliver(touch_counter& touched, const unsigned char* data, unsigned long length, std::vector<unsigned char>& dmf, std::vector<unsigned char>& client)
+	{
+		touched.copy(dmf.data(), data, length);
+		touched.copy(client.data(), dmf.data(), length);
+	}
+
+	uint64_t legacy_urb(unsigned long maxAudio, const std::vector<unsigned char>& urb)
+	{
+		const unsigned long size = HEADER + maxAudio;
+		std::vector<unsigned char> stack(size), dmf(size), client(size);
+		touch_counter touched;
+
+		touched.fill(stack.data(), 0, size);
+		write_header(touched, stack.data(), size, 0);
+		touched.bytes -= HEADER;  // the header sits inside the zeroed structure
+
+		for (unsigned long i = 0; i < PACKETS; i++)
+			touched.copy(stack.data() + HEADER + i * PACKET_SIZE, urb.data() + i * PACKET_SIZE, PACKET_SIZE);
+
+		deliver(touched, stack.data(), size, dmf, client);
+		return touched.bytes;
+	}
+
+	uint64_t staged_urb(unsigned long maxAudio, const std::vector<unsigned char>& urb, StagingSlots<2>& slots,
+		std::vector<std::vector<unsigned char>>& staging, unsigned long* untouchedDirty)
+	{
+		const unsigned long size = HEADER + maxAudio;
+		std::vector<unsigned char> dmf(size), client(size);
+		touch_counter touched;
+
+		const long slot = slots.Claim();
+		CHECK(slot >= 0);
+		unsigned char* data = staging[slot].data();
+
+		const unsigned long audio = PACKETS * PACKET_SIZE;
+		write_header(touched, data, size, audio);
+		for (unsigned long i = 0; i < PACKETS; i++)
+			touched.copy(data + HEADER + i * PACKET_SIZE, urb.data() + i * PACKET_SIZE, PACKET_SIZE);
+
+		deliver(touched, data, HEADER + audio, dmf, client);
+		slots.Release(slot, audio);
+
+		for (unsigned long i = HEADER + audio; i < size; i++)
+			*untouchedDirty += data[i] != 0xCD;
+
+		return touched.bytes;
+	}
+
+	void test_bytes_touched()
+	{
+		std::vector<unsigned char> urb(PACKETS * PACKET_SIZE, 0x42);
+		const unsigned long audio = PACKETS * PACKET_SIZE;
+
+		for (const unsigned long maxAudio : { 4096ul, 8192ul })
+		{
+			StagingSlots<2> slots;
+			std::vector<std::vector<unsigned char>> staging(2, std::vector<unsigned char>(HEADER + maxAudio, 0xCD));
+			unsigned long dirty = 0;
+
+			const uint64_t legacy = legacy_urb(maxAudio, urb);
+			uint64_t staged = 0;
+			for (int i = 0; i < 8; i++)
+				staged = staged_urb(maxAudio, urb, slots, staging, &dirty);
+
+			std::printf("max payload %5lu: %6llu bytes touched per URB on the stack path, %6llu staged\n",
+				maxAudio, static_cast<unsigned long long>(legacy), static_cast<unsigned long long>(staged));
+
+			CHECK_EQ(legacy, 3 * (HEADER + maxAudio) + audio);
+			CHECK_EQ(staged, 3 * (HEADER + audio));
+			CHECK_EQ(dirty, 0u);
+			CHECK_EQ(slots.PeakBusy(), 1);
+			CHECK_EQ(slots.PeakBytes(), static_cast<long>(audio));
+			CHECK_EQ(slots.Overflows(), 0);
+		}
+	}
+
+	void test_claim_release()
+	{
+		StagingSlots<2> slots;
+
+		CHECK_EQ(slots.Claim(), 0);
+		CHECK_EQ(slots.Claim(), 1);
+		CHECK_EQ(slots.Claim(), -1);
+		CHECK_EQ(slots.Overflows(), 1);
+		CHECK_EQ(slots.PeakBusy(), 2);
+
+		slots.Release(-1, 100);
+		slots.Release(0, 3840);
+		CHECK_EQ(slots.Claim(), 0);
+		slots.Release(1, 10);
+		slots.Release(0, 10);
+		CHECK_EQ(slots.PeakBytes(), 3840);
+	}
+
+	// Several URBs in flight: a slot is never owned twice
+	void test_concurrent()
+	{
+		StagingSlots<4> slots;
+		std::atomic<int> owners[4] = {};
+		std::atomic<unsigned long> doubleClaims = 0;
+		std::atomic<unsigned long> fallbacks = 0;
+
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 6; t++)
+		{
+			threads.emplace_back([&] {
+				for (int i = 0; i < 20000; i++)
+				{
+					const long slot = slots.Claim();
+					if (slot < 0)
+					{
+						fallbacks++;
+						slots.Release(slot, 384);
+						continue;
+					}
+					if (owners[slot].fetch_add(1) != 0)
+						doubleClaims++;
+					if (i % 64 == 0)
+						std::this_thread::yield();
+					owners[slot].fetch_sub(1);
+					slots.Release(slot, 3840);
+				}
+			});
+		}
+		for (auto& t : threads)
+			t.join();
+
+		CHECK_EQ(doubleClaims.load(), 0u);
+		CHECK_EQ(static_cast<unsigned long>(slots.Overflows()), fallbacks.load());
+		CHECK(slots.PeakBusy() >= 1 && slots.PeakBusy() <= 4);
+		CHECK_EQ(slots.PeakBytes(), 3840);
+
+		// All slots are free again
+		for (long i = 0; i < 4; i++)
+			CHECK(slots.Claim() >= 0);
+		CHECK_EQ(slots.Claim(), -1);
+	}
+}
+
+int main()
+{
+	test_bytes_touched();
+	test_claim_release();
+	test_concurrent();
+
+	return check_result("audio_staging_test");
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdio>
+
+//
+// 最小的断言：失败时打印位置并计数，main 返回 check_result()
+//
+inline int& check_failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                 \
+    do                                                                              \
+    {                                                                               \
+        if (!(cond))                                                                \
+        {                                                                           \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            check_failures()++;                                                     \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                              \
+    do                                                                              \
+    {                                                                               \
+        const auto check_a_ = (a);                                                  \
+        const auto check_b_ = (b);                                                  \
+        if (!(check_a_ == check_b_))                                                \
+        {                                                                           \
+            std::fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n",  \
+                         __FILE__, __LINE__, #a, #b,                                \
+                         static_cast<long long>(check_a_), static_cast<long long>(check_b_)); \
+            check_failures()++;                                                     \
+        }                                                                           \
+    } while (0)
+
+inline int check_result(const char* name)
+{
+    if (check_failures() == 0)
+    {
+        std::printf("%s: OK\n", name);
+        return 0;
+    }
+
+    std::fprintf(stderr, "%s: %d check(s) failed\n", name, check_failures());
+    return 1;
+}
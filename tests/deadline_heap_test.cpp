@@ -0,0 +1,232 @@
+#include "check.h"
+
+#include <DeadlineHeap.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+//
+// DeadlineHeap against a brute-force model under random Schedule / Cancel /
+// PopDue sequences: same earliest deadline, same ids popped in deadline
+// order, Schedule only ever moves a queued id earlier. Plus the tick helpers
+// BusScheduler uses: batch pop / requeue, the periodic grid rule and the
+// one-shot timer delay.
+//
+namespace
+{
+	using ViGEm::Timing::DeadlineHeap;
+	using ViGEm::Timing::DueWork;
+	using ViGEm::Timing::NextPeriodicDeadline;
+	using ViGEm::Timing::TimerDelay;
+
+	constexpr unsigned long CAPACITY = 64;
+	constexpr unsigned long long NONE = ~0ULL;
+
+	struct model
+	{
+		std::vector<unsigned long long> deadline = std::vector<unsigned long long>(CAPACITY, NONE);
+
+		void schedule(unsigned long id, unsigned long long at)
+		{
+			if (id < CAPACITY && at < deadline[id])
+				deadline[id] = at;
+		}
+
+		unsigned long long earliest() const
+		{
+			unsigned long long best = NONE;
+			for (const auto d : deadline)
+				best = d < best ? d : best;
+			return best;
+		}
+
+		unsigned long count() const
+		{
+			unsigned long n = 0;
+			for (const auto d : deadline)
+				n += d != NONE;
+			return n;
+		}
+	};
+
+	void test_basics()
+	{
+		DeadlineHeap<8> heap;
+		heap.Init();
+		CHECK(heap.IsEmpty());
+
+		heap.Schedule(3, 100);
+		heap.Schedule(5, 50);
+		heap.Schedule(3, 200);  // later: ignored
+		heap.Schedule(8, 10);   // out of range: ignored
+		CHECK_EQ(heap.Count(), 2u);
+		CHECK_EQ(heap.NextDeadline(), 50u);
+
+		heap.Schedule(3, 20);   // earlier: moved up
+		CHECK_EQ(heap.NextDeadline(), 20u);
+
+		unsigned long id = 0;
+		unsigned long long deadline = 0;
+		CHECK(!heap.PopDue(19, &id, &deadline));
+		CHECK(heap.PopDue(20, &id, &deadline));
+		CHECK_EQ(id, 3u);
+		CHECK_EQ(deadline, 20u);
+		CHECK(!heap.IsQueued(3));
+
+		heap.Cancel(5);
+		heap.Cancel(5);
+		CHECK(heap.IsEmpty());
+	}
+
+	void test_random()
+	{
+		DeadlineHeap<CAPACITY> heap;
+		heap.Init();
+		model reference;
+		std::mt19937 rng(25);
+		unsigned long long now = 0;
+		unsigned long mismatches = 0;
+
+		for (int step = 0; step < 200000; step++)
+		{
+			const unsigned long id = rng() % (CAPACITY + 2);
+			switch (rng() % 4)
+			{
+			case 0:
+			case 1:
+			{
+				const unsigned long long at = now + rng() % 64;
+				heap.Schedule(id, at);
+				reference.schedule(id, at);
+				break;
+			}
+			case 2:
+				heap.Cancel(id);
+				if (id < CAPACITY)
+					reference.deadline[id] = NONE;
+				break;
+			case 3:
+			{
+				now += rng() % 8;
+				unsigned long popped;
+				unsigned long long deadline;
+				unsigned long long previous = 0;
+				while (heap.PopDue(now, &popped, &deadline))
+				{
+					mismatches += popped >= CAPACITY || reference.deadline[popped] != deadline || deadline < previous;
+					previous = deadline;
+					if (popped < CAPACITY)
+						reference.deadline[popped] = NONE;
+				}
+				mismatches += reference.earliest() != NONE && reference.earliest() <= now;
+				break;
+			}
+			}
+
+			mismatches += heap.Count() != reference.count();
+			mismatches += !heap.IsEmpty() && heap.NextDeadline() != reference.earliest();
+			mismatches += heap.IsQueued(id) != (id < CAPACITY && reference.deadline[id] != NONE);
+		}
+
+		CHECK_EQ(mismatches, 0u);
+	}
+
+	void test_batch()
+	{
+		DeadlineHeap<8> heap;
+		DueWork batch[8];
+		heap.Init();
+
+		heap.Schedule(0, 30);
+		heap.Schedule(1, 10);
+		heap.Schedule(2, 20);
+		heap.Schedule(3, 40);
+
+		CHECK_EQ(heap.PopAllDue(5, batch), 0u);
+
+		const unsigned long count = heap.PopAllDue(30, batch);
+		CHECK_EQ(count, 3u);
+		CHECK_EQ(batch[0].Id, 1u);
+		CHECK_EQ(batch[1].Id, 2u);
+		CHECK_EQ(batch[2].Id, 0u);
+		CHECK_EQ(batch[2].Deadline, 30u);
+		CHECK_EQ(batch[0].Next, 0u);
+		CHECK_EQ(heap.Count(), 1u);
+
+		// 1 is done, 2 was dropped by the owner while the batch ran, 0 goes on
+		batch[0].Next = 0;
+		batch[1].Next = 50;
+		batch[2].Next = 60;
+		heap.Requeue(batch, count, [&](unsigned long index) { return batch[index].Id != 2; });
+
+		CHECK_EQ(heap.Count(), 2u);
+		CHECK(heap.IsQueued(0));
+		CHECK(!heap.IsQueued(1));
+		CHECK(!heap.IsQueued(2));
+		CHECK_EQ(heap.NextDeadline(), 40u);
+
+		// Requeue moves earlier like Schedule does
+		batch[0].Id = 3;
+		batch[0].Next = 35;
+		heap.Requeue(batch, 1, [](unsigned long) { return true; });
+		CHECK_EQ(heap.NextDeadline(), 35u);
+	}
+
+	void test_periodic()
+	{
+		// On time and a little late: stays on the grid
+		CHECK_EQ(NextPeriodicDeadline(100, 48, 100), 148u);
+		CHECK_EQ(NextPeriodicDeadline(100, 48, 147), 148u);
+
+		// A whole period late: restarts from now
+		CHECK_EQ(NextPeriodicDeadline(100, 48, 148), 196u);
+		CHECK_EQ(NextPeriodicDeadline(100, 48, 500), 548u);
+
+		CHECK_EQ(TimerDelay(100, 50, 8), 50u);
+		CHECK_EQ(TimerDelay(100, 92, 8), 8u);
+		CHECK_EQ(TimerDelay(100, 95, 8), 8u);
+		CHECK_EQ(TimerDelay(100, 200, 8), 8u);
+	}
+
+	void test_one_shot()
+	{
+		// One idle pad polled every 6 ms: a one-shot timer armed for the
+		// earliest deadline wakes once per poll, not once per frame
+		constexpr unsigned long long period = 48;
+		DeadlineHeap<2> heap;
+		DueWork batch[2];
+		heap.Init();
+		heap.Schedule(0, 5);
+
+		unsigned long long now = TimerDelay(heap.NextDeadline(), 0, 8);
+		unsigned long ticks = 0, serviced = 0, empty = 0;
+
+		while (now < 8000)
+		{
+			ticks++;
+			const unsigned long count = heap.PopAllDue(now, batch);
+			empty += count == 0;
+			serviced += count;
+			for (unsigned long i = 0; i < count; i++)
+				batch[i].Next = NextPeriodicDeadline(batch[i].Deadline, period, now);
+			heap.Requeue(batch, count, [](unsigned long) { return true; });
+			now += TimerDelay(heap.NextDeadline(), now, 8);
+		}
+
+		CHECK_EQ(empty, 0u);
+		CHECK_EQ(serviced, ticks);
+		CHECK(ticks >= 166 && ticks <= 167);
+	}
+}
+
+int main()
+{
+	test_basics();
+	test_random();
+	test_batch();
+	test_periodic();
+	test_one_shot();
+
+	return check_result("deadline_heap_test");
+}
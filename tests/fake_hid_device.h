@@ -0,0 +1,181 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hid_device_io.h"
+
+//
+// 回环 HID 设备，代替 hidapi_device_io 驱动读写路径
+//
+// inject() 模拟手柄发来一个输入报文：有挂起的读请求时直接拷进去并在池上完成，
+// 否则排队，超过 depth 丢掉最旧的（与 Windows HID 类驱动的输入缓冲一致）。
+// disconnect() 模拟手柄断开，挂起的和之后的读都失败。
+// write() 记录写入的报文，可以设置每次写的耗时来模拟慢速蓝牙。
+// 不 bind 时完成回调直接在 inject() 的线程上执行，用来模拟阻塞读的唤醒。
+//
+class fake_hid_device : public hid_device_io
+{
+public:
+    explicit fake_hid_device(size_t depth = 32) : depth_(depth) {}
+
+    bool bind(io_pool& pool) override
+    {
+        pool_ = &pool;
+        return true;
+    }
+
+    bool read_async(uint8_t* data, size_t size, io_pool::task& done) override
+    {
+        std::unique_lock lock(mutex_);
+        if (disconnected_ || pending_.done)
+            return false;
+
+        if (queued_.empty())
+        {
+            pending_ = { data, size, &done };
+            return true;
+        }
+
+        const size_t n = std::min(size, queued_.front().size());
+        std::memcpy(data, queued_.front().data(), n);
+        queued_.pop_front();
+        lock.unlock();
+
+        return finish(done, true, n);
+    }
+
+    void cancel_read() override
+    {
+        io_pool::task* done = take_pending();
+        if (done)
+            finish(*done, false, 0);
+    }
+
+    int write(const uint8_t* data, size_t size) override
+    {
+        if (writeDelay_.count() != 0)
+            std::this_thread::sleep_for(writeDelay_);
+
+        std::scoped_lock lock(mutex_);
+        if (disconnected_)
+            return -1;
+
+        written_.emplace_back(data, data + size);
+        return static_cast<int>(size);
+    }
+
+    std::wstring read_error() override
+    {
+        std::scoped_lock lock(mutex_);
+        return disconnected_ ? L"device disconnected" : L"";
+    }
+
+    std::wstring write_error() override
+    {
+        return read_error();
+    }
+
+    //
+    // 以下由测试调用
+    //
+
+    void inject(const uint8_t* data, size_t size)
+    {
+        std::unique_lock lock(mutex_);
+        if (disconnected_)
+            return;
+
+        if (pending_.done)
+        {
+            const pending read = pending_;
+            pending_ = {};
+
+            const size_t n = std::min(size, read.size);
+            std::memcpy(read.data, data, n);
+            lock.unlock();
+
+            finish(*read.done, true, n);
+            return;
+        }
+
+        if (queued_.size() == depth_)
+        {
+            queued_.pop_front();
+            dropped_++;
+        }
+        queued_.emplace_back(data, data + size);
+    }
+
+    void disconnect()
+    {
+        io_pool::task* done;
+        {
+            std::scoped_lock lock(mutex_);
+            disconnected_ = true;
+            queued_.clear();
+            done = pending_.done;
+            pending_ = {};
+        }
+
+        if (done)
+            finish(*done, false, 0);
+    }
+
+    // 写入耗时，在 hid_writer 启动前设置
+    void set_write_delay(std::chrono::microseconds delay) { writeDelay_ = delay; }
+
+    size_t dropped()
+    {
+        std::scoped_lock lock(mutex_);
+        return dropped_;
+    }
+
+    std::vector<std::vector<uint8_t>> written()
+    {
+        std::scoped_lock lock(mutex_);
+        return written_;
+    }
+
+private:
+    bool finish(io_pool::task& done, bool ok, size_t transferred)
+    {
+        if (pool_)
+            return pool_->post(done, ok, transferred);
+
+        done.complete(ok, transferred);
+        return true;
+    }
+
+    struct pending
+    {
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        io_pool::task* done = nullptr;
+    };
+
+    io_pool::task* take_pending()
+    {
+        std::scoped_lock lock(mutex_);
+        io_pool::task* done = pending_.done;
+        pending_ = {};
+        return done;
+    }
+
+    const size_t depth_;
+    io_pool* pool_ = nullptr;
+    std::chrono::microseconds writeDelay_{ 0 };
+
+    std::mutex mutex_;
+    pending pending_;
+    std::deque<std::vector<uint8_t>> queued_;
+    size_t dropped_ = 0;
+    bool disconnected_ = false;
+    std::vector<std::vector<uint8_t>> written_;
+};
@@ -0,0 +1,157 @@
+#include "check.h"
+
+#include <FrameClock.h>
+
+//
+// FrameClock against exact 128-bit division, driven by a fake tick
+// source: microframes exact or one low right at a boundary, 8 microframes
+// per frame, the 32-bit frame number wrapping like a real bus, no
+// overflow after long uptimes.
+//
+namespace
+{
+	using ViGEm::Timing::FrameClock;
+	using ViGEm::Timing::MicroframesPerFrame;
+	using ViGEm::Timing::MicroframesPerSecond;
+
+	// Performance counter rates seen in the wild (ACPI PM, HPET, TSC based)
+	constexpr long long FREQUENCIES[] = { 3579545, 10000000, 14318180, 24000000, 1000000000 };
+
+	struct fake_counter
+	{
+		long long ticks = 0;
+
+		long long operator()() const
+		{
+			return ticks;
+		}
+	};
+
+	unsigned long long exact_microframes(long long ticks, long long frequency)
+	{
+		return static_cast<unsigned long long>(static_cast<unsigned __int128>(ticks) * MicroframesPerSecond / frequency);
+	}
+
+	// First tick of a microframe
+	long long microframe_start(unsigned long long microframe, long long frequency)
+	{
+		const unsigned __int128 scaled = static_cast<unsigned __int128>(microframe) * frequency;
+		return static_cast<long long>((scaled + MicroframesPerSecond - 1) / MicroframesPerSecond);
+	}
+
+	void test_rounding()
+	{
+		for (const long long frequency : FREQUENCIES)
+		{
+			FrameClock clock;
+			clock.Init(frequency);
+			fake_counter counter;
+
+			unsigned long off = 0, wrongFrame = 0, backwards = 0;
+			unsigned long long previous = 0;
+
+			// Every microframe boundary of the first 100 frames, a tick
+			// either side and right on it
+			for (unsigned long long microframe = 1; microframe <= 100 * MicroframesPerFrame; microframe++)
+			{
+				const long long start = microframe_start(microframe, frequency);
+
+				for (long long ticks = start - 1; ticks <= start + 1; ticks++)
+				{
+					counter.ticks = ticks;
+					const unsigned long long read = clock.CurrentMicroframe(counter);
+					const unsigned long long exact = exact_microframes(ticks, frequency);
+
+					off += (read == exact || read + 1 == exact) ? 0 : 1;
+					wrongFrame += clock.CurrentFrame(counter) == read / MicroframesPerFrame ? 0 : 1;
+					backwards += read < previous ? 1 : 0;
+					previous = read;
+				}
+
+				// Mid-microframe reads are exact
+				counter.ticks = start + frequency / MicroframesPerSecond / 2;
+				off += clock.CurrentMicroframe(counter) == microframe ? 0 : 1;
+			}
+
+			CHECK_EQ(off, 0u);
+			CHECK_EQ(wrongFrame, 0u);
+			CHECK_EQ(backwards, 0u);
+
+			// Eight microframes to a frame: mid-frame reads of frame k
+			// are microframes 8k..8k+7 and frame k
+			unsigned long frames = 0;
+			for (unsigned long frame = 0; frame < 1000; frame++)
+			{
+				for (unsigned long microframe = 0; microframe < MicroframesPerFrame; microframe++)
+				{
+					const unsigned long long m = frame * MicroframesPerFrame + microframe;
+					counter.ticks = microframe_start(m, frequency) + frequency / MicroframesPerSecond / 2;
+					frames += clock.CurrentFrame(counter) == frame ? 0 : 1;
+				}
+			}
+			CHECK_EQ(frames, 0u);
+		}
+	}
+
+	void test_wraparound()
+	{
+		for (const long long frequency : FREQUENCIES)
+		{
+			FrameClock clock;
+			clock.Init(frequency);
+			fake_counter counter;
+
+			// The frame number is 32 bits and wraps after ~49.7 days,
+			// microframes keep counting
+			const unsigned long long wrap = 1ULL << 32;
+			const long long half = frequency / MicroframesPerSecond / 2;
+
+			counter.ticks = microframe_start((wrap - 1) * MicroframesPerFrame + 7, frequency) + half;
+			CHECK_EQ(clock.CurrentFrame(counter), 0xFFFFFFFFul);
+			CHECK_EQ(clock.CurrentMicroframe(counter), (wrap - 1) * MicroframesPerFrame + 7);
+
+			counter.ticks = microframe_start(wrap * MicroframesPerFrame, frequency) + half;
+			CHECK_EQ(clock.CurrentFrame(counter), 0ul);
+			CHECK_EQ(clock.CurrentMicroframe(counter), wrap * MicroframesPerFrame);
+
+			counter.ticks = microframe_start((wrap + 1) * MicroframesPerFrame, frequency) + half;
+			CHECK_EQ(clock.CurrentFrame(counter), 1ul);
+
+			// 100 years of uptime: still exact or one low, nothing overflows
+			counter.ticks = 100LL * 365 * 24 * 3600 * frequency + 12345;
+			const unsigned long long exact = exact_microframes(counter.ticks, frequency);
+			const unsigned long long read = clock.CurrentMicroframe(counter);
+			CHECK(read == exact || read + 1 == exact);
+		}
+	}
+
+	void test_origin()
+	{
+		FrameClock clock;
+		clock.Init(10000000, 5000000);
+		CHECK(clock.IsInitialized());
+		CHECK_EQ(clock.Frequency(), 10000000);
+
+		// Before and at the origin is microframe 0, the counter going
+		// negative too
+		fake_counter counter;
+		counter.ticks = -1;
+		CHECK_EQ(clock.CurrentMicroframe(counter), 0u);
+		counter.ticks = 5000000;
+		CHECK_EQ(clock.CurrentMicroframe(counter), 0u);
+
+		// Half a second after the origin
+		counter.ticks = 10000000 + 625;
+		CHECK_EQ(clock.CurrentMicroframe(counter), MicroframesPerSecond / 2);
+		CHECK_EQ(clock.CurrentFrame(counter), 500ul);
+	}
+}
+
+int main()
+{
+	test_rounding();
+	test_wraparound();
+	test_origin();
+
+	return check_result("frame_clock_test");
+}
@@ -0,0 +1,238 @@
+#include "audio_ring.h"
+#include "check.h"
+#include "fake_hid_device.h"
+#include "haptics_handler.h"
+#include "hid_writer.h"
+#include "polyphase_decimator.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+//
+// 振动管线的参考向量测试
+//
+// 1. 抽取器分块处理的输出与双精度直接卷积后每 16 点取一点的参考结果对照
+// 2. 通带 / 阻带的幅度响应
+// 3. 整条管线：已知输入经 haptics_handler 和写线程到回环设备，
+//    报文逐字节与参考报文对照，校验和用逐位 CRC 独立验证
+//
+namespace
+{
+    constexpr double PI = 3.14159265358979323846;
+    constexpr unsigned RATE = 48000;
+    constexpr unsigned DECIMATION = 16;
+    constexpr unsigned TAPS_PER_PHASE = 16;
+    constexpr double CUTOFF = 1250.0 / RATE;
+    constexpr size_t BLOCK = 512;
+
+    // 与抽取器相同的 Blackman 窗 sinc 设计，全程双精度
+    std::vector<double> reference_taps()
+    {
+        const size_t taps = DECIMATION * TAPS_PER_PHASE;
+        const double center = (taps - 1) / 2.0;
+        std::vector<double> h(taps);
+        double sum = 0.0;
+        for (size_t n = 0; n < taps; n++)
+        {
+            const double x = n - center;
+            const double sinc = x == 0.0 ? 2.0 * CUTOFF : std::sin(2.0 * PI * CUTOFF * x) / (PI * x);
+            const double window = 0.42 - 0.5 * std::cos(2.0 * PI * n / (taps - 1)) + 0.08 * std::cos(4.0 * PI * n / (taps - 1));
+            h[n] = sinc * window;
+            sum += h[n];
+        }
+        for (auto& v : h)
+            v /= sum;
+        return h;
+    }
+
+    // y[m] = sum h[n] * x[t - n]，t = (m + 1) * 16 - 1，信号之前补零
+    std::vector<double> reference_decimate(const std::vector<float>& x)
+    {
+        const auto h = reference_taps();
+        std::vector<double> y(x.size() / DECIMATION);
+        for (size_t m = 0; m < y.size(); m++)
+        {
+            const size_t t = (m + 1) * DECIMATION - 1;
+            double acc = 0.0;
+            for (size_t n = 0; n < h.size() && n <= t; n++)
+                acc += h[n] * x[t - n];
+            y[m] = acc;
+        }
+        return y;
+    }
+
+    std::vector<float> decimate(const std::vector<float>& x)
+    {
+        polyphase_decimator decimator(DECIMATION, TAPS_PER_PHASE, CUTOFF, BLOCK);
+        std::vector<float> y(x.size() / DECIMATION);
+        for (size_t i = 0; i + BLOCK <= x.size(); i += BLOCK)
+            decimator.process(&x[i], BLOCK, &y[i / DECIMATION]);
+        return y;
+    }
+
+    std::vector<float> sine(double hz, size_t count)
+    {
+        std::vector<float> x(count);
+        for (size_t i = 0; i < count; i++)
+            x[i] = static_cast<float>(std::sin(2.0 * PI * hz * i / RATE));
+        return x;
+    }
+
+    // 跳过滤波器建立阶段后按 RMS 估计的正弦幅度（抽样点不一定落在峰值上）
+    double amplitude(const std::vector<float>& y)
+    {
+        double sum = 0.0;
+        for (size_t i = TAPS_PER_PHASE; i < y.size(); i++)
+            sum += static_cast<double>(y[i]) * y[i];
+        return std::sqrt(2.0 * sum / (y.size() - TAPS_PER_PHASE));
+    }
+
+    void test_decimator_reference()
+    {
+        std::vector<float> x(BLOCK * 8);
+        uint32_t lcg = 1;
+        for (auto& v : x)
+        {
+            lcg = lcg * 1664525u + 1013904223u;
+            v = static_cast<int32_t>(lcg) / 2147483648.0f;
+        }
+
+        const auto got = decimate(x);
+        const auto want = reference_decimate(x);
+
+        double worst = 0.0;
+        for (size_t i = 0; i < got.size(); i++)
+            worst = std::max(worst, std::fabs(got[i] - want[i]));
+        std::printf("decimator max error vs double reference: %.2e\n", worst);
+        CHECK(worst < 1e-5);
+
+        // reset 后从零历史重新开始
+        polyphase_decimator decimator(DECIMATION, TAPS_PER_PHASE, CUTOFF, BLOCK);
+        std::vector<float> y(BLOCK / DECIMATION);
+        decimator.process(&x[BLOCK], BLOCK, y.data());
+        decimator.reset();
+        decimator.process(&x[0], BLOCK, y.data());
+        CHECK(std::fabs(y[5] - want[5]) < 1e-5);
+    }
+
+    void test_response()
+    {
+        const size_t count = BLOCK * 32;
+        const double pass = amplitude(decimate(sine(300.0, count)));
+        const double edge = amplitude(decimate(sine(1000.0, count)));
+        const double stop = amplitude(decimate(sine(2000.0, count)));
+        const double alias = amplitude(decimate(sine(4000.0, count)));
+        std::printf("gain 300 Hz %.4f  1 kHz %.4f  2 kHz %.1f dB  4 kHz %.1f dB\n",
+            pass, edge, 20 * std::log10(stop), 20 * std::log10(alias));
+
+        CHECK(std::fabs(pass - 1.0) < 0.01);
+        CHECK(edge > 0.7);
+        CHECK(20 * std::log10(stop) < -70.0);
+        CHECK(20 * std::log10(alias) < -70.0);
+    }
+
+    uint32_t crc32_bitwise_a2(const uint8_t* data, size_t size)
+    {
+        uint32_t state = ~0u;
+        const uint8_t seed = 0xA2;
+        for (size_t i = 0; i <= size; i++)
+        {
+            state ^= i == 0 ? seed : data[i - 1];
+            for (unsigned b = 0; b < 8; b++)
+                state = (state >> 1) ^ (0xEDB88320 & (0u - (state & 1)));
+        }
+        return ~state;
+    }
+
+    // 参考报文：稳态时左右声道分别是 0.25 / -0.25 的直流
+    std::vector<uint8_t> reference_report(uint8_t seq)
+    {
+        std::vector<uint8_t> r(141, 0);
+        r[0] = 0x32;
+        r[1] = static_cast<uint8_t>(seq << 4);
+        const uint8_t control[] = { 0x91, 0x07, 0xFE, 0x00, 0x00, 0x00, 0x00, seq, 0x00 };
+        std::copy(std::begin(control), std::end(control), r.begin() + 2);
+        r[11] = 0x92;
+        r[12] = 0x40;
+        for (size_t i = 0; i < 32; i++)
+        {
+            r[13 + 2 * i] = 32;
+            r[14 + 2 * i] = static_cast<uint8_t>(-32);
+        }
+        const uint32_t crc = crc32_bitwise_a2(r.data(), 137);
+        for (size_t i = 0; i < 4; i++)
+            r[137 + i] = static_cast<uint8_t>(crc >> (8 * i));
+        return r;
+    }
+
+    void test_pipeline()
+    {
+        fake_hid_device device;
+        hid_writer writer(0);
+        writer.start();
+        hid_writer::channel* channel = writer.open_channel(device);
+
+        audio_ring ring(1 << 16);
+        haptics_handler handler(ring, channel, 0);
+
+        // 扬声器声道放满幅噪声，不应漏进振动报文
+        constexpr unsigned REPORTS = 20;
+        std::vector<int16_t> block(BLOCK * 4);
+        uint32_t lcg = 3;
+        for (unsigned n = 0; n < REPORTS; n++)
+        {
+            for (size_t i = 0; i < BLOCK; i++)
+            {
+                lcg = lcg * 1664525u + 1013904223u;
+                block[4 * i + 0] = static_cast<int16_t>(lcg >> 16);
+                block[4 * i + 1] = static_cast<int16_t>(lcg);
+                block[4 * i + 2] = 8192;
+                block[4 * i + 3] = -8192;
+            }
+            CHECK(ring.write(reinterpret_cast<const uint8_t*>(block.data()), block.size() * sizeof(int16_t)));
+            CHECK(handler.pump());
+        }
+
+        // 不足一块时不出报文
+        CHECK(!handler.pump());
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (device.written().size() < REPORTS && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        const auto written = device.written();
+        CHECK_EQ(written.size(), REPORTS);
+        for (unsigned n = 0; n < written.size(); n++)
+        {
+            const auto& report = written[n];
+            const uint8_t seq = n & 0x0F;
+            CHECK_EQ(report.size(), 141u);
+
+            // 每个报文都核对校验和与序号
+            const uint32_t crc = crc32_bitwise_a2(report.data(), 137);
+            CHECK_EQ(report[137] | report[138] << 8 | report[139] << 16 | static_cast<uint32_t>(report[140]) << 24, crc);
+            CHECK_EQ(report[1], seq << 4);
+            CHECK_EQ(report[9], seq);
+
+            // 第一个报文包含滤波器建立过程，之后与参考报文逐字节一致
+            if (n > 0)
+                CHECK(report == reference_report(seq));
+        }
+
+        writer.close_channel(channel);
+        writer.stop();
+    }
+}
+
+int main()
+{
+    test_decimator_reference();
+    test_response();
+    test_pipeline();
+
+    return check_result("haptics_test");
+}
@@ -0,0 +1,249 @@
+#include "check.h"
+#include "fake_hid_device.h"
+#include "io_pool.h"
+#include "latency_histogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//
+// HID 读路径：io_pool + io_loop + 回环设备，与 ds5_session 的输入循环同一结构
+//
+namespace
+{
+    using namespace std::chrono;
+
+    constexpr size_t REPORT_SIZE = 78;
+
+    // 报文第 1、2 字节放序号，第 3 字节起放注入时刻
+    void make_report(uint8_t* report, uint16_t seq)
+    {
+        std::memset(report, 0, REPORT_SIZE);
+        report[0] = 0x31;
+        report[1] = static_cast<uint8_t>(seq);
+        report[2] = static_cast<uint8_t>(seq >> 8);
+
+        const int64_t now = steady_clock::now().time_since_epoch().count();
+        std::memcpy(report + 3, &now, sizeof(now));
+    }
+
+    class reader : public io_loop
+    {
+    public:
+        explicit reader(hid_device_io& device) : device_(device) {}
+        ~reader() { stop(); }
+
+        std::atomic<size_t> received = 0;
+        std::atomic<size_t> failed = 0;
+        std::atomic<size_t> outOfOrder = 0;
+        latency_histogram latency;  // 注入到完成回调
+
+    private:
+        bool issue() override { return device_.read_async(buffer_, sizeof(buffer_), *this); }
+        void cancel() override { device_.cancel_read(); }
+
+        bool completed(bool ok, size_t transferred) override
+        {
+            if (!ok)
+            {
+                failed++;
+                return false;
+            }
+
+            if (transferred != REPORT_SIZE || buffer_[0] != 0x31)
+            {
+                failed++;
+                return true;
+            }
+
+            const uint16_t seq = static_cast<uint16_t>(buffer_[1] | (buffer_[2] << 8));
+            if (received.load(std::memory_order_relaxed) != 0 && seq <= last_)
+                outOfOrder++;
+            last_ = seq;
+
+            int64_t injected;
+            std::memcpy(&injected, buffer_ + 3, sizeof(injected));
+            latency.record(steady_clock::now().time_since_epoch().count() - injected);
+
+            received.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+
+        hid_device_io& device_;
+        uint8_t buffer_[128] = {};
+        uint16_t last_ = 0;
+    };
+
+    template <typename Pred>
+    bool wait_for(Pred pred)
+    {
+        const auto deadline = steady_clock::now() + seconds(10);
+        while (!pred())
+        {
+            if (steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(microseconds(100));
+        }
+        return true;
+    }
+
+    // 读得比注入快时一个不丢、顺序不变
+    void test_in_order(io_pool& pool)
+    {
+        constexpr uint16_t COUNT = 2000;
+
+        fake_hid_device device(COUNT);
+        CHECK(device.bind(pool));
+
+        reader r(device);
+        CHECK(r.start());
+
+        uint8_t report[REPORT_SIZE];
+        for (uint16_t seq = 0; seq < COUNT; seq++)
+        {
+            make_report(report, seq);
+            device.inject(report, sizeof(report));
+        }
+
+        CHECK(wait_for([&] { return r.received.load() == COUNT; }));
+        CHECK_EQ(r.outOfOrder.load(), 0u);
+        CHECK_EQ(r.failed.load(), 0u);
+        CHECK_EQ(device.dropped(), 0u);
+
+        std::printf("inject -> callback: p50 %.1f us, p99 %.1f us\n",
+                    r.latency.percentile(0.50) / 1e3, r.latency.percentile(0.99) / 1e3);
+
+        r.stop();
+        CHECK(!r.running());
+    }
+
+    // 设备缓冲满时丢最旧的，留下来的仍然有序
+    void test_overflow(io_pool& pool)
+    {
+        fake_hid_device device(8);
+        CHECK(device.bind(pool));
+
+        uint8_t report[REPORT_SIZE];
+        for (uint16_t seq = 0; seq < 20; seq++)
+        {
+            make_report(report, seq);
+            device.inject(report, sizeof(report));
+        }
+        CHECK_EQ(device.dropped(), 12u);
+
+        reader r(device);
+        CHECK(r.start());
+        CHECK(wait_for([&] { return r.received.load() == 8; }));
+        CHECK_EQ(r.outOfOrder.load(), 0u);
+    }
+
+    // stop() 取消挂起的读，被取消的完成不算错误
+    void test_stop_pending(io_pool& pool)
+    {
+        fake_hid_device device;
+        CHECK(device.bind(pool));
+
+        reader r(device);
+        for (int round = 0; round < 100; round++)
+        {
+            CHECK(r.start());
+            CHECK(r.running());
+            r.stop();
+            CHECK(!r.running());
+        }
+        CHECK_EQ(r.failed.load(), 0u);
+
+        // 停止后注入的报文留在设备缓冲里
+        uint8_t report[REPORT_SIZE];
+        make_report(report, 0);
+        device.inject(report, sizeof(report));
+        CHECK_EQ(r.received.load(), 0u);
+    }
+
+    // 手柄断开：挂起的读失败，循环自己结束
+    void test_disconnect(io_pool& pool)
+    {
+        fake_hid_device device;
+        CHECK(device.bind(pool));
+
+        reader r(device);
+        CHECK(r.start());
+
+        uint8_t report[REPORT_SIZE];
+        make_report(report, 0);
+        device.inject(report, sizeof(report));
+        CHECK(wait_for([&] { return r.received.load() == 1; }));
+
+        device.disconnect();
+        CHECK(wait_for([&] { return !r.running(); }));
+        CHECK_EQ(r.failed.load(), 1u);
+
+        // 断开后重新启动直接失败
+        CHECK(!r.start());
+        r.stop();
+    }
+
+    // 多个设备、多个注入线程共用两个池线程
+    void test_many_devices(io_pool& pool)
+    {
+        constexpr size_t DEVICES = 16;
+        constexpr uint16_t COUNT = 500;
+
+        std::vector<std::unique_ptr<fake_hid_device>> devices;
+        std::vector<std::unique_ptr<reader>> readers;
+        for (size_t i = 0; i < DEVICES; i++)
+        {
+            devices.push_back(std::make_unique<fake_hid_device>(COUNT));
+            CHECK(devices.back()->bind(pool));
+            readers.push_back(std::make_unique<reader>(*devices.back()));
+            CHECK(readers.back()->start());
+        }
+
+        std::vector<std::thread> injectors;
+        for (size_t t = 0; t < 4; t++)
+        {
+            injectors.emplace_back([&, t] {
+                uint8_t report[REPORT_SIZE];
+                for (uint16_t seq = 0; seq < COUNT; seq++)
+                {
+                    for (size_t i = t; i < DEVICES; i += 4)
+                    {
+                        make_report(report, seq);
+                        devices[i]->inject(report, sizeof(report));
+                    }
+                }
+            });
+        }
+        for (auto& t : injectors)
+            t.join();
+
+        for (size_t i = 0; i < DEVICES; i++)
+        {
+            CHECK(wait_for([&] { return readers[i]->received.load() == COUNT; }));
+            CHECK_EQ(readers[i]->outOfOrder.load(), 0u);
+        }
+
+        for (auto& r : readers)
+            r->stop();
+    }
+}
+
+int main()
+{
+    io_pool pool(2);
+    CHECK(pool.start());
+
+    test_in_order(pool);
+    test_overflow(pool);
+    test_stop_pending(pool);
+    test_disconnect(pool);
+    test_many_devices(pool);
+
+    pool.stop();
+    return check_result("hid_read_path_test");
+}
@@ -0,0 +1,218 @@
+#include "check.h"
+#include "fake_hid_device.h"
+#include "hid_writer.h"
+#include "io_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+//
+// hid_writer 与回环设备：写入顺序、队列满丢弃、通道归还与复用，
+// 以及慢速写期间读路径照常完成（读写不共享锁）
+//
+namespace
+{
+    using namespace std::chrono;
+
+    template <typename Pred>
+    bool wait_for(Pred pred)
+    {
+        const auto deadline = steady_clock::now() + seconds(10);
+        while (!pred())
+        {
+            if (steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(microseconds(100));
+        }
+        return true;
+    }
+
+    // 两个设备的报文各自按提交顺序写出，内容不变
+    void test_order()
+    {
+        fake_hid_device a;
+        fake_hid_device b;
+        hid_writer writer(0);
+        writer.start();
+
+        hid_writer::channel* ca = writer.open_channel(a);
+        hid_writer::channel* cb = writer.open_channel(b);
+        CHECK(ca && cb);
+        CHECK_EQ(writer.channel_count(), 2u);
+
+        constexpr int COUNT = 200;
+        uint8_t report[78] = { 0x31 };
+        for (int i = 0; i < COUNT; i++)
+        {
+            report[1] = static_cast<uint8_t>(i);
+            // 队列满时等写线程追上，这里只验证顺序
+            while (!ca->submit(report, sizeof(report)))
+                std::this_thread::yield();
+            report[2] = 0xBB;
+            while (!cb->submit(report, sizeof(report)))
+                std::this_thread::yield();
+            report[2] = 0;
+        }
+
+        CHECK(wait_for([&] { return a.written().size() == COUNT && b.written().size() == COUNT; }));
+
+        const auto wa = a.written();
+        const auto wb = b.written();
+        for (int i = 0; i < COUNT; i++)
+        {
+            CHECK_EQ(wa[i].size(), 78u);
+            CHECK_EQ(wa[i][1], static_cast<uint8_t>(i));
+            CHECK_EQ(wa[i][2], 0);
+            CHECK_EQ(wb[i][1], static_cast<uint8_t>(i));
+            CHECK_EQ(wb[i][2], 0xBB);
+        }
+
+        // 超长报文直接拒绝
+        uint8_t big[hid_writer::MAX_REPORT_SIZE + 1] = {};
+        CHECK(!ca->submit(big, sizeof(big)));
+
+        writer.close_channel(ca);
+        writer.close_channel(cb);
+        writer.stop();
+    }
+
+    // 写得慢时队列满就丢，写出的加丢弃的等于提交的
+    void test_drop_when_slow()
+    {
+        fake_hid_device device;
+        device.set_write_delay(milliseconds(2));
+
+        hid_writer writer(0);
+        writer.start();
+        hid_writer::channel* ch = writer.open_channel(device);
+
+        constexpr size_t COUNT = 100;
+        uint8_t report[78] = { 0x31 };
+        size_t accepted = 0;
+        for (size_t i = 0; i < COUNT; i++)
+            accepted += ch->submit(report, sizeof(report)) ? 1 : 0;
+
+        CHECK(ch->dropped() > 0);
+        CHECK_EQ(accepted + ch->dropped(), COUNT);
+        CHECK(wait_for([&] { return device.written().size() == accepted; }));
+
+        writer.close_channel(ch);
+        writer.stop();
+    }
+
+    // 归还通道：等写线程写完当前报文，丢弃积压，之后设备不再被写；通道可复用
+    void test_close_channel()
+    {
+        fake_hid_device device;
+        device.set_write_delay(milliseconds(5));
+
+        hid_writer writer(0);
+        writer.start();
+        hid_writer::channel* ch = writer.open_channel(device);
+
+        uint8_t report[78] = { 0x31 };
+        for (int i = 0; i < 10; i++)
+            ch->submit(report, sizeof(report));
+
+        CHECK(wait_for([&] { return ch->busy(); }));
+        writer.close_channel(ch);
+        CHECK(!ch->busy());
+        CHECK_EQ(writer.channel_count(), 0u);
+
+        const size_t written = device.written().size();
+        CHECK(written < 10);
+        std::this_thread::sleep_for(milliseconds(20));
+        CHECK_EQ(device.written().size(), written);
+
+        // 复用同一个通道，计数清零
+        fake_hid_device other;
+        hid_writer::channel* reopened = writer.open_channel(other);
+        CHECK(reopened == ch);
+        CHECK_EQ(reopened->dropped(), 0u);
+        CHECK(reopened->submit(report, sizeof(report)));
+        CHECK(wait_for([&] { return other.written().size() == 1; }));
+        CHECK_EQ(device.written().size(), written);
+
+        writer.close_channel(reopened);
+        writer.stop();
+    }
+
+    class reader : public io_loop
+    {
+    public:
+        reader(hid_device_io& device, hid_writer::channel& channel) : device_(device), channel_(channel) {}
+        ~reader() { stop(); }
+
+        std::atomic<size_t> received = 0;
+        std::atomic<size_t> overlapped = 0;  // 到达时写线程正在写同一设备
+
+    private:
+        bool issue() override { return device_.read_async(buffer_, sizeof(buffer_), *this); }
+        void cancel() override { device_.cancel_read(); }
+
+        bool completed(bool ok, size_t) override
+        {
+            if (!ok)
+                return false;
+            if (channel_.busy())
+                overlapped++;
+            received++;
+            return true;
+        }
+
+        hid_device_io& device_;
+        hid_writer::channel& channel_;
+        uint8_t buffer_[128] = {};
+    };
+
+    // 同一设备上的写阻塞几毫秒时，输入报文照常送达
+    void test_read_during_write()
+    {
+        io_pool pool(2);
+        CHECK(pool.start());
+
+        fake_hid_device device(256);
+        device.set_write_delay(milliseconds(3));
+        CHECK(device.bind(pool));
+
+        hid_writer writer(0);
+        writer.start();
+        hid_writer::channel* ch = writer.open_channel(device);
+
+        reader r(device, *ch);
+        CHECK(r.start());
+
+        uint8_t output[78] = { 0x31 };
+        uint8_t input[78] = { 0x31 };
+        constexpr size_t READS = 100;
+        for (size_t i = 0; i < READS; i++)
+        {
+            if (i % 4 == 0)
+                ch->submit(output, sizeof(output));
+            device.inject(input, sizeof(input));
+            std::this_thread::sleep_for(microseconds(500));
+        }
+
+        CHECK(wait_for([&] { return r.received.load() == READS; }));
+        std::printf("reads completed during a write: %zu of %zu\n", r.overlapped.load(), READS);
+        CHECK(r.overlapped.load() > 0);
+
+        r.stop();
+        writer.close_channel(ch);
+        writer.stop();
+        pool.stop();
+    }
+}
+
+int main()
+{
+    test_order();
+    test_drop_when_slow();
+    test_close_channel();
+    test_read_during_write();
+
+    return check_result("hid_writer_test");
+}
@@ -0,0 +1,134 @@
+#include "check.h"
+
+#include <InputSlot.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+//
+// InputSlot protocol model: the feeder publishes on one thread, the bus
+// polls on another. Every report the reader accepts must be one the
+// feeder wrote in full, and sequences must only move forward.
+//
+namespace
+{
+	using namespace ViGEm::Reports;
+
+	void fill(unsigned char* report, unsigned char value)
+	{
+		std::memset(report, value, InputSlotReportSize);
+	}
+
+	bool uniform(const unsigned char* report)
+	{
+		for (unsigned int i = 1; i < InputSlotReportSize; i++)
+		{
+			if (report[i] != report[0])
+				return false;
+		}
+		return true;
+	}
+
+	void test_single_thread()
+	{
+		INPUT_SLOT slot = {};
+		unsigned char report[InputSlotReportSize];
+		unsigned char read[InputSlotReportSize];
+		long last = 0;
+
+		CHECK(ReadInputSlot(&slot, read, sizeof(read), &last) == InputSlotRead::Unchanged);
+
+		fill(report, 0x5A);
+		PublishInputSlot(&slot, report, sizeof(report));
+		CHECK_EQ(slot.Sequence, 2);
+		CHECK(ReadInputSlot(&slot, read, sizeof(read), &last) == InputSlotRead::Updated);
+		CHECK_EQ(last, 2);
+		CHECK(std::memcmp(read, report, sizeof(report)) == 0);
+		CHECK(ReadInputSlot(&slot, read, sizeof(read), &last) == InputSlotRead::Unchanged);
+
+		// Short publish only touches the first bytes
+		const unsigned char head[4] = { 1, 2, 3, 4 };
+		PublishInputSlot(&slot, head, sizeof(head));
+		CHECK(ReadInputSlot(&slot, read, sizeof(read), &last) == InputSlotRead::Updated);
+		CHECK_EQ(read[3], 4);
+		CHECK_EQ(read[4], 0x5A);
+
+		// Oversized lengths are clamped to the slot
+		unsigned char big[InputSlotReportSize + 16];
+		std::memset(big, 0x77, sizeof(big));
+		PublishInputSlot(&slot, big, sizeof(big));
+		CHECK(ReadInputSlot(&slot, big, sizeof(big), &last) == InputSlotRead::Updated);
+		CHECK_EQ(slot.Reserved, 0u);
+
+		// A feeder stuck mid-write never blocks the reader
+		slot.Sequence = slot.Sequence + 1;
+		CHECK(ReadInputSlot(&slot, read, sizeof(read), &last) == InputSlotRead::Torn);
+		slot.Sequence = slot.Sequence + 1;
+		CHECK(ReadInputSlot(&slot, read, sizeof(read), &last) == InputSlotRead::Updated);
+	}
+
+	void test_concurrent()
+	{
+		INPUT_SLOT slot = {};
+		constexpr unsigned int PUBLISHES = 200000;
+		std::atomic<bool> done = false;
+
+		std::thread feeder([&] {
+			unsigned char report[InputSlotReportSize];
+			for (unsigned int i = 1; i <= PUBLISHES; i++)
+			{
+				fill(report, static_cast<unsigned char>(i));
+				PublishInputSlot(&slot, report, sizeof(report));
+
+				// Let the reader in regularly even on a single core
+				if (i % 16 == 0)
+					std::this_thread::yield();
+			}
+			done = true;
+		});
+
+		unsigned char read[InputSlotReportSize];
+		long last = 0;
+		unsigned long long updated = 0, torn = 0, inconsistent = 0, backwards = 0;
+
+		while (!done.load())
+		{
+			const long before = last;
+			switch (ReadInputSlot(&slot, read, sizeof(read), &last))
+			{
+			case InputSlotRead::Updated:
+				updated++;
+				inconsistent += uniform(read) ? 0 : 1;
+				backwards += (last > before && (last & 1) == 0) ? 0 : 1;
+				break;
+			case InputSlotRead::Torn:
+				torn++;
+				break;
+			case InputSlotRead::Unchanged:
+				std::this_thread::yield();
+				break;
+			}
+		}
+		feeder.join();
+
+		// The final report is always picked up once the feeder is quiet
+		CHECK(ReadInputSlot(&slot, read, sizeof(read), &last) != InputSlotRead::Torn);
+		CHECK_EQ(last, static_cast<long>(2 * PUBLISHES));
+		CHECK_EQ(read[0], static_cast<unsigned char>(PUBLISHES));
+
+		std::printf("concurrent: %llu updated, %llu torn of %u publishes\n", updated, torn, PUBLISHES);
+		CHECK_EQ(inconsistent, 0u);
+		CHECK_EQ(backwards, 0u);
+	}
+}
+
+int main()
+{
+	test_single_thread();
+	test_concurrent();
+
+	return check_result("input_slot_test");
+}
@@ -0,0 +1,202 @@
+#include "check.h"
+
+#include <IsoPacer.h>
+
+#include <deque>
+#include <random>
+
+//
+// IsoOutPacer on a fake microframe clock, run the way ServiceIsoOut runs
+// it: the host keeps a few URBs queued, each URB gets its due time when
+// queued, and a timer pass completes every URB at the head that is due.
+// Checks packets per frame, catch-up after late passes and re-anchoring
+// after the host pauses.
+//
+namespace
+{
+	using ViGEm::Audio::IsoOutPacer;
+	using ViGEm::Audio::IsoOutResyncFrames;
+	using ViGEm::Timing::MicroframesPerFrame;
+
+	constexpr long long FRAME = MicroframesPerFrame;
+
+	struct urb
+	{
+		long long due;
+		unsigned long packets;
+	};
+
+	struct stream
+	{
+		IsoOutPacer pacer;
+		std::deque<urb> queue;
+		unsigned long long completedPackets = 0;
+
+		stream()
+		{
+			pacer.Init();
+		}
+
+		void submit(long long now, unsigned long packets)
+		{
+			queue.push_back({ pacer.Schedule(now, packets), packets });
+		}
+
+		// One timer pass, returns the URBs completed
+		unsigned long pass(long long now)
+		{
+			unsigned long completed = 0;
+
+			while (!queue.empty() && queue.front().due <= now)
+			{
+				pacer.Complete(now, queue.front().due, queue.front().packets);
+				completedPackets += queue.front().packets;
+				queue.pop_front();
+				completed++;
+			}
+
+			pacer.RecordPass(completed != 0);
+
+			return completed;
+		}
+	};
+
+	void test_schedule()
+	{
+		IsoOutPacer pacer;
+		pacer.Init();
+
+		// Due at the end of each URB's last frame, counted from the start
+		CHECK_EQ(pacer.Schedule(100, 10), 100 + 10 * FRAME);
+		CHECK_EQ(pacer.Schedule(104, 8), 100 + 18 * FRAME);
+		CHECK_EQ(pacer.Schedule(150, 12), 100 + 30 * FRAME);
+		CHECK_EQ(pacer.Resyncs, 0u);
+
+		// Still within IsoOutResyncFrames of the last due time: same stream
+		const long long lastDue = 100 + 30 * FRAME;
+		CHECK_EQ(pacer.Schedule(lastDue + IsoOutResyncFrames * FRAME, 10), lastDue + 10 * FRAME);
+		CHECK_EQ(pacer.Resyncs, 0u);
+
+		// Later than that: the stream restarts at now
+		const long long restart = lastDue + 10 * FRAME + IsoOutResyncFrames * FRAME + 1;
+		CHECK_EQ(pacer.Schedule(restart, 10), restart + 10 * FRAME);
+		CHECK_EQ(pacer.Resyncs, 1u);
+		CHECK_EQ(pacer.Anchor, restart);
+	}
+
+	void test_packets_per_frame()
+	{
+		// 10 s of mixed URB sizes, host three URBs ahead, a pass every
+		// frame with up to 3 ms of jitter
+		stream s;
+		std::mt19937 rng(21);
+		const unsigned long sizes[] = { 8, 10, 12, 20 };
+
+		long long now = 0;
+		long long maxDrift = 0, minDrift = 0;
+		unsigned long long lastSecond = 0;
+		unsigned long badSeconds = 0;
+
+		for (long long frame = 1; frame <= 10000; frame++)
+		{
+			while (s.queue.size() < 3)
+				s.submit(now, sizes[rng() % 4]);
+
+			const long long fire = frame * FRAME + rng() % (3 * FRAME);
+			now = fire > now ? fire : now;
+			s.pass(now);
+
+			const long long drift = s.pacer.DriftFrames(now);
+			maxDrift = drift > maxDrift ? drift : maxDrift;
+			minDrift = drift < minDrift ? drift : minDrift;
+
+			// About 1000 packets each second, whatever the URB sizes
+			if (frame % 1000 == 0)
+			{
+				const unsigned long long packets = s.completedPackets - lastSecond;
+				badSeconds += (packets + 25 >= 1000 && packets <= 1000 + 25) ? 0 : 1;
+				lastSecond = s.completedPackets;
+			}
+		}
+
+		CHECK_EQ(badSeconds, 0u);
+
+		// Never ahead of real time, never more than the jitter plus one URB
+		// behind, and it doesn't add up
+		CHECK(maxDrift <= 0);
+		CHECK(minDrift >= -(3 + 20));
+		CHECK_EQ(s.pacer.Resyncs, 0u);
+		CHECK(s.pacer.Passes == 10000u);
+		CHECK(s.pacer.UsefulPasses > 0 && s.pacer.UsefulPasses < s.pacer.Passes);
+	}
+
+	void test_late_pass()
+	{
+		stream s;
+		long long now = 0;
+
+		// Ten 10-packet URBs queued up front
+		for (int i = 0; i < 10; i++)
+			s.submit(now, 10);
+
+		// On time: one URB per 10 frames
+		for (long long frame = 1; frame <= 20; frame++)
+		{
+			now = frame * FRAME;
+			s.pass(now);
+		}
+		CHECK_EQ(s.completedPackets, 20u);
+		CHECK_EQ(s.pacer.LateCompletions, 0u);
+		CHECK_EQ(s.pacer.MaxLateness, 0);
+
+		// The next pass comes 35 ms late and catches up on everything due
+		// meanwhile in one go
+		now += 35 * FRAME;
+		CHECK_EQ(s.pass(now), 3u);
+		CHECK_EQ(s.completedPackets, 50u);
+		CHECK_EQ(s.pacer.LateCompletions, 3u);
+		CHECK_EQ(s.pacer.MaxLateness, 25 * FRAME);
+		CHECK_EQ(s.pacer.DriftFrames(now), -5);
+
+		// Due times didn't move: back to one URB per 10 frames on the
+		// original grid, no drift left
+		const long long resume = now;
+		unsigned long completed = 0;
+		for (now = resume + 1; now <= 100 * FRAME; now++)
+			completed += s.pass(now);
+
+		CHECK_EQ(completed, 5u);
+		CHECK_EQ(s.completedPackets, 100u);
+		CHECK_EQ(s.pacer.DriftFrames(100 * FRAME), 0);
+		CHECK(s.queue.empty());
+		CHECK_EQ(s.pacer.Resyncs, 0u);
+	}
+
+	void test_host_pause()
+	{
+		stream s;
+		s.submit(0, 10);
+		s.pass(10 * FRAME);
+
+		// Host comes back long after the last due time: the new URB is
+		// paced from now rather than completed at once as overdue
+		const long long back = 10 * FRAME + 50 * FRAME;
+		CHECK_EQ(s.pacer.Schedule(back, 10), back + 10 * FRAME);
+		CHECK_EQ(s.pacer.Resyncs, 1u);
+		CHECK_EQ(s.pacer.DriftFrames(back), 0);
+
+		s.pacer.ResetStatistics();
+		CHECK_EQ(s.pacer.Resyncs, 0u);
+		CHECK_EQ(s.pacer.Passes, 0u);
+	}
+}
+
+int main()
+{
+	test_schedule();
+	test_packets_per_frame();
+	test_late_pass();
+	test_host_pause();
+
+	return check_result("iso_pacer_test");
+}
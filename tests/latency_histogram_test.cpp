@@ -0,0 +1,157 @@
+#include "check.h"
+#include "latency_histogram.h"
+
+#include <LatencyHistogram.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <random>
+#include <vector>
+
+//
+// LatencyHistogram fed known deltas: percentiles are the floor of the
+// bucket holding the exact rank, buckets are within 25% of the value,
+// the maximum is exact. Also the QPC tick to nanosecond path the DS5
+// target records through, and the app's wrapper.
+//
+namespace
+{
+	using ViGEm::Stats::LatencyHistogram;
+	using ViGEm::Stats::LatencySummary;
+
+	unsigned long long floor_of(unsigned long long value)
+	{
+		return LatencyHistogram::BucketFloor(LatencyHistogram::BucketOf(value));
+	}
+
+	// Nearest-rank percentile of the raw samples
+	unsigned long long exact_percentile(std::vector<unsigned long long> samples, unsigned int ppm)
+	{
+		std::sort(samples.begin(), samples.end());
+		unsigned long long rank = (samples.size() * ppm + 999999ULL) / 1000000ULL;
+		rank = std::max(rank, 1ULL);
+		return samples[rank - 1];
+	}
+
+	void test_buckets()
+	{
+		// Exact below the first power-of-two range
+		for (unsigned long long v = 0; v < LatencyHistogram::Linear; v++)
+			CHECK_EQ(floor_of(v), v);
+
+		CHECK_EQ(floor_of(100), 96u);
+		CHECK_EQ(floor_of(1000000), 917504u);
+
+		// Within 25% everywhere, bucket floors map back to themselves
+		std::mt19937_64 rng(9);
+		unsigned long wrong = 0;
+		for (int i = 0; i < 100000; i++)
+		{
+			const unsigned long long v = rng() >> (rng() % 64);
+			const unsigned long long f = floor_of(v);
+			wrong += (f <= v && v - f <= f / 4) ? 0 : 1;
+			wrong += floor_of(f) == f ? 0 : 1;
+		}
+		CHECK_EQ(wrong, 0u);
+		CHECK(LatencyHistogram::BucketOf(~0ULL) < LatencyHistogram::Buckets);
+	}
+
+	void test_known_deltas()
+	{
+		LatencyHistogram histogram;
+		CHECK_EQ(histogram.Percentile(500000), 0u);
+		CHECK_EQ(histogram.Max(), 0u);
+
+		// 99 deliveries at 100 ns and one stall at 1 ms
+		for (int i = 0; i < 99; i++)
+			histogram.Record(100);
+		histogram.Record(1000000);
+
+		const LatencySummary summary = histogram.Summarize();
+		CHECK_EQ(summary.Count, 100u);
+		CHECK_EQ(summary.P50, 96u);
+		CHECK_EQ(summary.P99, 96u);
+		CHECK_EQ(summary.P999, 917504u);
+		CHECK_EQ(summary.Max, 1000000u);
+
+		histogram.Reset();
+		CHECK_EQ(histogram.Count(), 0u);
+		CHECK_EQ(histogram.Summarize().P50, 0u);
+		CHECK_EQ(histogram.Max(), 0u);
+	}
+
+	void test_against_samples()
+	{
+		// Log-normal-ish delays around 1 ms, percentiles land in the same
+		// bucket as the exact nearest-rank value
+		std::mt19937_64 rng(10);
+		std::lognormal_distribution<double> delay(13.8, 0.6);
+		std::vector<unsigned long long> samples;
+		LatencyHistogram histogram;
+
+		for (int i = 0; i < 50000; i++)
+		{
+			const auto ns = static_cast<unsigned long long>(delay(rng));
+			samples.push_back(ns);
+			histogram.Record(ns);
+		}
+
+		for (const unsigned int ppm : { 500000u, 990000u, 999000u })
+			CHECK_EQ(histogram.Percentile(ppm), floor_of(exact_percentile(samples, ppm)));
+
+		CHECK_EQ(histogram.Max(), *std::max_element(samples.begin(), samples.end()));
+	}
+
+	void test_qpc_deltas()
+	{
+		// RecordReportDelivered: submit and URB completion stamped on a
+		// 10 MHz counter, converted to nanoseconds
+		constexpr unsigned long long freq = 10000000;
+		const unsigned long long deltas[] = { 5000, 6000, 7000, 8000, 60000 };  // 0.5 to 6 ms
+		LatencyHistogram histogram;
+		unsigned long long cachedAt = 123456789;
+
+		for (int round = 0; round < 20; round++)
+		{
+			for (const unsigned long long delta : deltas)
+			{
+				const unsigned long long deliveredAt = cachedAt + delta;
+				histogram.Record((deliveredAt - cachedAt) * 1000000000ULL / freq);
+				cachedAt = deliveredAt + 1000;
+			}
+		}
+
+		const LatencySummary summary = histogram.Summarize();
+		CHECK_EQ(summary.Count, 100u);
+		CHECK_EQ(summary.P50, floor_of(700000));
+		CHECK_EQ(summary.P99, floor_of(6000000));
+		CHECK_EQ(summary.Max, 6000000u);
+	}
+
+	void test_app_wrapper()
+	{
+		latency_histogram histogram;
+		for (uint64_t ns = 1; ns <= 1000; ns++)
+			histogram.record(ns);
+
+		CHECK_EQ(histogram.count(), 1000u);
+		CHECK_EQ(histogram.max(), 1000u);
+		CHECK_EQ(histogram.percentile(0.50), floor_of(500));
+		CHECK_EQ(histogram.percentile(0.99), floor_of(990));
+		CHECK_EQ(histogram.percentile(0.999), floor_of(999));
+
+		histogram.reset();
+		CHECK_EQ(histogram.count(), 0u);
+	}
+}
+
+int main()
+{
+	test_buckets();
+	test_known_deltas();
+	test_against_samples();
+	test_qpc_deltas();
+	test_app_wrapper();
+
+	return check_result("latency_histogram_test");
+}
@@ -0,0 +1,172 @@
+#include "check.h"
+
+#include <NotificationBacklog.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+//
+// NotificationBacklog byte accounting, driven the way the bus' per-target
+// NotificationChannel drives it: an await either takes a backlog entry or
+// is parked, a notification either completes the oldest parked await or
+// goes to the backlog. Every copy must move only the header plus the
+// captured audio, never the whole maximum-size structure.
+//
+namespace
+{
+	using namespace ViGEm::Notifications;
+
+	constexpr unsigned long AUDIO_HEADER = 12;  // Size, SerialNo, AudioDataLength
+	constexpr unsigned long AUDIO_MAX = 4096;
+	constexpr unsigned long ENTRY_SIZE = AUDIO_HEADER + AUDIO_MAX;
+	constexpr unsigned long BACKLOG = 4;
+
+	struct completion
+	{
+		std::vector<unsigned char> data;
+	};
+
+	// User-mode stand-in for NotificationChannel
+	class channel_model
+	{
+	public:
+		// Returns true when the await completed at once from the backlog
+		bool await(completion& target)
+		{
+			target.data.assign(ENTRY_SIZE, 0);
+			unsigned long length;
+			if (backlog.Take(target.data.data(), &length))
+			{
+				target.data.resize(length);
+				return true;
+			}
+			parked.push_back(&target);
+			return false;
+		}
+
+		void deliver(const unsigned char* data, unsigned long length)
+		{
+			if (!parked.empty())
+			{
+				completion* target = parked.front();
+				parked.pop_front();
+				backlog.CountRouted(length);
+				target->data.assign(data, data + length);
+				return;
+			}
+			backlog.Store(data, length);
+		}
+
+		NotificationBacklog<ENTRY_SIZE, BACKLOG> backlog;
+		std::deque<completion*> parked;
+	};
+
+	std::vector<unsigned char> make_urb(unsigned long audioLength, unsigned char tag)
+	{
+		std::vector<unsigned char> urb(AUDIO_HEADER + audioLength, tag);
+		std::memcpy(urb.data() + 8, &audioLength, sizeof(uint32_t));
+		return urb;
+	}
+
+	void test_routed_bytes()
+	{
+		channel_model channel;
+		unsigned long long expected = 0;
+		unsigned long long fixed = 0;
+
+		// Captured length varies per 10 ms URB (384 bytes per 1 ms packet)
+		for (unsigned int i = 0; i < 100; i++)
+		{
+			completion c;
+			CHECK(!channel.await(c));
+
+			const unsigned long audio = 384 * (1 + i % 10);
+			const auto urb = make_urb(audio, static_cast<unsigned char>(i));
+			channel.deliver(urb.data(), static_cast<unsigned long>(urb.size()));
+
+			CHECK(c.data == urb);
+			expected += urb.size();
+			fixed += ENTRY_SIZE;
+		}
+
+		const auto stats = channel.backlog.TakeStatistics();
+		CHECK_EQ(stats.Routed, 100u);
+		CHECK_EQ(stats.Buffered, 0u);
+		CHECK_EQ(stats.BytesCopied, expected);
+		std::printf("routed: %llu bytes copied, %llu with fixed-size completions (%.1fx)\n",
+			stats.BytesCopied, fixed, static_cast<double>(fixed) / stats.BytesCopied);
+
+		// Counters restart after TakeStatistics
+		CHECK_EQ(channel.backlog.TakeStatistics().BytesCopied, 0u);
+	}
+
+	void test_backlog()
+	{
+		channel_model channel;
+
+		// Nobody has awaited yet: nothing is kept
+		auto urb = make_urb(100, 1);
+		channel.deliver(urb.data(), static_cast<unsigned long>(urb.size()));
+		CHECK_EQ(channel.backlog.Count(), 0u);
+
+		completion first;
+		CHECK(!channel.await(first));
+		channel.deliver(urb.data(), static_cast<unsigned long>(urb.size()));
+		CHECK(first.data == urb);
+
+		// Six URBs with no await parked: the two oldest are dropped
+		for (unsigned char tag = 10; tag < 16; tag++)
+		{
+			urb = make_urb(64u * tag, tag);
+			channel.deliver(urb.data(), static_cast<unsigned long>(urb.size()));
+		}
+		CHECK_EQ(channel.backlog.Count(), BACKLOG);
+
+		unsigned long long taken = 0;
+		for (unsigned char tag = 12; tag < 16; tag++)
+		{
+			completion c;
+			CHECK(channel.await(c));
+			CHECK(c.data == make_urb(64u * tag, tag));
+			taken += c.data.size();
+		}
+
+		const auto stats = channel.backlog.TakeStatistics();
+		CHECK_EQ(stats.Routed, 1u);
+		CHECK_EQ(stats.Buffered, 6u);
+		CHECK_EQ(stats.Dropped, 2u);
+		CHECK_EQ(stats.BytesCopied, (AUDIO_HEADER + 100) + taken);
+
+		// Empty again: the next await parks
+		completion last;
+		CHECK(!channel.await(last));
+		CHECK_EQ(channel.parked.size(), 1u);
+	}
+
+	void test_oversized_store()
+	{
+		channel_model channel;
+		completion c;
+		channel.await(c);
+		channel.deliver(make_urb(10, 0).data(), AUDIO_HEADER + 10);
+
+		std::vector<unsigned char> big(ENTRY_SIZE + 100, 0xEE);
+		channel.deliver(big.data(), static_cast<unsigned long>(big.size()));
+
+		completion clamped;
+		CHECK(channel.await(clamped));
+		CHECK_EQ(clamped.data.size(), ENTRY_SIZE);
+	}
+}
+
+int main()
+{
+	test_routed_bytes();
+	test_backlog();
+	test_oversized_store();
+
+	return check_result("notification_backlog_test");
+}
@@ -0,0 +1,142 @@
+#include "check.h"
+#include "output_checksum.h"
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+//
+// 增量校验（output_report_checksum）与整帧逐位重算对照，
+// 以及 crc32_shift / combine / patch / crc32_shifter 的代数性质
+//
+namespace
+{
+    constexpr size_t REPORT_SIZE = 78;   // 蓝牙输出报文 0x31
+
+    uint32_t crc32_bitwise(uint32_t state, const uint8_t* data, size_t size)
+    {
+        while (size--)
+        {
+            state ^= *data++;
+            for (unsigned i = 0; i < 8; i++)
+                state = (state >> 1) ^ (0xEDB88320 & (0u - (state & 1)));
+        }
+        return state;
+    }
+
+    // 原 fill_output_report_checksum 的结果：0xA2 种子，逐位计算
+    uint32_t reference_checksum(const uint8_t* report, size_t len)
+    {
+        const uint8_t a2 = 0xA2;
+        return ~crc32_bitwise(crc32_bitwise(~0u, &a2, 1), report, len - 4);
+    }
+
+    uint32_t stored_checksum(const uint8_t* report, size_t len)
+    {
+        return report[len - 4] | (report[len - 3] << 8) | (report[len - 2] << 16) |
+               (static_cast<uint32_t>(report[len - 1]) << 24);
+    }
+
+    void test_algebra(std::mt19937& rng)
+    {
+        std::vector<uint8_t> data(512);
+        for (auto& b : data)
+            b = static_cast<uint8_t>(rng());
+
+        const std::vector<uint8_t> zeros(512, 0);
+
+        for (size_t length : { 0, 1, 3, 16, 70, 255, 512 })
+        {
+            const uint32_t state = static_cast<uint32_t>(rng());
+
+            // shift 等价于喂 0x00
+            CHECK_EQ(crc32_shift(state, length), crc32_bitwise(state, zeros.data(), length));
+            CHECK_EQ(crc32_shifter(length)(state), crc32_shift(state, length));
+
+            // combine：A || B
+            const size_t split = length / 3;
+            const uint32_t a = crc32_bitwise(state, data.data(), split);
+            const uint32_t b = crc32_bitwise(0, data.data() + split, length - split);
+            CHECK_EQ(crc32_combine(a, b, length - split), crc32_bitwise(state, data.data(), length));
+        }
+
+        // patch：改动中间 6 字节
+        std::vector<uint8_t> changed = data;
+        for (size_t i = 100; i < 106; i++)
+            changed[i] = static_cast<uint8_t>(rng());
+
+        const uint32_t before = crc32_bitwise(~0u, data.data(), 300);
+        CHECK_EQ(crc32_patch(before, data.data() + 100, changed.data() + 100, 6, 300 - 106),
+                 crc32_bitwise(~0u, changed.data(), 300));
+    }
+
+    void test_sequence(std::mt19937& rng)
+    {
+        output_report_checksum checksum(REPORT_SIZE);
+
+        uint8_t report[REPORT_SIZE] = {};
+        report[0] = 0x31;
+        report[2] = 0x10;
+        for (size_t i = 3; i < REPORT_SIZE - 4; i++)
+            report[i] = static_cast<uint8_t>(rng());
+
+        uint8_t seq = 0;
+
+        for (int frame = 0; frame < 5000; frame++)
+        {
+            // 每帧序号 +1，按概率改动马达 / 灯条 / 其他字节 / 报文头
+            report[1] = static_cast<uint8_t>(seq++ << 4);
+
+            const unsigned roll = rng() % 16;
+            if (roll < 6)
+                report[3 + rng() % 4] = static_cast<uint8_t>(rng());
+            else if (roll < 10)
+                report[44 + rng() % 6] = static_cast<uint8_t>(rng());
+            else if (roll < 12)
+                report[10 + rng() % 30] = static_cast<uint8_t>(rng());
+            else if (roll == 12)
+                report[1] |= 0x01;          // 序号字节低位被占用，必须整帧重算
+
+            checksum.fill(report);
+            CHECK_EQ(stored_checksum(report, REPORT_SIZE), reference_checksum(report, REPORT_SIZE));
+
+            report[1] &= 0xF0;
+        }
+
+        // 绝大部分帧应走增量路径
+        CHECK(checksum.patched() > checksum.recomputed());
+        CHECK_EQ(checksum.patched() + checksum.recomputed(), 5000u);
+
+        // 非 0x31 报文也能正确计算
+        uint8_t other[REPORT_SIZE];
+        for (auto& b : other)
+            b = static_cast<uint8_t>(rng());
+        checksum.fill(other);
+        CHECK_EQ(stored_checksum(other, REPORT_SIZE), reference_checksum(other, REPORT_SIZE));
+    }
+
+    void test_fill_function(std::mt19937& rng)
+    {
+        for (size_t len : { 10, 78, 141, 547 })
+        {
+            std::vector<uint8_t> report(len);
+            for (auto& b : report)
+                b = static_cast<uint8_t>(rng());
+
+            fill_output_report_checksum(report.data(), len);
+            CHECK_EQ(stored_checksum(report.data(), len), reference_checksum(report.data(), len));
+        }
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(2);
+
+    test_algebra(rng);
+    test_sequence(rng);
+    test_fill_function(rng);
+
+    return check_result("output_checksum_test");
+}
@@ -0,0 +1,306 @@
+#include "check.h"
+#include "output_receiver.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// output_receiver 与模拟的通知源：按 DMF 通知模块的规则，每次广播完成一个
+// 挂起的请求，没有挂起的请求时先缓存。检查按序分发、退订、停止时排空
+// 所有挂起的请求，以及源失效时接收线程退出。
+//
+namespace
+{
+    using namespace std::chrono;
+
+    template <typename Pred>
+    bool wait_for(Pred pred)
+    {
+        const auto deadline = steady_clock::now() + seconds(10);
+        while (!pred())
+        {
+            if (steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(microseconds(100));
+        }
+        return true;
+    }
+
+    output_report make_report(uint32_t sequence)
+    {
+        output_report report = {};
+        std::memcpy(&report, &sequence, sizeof(sequence));
+        return report;
+    }
+
+    uint32_t sequence_of(const output_report& report)
+    {
+        uint32_t sequence;
+        std::memcpy(&sequence, &report, sizeof(sequence));
+        return sequence;
+    }
+
+    class fake_notifier : public output_source
+    {
+    public:
+        static constexpr unsigned DEPTH = 4;
+
+        unsigned capacity() const override { return DEPTH; }
+
+        bool post(unsigned slot) override
+        {
+            std::scoped_lock lock(mutex_);
+            if (slot >= DEPTH || inFlight_[slot])
+            {
+                misuse_++;
+                return false;
+            }
+
+            inFlight_[slot] = true;
+            posts_++;
+
+            // 有缓存的报文时请求立即完成
+            if (!backlog_.empty())
+            {
+                complete(slot, backlog_.front().first, backlog_.front().second);
+                backlog_.pop_front();
+            }
+            else
+                pending_.push_back(slot);
+            return true;
+        }
+
+        bool wait(completion& done) override
+        {
+            std::unique_lock lock(mutex_);
+            cv_.wait(lock, [this] { return !done_.empty() || failed_; });
+            if (done_.empty())
+                return false;
+
+            done = done_.front();
+            done_.pop_front();
+            inFlight_[done.slot] = false;
+            return true;
+        }
+
+        void cancel() override
+        {
+            std::scoped_lock lock(mutex_);
+            while (!pending_.empty())
+            {
+                completion c;
+                c.slot = pending_.front();
+                pending_.pop_front();
+                done_.push_back(c);
+                cancelled_++;
+            }
+            cv_.notify_all();
+        }
+
+        void broadcast(uint32_t serial, const output_report& report)
+        {
+            std::scoped_lock lock(mutex_);
+            if (pending_.empty())
+            {
+                backlog_.emplace_back(serial, report);
+                return;
+            }
+
+            complete(pending_.front(), serial, report);
+            pending_.pop_front();
+        }
+
+        void fail()
+        {
+            std::scoped_lock lock(mutex_);
+            failed_ = true;
+            cv_.notify_all();
+        }
+
+        unsigned pending() const
+        {
+            std::scoped_lock lock(mutex_);
+            return static_cast<unsigned>(pending_.size());
+        }
+
+        unsigned in_flight() const
+        {
+            std::scoped_lock lock(mutex_);
+            unsigned n = 0;
+            for (const bool f : inFlight_)
+                n += f ? 1 : 0;
+            return n;
+        }
+
+        unsigned misuse() const { std::scoped_lock lock(mutex_); return misuse_; }
+        unsigned cancelled() const { std::scoped_lock lock(mutex_); return cancelled_; }
+        uint64_t posts() const { std::scoped_lock lock(mutex_); return posts_; }
+
+    private:
+        void complete(unsigned slot, uint32_t serial, const output_report& report)
+        {
+            completion c;
+            c.slot = slot;
+            c.ok = true;
+            c.serial = serial;
+            c.report = report;
+            done_.push_back(c);
+            cv_.notify_all();
+        }
+
+        mutable std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<unsigned> pending_;
+        std::deque<completion> done_;
+        std::deque<std::pair<uint32_t, output_report>> backlog_;
+        bool inFlight_[DEPTH] = {};
+        bool failed_ = false;
+        unsigned misuse_ = 0;
+        unsigned cancelled_ = 0;
+        uint64_t posts_ = 0;
+    };
+
+    // 4 个订阅的序列号加一个没人订阅的，交错广播；每个订阅者按序收到全部报文
+    void test_in_order()
+    {
+        fake_notifier source;
+        output_receiver receiver(source);
+
+        constexpr uint32_t SERIALS = 4;
+        constexpr uint32_t PER_SERIAL = 2000;
+        std::mutex m;
+        std::map<uint32_t, std::vector<uint32_t>> received;
+
+        for (uint32_t serial = 1; serial <= SERIALS; serial++)
+        {
+            receiver.subscribe(serial, [&, serial](const output_report& report) {
+                std::scoped_lock lock(m);
+                received[serial].push_back(sequence_of(report));
+            });
+        }
+
+        receiver.start();
+        CHECK(wait_for([&] { return source.pending() == fake_notifier::DEPTH; }));
+
+        for (uint32_t i = 0; i < PER_SERIAL; i++)
+        {
+            for (uint32_t serial = 1; serial <= SERIALS; serial++)
+                source.broadcast(serial, make_report(i));
+            source.broadcast(99, make_report(i));
+
+            // 偶尔让接收线程追上，也覆盖请求全部挂起时的缓存路径
+            if (i % 64 == 0)
+                std::this_thread::yield();
+        }
+
+        CHECK(wait_for([&] {
+            std::scoped_lock lock(m);
+            for (uint32_t serial = 1; serial <= SERIALS; serial++)
+            {
+                if (received[serial].size() != PER_SERIAL)
+                    return false;
+            }
+            return true;
+        }));
+
+        // 补投始终保持 DEPTH 个请求挂起
+        CHECK(wait_for([&] { return source.pending() == fake_notifier::DEPTH; }));
+        receiver.stop();
+
+        unsigned outOfOrder = 0;
+        for (uint32_t serial = 1; serial <= SERIALS; serial++)
+        {
+            const auto& got = received[serial];
+            CHECK_EQ(got.size(), PER_SERIAL);
+            for (size_t i = 0; i < got.size(); i++)
+                outOfOrder += got[i] == i ? 0 : 1;
+        }
+        CHECK_EQ(outOfOrder, 0u);
+        CHECK_EQ(received.count(99), 0u);
+
+        // 初始投递加上每个完成一次补投，没有重复投递同一个 slot
+        CHECK_EQ(source.posts(), fake_notifier::DEPTH + (SERIALS + 1) * PER_SERIAL);
+        CHECK_EQ(source.misuse(), 0u);
+    }
+
+    // unsubscribe 返回后回调不再被调用，其他订阅者不受影响
+    void test_unsubscribe()
+    {
+        fake_notifier source;
+        output_receiver receiver(source);
+        std::atomic<unsigned> a = 0, b = 0;
+
+        receiver.subscribe(1, [&](const output_report&) { a++; });
+        receiver.subscribe(2, [&](const output_report&) { b++; });
+        receiver.start();
+
+        source.broadcast(1, make_report(0));
+        source.broadcast(2, make_report(0));
+        CHECK(wait_for([&] { return a == 1 && b == 1; }));
+
+        receiver.unsubscribe(1);
+        for (uint32_t i = 0; i < 100; i++)
+        {
+            source.broadcast(1, make_report(i));
+            source.broadcast(2, make_report(i));
+        }
+
+        CHECK(wait_for([&] { return b == 101; }));
+        receiver.stop();
+        CHECK_EQ(a.load(), 1u);
+    }
+
+    // stop() 取消所有挂起的请求并等它们完成，之后不再投递
+    void test_stop_drains()
+    {
+        fake_notifier source;
+        output_receiver receiver(source);
+        receiver.start();
+
+        CHECK(wait_for([&] { return source.pending() == fake_notifier::DEPTH; }));
+        const uint64_t posts = source.posts();
+
+        receiver.stop();
+        CHECK_EQ(source.cancelled(), fake_notifier::DEPTH);
+        CHECK_EQ(source.in_flight(), 0u);
+        CHECK_EQ(source.posts(), posts);
+
+        // 停止后的广播进缓存，没有请求去取
+        source.broadcast(1, make_report(0));
+        CHECK_EQ(source.in_flight(), 0u);
+
+        // 重复 stop 无害
+        receiver.stop();
+    }
+
+    // 源失效时接收线程放弃剩余请求并退出，stop() 不会卡住
+    void test_source_failure()
+    {
+        fake_notifier source;
+        output_receiver receiver(source);
+        receiver.start();
+
+        CHECK(wait_for([&] { return source.pending() == fake_notifier::DEPTH; }));
+        source.fail();
+        receiver.stop();
+        CHECK_EQ(source.cancelled(), fake_notifier::DEPTH);
+    }
+}
+
+int main()
+{
+    test_in_order();
+    test_unsubscribe();
+    test_stop_drains();
+    test_source_failure();
+
+    return check_result("output_receiver_test");
+}
@@ -0,0 +1,258 @@
+#include "check.h"
+
+#include <DeadlineHeap.h>
+#include <FrameClock.h>
+#include <PollPump.h>
+
+#include <initializer_list>
+
+//
+// PollPump driven the way EmulationTargetDS5 drives it: the host queues
+// interrupt IN URBs (and queues the next one as soon as one completes),
+// queuing schedules a poll, and each poll resends the cached report on one
+// pending URB unless a submit already answered this interval. Polls run
+// from a one-shot timer armed for the earliest deadline, as in the bus
+// scheduler. Performance counter ticks are microframes here.
+//
+namespace
+{
+	using ViGEm::Reports::ClampPollingInterval;
+	using ViGEm::Reports::PollPump;
+	using ViGEm::Timing::DeadlineHeap;
+	using ViGEm::Timing::DueWork;
+	using ViGEm::Timing::MicroframesPerFrame;
+	using ViGEm::Timing::MicroframesPerSecond;
+	using ViGEm::Timing::NextPeriodicDeadline;
+	using ViGEm::Timing::TimerDelay;
+
+	constexpr unsigned long long MIN_DELAY = MicroframesPerFrame;
+
+	struct target
+	{
+		PollPump pump;
+		// Interrupt IN and ISO OUT, as a target has in BusScheduler
+		DeadlineHeap<2> heap;
+		unsigned long long now = 0;
+		unsigned long pending = 0;
+		unsigned long completed = 0;
+		unsigned long lastDeliveryFrame = 0;
+		bool undelivered = false;
+
+		// Host re-queues a URB as soon as one completes, like HIDUSB
+		bool hostPolling = true;
+
+		explicit target(unsigned long intervalMs)
+		{
+			pump.Init(intervalMs, static_cast<long long>(MicroframesPerSecond));
+			heap.Init();
+		}
+
+		unsigned long long period() const
+		{
+			return pump.IntervalMs * MicroframesPerFrame;
+		}
+
+		void queue_urb()
+		{
+			pending++;
+			heap.Schedule(0, now + period());
+		}
+
+		bool deliver()
+		{
+			if (pending == 0)
+				return false;
+
+			pending--;
+			completed++;
+			undelivered = false;
+			lastDeliveryFrame = static_cast<unsigned long>(now / MicroframesPerFrame);
+
+			if (hostPolling)
+				queue_urb();
+
+			return true;
+		}
+
+		// Feeder submit: goes out at once on a pending URB
+		void submit()
+		{
+			undelivered = true;
+			deliver();
+		}
+
+		// ServicePolling
+		unsigned long long service(unsigned long long deadline)
+		{
+			const unsigned long sinceDelivery = static_cast<unsigned long>(now / MicroframesPerFrame) - lastDeliveryFrame;
+			bool delivered = false;
+
+			if (pump.ShouldResend(sinceDelivery, undelivered))
+				delivered = deliver();
+
+			pump.Poll(static_cast<long long>(now), delivered);
+
+			if (pending == 0)
+			{
+				pump.Pause();
+				return 0;
+			}
+
+			return NextPeriodicDeadline(deadline, period(), now);
+		}
+
+		// Runs the one-shot timer until End, Late delays the tick at or
+		// after LateAt by that much once
+		unsigned long run(unsigned long long end, unsigned long long lateAt = ~0ULL, unsigned long long late = 0)
+		{
+			unsigned long ticks = 0;
+
+			while (!heap.IsEmpty())
+			{
+				unsigned long long fire = now + TimerDelay(heap.NextDeadline(), now, MIN_DELAY);
+
+				if (fire >= lateAt)
+				{
+					fire += late;
+					lateAt = ~0ULL;
+				}
+
+				if (fire > end)
+					break;
+
+				now = fire;
+				ticks++;
+
+				DueWork batch[2] = {};
+				const unsigned long count = heap.PopAllDue(now, batch);
+				for (unsigned long i = 0; i < count; i++)
+					batch[i].Next = service(batch[i].Deadline);
+				heap.Requeue(batch, count, [](unsigned long) { return true; });
+			}
+
+			now = end;
+			return ticks;
+		}
+	};
+
+	void test_clamp()
+	{
+		CHECK_EQ(ClampPollingInterval(0), 1ul);
+		CHECK_EQ(ClampPollingInterval(1), 1ul);
+		CHECK_EQ(ClampPollingInterval(6), 6ul);
+		CHECK_EQ(ClampPollingInterval(16), 16ul);
+		CHECK_EQ(ClampPollingInterval(17), 16ul);
+
+		PollPump pump;
+		pump.Init(4, 10000000);
+		CHECK_EQ(pump.Period, 40000);
+	}
+
+	void test_once_per_period()
+	{
+		for (const unsigned long interval : { 1ul, 4ul, 6ul, 16ul })
+		{
+			// Idle pad, host always has one URB pending: one completion and
+			// one timer tick per interval, nothing missed, no jitter
+			target t(interval);
+			t.queue_urb();
+			const unsigned long ticks = t.run(MicroframesPerSecond);
+
+			const unsigned long expected = 1000 / interval;
+			CHECK(t.completed == expected || t.completed + 1 == expected);
+			CHECK_EQ(ticks, t.completed);
+			CHECK_EQ(t.pump.Polls, t.completed);
+			CHECK_EQ(t.pump.Useful, t.completed);
+			CHECK_EQ(t.pump.Missed, 0u);
+			CHECK_EQ(t.pump.MaxJitter, 0);
+			CHECK_EQ(t.pending, 1u);
+		}
+	}
+
+	void test_submits_answer_polls()
+	{
+		// The feeder submits halfway through every 6 ms interval: each
+		// submit is the interval's completion, polls don't resend on top
+		target t(6);
+		t.queue_urb();
+
+		for (int i = 0; i < 100; i++)
+		{
+			t.run(t.now + 3 * MicroframesPerFrame);
+			t.submit();
+			t.run(t.now + 3 * MicroframesPerFrame);
+		}
+
+		CHECK_EQ(t.completed, 100u);
+		CHECK_EQ(t.pump.Useful, 0u);
+		CHECK(t.pump.Polls >= 99u);
+
+		// A submit with no URB pending waits for the next one
+		target u(6);
+		u.submit();
+		CHECK(u.undelivered);
+		u.queue_urb();
+		u.run(6 * MicroframesPerFrame);
+		CHECK_EQ(u.completed, 1u);
+		CHECK(!u.undelivered);
+	}
+
+	void test_cancel_and_drain()
+	{
+		target t(6);
+		t.queue_urb();
+		t.run(60 * MicroframesPerFrame);
+		CHECK_EQ(t.completed, 10u);
+
+		// Host stops polling and cancels its URB: the next poll finds the
+		// queue drained, pauses and schedules nothing, the timer goes quiet
+		t.hostPolling = false;
+		t.pending = 0;
+		const unsigned long polls = t.pump.Polls;
+		const unsigned long ticks = t.run(t.now + MicroframesPerSecond);
+		CHECK_EQ(ticks, 1u);
+		CHECK_EQ(t.pump.Polls, polls + 1);
+		CHECK(t.heap.IsEmpty());
+		CHECK(!t.pump.Started);
+		CHECK_EQ(t.completed, 10u);
+
+		// A new URB a second later starts polling again, the gap is neither
+		// missed polls nor jitter
+		t.hostPolling = true;
+		t.queue_urb();
+		t.run(t.now + 60 * MicroframesPerFrame);
+		CHECK_EQ(t.completed, 20u);
+		CHECK_EQ(t.pump.Missed, 0u);
+		CHECK_EQ(t.pump.MaxJitter, 0);
+	}
+
+	void test_late_poll()
+	{
+		// One poll 20 ms late on a 6 ms interval: three polls missed, the
+		// late one still answers, then back on a 6 ms period from it
+		target t(6);
+		t.queue_urb();
+		t.run(60 * MicroframesPerFrame, 30 * MicroframesPerFrame, 20 * MicroframesPerFrame);
+
+		CHECK_EQ(t.pump.Missed, 3u);
+		CHECK_EQ(t.pump.MaxJitter, static_cast<long long>(20 * MicroframesPerFrame));
+		CHECK_EQ(t.completed, 6u);
+
+		t.pump.ResetStatistics();
+		t.run(t.now + 60 * MicroframesPerFrame);
+		CHECK_EQ(t.pump.Polls, 10u);
+		CHECK_EQ(t.pump.Missed, 0u);
+		CHECK_EQ(t.pump.MeanJitter(), 0u);
+	}
+}
+
+int main()
+{
+	test_clamp();
+	test_once_per_period();
+	test_submits_answer_polls();
+	test_cancel_and_drain();
+	test_late_poll();
+
+	return check_result("poll_pump_test");
+}
@@ -0,0 +1,194 @@
+#include "check.h"
+
+#include <ReportCache.h>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+//
+// ReportCache seqlock under contention: one writer stamps every byte of
+// the report with a sequence tag, N readers copy snapshots and check that
+// each one is a single tag (no torn copy) and that tags never go back.
+// A second case has several writers mutating in place to check that
+// Update serialises them.
+//
+namespace
+{
+	using ViGEm::Reports::ReportCache;
+
+	struct report
+	{
+		unsigned char bytes[64];
+	};
+
+	bool uniform(const report& r)
+	{
+		for (unsigned int i = 1; i < sizeof(r.bytes); i++)
+		{
+			if (r.bytes[i] != r.bytes[0])
+				return false;
+		}
+		return true;
+	}
+
+	void test_single_thread()
+	{
+		ReportCache<report> cache;
+		report read;
+
+		// Zero-initialised until the first write
+		std::memset(&read, 0xFF, sizeof(read));
+		cache.Read(&read);
+		CHECK(uniform(read));
+		CHECK_EQ(read.bytes[0], 0);
+
+		report written;
+		std::memset(&written, 0x42, sizeof(written));
+		cache.Write(written);
+		cache.Read(&read);
+		CHECK(std::memcmp(&read, &written, sizeof(read)) == 0);
+
+		// Update returns the mutator's result and edits in place
+		CHECK(!cache.Update([](report& r) { r.bytes[3] = 7; return false; }));
+		cache.Read(&read);
+		CHECK_EQ(read.bytes[3], 7);
+		CHECK_EQ(read.bytes[4], 0x42);
+	}
+
+	void test_one_writer()
+	{
+		constexpr unsigned int WRITES = 200000;
+		constexpr unsigned int READERS = 3;
+
+		ReportCache<report> cache;
+		std::atomic<bool> done = false;
+		std::vector<unsigned long long> snapshots(READERS), torn(READERS), backwards(READERS);
+		std::vector<std::thread> readers;
+
+		for (unsigned int n = 0; n < READERS; n++)
+		{
+			readers.emplace_back([&, n] {
+				report read;
+				unsigned char last = 0;
+				unsigned int wraps = 0;
+				unsigned long long previous = 0;
+
+				while (!done.load())
+				{
+					cache.Read(&read);
+					snapshots[n]++;
+					torn[n] += uniform(read) ? 0 : 1;
+
+					// Tags are one byte, unwrap them against the last one seen
+					if (read.bytes[0] < last)
+						wraps++;
+					last = read.bytes[0];
+
+					const unsigned long long tag = wraps * 256ULL + read.bytes[0];
+					backwards[n] += tag < previous ? 1 : 0;
+					previous = tag;
+
+					std::this_thread::yield();
+				}
+			});
+		}
+
+		for (unsigned int i = 1; i <= WRITES; i++)
+		{
+			const unsigned char tag = static_cast<unsigned char>(i);
+
+			// Half the report, then now and then hand the readers the
+			// processor mid-write so even a single core sees overlaps.
+			// Readers spin out their time slice meanwhile, so not often.
+			cache.Update([&](report& r) {
+				std::memset(r.bytes, tag, sizeof(r.bytes) / 2);
+				if (i % 1024 == 0)
+					std::this_thread::yield();
+				std::memset(r.bytes + sizeof(r.bytes) / 2, tag, sizeof(r.bytes) / 2);
+				return true;
+			});
+		}
+		done = true;
+
+		for (auto& reader : readers)
+			reader.join();
+
+		report read;
+		cache.Read(&read);
+		CHECK(uniform(read));
+		CHECK_EQ(read.bytes[0], static_cast<unsigned char>(WRITES));
+
+		for (unsigned int n = 0; n < READERS; n++)
+		{
+			CHECK(snapshots[n] > 0);
+			CHECK_EQ(torn[n], 0u);
+			CHECK_EQ(backwards[n], 0u);
+		}
+	}
+
+	void test_writers_serialised()
+	{
+		constexpr unsigned int WRITERS = 3;
+		constexpr unsigned int UPDATES = 50000;
+
+		ReportCache<report> cache;
+		std::atomic<bool> done = false;
+		std::atomic<unsigned long long> torn = 0;
+		std::vector<std::thread> threads;
+
+		// Every update rewrites the whole report with count + 1, so a reader
+		// sees a torn copy and the count loses increments if two overlap
+		for (unsigned int n = 0; n < WRITERS; n++)
+		{
+			threads.emplace_back([&] {
+				for (unsigned int i = 0; i < UPDATES; i++)
+				{
+					cache.Update([](report& r) {
+						unsigned int count;
+						std::memcpy(&count, r.bytes, sizeof(count));
+						count++;
+						for (unsigned int offset = 0; offset < sizeof(r.bytes); offset += sizeof(count))
+							std::memcpy(r.bytes + offset, &count, sizeof(count));
+						return true;
+					});
+
+					if (i % 16 == 0)
+						std::this_thread::yield();
+				}
+			});
+		}
+
+		std::thread reader([&] {
+			report read;
+			while (!done.load())
+			{
+				cache.Read(&read);
+				torn += std::memcmp(read.bytes, read.bytes + 4, sizeof(read.bytes) - 4) == 0 ? 0 : 1;
+				std::this_thread::yield();
+			}
+		});
+
+		for (auto& thread : threads)
+			thread.join();
+		done = true;
+		reader.join();
+
+		report read;
+		unsigned int count;
+		cache.Read(&read);
+		std::memcpy(&count, read.bytes, sizeof(count));
+		CHECK_EQ(count, WRITERS * UPDATES);
+		CHECK_EQ(torn.load(), 0u);
+	}
+}
+
+int main()
+{
+	test_single_thread();
+	test_one_writer();
+	test_writers_serialised();
+
+	return check_result("report_cache_test");
+}
@@ -0,0 +1,194 @@
+#include "check.h"
+
+#include <SubmitBatch.h>
+
+#include <cstring>
+#include <vector>
+
+//
+// SubmitBatch framing and entry validation the driver runs on every
+// IOCTL_VIGEM_SUBMIT_BATCH, and the builder the app packs batches with.
+//
+namespace
+{
+	using namespace ViGEm::Batch;
+
+	// Report sizes the driver passes in (XUSB_REPORT, DS5 input report)
+	constexpr unsigned int XUSB_SIZE = 12;
+	constexpr unsigned int DS5_SIZE = 63;
+
+	std::vector<unsigned char> batch(unsigned int count)
+	{
+		std::vector<unsigned char> buffer(SubmitBatchLength(count));
+		SubmitBatchBuilder builder(buffer.data(), buffer.size());
+		const unsigned char report[DS5_SIZE] = {};
+
+		for (unsigned int i = 0; i < count; i++)
+			builder.Add(SubmitBatchTargetDs5, i + 1, report, sizeof(report));
+
+		return buffer;
+	}
+
+	SUBMIT_BATCH_HEADER& header(std::vector<unsigned char>& buffer)
+	{
+		return *reinterpret_cast<PSUBMIT_BATCH_HEADER>(buffer.data());
+	}
+
+	void test_framing()
+	{
+		unsigned int count = 99;
+
+		// Too short for a header, or no buffer at all
+		auto buffer = batch(2);
+		CHECK(ValidateSubmitBatch(nullptr, buffer.size(), &count) == SubmitBatchError::BufferTooSmall);
+		CHECK(ValidateSubmitBatch(buffer.data(), sizeof(SUBMIT_BATCH_HEADER) - 1, &count) == SubmitBatchError::BufferTooSmall);
+		CHECK_EQ(count, 99u);
+
+		// Header Size other than sizeof(SUBMIT_BATCH_HEADER)
+		header(buffer).Size = sizeof(SUBMIT_BATCH_HEADER) + 4;
+		CHECK(ValidateSubmitBatch(buffer.data(), buffer.size(), &count) == SubmitBatchError::InvalidHeader);
+		header(buffer).Size = 0;
+		CHECK(ValidateSubmitBatch(buffer.data(), buffer.size(), &count) == SubmitBatchError::InvalidHeader);
+		header(buffer).Size = sizeof(SUBMIT_BATCH_HEADER);
+
+		// Count over the limit, even with a buffer that would hold it
+		auto big = batch(SubmitBatchMaxEntries);
+		big.resize(SubmitBatchLength(SubmitBatchMaxEntries + 1));
+		header(big).Count = SubmitBatchMaxEntries + 1;
+		CHECK(ValidateSubmitBatch(big.data(), big.size(), &count) == SubmitBatchError::TooManyEntries);
+
+		// Length not exactly header + Count entries
+		CHECK(ValidateSubmitBatch(buffer.data(), buffer.size() - 1, &count) == SubmitBatchError::LengthMismatch);
+		CHECK(ValidateSubmitBatch(buffer.data(), buffer.size() + sizeof(SUBMIT_BATCH_ENTRY), &count) == SubmitBatchError::LengthMismatch);
+		header(buffer).Count = 3;
+		CHECK(ValidateSubmitBatch(buffer.data(), buffer.size(), &count) == SubmitBatchError::LengthMismatch);
+		header(buffer).Count = 2;
+		CHECK_EQ(count, 99u);
+
+		// Well-formed, including the empty probe batch and a full one
+		CHECK(ValidateSubmitBatch(buffer.data(), buffer.size(), &count) == SubmitBatchError::None);
+		CHECK_EQ(count, 2u);
+
+		auto empty = batch(0);
+		CHECK(ValidateSubmitBatch(empty.data(), empty.size(), &count) == SubmitBatchError::None);
+		CHECK_EQ(count, 0u);
+
+		auto full = batch(SubmitBatchMaxEntries);
+		CHECK(ValidateSubmitBatch(full.data(), full.size(), &count) == SubmitBatchError::None);
+		CHECK_EQ(count, SubmitBatchMaxEntries);
+	}
+
+	void test_entries()
+	{
+		SUBMIT_BATCH_ENTRY entry = {};
+		entry.SerialNo = 1;
+		entry.Target = SubmitBatchTargetXusb;
+		entry.ReportSize = XUSB_SIZE;
+		CHECK(ValidateSubmitBatchEntry(entry, XUSB_SIZE, DS5_SIZE));
+
+		entry.Target = SubmitBatchTargetDs5;
+		entry.ReportSize = DS5_SIZE;
+		CHECK(ValidateSubmitBatchEntry(entry, XUSB_SIZE, DS5_SIZE));
+
+		// Serial 0 is never a plugged-in target
+		entry.SerialNo = 0;
+		CHECK(!ValidateSubmitBatchEntry(entry, XUSB_SIZE, DS5_SIZE));
+		entry.SerialNo = 1;
+
+		// Unknown target type
+		entry.Target = 0;
+		CHECK(!ValidateSubmitBatchEntry(entry, XUSB_SIZE, DS5_SIZE));
+		entry.Target = 3;
+		CHECK(!ValidateSubmitBatchEntry(entry, XUSB_SIZE, DS5_SIZE));
+
+		// Report size of the other target type, or just off by one
+		entry.Target = SubmitBatchTargetDs5;
+		entry.ReportSize = XUSB_SIZE;
+		CHECK(!ValidateSubmitBatchEntry(entry, XUSB_SIZE, DS5_SIZE));
+		entry.ReportSize = DS5_SIZE + 1;
+		CHECK(!ValidateSubmitBatchEntry(entry, XUSB_SIZE, DS5_SIZE));
+		entry.Target = SubmitBatchTargetXusb;
+		entry.ReportSize = XUSB_SIZE - 1;
+		CHECK(!ValidateSubmitBatchEntry(entry, XUSB_SIZE, DS5_SIZE));
+	}
+
+	void test_builder()
+	{
+		// Room for three entries only
+		std::vector<unsigned char> buffer(SubmitBatchLength(3));
+		std::memset(buffer.data(), 0xCC, buffer.size());
+		SubmitBatchBuilder builder(buffer.data(), buffer.size());
+		CHECK_EQ(builder.Count(), 0u);
+		CHECK_EQ(builder.Length(), sizeof(SUBMIT_BATCH_HEADER));
+
+		unsigned char report[SubmitBatchMaxReportSize + 1];
+		std::memset(report, 0x5A, sizeof(report));
+
+		CHECK(builder.Add(SubmitBatchTargetXusb, 7, report, XUSB_SIZE));
+		CHECK(builder.Add(SubmitBatchTargetDs5, 8, report, DS5_SIZE));
+
+		// Report larger than an entry holds
+		CHECK(!builder.Add(SubmitBatchTargetDs5, 9, report, SubmitBatchMaxReportSize + 1));
+		CHECK_EQ(builder.Count(), 2u);
+
+		CHECK(builder.Add(SubmitBatchTargetDs5, 9, report, SubmitBatchMaxReportSize));
+
+		// Buffer full
+		CHECK(!builder.Add(SubmitBatchTargetXusb, 10, report, XUSB_SIZE));
+		CHECK_EQ(builder.Count(), 3u);
+		CHECK_EQ(builder.Length(), buffer.size());
+
+		unsigned int count = 0;
+		CHECK(ValidateSubmitBatch(buffer.data(), builder.Length(), &count) == SubmitBatchError::None);
+		CHECK_EQ(count, 3u);
+
+		// Entries as packed, Report zero-padded past ReportSize (the buffer
+		// started out as 0xCC)
+		const SUBMIT_BATCH_ENTRY& first = builder.Entry(0);
+		CHECK_EQ(first.SerialNo, 7u);
+		CHECK_EQ(first.Target, static_cast<unsigned int>(SubmitBatchTargetXusb));
+		CHECK_EQ(first.ReportSize, XUSB_SIZE);
+		CHECK_EQ(first.Status, 0);
+		CHECK(ValidateSubmitBatchEntry(first, XUSB_SIZE, DS5_SIZE));
+
+		unsigned int wrong = 0;
+		for (unsigned int i = 0; i < SubmitBatchMaxReportSize; i++)
+			wrong += first.Report[i] != (i < XUSB_SIZE ? 0x5A : 0);
+		CHECK_EQ(wrong, 0u);
+
+		CHECK_EQ(builder.Entry(1).Report[DS5_SIZE - 1], 0x5A);
+		CHECK_EQ(builder.Entry(1).Report[DS5_SIZE], 0);
+		CHECK_EQ(builder.Entry(2).Report[SubmitBatchMaxReportSize - 1], 0x5A);
+
+		// Reset starts over in the same buffer
+		builder.Reset();
+		CHECK_EQ(builder.Count(), 0u);
+		CHECK(ValidateSubmitBatch(buffer.data(), builder.Length(), &count) == SubmitBatchError::None);
+		CHECK_EQ(count, 0u);
+	}
+
+	void test_entry_limit()
+	{
+		// Buffer with room to spare still stops at SubmitBatchMaxEntries
+		std::vector<unsigned char> buffer(SubmitBatchLength(SubmitBatchMaxEntries + 4));
+		SubmitBatchBuilder builder(buffer.data(), buffer.size());
+		const unsigned char report[XUSB_SIZE] = {};
+
+		unsigned int added = 0;
+		while (builder.Add(SubmitBatchTargetXusb, added + 1, report, sizeof(report)))
+			added++;
+
+		CHECK_EQ(added, SubmitBatchMaxEntries);
+		CHECK_EQ(builder.Length(), SubmitBatchLength(SubmitBatchMaxEntries));
+	}
+}
+
+int main()
+{
+	test_framing();
+	test_entries();
+	test_builder();
+	test_entry_limit();
+
+	return check_result("submit_batch_test");
+}
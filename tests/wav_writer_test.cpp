@@ -0,0 +1,255 @@
+#include "check.h"
+#include "wav_writer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+//
+// wav_writer 写到临时目录再读回：每次落盘后的 RIFF / data 长度、分段的
+// 文件名与长度，以及调低 RIFF 上限后 JUNK 原地改写为 RF64 + ds64
+//
+namespace
+{
+    namespace fs = std::filesystem;
+
+    constexpr size_t HEADER_SIZE = 80;
+    // 4 声道 16 bit，一帧 8 字节
+    const wav_format FORMAT = { 4, 48000, 16 };
+    constexpr uint32_t BLOCK_ALIGN = 8;
+
+    struct temp_dir
+    {
+        fs::path path;
+
+        temp_dir()
+        {
+            static unsigned counter = 0;
+            path = fs::temp_directory_path() / ("wav_writer_test_" + std::to_string(std::random_device()()) + "_" + std::to_string(counter++));
+            fs::remove_all(path);
+            fs::create_directories(path);
+        }
+
+        ~temp_dir() { fs::remove_all(path); }
+
+        std::string file(const char* name) const { return (path / name).string(); }
+    };
+
+    std::vector<uint8_t> read_file(const std::string& name)
+    {
+        std::ifstream in(name, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), {});
+    }
+
+    uint32_t get32(const std::vector<uint8_t>& b, size_t offset)
+    {
+        uint32_t v = 0;
+        if (offset + 4 <= b.size())
+            std::memcpy(&v, b.data() + offset, 4);
+        return v;
+    }
+
+    uint64_t get64(const std::vector<uint8_t>& b, size_t offset)
+    {
+        uint64_t v = 0;
+        if (offset + 8 <= b.size())
+            std::memcpy(&v, b.data() + offset, 8);
+        return v;
+    }
+
+    std::string tag(const std::vector<uint8_t>& b, size_t offset)
+    {
+        return offset + 4 <= b.size() ? std::string(reinterpret_cast<const char*>(b.data() + offset), 4) : "";
+    }
+
+    std::vector<uint8_t> pcm(size_t size, uint8_t seed)
+    {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; i++)
+            data[i] = static_cast<uint8_t>(seed + i);
+        return data;
+    }
+
+    // 普通 RIFF 头：长度字段与文件实际长度一致，JUNK 未被占用
+    void check_riff(const std::string& name, uint64_t dataSize)
+    {
+        const auto b = read_file(name);
+        CHECK_EQ(b.size(), HEADER_SIZE + dataSize);
+        CHECK(tag(b, 0) == "RIFF");
+        CHECK_EQ(get32(b, 4), HEADER_SIZE - 8 + dataSize);
+        CHECK(tag(b, 8) == "WAVE");
+        CHECK(tag(b, 12) == "JUNK");
+        CHECK_EQ(get32(b, 16), 28u);
+        CHECK_EQ(get64(b, 20), 0u);
+        CHECK(tag(b, 48) == "fmt ");
+        CHECK(tag(b, 72) == "data");
+        CHECK_EQ(get32(b, 76), dataSize);
+    }
+
+    void test_header_after_each_flush()
+    {
+        temp_dir dir;
+        const std::string name = dir.file("flush.wav");
+
+        wav_writer_options options;
+        options.chunkSize = 64;
+        wav_writer writer(name, FORMAT, options);
+
+        // 不满一块时只有文件头，长度为 0
+        const auto a = pcm(40, 1);
+        CHECK(writer.write(a.data(), a.size()));
+        check_riff(name, 0);
+
+        // 凑满第一块：落盘 64 字节，剩下的 16 字节还在缓冲里
+        CHECK(writer.write(a.data(), a.size()));
+        check_riff(name, 64);
+
+        // 一次写多块
+        const auto b = pcm(200, 7);
+        CHECK(writer.write(b.data(), b.size()));
+        check_riff(name, 256);
+
+        // fmt 块
+        const auto h = read_file(name);
+        CHECK_EQ(get32(h, 52), 16u);
+        CHECK_EQ(get32(h, 56) & 0xFFFF, 1u);
+        CHECK_EQ(get32(h, 56) >> 16, 4u);
+        CHECK_EQ(get32(h, 60), 48000u);
+        CHECK_EQ(get32(h, 64), 48000u * BLOCK_ALIGN);
+        CHECK_EQ(get32(h, 68) & 0xFFFF, BLOCK_ALIGN);
+        CHECK_EQ(get32(h, 68) >> 16, 16u);
+
+        // close 写出余下部分，数据原样
+        writer.close();
+        check_riff(name, 280);
+        CHECK_EQ(writer.total_bytes(), 280u);
+
+        const auto all = read_file(name);
+        std::vector<uint8_t> expected(a);
+        expected.insert(expected.end(), a.begin(), a.end());
+        expected.insert(expected.end(), b.begin(), b.end());
+        CHECK(std::equal(expected.begin(), expected.end(), all.begin() + HEADER_SIZE));
+    }
+
+    void test_rotation()
+    {
+        temp_dir dir;
+
+        // 按字节切分：上限 1000 字节，不是整帧时向下取整到 1000 - 1000 % 8
+        {
+            wav_writer_options options;
+            options.segmentBytes = 1003;
+            options.chunkSize = 256;
+            wav_writer writer(dir.file("bytes.wav"), FORMAT, options);
+
+            const auto data = pcm(2500, 3);
+            CHECK(writer.write(data.data(), data.size()));
+            writer.close();
+
+            CHECK_EQ(writer.segments(), 3u);
+            check_riff(dir.file("bytes_000.wav"), 1000);
+            check_riff(dir.file("bytes_001.wav"), 1000);
+            check_riff(dir.file("bytes_002.wav"), 500);
+            CHECK(!fs::exists(dir.file("bytes.wav")));
+            CHECK(!fs::exists(dir.file("bytes_003.wav")));
+
+            // 跨分段的数据连续
+            const auto second = read_file(dir.file("bytes_001.wav"));
+            CHECK_EQ(second[HEADER_SIZE], data[1000]);
+        }
+
+        // 按时长切分：100 Hz 一秒 800 字节，字节上限更大时按时长
+        {
+            const wav_format slow = { 4, 100, 16 };
+            wav_writer_options options;
+            options.segmentSeconds = 1;
+            options.segmentBytes = 5000;
+            wav_writer writer(dir.file("time"), slow, options);
+
+            const auto data = pcm(2000, 5);
+            for (size_t offset = 0; offset < data.size(); offset += 8)
+                CHECK(writer.write(data.data() + offset, 8));
+            writer.close();
+
+            CHECK_EQ(writer.segments(), 3u);
+            check_riff(dir.file("time_000.wav"), 800);
+            check_riff(dir.file("time_001.wav"), 800);
+            check_riff(dir.file("time_002.wav"), 400);
+        }
+
+        // 未设上限时不加序号
+        {
+            wav_writer writer(dir.file("single.wav"), FORMAT);
+            const auto data = pcm(100, 0);
+            CHECK(writer.write(data.data(), data.size()));
+            writer.close();
+            check_riff(dir.file("single.wav"), 100);
+            CHECK_EQ(writer.segments(), 1u);
+        }
+    }
+
+    void test_rf64_promotion()
+    {
+        temp_dir dir;
+        const std::string name = dir.file("big.wav");
+
+        // RIFF 长度超过 200 字节（data 超过 128 字节）时改写为 RF64
+        wav_writer_options options;
+        options.chunkSize = 64;
+        options.riffLimit = 200;
+        wav_writer writer(name, FORMAT, options);
+
+        const auto data = pcm(128, 9);
+        CHECK(writer.write(data.data(), data.size()));
+        check_riff(name, 128);
+
+        CHECK(writer.write(data.data(), 64));
+        {
+            const auto b = read_file(name);
+            CHECK_EQ(b.size(), HEADER_SIZE + 192);
+            CHECK(tag(b, 0) == "RF64");
+            CHECK_EQ(get32(b, 4), 0xFFFFFFFFu);
+            CHECK(tag(b, 12) == "ds64");
+            CHECK_EQ(get32(b, 16), 28u);
+            CHECK_EQ(get64(b, 20), HEADER_SIZE - 8 + 192);
+            CHECK_EQ(get64(b, 28), 192u);
+            CHECK_EQ(get64(b, 36), 192u / BLOCK_ALIGN);
+            CHECK_EQ(get32(b, 44), 0u);
+            CHECK(tag(b, 48) == "fmt ");
+            CHECK(tag(b, 72) == "data");
+            CHECK_EQ(get32(b, 76), 0xFFFFFFFFu);
+
+            // 改写只动文件头，数据不搬移
+            CHECK(std::equal(data.begin(), data.end(), b.begin() + HEADER_SIZE));
+        }
+
+        writer.close();
+        const auto b = read_file(name);
+        CHECK_EQ(get64(b, 28), 192u);
+    }
+
+    void test_open_failure()
+    {
+        temp_dir dir;
+        wav_writer writer(dir.file("missing/dir.wav"), FORMAT);
+        const auto data = pcm(16, 0);
+        CHECK(!writer.write(data.data(), data.size()));
+        CHECK(!writer.write(data.data(), data.size()));
+        writer.close();
+    }
+}
+
+int main()
+{
+    test_header_after_each_flush();
+    test_rotation();
+    test_rf64_promotion();
+    test_open_failure();
+
+    return check_result("wav_writer_test");
+}